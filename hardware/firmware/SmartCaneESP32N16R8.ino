@@ -1,12 +1,21 @@
 #include "Pins.h"
+#include "Log.h"
 // #include <WiFi.h>  // Disabled to save memory
 // #include "ConnectivityManager.h"  // Disabled to save memory
 #include "EnvMonitor.h"
 #include "LightSensor.h"
 #include "IMU.h"
 #include "ToF.h"
+#include "DropOffDetector.h"
+#include "StepJournal.h"
+#include "BlackBox.h"
 #include "RFID.h"
 #include "GPSModule.h"
+#include "PdrFilter.h"
+#include "WaypointStore.h"
+#include "PoiDatabase.h"
+#include "RouteEngine.h"
+#include "TrackLogger.h"
 #include "SensorData.h"
 #include "FeedbackManager.h"
 #include "BLEManager.h"
@@ -46,47 +55,111 @@ static uint32_t lastCloudRetry = 0;
 static const int MAX_CLOUD_RETRIES = 5;
 
 void printHeader() {
-  Serial.println("=========================================================================================================================================================================================================================================");
-  Serial.println("| Time | Temp (C) | Hum (%) | HeatIdx | DewPt | Lux   | Env                | Pitch | Roll  | Yaw   | ToF (cm) | RFID                        | Room | Lat         | Lon         | Alt (m) | Spd (km/h) | Sats | Daily | Total | Mode |");
-  Serial.println("=========================================================================================================================================================================================================================================");
+  static const char* const RULE = "=========================================================================================================================================================================================================================================\n";
+  LOG_ADMITTED(LOG_CAT_TABLE, LOG_LEVEL_INFO, RULE);
+  LOG_ADMITTED(LOG_CAT_TABLE, LOG_LEVEL_INFO, "| Time | Temp (C) | Hum (%%) | HeatIdx | DewPt | Lux   | Env                | Pitch | Roll  | Yaw   | ToF (cm) | RFID                        | Room | Lat         | Lon         | Alt (m) | Spd (km/h) | Sats | Daily | Total | Mode |\n");
+  LOG_ADMITTED(LOG_CAT_TABLE, LOG_LEVEL_INFO, RULE);
 }
 
+// One table row as four deferred records (at most LOG_MAX_ARGS slots each),
+// admitted once so rate limiting drops whole rows.
 void printLine(const SensorData& s) {
-  if (millis() - hdrT > 10000) { printHeader(); hdrT = millis(); }
-  char buf[512];
-  snprintf(buf, sizeof(buf),
-    "| %5lu | %8.1f | %7.1f | %7.1f | %5.1f | %5.1f | %-18s | %6.1f | %6.1f | %6.1f | %8.1f | %-28s | %4s | %10.6f | %10.6f | %7.1f | %10.2f | %4d | %5lu | %6lu | %-4s |",
-    millis() / 1000,
-    s.temperature,
-    s.humidity,
-    s.heatIndex,
-    s.dewPoint,
-    s.lightLux,
-    s.lightEnvironment,
-    s.imuPitch,
-    s.imuRoll,
-    s.imuYaw,
-    s.tofDistance,
-    s.rfidUID[0] ? s.rfidUID : "(none)",
-    s.currentRoom > 0 ? String(s.currentRoom).c_str() : "---",
-    s.gpsLat,
-    s.gpsLon,
-    s.gpsAlt,
-    s.gpsSpeed,
-    s.gpsSatellites,
-    s.dailySteps,
-    s.totalSteps,
-    (s.feedbackMode == FEEDBACK_MODE_BOTH) ? "BOTH" : 
-    (s.feedbackMode == FEEDBACK_MODE_BUZZER) ? "BUZZ" : "VIBR"
-  );
-  
-  // Print to Serial monitor
-  Serial.println(buf);
-  
   // Show room change notification
   if (s.roomChanged && s.currentRoom > 0) {
-    Serial.printf("🏠 LOCATION: %s\n", s.currentRoomName);
+    LOG_INFO(LOG_CAT_SYS, "🏠 LOCATION: %s\n", s.currentRoomName);
   }
+  if (!LOG_ENABLED(LOG_CAT_TABLE, LOG_LEVEL_INFO) || !Log_admit(LOG_CAT_TABLE)) return;
+
+  if (millis() - hdrT > 10000) { printHeader(); hdrT = millis(); }
+  char room[4] = "---";
+  if (s.currentRoom > 0) snprintf(room, sizeof(room), "%u", s.currentRoom);
+  LOG_ADMITTED(LOG_CAT_TABLE, LOG_LEVEL_INFO, "| %5lu | %8.1f | %7.1f | %7.1f | %5.1f | %5.1f | %-18s | %6.1f ",
+    millis() / 1000, s.temperature, s.humidity, s.heatIndex, s.dewPoint, s.lightLux,
+    s.lightEnvironment, s.imuPitch);
+  LOG_ADMITTED(LOG_CAT_TABLE, LOG_LEVEL_INFO, "| %6.1f | %6.1f | %8.1f | %-28s | %4s ",
+    s.imuRoll, s.imuYaw, s.tofDistance, s.rfidUID[0] ? s.rfidUID : "(none)", room);
+  LOG_ADMITTED(LOG_CAT_TABLE, LOG_LEVEL_INFO, "| %10.6f | %10.6f ", s.gpsLat, s.gpsLon);
+  LOG_ADMITTED(LOG_CAT_TABLE, LOG_LEVEL_INFO, "| %7.1f | %10.2f | %4d | %5lu | %6lu | %-4s |\n",
+    s.gpsAlt, s.gpsSpeed, s.gpsSatellites, s.dailySteps, s.totalSteps,
+    (s.feedbackMode == FEEDBACK_MODE_BOTH) ? "BOTH" : 
+    (s.feedbackMode == FEEDBACK_MODE_BUZZER) ? "BUZZ" : "VIBR");
+}
+
+// Geofence events: the app speaks the name ("near the pharmacy entrance"),
+// arriving at the navigation target plays the destination clip
+void announceWaypoint(const WaypointEvent& event) {
+  if (event.type == WAYPOINT_EVENT_ENTER) {
+    Serial.printf("📍 Near %s (%.0f m, %.0f°)\n", event.name, event.distanceM, event.bearingDeg);
+    BLEManager::queueBLEMessage("NEAR:%u,%.0f,%.0f,%s", event.id, event.distanceM, event.bearingDeg, event.name);
+    if (event.isTarget) {
+      audioManager.playDestinationReached();
+      Waypoint_setTarget(0);
+      Serial.printf("🏁 Arrived at %s\n", event.name);
+    }
+  } else {
+    Serial.printf("📍 Left %s\n", event.name);
+    BLEManager::queueBLEMessage("LEFT:%u,%s", event.id, event.name);
+  }
+}
+
+void announcePoi(const PoiResult& poi) {
+  Serial.printf("📍 %s %s (%.0f m, %.0f°)\n", Poi_categoryName(poi.category), poi.name, poi.distanceM, poi.bearingDeg);
+  BLEManager::queueBLEMessage("POI:%u,%.0f,%.0f,%s", poi.category, poi.distanceM, poi.bearingDeg, poi.name);
+  audioManager.announcePoi(poi.category, poi.distanceM);
+}
+
+void playRouteTurn(RouteManeuverType maneuver) {
+  if (maneuver == ROUTE_TURN_LEFT) audioManager.playTurnLeft();
+  else if (maneuver == ROUTE_TURN_RIGHT) audioManager.playTurnRight();
+}
+
+// One phrase per event; a newer instruction replaces one still waiting
+void announceRoute(const RouteEvent& event) {
+  audioManager.beginPhrase(AUDIO_PRIORITY_NAVIGATION, AUDIO_KEY_ROUTE);
+  switch (event.type) {
+    case ROUTE_EVENT_PLANNED:
+      Serial.printf("🧭 Route planned: %.0f m, first instruction in %.0f m\n", event.distanceM, event.nextDistanceM);
+      BLEManager::queueBLEMessage("ROUTE:PLANNED,%.0f", event.distanceM);
+      audioManager.playGoStraight();
+      audioManager.announceNumber((int)(event.nextDistanceM + 0.5f));
+      audioManager.announceUnit("meters");
+      break;
+    case ROUTE_EVENT_FAILED:
+      Serial.printf("❌ Route failed: %s\n", Route_errorName(event.error));
+      BLEManager::queueBLEMessage("ROUTE:FAILED,%s", Route_errorName(event.error));
+      break;
+    case ROUTE_EVENT_PREPARE:
+      Serial.printf("🧭 %s in %.0f m\n", event.maneuver == ROUTE_TURN_LEFT ? "Left" : "Right", event.nextDistanceM);
+      BLEManager::queueBLEMessage("ROUTE:PREPARE,%s,%.0f", event.maneuver == ROUTE_TURN_LEFT ? "L" : "R",
+                                  event.nextDistanceM);
+      playRouteTurn(event.maneuver);
+      audioManager.announceNumber((int)(event.nextDistanceM + 0.5f));
+      audioManager.announceUnit("meters");
+      break;
+    case ROUTE_EVENT_TURN:
+      Serial.printf("🧭 Turn %s now (%.0f m to go)\n", event.maneuver == ROUTE_TURN_LEFT ? "left" : "right",
+                    event.distanceM);
+      BLEManager::queueBLEMessage("ROUTE:TURN,%s,%.0f", event.maneuver == ROUTE_TURN_LEFT ? "L" : "R", event.distanceM);
+      playRouteTurn(event.maneuver);
+      break;
+    case ROUTE_EVENT_OFF_ROUTE:
+      Serial.printf("🧭 Off route (%.0f m away), re-planning\n", event.nextDistanceM);
+      BLEManager::queueBLEMessage("ROUTE:OFF,%.0f", event.nextDistanceM);
+      break;
+    case ROUTE_EVENT_ARRIVED:
+      Serial.println("🏁 Route complete");
+      BLEManager::queueBLEMessage("ROUTE:ARRIVED");
+      audioManager.playDestinationReached();
+      break;
+  }
+  audioManager.endPhrase();
+}
+
+// Distance and bearing to a waypoint from the current position
+void printWaypointRange(const char* label, const Waypoint& waypoint) {
+  float bearing;
+  float distance = Waypoint_distance(waypoint, sensorData.gpsLat, sensorData.gpsLon, &bearing);
+  Serial.printf("%s %s: %.0f m, bearing %.0f°\n", label, waypoint.name, distance, bearing);
 }
 
 void processSerialCommand(const String& command) {
@@ -102,18 +175,18 @@ void processSerialCommand(const String& command) {
   else if (cmd == "audiostatus") {
     Serial.println("🔊 Audio System Status:");
     audioManager.announceSerialStatement("Audio System Status");
-    Serial.printf("   Initialized: %s\n", audioManager.isAudioReady() ? "Yes" : "No");
-    Serial.printf("   SD Card Available: %s\n", audioManager.isAudioReady() ? "Yes" : "No");
+    audioManager.printStatus();
+  }
+  else if (cmd == "audiostop") {
+    audioManager.clearQueue();
+    Serial.println("🔇 Audio queue cleared");
   }
   else if (cmd == "announce") {
     Serial.println("📢 Announcing current sensor readings...");
     audioManager.announceSerialStatement("Announcing current sensor readings");
     audioManager.announceDistanceReading(sensorData.tofDistance);
-    delay(2000);
     audioManager.announceTemperature(sensorData.temperature);
-    delay(2000);
     audioManager.announceLightLevel(sensorData.lightLux, sensorData.lightEnvironment);
-    delay(2000);
     audioManager.announceGPSStatus(sensorData);
   }
   else if (cmd == "v" || cmd == "vibrate") {
@@ -214,24 +287,79 @@ void processSerialCommand(const String& command) {
     Serial.println("📡 GPS raw data toggle - functionality moved to GPS module");
   }
   else if (cmd == "gpssats") {
-    // Show GPS satellites
-    Serial.println("🛰️ GPS satellite info - functionality moved to GPS module");
+    GPSModule_printSatellites();
   }
   else if (cmd == "gpstop3") {
-    // Show top 3 GPS satellites
-    Serial.println("🛰️ GPS top 3 satellites - functionality moved to GPS module");
+    GPSModule_printTopSatellites(3);
   }
   else if (cmd == "gpsview") {
-    // View all GPS satellites
-    Serial.println("🛰️ GPS view all satellites - functionality moved to GPS module");
+    GPSModule_printSatelliteView();
+  }
+  else if (cmd == "gpsparsebench") {
+    SatTable_runBenchmark();
   }
   else if (cmd == "gpsstatus") {
-    // GPS status display
-    Serial.println("📍 GPS status - functionality moved to GPS module");
+    GPSModule_printLinkStatus();
+  }
+  else if (cmd == "gpsfilter") {
+    GPSModule_printFilterStatus();
+  }
+  else if (cmd.startsWith("gpsfilter ")) {
+    String setting = cmd.substring(10);
+    bool enable = (setting == "on" || setting == "1" || setting == "true");
+    GPSModule_enableFusion(enable);
+    Serial.printf("🧭 GPS/step fusion %s\n", enable ? "enabled" : "disabled (raw fixes)");
+  }
+  else if (cmd == "gpsfilterbench") {
+    Pdr_runBenchmark();
+  }
+  else if (cmd == "imustats") {
+    IMU_printAcquisitionStats();
+  }
+  else if (cmd == "imubench") {
+    IMU_runPreprocessBenchmark();
+  }
+  else if (cmd == "stepjournal") {
+    StepJournal_printStatus();
+  }
+  else if (cmd == "blackbox") {
+    BlackBox_printStatus();
+  }
+  else if (cmd == "logstats") {
+    Log_printStats();
+  }
+  else if (cmd.startsWith("logmode")) {
+    String mode = cmd.substring(7);
+    mode.trim();
+    if (mode == "binary") Log_setBinary(true);
+    else if (mode == "text") Log_setBinary(false);
+    Serial.printf("📝 Log output: %s\n", Log_isBinary() ? "binary (decode with hardware/tools/log_decode.py)" : "text");
+  }
+  else if (cmd == "blackboxsave") {
+    if (BlackBox_trigger(BLACKBOX_REASON_MANUAL)) {
+      Serial.println("📦 Black box capture triggered");
+    } else {
+      Serial.println("⚠️ Black box busy or unavailable");
+    }
+  }
+  else if (cmd == "gait") {
+    GaitMetrics gait = IMU_getGaitMetrics();
+    Serial.println("\n🚶 Gait Analytics:");
+    Serial.printf("Walking: %s | Cadence: %.1f steps/min | Speed: %.2f m/s\n",
+                  gait.walking ? "Yes" : "No", gait.cadenceSpm, gait.walkingSpeed);
+    Serial.printf("Stride time: %.3f s ± %.3f s (CV %.1f%%) over %lu strides\n",
+                  gait.strideTimeMean, gait.strideTimeStdDev, gait.strideTimeCv, gait.strideCount);
+    Serial.printf("Symmetry index: %.1f%% | Step length: %.2f m\n", gait.symmetryIndex, gait.stepLengthM);
   }
   else if (cmd == "tofdiag") {
     ToF_diagnostics();
   }
+  else if (cmd == "tofbench") {
+    ToF_runFilterBenchmark();
+  }
+  else if (cmd == "tofprofile") {
+    ToF_printProfileLog();
+  }
   else if (cmd == "tofreset") {
     Serial.println("🔄 Resetting ToF sensor...");
     ToF_manualReset();
@@ -303,8 +431,9 @@ void processSerialCommand(const String& command) {
     Serial.printf("   Fix Status: %s\n", sensorData.gpsLat != 0 ? "FIXED" : "NO FIX");
     Serial.printf("   Satellites: %d\n", sensorData.gpsSatellites);
     Serial.println("   ⚡ MAXIMUM SPEED MODE - No accuracy filtering");
-    Serial.println("   📡 All GNSS enabled: GPS+GLONASS+Galileo+BeiDou+QZSS");
-    Serial.println("   🔄 Update Rate: 5Hz (200ms)");
+    Serial.printf("   📡 Protocol: %s @ %lu baud\n", GPSModule_isUbxActive() ? "UBX (NAV-POSLLH/SOL/VELNED)" : "NMEA",
+                  GPSModule_getBaud());
+    Serial.printf("   🔄 Update Rate: %dHz\n", GPSModule_getConfig().updateRate);
     
     if (sensorData.gpsLat != 0) {
       Serial.printf("   📍 Position: %.6f, %.6f\n", sensorData.gpsLat, sensorData.gpsLon);
@@ -390,15 +519,15 @@ void processSerialCommand(const String& command) {
     }
   }
   else if (cmd == "gpsttff") {
-    uint32_t ttff = GPSModule_getTimeToFirstFix();
-    Serial.printf("⏱️ Time to First Fix: %lu ms\n", ttff);
-    if (ttff < 1000) {
-      Serial.println("   ⚡ Hot start performance");
-    } else if (ttff < 25000) {
-      Serial.println("   🔥 Warm start performance");
-    } else {
-      Serial.println("   ❄️ Cold start performance");
-    }
+    GPSModule_printTtffStats();
+  }
+  else if (cmd == "gpsaid save") {
+    if (GPSModule_saveAiding()) Serial.println("💾 Polling ephemerides and almanac; saving in a few seconds");
+    else Serial.println("❌ Needs a UBX receiver with a fix");
+  }
+  else if (cmd == "gpsaid clear") {
+    GPSModule_clearAiding();
+    Serial.println("🗑️ GPS aiding data cleared; the next start is cold");
   }
   else if (cmd == "gpsinfo") {
     Serial.println("📡 Detailed GPS Information:");
@@ -419,27 +548,25 @@ void processSerialCommand(const String& command) {
   }
   else if (cmd == "sethome") {
     if (sensorData.gpsLat != 0 && sensorData.gpsLon != 0) {
-      // Save home location to EEPROM (you can implement this)
-      Serial.printf("🏠 Home location saved: %.6f, %.6f\n", sensorData.gpsLat, sensorData.gpsLon);
+      if (Waypoint_setHome(sensorData.gpsLat, sensorData.gpsLon)) {
+        Serial.printf("🏠 Home location saved: %.6f, %.6f\n", sensorData.gpsLat, sensorData.gpsLon);
+      } else {
+        Serial.println("❌ Waypoint store full, home not saved");
+      }
     } else {
       Serial.println("❌ No GPS fix available to set home");
     }
   }
   else if (cmd == "home") {
-    if (sensorData.gpsLat != 0 && sensorData.gpsLon != 0) {
-      // Calculate distance from home (you can implement this)
-      Serial.println("🏠 Distance from home: Calculating...");
-      Serial.println("   (Home location feature needs implementation)");
+    Waypoint home;
+    if (!Waypoint_getHome(&home)) {
+      Serial.println("🏠 No home set (use sethome)");
+    } else if (sensorData.gpsLat != 0 && sensorData.gpsLon != 0) {
+      printWaypointRange("🏠", home);
     } else {
       Serial.println("❌ No GPS fix available");
     }
   }
-  else if (cmd == "gpssats") {
-    Serial.printf("🛰️ Satellite Information:\n");
-    Serial.printf("   Satellites in view: %d\n", sensorData.gpsSatellites);
-    Serial.printf("   Signal quality: %s\n", sensorData.gpsSatellites > 5 ? "Excellent" : 
-                  sensorData.gpsSatellites > 3 ? "Good" : "Poor");
-  }
   else if (cmd == "gpsfix") {
     Serial.printf("🎯 GPS Fix Quality:\n");
     Serial.printf("   Satellites: %d\n", sensorData.gpsSatellites);
@@ -460,6 +587,16 @@ void processSerialCommand(const String& command) {
     Serial.printf("   Altitude: %.1f meters\n", sensorData.gpsAlt);
     Serial.printf("   Speed: %.1f km/h\n", sensorData.gpsSpeed);
     Serial.printf("   Coordinates: %.6f, %.6f\n", sensorData.gpsLat, sensorData.gpsLon);
+    GPSUartStats uart = GPSModule_getUartStats();
+    Serial.printf("   NMEA sentences: %lu | Checksum errors: %lu | Oversized: %lu\n",
+                  uart.sentences, uart.checksumErrors, uart.oversized);
+    Serial.printf("   UART overflows: %lu | Batches: %lu (max %lu sentences)\n",
+                  uart.overflows, uart.batches, uart.maxBatch);
+    Serial.printf("   UBX frames: %lu | UBX checksum errors: %lu | ACK: %lu | NAK: %lu\n",
+                  uart.ubxFrames, uart.ubxChecksumErrors, uart.acks, uart.naks);
+    if (uart.lastFixMicros != 0) {
+      Serial.printf("   Last fix received %lu ms ago\n", (micros() - uart.lastFixMicros) / 1000);
+    }
   }
   else if (cmd == "gpsclear") {
     Serial.println("🗑️ GPS data cleared");
@@ -469,10 +606,7 @@ void processSerialCommand(const String& command) {
   // Use full word commands instead to avoid conflicts with other modules
   // Additional GPS commands
   else if (cmd == "gpstrack") {
-    Serial.println("🗺️ GPS Track Information:");
-    Serial.printf("   Track points: %d\n", 0); // You can implement track counting
-    Serial.printf("   Total distance: %.1f km\n", 0.0); // You can implement distance calculation
-    Serial.println("   (Track recording feature needs implementation)");
+    TrackLog_printStatus();
   }
   else if (cmd == "gpsmode") {
     Serial.println("⚙️ GPS Mode Settings:");
@@ -487,9 +621,17 @@ void processSerialCommand(const String& command) {
     Serial.println("   (Calibration feature needs implementation)");
   }
   else if (cmd == "gpslog") {
-    Serial.println("📝 GPS Logging:");
-    Serial.println("   Toggle GPS data logging");
-    Serial.println("   (Logging feature needs implementation)");
+    if (TrackLog_isRecording()) TrackLog_stop();
+    else TrackLog_start();
+    Serial.printf("📝 GPS track logging %s\n", TrackLog_isRecording() ? "ON" : "OFF");
+  }
+  else if (cmd == "gpslog on" || cmd == "gpslog off") {
+    if (cmd == "gpslog on") TrackLog_start();
+    else TrackLog_stop();
+    Serial.printf("📝 GPS track logging %s\n", TrackLog_isRecording() ? "ON" : "OFF");
+  }
+  else if (cmd == "gpslogbench") {
+    TrackLog_runBenchmark();
   }
   else if (cmd == "gpsexport") {
     Serial.println("📤 GPS Data Export:");
@@ -497,7 +639,8 @@ void processSerialCommand(const String& command) {
     Serial.printf("   Altitude: %.1f meters\n", sensorData.gpsAlt);
     Serial.printf("   Speed: %.1f km/h\n", sensorData.gpsSpeed);
     Serial.printf("   Satellites: %d\n", sensorData.gpsSatellites);
-    Serial.println("   (Export to file feature needs implementation)");
+    Serial.printf("   Track files in %s:\n", TRACK_DIR);
+    TrackLog_printFiles();
   }
   else if (cmd == "gpsreset") {
     Serial.println("🔄 GPS Reset:");
@@ -532,8 +675,21 @@ void processSerialCommand(const String& command) {
   }
   else if (cmd == "gpshistory") {
     Serial.println("📚 GPS History:");
-    Serial.println("   Recent GPS data points:");
-    Serial.println("   (History feature needs implementation)");
+    TrackPoint points[TRACK_HISTORY];
+    uint8_t count = TrackLog_getHistory(points, TRACK_HISTORY);
+    if (count == 0) Serial.println("   No logged fixes (gpslog on)");
+    for (uint8_t i = 0; i < count; i++) {
+      const TrackPoint& p = points[i];
+      if (p.utcMs) {
+        uint32_t secondOfDay = (uint32_t)((p.utcMs / 1000) % 86400);
+        Serial.printf("   %02lu:%02lu:%02lu UTC", (unsigned long)(secondOfDay / 3600),
+                      (unsigned long)(secondOfDay / 60 % 60), (unsigned long)(secondOfDay % 60));
+      } else {
+        Serial.print("   --:--:--    ");
+      }
+      Serial.printf("  %.7f, %.7f  %.1f m  %.1f km/h  HDOP %.2f  %u sats\n", p.latE7 * 1e-7, p.lonE7 * 1e-7,
+                    p.altDm / 10.0f, p.speedCms * 0.036f, p.hdopCenti / 100.0f, p.satellites);
+    }
   }
   else if (cmd == "gpshealth") {
     Serial.println("🏥 GPS Health Status:");
@@ -551,17 +707,124 @@ void processSerialCommand(const String& command) {
     Serial.println("   Time sync functionality disabled to save memory");
   }
   else if (cmd == "gpswaypoint") {
-    Serial.println("📍 GPS Waypoint Management:");
     Serial.printf("   Current location: %.6f, %.6f\n", sensorData.gpsLat, sensorData.gpsLon);
-    Serial.println("   Available waypoints: 0");
-    Serial.println("   (Waypoint feature needs implementation)");
+    Waypoint_printList(sensorData.gpsLat, sensorData.gpsLon, 10);
+  }
+  else if (cmd.startsWith("gpswaypoint add ")) {
+    // gpswaypoint add [radius] <name>, at the current position
+    String rest = command.substring(16);
+    rest.trim();
+    uint16_t radius = WAYPOINT_DEFAULT_RADIUS_M;
+    int space = rest.indexOf(' ');
+    if (space > 0 && rest.substring(0, space).toInt() > 0) {
+      radius = rest.substring(0, space).toInt();
+      rest = rest.substring(space + 1);
+    }
+    if (sensorData.gpsLat == 0 && sensorData.gpsLon == 0) {
+      Serial.println("❌ No GPS fix available");
+    } else if (rest.isEmpty()) {
+      Serial.println("❌ Usage: gpswaypoint add [radius] <name>");
+    } else {
+      uint16_t id = Waypoint_add(rest.c_str(), sensorData.gpsLat, sensorData.gpsLon, radius);
+      if (id) Serial.printf("📍 Waypoint #%u saved: %s (%u m geofence)\n", id, rest.c_str(), min(radius, (uint16_t)WAYPOINT_MAX_RADIUS_M));
+      else Serial.println("❌ Waypoint store or grid cell full");
+    }
+  }
+  else if (cmd.startsWith("gpswaypoint del ")) {
+    int id = cmd.substring(16).toInt();
+    Serial.println(Waypoint_remove(id) ? "🗑️ Waypoint removed" : "❌ No such waypoint");
+  }
+  else if (cmd == "gpswaypoint stats") {
+    Waypoint_printStatus();
+  }
+  else if (cmd == "gpswaypointbench") {
+    Waypoint_runBenchmark();
+  }
+  else if (cmd == "poi") {
+    Poi_printStatus();
+  }
+  else if (cmd == "poi near") {
+    if (sensorData.gpsLat == 0 && sensorData.gpsLon == 0) {
+      Serial.println("❌ No GPS fix yet");
+    } else {
+      Poi_printNearby(sensorData.gpsLat, sensorData.gpsLon);
+    }
+  }
+  else if (cmd == "poi on" || cmd == "poi off") {
+    Poi_enableAnnouncements(cmd == "poi on");
+    Serial.printf("📍 POI announcements %s\n", Poi_areAnnouncementsEnabled() ? "enabled" : "disabled");
+  }
+  else if (cmd == "poibench") {
+    Poi_runBenchmark();
+  }
+  else if (cmd == "route") {
+    Route_printStatus();
+  }
+  else if (cmd == "route list") {
+    Route_printDirections();
+  }
+  else if (cmd == "route off") {
+    Route_cancel();
+    Serial.println("🧭 Route cancelled");
+  }
+  else if (cmd == "routebench") {
+    Route_runBenchmark();
+  }
+  else if (cmd.startsWith("route ")) {
+    // route <waypoint id>|home|<lat>,<lon>
+    String setting = cmd.substring(6);
+    setting.trim();
+    Waypoint target;
+    double toLat = 0, toLon = 0;
+    String name = setting;
+    int comma = setting.indexOf(',');
+    if (comma > 0) {
+      toLat = atof(setting.substring(0, comma).c_str());
+      toLon = atof(setting.substring(comma + 1).c_str());
+    } else {
+      uint16_t id = setting == "home" ? (Waypoint_getHome(&target) ? target.id : 0) : setting.toInt();
+      if (!id || !Waypoint_get(id, &target)) {
+        Serial.println("❌ No such waypoint (route <id>|home|<lat>,<lon>)");
+        return;
+      }
+      toLat = target.latE7 * 1e-7;
+      toLon = target.lonE7 * 1e-7;
+      name = target.name;
+    }
+    if (sensorData.gpsLat == 0 && sensorData.gpsLon == 0) {
+      Serial.println("❌ No GPS fix yet");
+    } else {
+      RouteError error = Route_request(sensorData.gpsLat, sensorData.gpsLon, toLat, toLon, name.c_str());
+      if (error == ROUTE_OK) Serial.printf("🧭 Planning a route to %s...\n", name.c_str());
+      else Serial.printf("❌ %s\n", Route_errorName(error));
+    }
   }
   else if (cmd == "gpsnavigation") {
     Serial.println("🧭 GPS Navigation:");
-    Serial.println("   Navigation mode: Disabled");
-    Serial.println("   Target: None set");
-    Serial.println("   Distance: N/A");
-    Serial.println("   (Navigation feature needs implementation)");
+    Waypoint target;
+    if (!Waypoint_getTarget() || !Waypoint_get(Waypoint_getTarget(), &target)) {
+      Serial.println("   Target: None set (gpsnavigation <id>|home)");
+    } else if (sensorData.gpsLat == 0 && sensorData.gpsLon == 0) {
+      Serial.printf("   Target: %s, waiting for a fix\n", target.name);
+    } else {
+      printWaypointRange("   Target", target);
+    }
+  }
+  else if (cmd.startsWith("gpsnavigation ")) {
+    String setting = cmd.substring(14);
+    Waypoint target;
+    if (setting == "off") {
+      Waypoint_setTarget(0);
+      Serial.println("🧭 Navigation stopped");
+    } else {
+      uint16_t id = setting.toInt();
+      if (setting == "home") id = Waypoint_getHome(&target) ? target.id : 0;
+      if (id && Waypoint_get(id, &target) && Waypoint_setTarget(id)) {
+        Serial.printf("🧭 Navigating to %s; arrival announced within %u m\n", target.name, target.radiusM);
+      } else {
+        Serial.println("❌ No such waypoint");
+      }
+    }
   }
   else if (cmd.startsWith("addroom")) {
     // Format: addroom <room_number> <card_uid>
@@ -852,7 +1115,7 @@ void processSerialCommand(const String& command) {
   else if (cmd == "reboot") {
     Serial.println("🔄 Rebooting system with full diagnostics...");
     audioManager.announceSerialStatement("Rebooting system");
-    delay(2000);  // Give time for audio to play
+    audioManager.waitUntilIdle(5000);  // Let queued audio finish
     ESP.restart();
   }
   else if (cmd == "startup") {
@@ -864,6 +1127,7 @@ void processSerialCommand(const String& command) {
     Serial.println("\n🔊 Audio Commands:");
     Serial.println("   audiotest    - Test audio system");
     Serial.println("   audiostatus  - Show audio system status");
+    Serial.println("   audiostop    - Stop speech and clear the queue");
     Serial.println("   announce     - Announce all sensor readings");
     Serial.println("\n📊 System Commands:");
     Serial.println("   systemstatus - Show system status with audio");
@@ -905,11 +1169,20 @@ void processSerialCommand(const String& command) {
   Serial.println("   bletest           - Run comprehensive BLE performance test");
   Serial.println("\n📱 BLE Commands:");
   Serial.println("   blestatus - Show BLE connection status");
+  Serial.println("\n📈 IMU Commands:");
+  Serial.println("   imustats  - Show IMU FIFO and sampling task jitter stats");
+  Serial.println("   imubench  - Check and benchmark the six-axis IMU preprocessing");
+  Serial.println("   gait      - Show cadence, stride variability, symmetry and speed");
+  Serial.println("   stepjournal - Show step journal segments, commits and boot recovery");
+  Serial.println("   blackbox  - Show fall black box status and last capture");
+  Serial.println("   blackboxsave - Save the last 5s of IMU data now (manual capture)");
   Serial.println("\n📡 ToF Mode Commands:");
   Serial.println("   radar     - Switch to RADAR mode (servo scanning)");
   Serial.println("   simple    - Switch to SIMPLE mode (fixed ToF)");
   Serial.println("   tofmode   - Show current ToF mode");
   Serial.println("   tofdiag   - Run ToF sensor diagnostics");
+  Serial.println("   tofprofile - Show ToF range profile and recent switches");
+  Serial.println("   tofbench  - Check and benchmark the ToF median/EMA filters");
   Serial.println("   tofreset  - Manual ToF sensor reset");
   Serial.println("   vibrate   - Test vibration motors");
   Serial.println("   testfeedback - Test buzzer-vibration sync");
@@ -947,18 +1220,42 @@ void processSerialCommand(const String& command) {
     Serial.println("   gpsload       - Load GPS config from SD card");
     Serial.println("   // GPS jamming status commands removed for performance");
     Serial.println("   gpsaccuracy   - Position accuracy assessment");
-    Serial.println("   gpsttff       - Time to first fix information");
+    Serial.println("   gpsttff       - Time to first fix: this start, aiding used, logged distribution per start type");
+    Serial.println("   gpsaid <save|clear> - Save receiver aiding data now / start cold next time");
     Serial.println("   gpsinfo       - Legacy detailed GPS information");
     Serial.println("   location      - Current coordinates");
     Serial.println("   sethome       - Set current location as home");
-    Serial.println("   home          - Distance from home point");
+    Serial.println("   home          - Distance and bearing to home");
+    Serial.println("   gpswaypoint   - Saved waypoints, nearest first");
+    Serial.println("   gpswaypoint add [radius] <name> - Save the current location with a geofence");
+    Serial.println("   gpswaypoint del <id> - Remove a waypoint");
+    Serial.println("   gpswaypoint stats - Waypoint grid, journal and per-fix geofence cost");
+    Serial.println("   gpswaypointbench - Geofence grid vs full scan self-test and cycles/fix");
+    Serial.println("   gpsnavigation [<id>|home|off] - Navigation target, distance and bearing");
+    Serial.println("   poi [near|on|off] - Offline POI index status, nearby POIs, announcements");
+    Serial.println("   poibench     - POI index tree vs full scan, query time and page reads");
+    Serial.println("   route [<id>|home|<lat>,<lon>|list|off] - Offline walking route, turn-by-turn");
+    Serial.println("   routebench   - A* vs Dijkstra self-test, ~2 km plan time from a cold cache");
+    Serial.println("   gpslog [on|off] - Record the GPS track to /tracks on the SD card");
+    Serial.println("   gpstrack      - Track session: fixes, distance, bytes per fix, SD writes");
+    Serial.println("   gpshistory    - Most recent logged fixes");
+    Serial.println("   gpsexport     - Current position and track files on the SD card");
+    Serial.println("   gpslogbench   - Track encoder round-trip self-test and projected day size");
     Serial.println("   gpstime       - GPS time display");
-    Serial.println("   gpsstats      - GPS statistics");
+    Serial.println("   gpsstats      - GPS statistics and UART ingestion counters");
+    Serial.println("   gpsstatus     - Fix, negotiated baud, output plan and link utilization");
+    Serial.println("   gpssats       - Satellites and SNR per constellation");
+    Serial.println("   gpstop3       - Top 3 satellites by signal quality");
+    Serial.println("   gpsview       - Every satellite in view");
+    Serial.println("   gpsparsebench - NMEA satellite parser self-test and cycles/sentence");
+    Serial.println("   gpsfilter     - GPS/step fusion state, error estimate and cycle cost");
+    Serial.println("   gpsfilter on|off - Fuse steps with fixes, or report raw fixes");
+    Serial.println("   gpsfilterbench - Fusion self-test on a synthetic walk with a GPS outage");
     Serial.println("\n🛰️ GPS Features:");
-    Serial.println("   • Multi-constellation: GPS + GLONASS + Galileo");
+    Serial.println("   • u-blox UBX binary protocol: NAV-POSLLH/SOL/VELNED/DOP/SVINFO, baud negotiated up to 115200");
     Serial.println("   • SBAS support: WAAS, EGNOS, MSAS, GAGAN");
     Serial.println("   • High-precision positioning with multiple GNSS systems");
-    Serial.println("   • Kalman filtering for improved accuracy");
+    Serial.println("   • Step/IMU dead reckoning fused with fixes in an EKF (smooth, coasts through outages)");
     Serial.println("   • Configurable 1-5Hz update rates");
     Serial.println("   • Persistent configuration storage on SD card");
     Serial.println("\n🔍 Diagnostic Commands:");
@@ -967,6 +1264,8 @@ void processSerialCommand(const String& command) {
     Serial.println("   systemstatus  - Show current system status");
     Serial.println("   reboot        - Restart system with full diagnostics");
     Serial.println("   startup       - Show startup message again");
+    Serial.println("   logstats      - Show deferred log ring usage, drops and rate limits");
+    Serial.println("   logmode text|binary - Switch deferred log output format");
   }
   // High-Speed BLE Performance Commands
   else if (cmd == "blestats") {
@@ -1020,6 +1319,7 @@ void processSerialCommand(const String& command) {
 void setup() {
   Serial.begin(115200);
   delay(1000); // Allow serial to stabilize
+  Log_begin();
   
   // Initialize Diagnostic UI
   DiagnosticUI::init();
@@ -1132,6 +1432,10 @@ void setup() {
   DiagnosticUI::showCalibrationStatus("GPS Configuration", SENSOR_CALIBRATING);
   GPSModule_init();
   DiagnosticUI::showCalibrationStatus("GPS Configuration", SENSOR_CALIBRATED, "Outdoor positioning ready");
+  Waypoint_begin();
+  Poi_begin();
+  Route_begin();
+  TrackLog_begin();
   
   // Show system configuration
   DiagnosticUI::showCalibrationStatus("Max Range", SENSOR_CALIBRATED, "3500 cm");
@@ -1167,9 +1471,28 @@ void loop() {
     EnvMonitor_update(&sensorData);
     LightSensor_update(&sensorData);
     IMU_update(&sensorData);
+    // A confirmed fall is also spoken; the IMU module drives the buzzer and motors
+    static FallState lastFallState = FALL_NONE;
+    FallState fallState = IMU_getFallState();
+    if (fallState == FALL_CONFIRMED && lastFallState != FALL_CONFIRMED) audioManager.playFallDetected();
+    lastFallState = fallState;
     ToF_update(&sensorData);  // This will now run at full speed!
+    BlackBox_setRange((uint16_t)sensorData.tofDistance);
+    
+    // Drop-off / step hazards get their own announcement (rate limited by the detector)
+    switch (DropOff_takeAnnouncement()) {
+      case HAZARD_DROP: audioManager.playStairsDown(); break;
+      case HAZARD_STEP_UP: audioManager.playStairsAhead(); break;
+      default: break;
+    }
     RFID_update(&sensorData);
     GPSModule_update(&sensorData);
+    WaypointEvent waypointEvent;
+    while (Waypoint_takeEvent(&waypointEvent)) announceWaypoint(waypointEvent);
+    PoiResult nearbyPoi;
+    while (Poi_takeAnnouncement(&nearbyPoi)) announcePoi(nearbyPoi);
+    RouteEvent routeEvent;
+    while (Route_takeEvent(&routeEvent)) announceRoute(routeEvent);
 
     // Process audio feedback for sensor changes
     SensorData previousData;
@@ -1190,6 +1513,7 @@ void loop() {
     if (BLEManager::isConnected()) {
       // Send step updates immediately when step count changes
       BLEManager::sendStepUpdateIfChanged(sensorData.dailySteps);
+      BLEManager::sendGaitUpdateIfChanged(IMU_getGaitMetrics());
       
       // Use optimized batched transmission for better performance
       if (loopCounter % 10 == 0) {  // Send every 10 loops (still very fast)
@@ -1,5 +1,36 @@
 #include "AudioFeedbackManager.h"
 #include "SDCardManager.h"
+#include "freertos/task.h"
+
+#define AUDIO_TASK_STACK_SIZE 4096
+#define AUDIO_WRITER_PRIORITY 3         // Above the reader: the DMA must not run dry
+#define AUDIO_READER_PRIORITY 2
+#define AUDIO_TASK_CORE 0               // The sensor loop keeps core 1 to itself
+#define AUDIO_NO_BUFFER 0xFF
+#define AUDIO_NO_ENTRY 0xFF
+#define AUDIO_CHUNK_START 0x01          // First chunk of a phrase: latency, gap after the previous one
+#define AUDIO_CHUNK_END 0x02            // End marker: report completion
+#define AUDIO_CHUNK_FAILED 0x04         // No clip of the phrase could be played
+#define AUDIO_SLOT_FREE 0
+#define AUDIO_SLOT_PENDING 1
+#define AUDIO_SLOT_PLAYING 2
+
+static portMUX_TYPE phraseMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Preloaded at boot and never evicted: the alerts that must not wait for SD
+static const char* const PINNED_CLIPS[] = {
+    CRITICAL_AUDIO_PATH "/obstacle_ahead.wav",
+    CRITICAL_AUDIO_PATH "/emergency_alert.wav",
+    CRITICAL_AUDIO_PATH "/fall_detected.wav",
+    CRITICAL_AUDIO_PATH "/low_battery.wav",
+};
+
+// FNV-1a
+static uint32_t pathHash(const char* path) {
+    uint32_t hash = 2166136261u;
+    while (*path) hash = (hash ^ (uint8_t)*path++) * 16777619u;
+    return hash;
+}
 
 // Global instance definition
 AudioFeedbackManager audioManager;
@@ -7,11 +38,24 @@ AudioFeedbackManager audioManager;
 AudioFeedbackManager::AudioFeedbackManager() {
     audioInitialized = false;
     sdCardAvailable = false;
-    lastPlayTime = 0;
-    queueHead = 0;
-    queueTail = 0;
-    queueSize = 0;
     mappingCount = 0;
+    phrases = nullptr;
+    memset(&building, 0, sizeof(building));
+    buildDepth = 0;
+    readerHandle = nullptr;
+    freeChunks = nullptr;
+    fullChunks = nullptr;
+    chunkData = nullptr;
+    clipCache = nullptr;
+    cacheClock = 0;
+    nextRequestId = 0;
+    playCounter = 0;
+    preemptSeq = 0;
+    cancelSeq = 0;
+    pendingRequests = 0;
+    idleSinceMs = 0;
+    doneCallback = nullptr;
+    memset(&stats, 0, sizeof(stats));
 }
 
 AudioFeedbackManager::~AudioFeedbackManager() {
@@ -22,7 +66,7 @@ bool AudioFeedbackManager::initialize() {
     Serial.println("[AudioManager] Initializing audio system...");
     
     // Check SD card availability
-    if (!SDCardManager::isInitialized() {
+    if (SD.cardType() == CARD_NONE) {
         Serial.println("[AudioManager] SD card not available");
         sdCardAvailable = false;
         return false;
@@ -37,6 +81,14 @@ bool AudioFeedbackManager::initialize() {
         return false;
     }
     
+    // Critical alerts into PSRAM before anything can ask for them
+    preloadClips();
+    
+    if (!startTasks()) {
+        Serial.println("[AudioManager] Failed to start playback tasks");
+        return false;
+    }
+    
     // Initialize serial statement mappings
     initializeSerialMappings();
     
@@ -142,65 +194,6 @@ bool AudioFeedbackManager::fileExists(const String& path) {
     return false;
 }
 
-bool AudioFeedbackManager::playAudioFile(const String& filePath) {
-    if (!isAudioReady()) {
-        Serial.println("[AudioManager] Audio system not ready");
-        return false;
-    }
-    
-    // Check minimum interval between plays
-    unsigned long currentTime = millis();
-    if (currentTime - lastPlayTime < MIN_PLAY_INTERVAL) {
-        Serial.println("[AudioManager] Audio play rate limited");
-        return false;
-    }
-    
-    if (!fileExists(filePath)) {
-        Serial.printf("[AudioManager] Audio file not found: %s\n", filePath.c_str());
-        return false;
-    }
-    
-    bool success = loadAndPlayWAV(filePath);
-    if (success) {
-        lastPlayTime = currentTime;
-        Serial.printf("[AudioManager] Played: %s\n", filePath.c_str());
-    }
-    
-    return success;
-}
-
-bool AudioFeedbackManager::loadAndPlayWAV(const String& filePath) {
-    File audioFile = SD.open(filePath);
-    if (!audioFile) {
-        Serial.printf("[AudioManager] Failed to open: %s\n", filePath.c_str());
-        return false;
-    }
-    
-    uint32_t dataSize;
-    uint32_t sampleRate;
-    
-    if (!parseWAVHeader(audioFile, dataSize, sampleRate)) {
-        Serial.println("[AudioManager] Invalid WAV file format");
-        audioFile.close();
-        return false;
-    }
-    
-    // Adjust I2S sample rate if needed
-    if (sampleRate != AUDIO_SAMPLE_RATE) {
-        i2s_set_sample_rates(I2S_NUM_0, sampleRate);
-    }
-    
-    playAudioData(audioFile, dataSize);
-    
-    // Reset to default sample rate
-    if (sampleRate != AUDIO_SAMPLE_RATE) {
-        i2s_set_sample_rates(I2S_NUM_0, AUDIO_SAMPLE_RATE);
-    }
-    
-    audioFile.close();
-    return true;
-}
-
 bool AudioFeedbackManager::parseWAVHeader(File& file, uint32_t& dataSize, uint32_t& sampleRate) {
     // Simple WAV header parsing
     file.seek(0);
@@ -244,31 +237,628 @@ bool AudioFeedbackManager::parseWAVHeader(File& file, uint32_t& dataSize, uint32
     return false;
 }
 
-void AudioFeedbackManager::playAudioData(File& file, uint32_t dataSize) {
-    const size_t bufferSize = 1024;
-    uint8_t buffer[bufferSize];
-    size_t bytesWritten;
-    
-    uint32_t totalBytesRead = 0;
-    
-    while (totalBytesRead < dataSize && file.available()) {
-        size_t bytesToRead = min(bufferSize, dataSize - totalBytesRead);
-        size_t bytesRead = file.read(buffer, bytesToRead);
+bool AudioFeedbackManager::playAudioFile(const String& filePath) {
+    if (!isAudioReady()) {
+        Serial.println("[AudioManager] Audio system not ready");
+        return false;
+    }
+    return playClip(filePath.c_str(), AUDIO_PRIORITY_INFO);
+}
+
+bool AudioFeedbackManager::playClip(const char* filePath, AudioPriority priority, AudioKey key) {
+    if (!isAudioReady()) return false;
+    beginPhrase(priority, key);
+    addClip(filePath, leadGap());
+    return endPhrase() != 0 || buildDepth > 0;
+}
+
+// ============= Phrase Scheduler =============
+
+void AudioFeedbackManager::beginPhrase(AudioPriority priority, AudioKey key, uint32_t maxAgeMs) {
+    if (buildDepth++ > 0) {
+        // Nested: the enclosing phrase keeps its key and deadline
+        if (priority > building.priority) building.priority = priority;
+        return;
+    }
+    building.priority = priority;
+    building.key = key;
+    building.clipCount = 0;
+    if (maxAgeMs == 0) {
+        maxAgeMs = priority == AUDIO_PRIORITY_CRITICAL     ? AUDIO_MAX_AGE_CRITICAL_MS
+                   : priority == AUDIO_PRIORITY_NAVIGATION ? AUDIO_MAX_AGE_NAVIGATION_MS
+                                                           : AUDIO_MAX_AGE_INFO_MS;
+    }
+    building.maxAgeMs = maxAgeMs;
+}
+
+uint32_t AudioFeedbackManager::endPhrase() {
+    if (buildDepth == 0 || --buildDepth > 0) return 0;
+    if (building.clipCount == 0 || !isAudioReady() || !phrases) return 0;
+    building.id = ++nextRequestId;
+    building.queuedMs = millis();
+    return submitPhrase(building) ? building.id : 0;
+}
+
+void AudioFeedbackManager::addClip(const String& filePath, uint16_t gapMs) {
+    if (buildDepth == 0) {
+        // A lone announce* word outside any phrase
+        beginPhrase(AUDIO_PRIORITY_INFO);
+        addClip(filePath, gapMs);
+        endPhrase();
+        return;
+    }
+    if (building.clipCount >= AUDIO_PHRASE_CLIPS) {
+        Serial.printf("[AudioManager] Phrase too long, clip skipped: %s\n", filePath.c_str());
+        return;
+    }
+    AudioClip& clip = building.clips[building.clipCount++];
+    clip.gapMs = gapMs;
+    strncpy(clip.path, filePath.c_str(), sizeof(clip.path) - 1);
+    clip.path[sizeof(clip.path) - 1] = '\0';
+}
+
+uint16_t AudioFeedbackManager::leadGap() const {
+    return buildDepth > 0 && building.clipCount > 0 ? AUDIO_PHRASE_GAP_MS : 0;
+}
+
+bool AudioFeedbackManager::sameClips(const AudioPhrase& a, const AudioPhrase& b) const {
+    if (a.clipCount != b.clipCount) return false;
+    for (uint8_t i = 0; i < a.clipCount; i++) {
+        if (strcmp(a.clips[i].path, b.clips[i].path) != 0) return false;
+    }
+    return true;
+}
+
+// Into a slot: replaces a waiting phrase with the same key (or the same clips
+// when unkeyed), else a free slot, else evicts the least urgent waiting phrase
+// if it is not more urgent than this one. A critical phrase cuts off whatever
+// lower-priority phrase the reader or writer is on.
+bool AudioFeedbackManager::submitPhrase(const AudioPhrase& phrase) {
+    uint32_t replacedId = 0;
+    bool coalesced = false;
+    int slot = -1;
+    portENTER_CRITICAL(&phraseMux);
+    for (int i = 0; i < AUDIO_PHRASE_SLOTS && slot < 0; i++) {
+        const AudioPhrase& other = phrases[i];
+        if (other.state != AUDIO_SLOT_PENDING) continue;
+        if (phrase.key != AUDIO_KEY_NONE ? other.key == phrase.key
+                                         : other.key == AUDIO_KEY_NONE && sameClips(other, phrase)) {
+            slot = i;
+            coalesced = true;
+        }
+    }
+    for (int i = 0; i < AUDIO_PHRASE_SLOTS && slot < 0; i++) {
+        if (phrases[i].state == AUDIO_SLOT_FREE) slot = i;
+    }
+    if (slot < 0) {
+        int victim = -1;
+        for (int i = 0; i < AUDIO_PHRASE_SLOTS; i++) {
+            const AudioPhrase& other = phrases[i];
+            if (other.state != AUDIO_SLOT_PENDING) continue;
+            if (victim < 0 || other.priority < phrases[victim].priority ||
+                (other.priority == phrases[victim].priority && other.id < phrases[victim].id)) {
+                victim = i;
+            }
+        }
+        if (victim >= 0 && phrases[victim].priority <= phrase.priority) slot = victim;
+    }
+    if (slot >= 0) {
+        if (phrases[slot].state == AUDIO_SLOT_PENDING) replacedId = phrases[slot].id;
+        memcpy(&phrases[slot], &phrase, sizeof(AudioPhrase));
+        phrases[slot].state = AUDIO_SLOT_PENDING;
+        pendingRequests++;
+        if (phrase.priority == AUDIO_PRIORITY_CRITICAL) preemptSeq = playCounter;
+    }
+    portEXIT_CRITICAL(&phraseMux);
+
+    if (slot < 0) {
+        stats.dropped++;
+        Serial.printf("[AudioManager] Queue full, dropped: %s\n", phrase.clips[0].path);
+        if (doneCallback) doneCallback(phrase.id, false);
+        return false;
+    }
+    stats.queued++;
+    if (replacedId) {
+        if (coalesced) stats.coalesced++;
+        else stats.dropped++;
+        finishPhrase(replacedId, false);
+    }
+    if (readerHandle) xTaskNotifyGive(readerHandle);
+    return true;
+}
+
+// Reader task: the most urgent waiting phrase (oldest first within a
+// priority), dropping any that waited too long; -1 if none
+int AudioFeedbackManager::takeNextPhrase() {
+    uint32_t expiredIds[AUDIO_PHRASE_SLOTS];
+    uint8_t expiredCount = 0;
+    int best = -1;
+    uint32_t now = millis();
+    portENTER_CRITICAL(&phraseMux);
+    for (int i = 0; i < AUDIO_PHRASE_SLOTS; i++) {
+        AudioPhrase& phrase = phrases[i];
+        if (phrase.state != AUDIO_SLOT_PENDING) continue;
+        if (now - phrase.queuedMs > phrase.maxAgeMs) {
+            phrase.state = AUDIO_SLOT_FREE;
+            expiredIds[expiredCount++] = phrase.id;
+            continue;
+        }
+        if (best < 0 || phrase.priority > phrases[best].priority ||
+            (phrase.priority == phrases[best].priority && phrase.id < phrases[best].id)) {
+            best = i;
+        }
+    }
+    if (best >= 0) {
+        phrases[best].state = AUDIO_SLOT_PLAYING;
+        phrases[best].playSeq = ++playCounter;
+    }
+    portEXIT_CRITICAL(&phraseMux);
+
+    for (uint8_t i = 0; i < expiredCount; i++) {
+        stats.expired++;
+        Serial.printf("[AudioManager] Announcement %lu expired\n", (unsigned long)expiredIds[i]);
+        finishPhrase(expiredIds[i], false);
+    }
+    return best;
+}
+
+// Writer task: a phrase cut off by a critical one goes back to the queue to
+// be played again from the start, unless its deadline has passed or a newer
+// phrase with its key is waiting
+bool AudioFeedbackManager::requeuePhrase(uint8_t slot) {
+    AudioPhrase& phrase = phrases[slot];
+    bool requeued = millis() - phrase.queuedMs <= phrase.maxAgeMs;
+    portENTER_CRITICAL(&phraseMux);
+    for (int i = 0; i < AUDIO_PHRASE_SLOTS && requeued && phrase.key != AUDIO_KEY_NONE; i++) {
+        if (phrases[i].state == AUDIO_SLOT_PENDING && phrases[i].key == phrase.key) requeued = false;
+    }
+    if (requeued) phrase.state = AUDIO_SLOT_PENDING;
+    portEXIT_CRITICAL(&phraseMux);
+    if (requeued) xTaskNotifyGive(readerHandle);
+    return requeued;
+}
+
+void AudioFeedbackManager::releasePhrase(uint8_t slot) {
+    portENTER_CRITICAL(&phraseMux);
+    phrases[slot].state = AUDIO_SLOT_FREE;
+    portEXIT_CRITICAL(&phraseMux);
+}
+
+void AudioFeedbackManager::finishPhrase(uint32_t id, bool played) {
+    idleSinceMs = millis();
+    __atomic_sub_fetch(&pendingRequests, 1, __ATOMIC_RELAXED);
+    if (doneCallback) doneCallback(id, played);
+}
+
+bool AudioFeedbackManager::isCutOff(uint32_t playSeq, uint8_t priority) const {
+    return playSeq <= cancelSeq || (priority < AUDIO_PRIORITY_CRITICAL && playSeq <= preemptSeq);
+}
+
+void AudioFeedbackManager::clearQueue() {
+    uint32_t clearedIds[AUDIO_PHRASE_SLOTS];
+    uint8_t clearedCount = 0;
+    if (!phrases) return;
+    portENTER_CRITICAL(&phraseMux);
+    for (int i = 0; i < AUDIO_PHRASE_SLOTS; i++) {
+        if (phrases[i].state != AUDIO_SLOT_PENDING) continue;
+        phrases[i].state = AUDIO_SLOT_FREE;
+        clearedIds[clearedCount++] = phrases[i].id;
+    }
+    cancelSeq = playCounter;
+    portEXIT_CRITICAL(&phraseMux);
+    for (uint8_t i = 0; i < clearedCount; i++) {
+        stats.dropped++;
+        finishPhrase(clearedIds[i], false);
+    }
+}
+
+bool AudioFeedbackManager::isBusy() const {
+    return pendingRequests > 0;
+}
+
+bool AudioFeedbackManager::waitUntilIdle(uint32_t timeoutMs) {
+    uint32_t start = millis();
+    while (millis() - start < timeoutMs) {
+        if (pendingRequests == 0 && millis() - idleSinceMs >= AUDIO_DMA_MS) return true;
+        delay(10);
+    }
+    return false;
+}
+
+void AudioFeedbackManager::setDoneCallback(AudioDoneCallback callback) {
+    doneCallback = callback;
+}
+
+AudioStats AudioFeedbackManager::getStats() const {
+    return stats;
+}
+
+void AudioFeedbackManager::printStatus() {
+    AudioStats s = getStats();
+    Serial.printf("   Phrases: %lu pending, %lu queued, %lu played, %lu dropped\n",
+                  (unsigned long)pendingRequests, (unsigned long)s.queued, (unsigned long)s.played,
+                  (unsigned long)s.dropped);
+    Serial.printf("   Replaced by newer: %lu, expired: %lu, cut off: %lu, failed clips: %lu\n",
+                  (unsigned long)s.coalesced, (unsigned long)s.expired, (unsigned long)s.preempted,
+                  (unsigned long)s.failed);
+    Serial.printf("   Start latency: %lu ms last, %lu ms max; slowest SD chunk read %lu ms\n",
+                  (unsigned long)s.lastStartMs, (unsigned long)s.maxStartMs, (unsigned long)s.maxReadMs);
+    Serial.printf("   Last phrase: %lu ms of audio\n", (unsigned long)s.lastPhraseMs);
+    if (clipCache) {
+        Serial.printf("   Clip cache: %u clips (%u pinned), %lu/%u KB; %lu hits, %lu loads, %lu evictions\n",
+                      s.cacheEntries, s.cachePinned, (unsigned long)(s.cacheBytes / 1024), AUDIO_CACHE_BYTES / 1024,
+                      (unsigned long)s.cacheHits, (unsigned long)s.cacheLoads, (unsigned long)s.cacheEvictions);
+    } else {
+        Serial.println("   Clip cache: off (no PSRAM)");
+    }
+}
+
+// ============= Streaming Tasks =============
+
+bool AudioFeedbackManager::startTasks() {
+    size_t phraseBytes = AUDIO_PHRASE_SLOTS * sizeof(AudioPhrase);
+    phrases = (AudioPhrase*)(psramFound() ? ps_malloc(phraseBytes) : malloc(phraseBytes));
+    chunkData = (uint8_t*)malloc(AUDIO_CHUNK_POOL * AUDIO_CHUNK_BYTES);
+    freeChunks = xQueueCreate(AUDIO_CHUNK_POOL, sizeof(uint8_t));
+    fullChunks = xQueueCreate(AUDIO_CHUNK_POOL + 1, sizeof(AudioChunk));   // + the end marker
+    if (!phrases || !chunkData || !freeChunks || !fullChunks) return false;
+    memset(phrases, 0, phraseBytes);
+    for (uint8_t i = 0; i < AUDIO_CHUNK_POOL; i++) xQueueSend(freeChunks, &i, 0);
+    TaskHandle_t writer = nullptr;
+    xTaskCreatePinnedToCore(writerTask, "AudioOut", AUDIO_TASK_STACK_SIZE, this, AUDIO_WRITER_PRIORITY, &writer,
+                            AUDIO_TASK_CORE);
+    xTaskCreatePinnedToCore(readerTask, "AudioRead", AUDIO_TASK_STACK_SIZE, this, AUDIO_READER_PRIORITY,
+                            &readerHandle, AUDIO_TASK_CORE);
+    return readerHandle && writer;
+}
+
+void AudioFeedbackManager::readerTask(void* parameter) {
+    AudioFeedbackManager* self = (AudioFeedbackManager*)parameter;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int slot;
+        while ((slot = self->takeNextPhrase()) >= 0) self->streamPhrase(self->phrases[slot]);
+    }
+}
+
+// Reader task: the phrase's clips into chunks for the writer, from the clip
+// cache or from SD via the chunk pool; blocks only on a free chunk, i.e.
+// while the writer is still busy. Cached clips are trimmed, and a cached word
+// followed by one with no gap keeps its last AUDIO_CROSSFADE_MS back to be
+// mixed with the next word's start. Cut off by a critical phrase, it stops
+// at the next chunk. The slot stays taken until the writer has the end marker.
+void AudioFeedbackManager::streamPhrase(AudioPhrase& phrase) {
+    AudioChunk chunk = {nullptr, AUDIO_NO_BUFFER, AUDIO_NO_ENTRY, AUDIO_CHUNK_START, phrase.priority,
+                        (uint8_t)(&phrase - phrases), 0, 0, phrase.id, phrase.playSeq, AUDIO_SAMPLE_RATE,
+                        phrase.queuedMs};
+    bool cutOff = false;
+    uint8_t played = 0;
+    int held = -1;                                  // Cached word whose end is held back
+    uint32_t heldOffset = 0;
+    for (uint8_t i = 0; i < phrase.clipCount && !cutOff; i++) {
+        const AudioClip& clip = phrase.clips[i];
+        uint32_t hash = pathHash(clip.path);
+        int entry = clipCache ? findCachedClip(clip.path, hash) : -1;
+        uint32_t remaining = 0;
+        uint32_t sampleRate = AUDIO_SAMPLE_RATE;
+        File file;
+        if (entry >= 0) {
+            stats.cacheHits++;
+        } else {
+            file = SD.open(clip.path);
+            if (!file || !parseWAVHeader(file, remaining, sampleRate)) {
+                Serial.printf("[AudioManager] Audio file %s: %s\n", file ? "invalid" : "not found", clip.path);
+                if (file) file.close();
+                stats.failed++;
+                continue;
+            }
+            if (clipCache && isCacheable(clip.path) && remaining <= AUDIO_CACHE_CLIP_MAX) {
+                entry = cacheClip(file, clip.path, hash, remaining, sampleRate, false);
+            }
+        }
+        uint32_t begin = 0, end = 0;
+        if (entry >= 0) {
+            if (file) file.close();
+            begin = clipCache[entry].trimStart;
+            end = clipCache[entry].trimEnd;
+            sampleRate = clipCache[entry].sampleRate;
+        }
+        uint32_t fadeBytes = sampleRate * AUDIO_CROSSFADE_MS / 1000 * sizeof(int16_t);
         
-        if (bytesRead == 0) break;
+        // The previous word's held end: mixed into this word, or played as it is
+        if (held >= 0) {
+            if (entry >= 0 && clip.gapMs == 0 && clipCache[held].sampleRate == sampleRate &&
+                end - begin >= 2 * fadeBytes) {
+                cutOff = !sendCrossfade(chunk, phrase, held, heldOffset, entry, begin, fadeBytes);
+                begin += fadeBytes;
+            } else {
+                cutOff = !sendCached(chunk, phrase, held, heldOffset, clipCache[held].trimEnd);
+            }
+            __atomic_sub_fetch(&clipCache[held].refs, 1, __ATOMIC_RELAXED);
+            held = -1;
+            if (cutOff) {
+                if (file) file.close();
+                break;
+            }
+        }
         
-        // Write to I2S
-        esp_err_t err = i2s_write(I2S_NUM_0, buffer, bytesRead, &bytesWritten, portMAX_DELAY);
-        if (err != ESP_OK) {
-            Serial.printf("[AudioManager] I2S write error: %s\n", esp_err_to_name(err));
+        chunk.gapMs = played > 0 ? clip.gapMs : 0;
+        if (entry >= 0) {
+            uint32_t bodyEnd = end;
+            if (i + 1 < phrase.clipCount && phrase.clips[i + 1].gapMs == 0 && end - begin >= 2 * fadeBytes) {
+                bodyEnd = end - fadeBytes;
+            }
+            cutOff = !sendCached(chunk, phrase, entry, begin, bodyEnd);
+            if (!cutOff && bodyEnd < end) {
+                // Not evicted while held, even if the next word has to be loaded
+                __atomic_add_fetch(&clipCache[entry].refs, 1, __ATOMIC_RELAXED);
+                held = entry;
+                heldOffset = bodyEnd;
+            }
+        } else {
+            chunk.sampleRate = sampleRate;
+            cutOff = !sendFile(chunk, phrase, file, remaining);
+            file.close();
+        }
+        played++;
+    }
+    if (held >= 0) {
+        if (!cutOff) cutOff = !sendCached(chunk, phrase, held, heldOffset, clipCache[held].trimEnd);
+        __atomic_sub_fetch(&clipCache[held].refs, 1, __ATOMIC_RELAXED);
+    }
+
+    // The writer reports the phrase on this marker, or requeues it if cut off
+    chunk.data = nullptr;
+    chunk.buffer = AUDIO_NO_BUFFER;
+    chunk.flags |= AUDIO_CHUNK_END | (played ? 0 : AUDIO_CHUNK_FAILED);
+    chunk.length = 0;
+    chunk.gapMs = 0;
+    xQueueSend(fullChunks, &chunk, portMAX_DELAY);
+}
+
+// Chunks pointing into a cached clip; false if the phrase was cut off
+bool AudioFeedbackManager::sendCached(AudioChunk& chunk, const AudioPhrase& phrase, int entry, uint32_t begin,
+                                      uint32_t end) {
+    CachedClip& cached = clipCache[entry];
+    chunk.sampleRate = cached.sampleRate;
+    chunk.buffer = AUDIO_NO_BUFFER;
+    chunk.cacheEntry = entry;
+    bool sent = true;
+    for (uint32_t offset = begin; offset < end;) {
+        if (isCutOff(phrase.playSeq, phrase.priority)) {
+            sent = false;
             break;
         }
-        
-        totalBytesRead += bytesRead;
+        chunk.data = cached.data + offset;
+        chunk.length = min((uint32_t)AUDIO_CHUNK_BYTES, end - offset);
+        offset += chunk.length;
+        __atomic_add_fetch(&cached.refs, 1, __ATOMIC_RELAXED);
+        xQueueSend(fullChunks, &chunk, portMAX_DELAY);
+        chunk.flags = 0;
+        chunk.gapMs = 0;
+    }
+    chunk.cacheEntry = AUDIO_NO_ENTRY;
+    return sent;
+}
+
+// The end of one cached word faded out over the start of the next, into a
+// pool chunk
+bool AudioFeedbackManager::sendCrossfade(AudioChunk& chunk, const AudioPhrase& phrase, int fromEntry,
+                                         uint32_t fromOffset, int toEntry, uint32_t toOffset, uint32_t bytes) {
+    if (isCutOff(phrase.playSeq, phrase.priority)) return false;
+    xQueueReceive(freeChunks, &chunk.buffer, portMAX_DELAY);
+    int16_t* out = (int16_t*)(chunkData + chunk.buffer * AUDIO_CHUNK_BYTES);
+    const int16_t* from = (const int16_t*)(clipCache[fromEntry].data + fromOffset);
+    const int16_t* to = (const int16_t*)(clipCache[toEntry].data + toOffset);
+    int32_t samples = bytes / sizeof(int16_t);
+    for (int32_t k = 0; k < samples; k++) {
+        out[k] = (int16_t)((from[k] * (samples - k) + to[k] * k) / samples);
+    }
+    chunk.data = (const uint8_t*)out;
+    chunk.length = bytes;
+    chunk.sampleRate = clipCache[toEntry].sampleRate;
+    xQueueSend(fullChunks, &chunk, portMAX_DELAY);
+    chunk.flags = 0;
+    chunk.gapMs = 0;
+    return true;
+}
+
+// A clip streamed from SD through the chunk pool; false if the phrase was cut off
+bool AudioFeedbackManager::sendFile(AudioChunk& chunk, const AudioPhrase& phrase, File& file, uint32_t remaining) {
+    do {
+        if (isCutOff(phrase.playSeq, phrase.priority)) return false;
+        xQueueReceive(freeChunks, &chunk.buffer, portMAX_DELAY);
+        uint8_t* buffer = chunkData + chunk.buffer * AUDIO_CHUNK_BYTES;
+        uint32_t start = millis();
+        size_t want = min((uint32_t)AUDIO_CHUNK_BYTES, remaining);
+        size_t got = want ? file.read(buffer, want) : 0;
+        uint32_t elapsed = millis() - start;
+        if (elapsed > stats.maxReadMs) stats.maxReadMs = elapsed;
+        remaining = got < want ? 0 : remaining - got;
+        chunk.data = buffer;
+        chunk.length = got & ~1;                    // Whole 16-bit samples
+        xQueueSend(fullChunks, &chunk, portMAX_DELAY);
+        chunk.flags = 0;
+        chunk.gapMs = 0;
+    } while (remaining > 0);
+    return true;
+}
+
+void AudioFeedbackManager::writerTask(void* parameter) {
+    AudioFeedbackManager* self = (AudioFeedbackManager*)parameter;
+    uint32_t currentRate = AUDIO_SAMPLE_RATE;
+    uint32_t silencedSeq = 0;                       // Last phrase whose queued audio was flushed
+    uint32_t lastSoundMs = 0;                       // End of the last phrase handed to I2S
+    uint32_t phraseBytes = 0;                       // Of the current phrase, silence included
+    AudioChunk chunk;
+    size_t written;
+    for (;;) {
+        if (xQueueReceive(self->fullChunks, &chunk, portMAX_DELAY) != pdTRUE) continue;
+        bool cutOff = self->isCutOff(chunk.playSeq, chunk.priority);
+        if (cutOff && silencedSeq != chunk.playSeq) {
+            i2s_zero_dma_buffer(I2S_NUM_0);         // Stop mid-word rather than finish the DMA
+            silencedSeq = chunk.playSeq;
+        }
+        if (!cutOff && chunk.data) {
+            if (chunk.sampleRate != currentRate) {
+                i2s_set_sample_rates(I2S_NUM_0, chunk.sampleRate);
+                currentRate = chunk.sampleRate;
+            }
+            if (chunk.flags & AUDIO_CHUNK_START) {
+                // Still sounding the previous phrase: separate the two
+                phraseBytes = 0;
+                if (lastSoundMs && millis() - lastSoundMs < AUDIO_DMA_MS) self->writeSilence(AUDIO_PHRASE_GAP_MS, currentRate);
+                self->stats.lastStartMs = millis() - chunk.queuedMs;
+                if (self->stats.lastStartMs > self->stats.maxStartMs) self->stats.maxStartMs = self->stats.lastStartMs;
+            }
+            if (chunk.gapMs) phraseBytes += self->writeSilence(chunk.gapMs, currentRate);
+            if (chunk.length) {
+                i2s_write(I2S_NUM_0, chunk.data, chunk.length, &written, portMAX_DELAY);
+                phraseBytes += chunk.length;
+            }
+        }
+        if (chunk.buffer != AUDIO_NO_BUFFER) xQueueSend(self->freeChunks, &chunk.buffer, 0);
+        if (chunk.cacheEntry != AUDIO_NO_ENTRY) {
+            __atomic_sub_fetch(&self->clipCache[chunk.cacheEntry].refs, 1, __ATOMIC_RELAXED);
+        }
+        if (chunk.flags & AUDIO_CHUNK_END) {
+            if (cutOff && chunk.playSeq > self->cancelSeq && self->requeuePhrase(chunk.slot)) continue;
+            self->releasePhrase(chunk.slot);
+            bool played = !cutOff && !(chunk.flags & AUDIO_CHUNK_FAILED);
+            if (played) {
+                self->stats.played++;
+                self->stats.lastPhraseMs = (uint64_t)phraseBytes * 1000 / (currentRate * sizeof(int16_t));
+                lastSoundMs = millis();
+            } else if (cutOff) {
+                if (chunk.playSeq > self->cancelSeq) self->stats.preempted++;
+                else self->stats.dropped++;
+            }
+            self->finishPhrase(chunk.id, played);
+        }
+    }
+}
+
+size_t AudioFeedbackManager::writeSilence(uint16_t ms, uint32_t sampleRate) {
+    static const uint8_t zeros[512] = {0};
+    size_t total = (size_t)sampleRate * ms / 1000 * sizeof(int16_t);
+    size_t written;
+    for (size_t bytes = total; bytes > 0;) {
+        size_t n = min(bytes, sizeof(zeros));
+        i2s_write(I2S_NUM_0, zeros, n, &written, portMAX_DELAY);
+        bytes -= n;
+    }
+    return total;
+}
+
+// ============= Clip Cache =============
+
+// Digits and units: few, short, and most announcements are made of them
+bool AudioFeedbackManager::isCacheable(const char* path) const {
+    return strncmp(path, DIGITS_AUDIO_PATH "/", sizeof(DIGITS_AUDIO_PATH)) == 0;
+}
+
+int AudioFeedbackManager::findCachedClip(const char* path, uint32_t hash) {
+    for (int i = 0; i < AUDIO_CACHE_ENTRIES; i++) {
+        CachedClip& cached = clipCache[i];
+        if (cached.data && cached.hash == hash && strcmp(cached.path, path) == 0) {
+            cached.lastUsed = ++cacheClock;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Reads the rest of a file positioned at its samples into PSRAM, evicting
+// least recently used clips for room; -1 (file position kept) if there is no
+// room or the read fails. Reader task, or initialize() before it starts.
+int AudioFeedbackManager::cacheClip(File& file, const char* path, uint32_t hash, uint32_t length,
+                                    uint32_t sampleRate, bool pinned) {
+    length &= ~1;
+    if (length == 0) return -1;
+    int slot;
+    for (;;) {
+        slot = -1;
+        for (int i = 0; i < AUDIO_CACHE_ENTRIES && slot < 0; i++) {
+            if (!clipCache[i].data) slot = i;
+        }
+        if (slot >= 0 && stats.cacheBytes + length <= AUDIO_CACHE_BYTES) break;
+        int victim = -1;
+        for (int i = 0; i < AUDIO_CACHE_ENTRIES; i++) {
+            const CachedClip& cached = clipCache[i];
+            if (!cached.data || cached.pinned || cached.refs > 0) continue;
+            if (victim < 0 || cached.lastUsed < clipCache[victim].lastUsed) victim = i;
+        }
+        if (victim < 0) return -1;
+        free(clipCache[victim].data);
+        clipCache[victim].data = nullptr;
+        stats.cacheBytes -= clipCache[victim].length;
+        stats.cacheEntries--;
+        stats.cacheEvictions++;
     }
     
-    // Wait for I2S to finish playing
-    delay(100);
+    uint8_t* data = (uint8_t*)ps_malloc(length);
+    if (!data) return -1;
+    uint32_t start = file.position();
+    uint32_t readStart = millis();
+    if (file.read(data, length) != length) {
+        free(data);
+        file.seek(start);
+        return -1;
+    }
+    uint32_t elapsed = millis() - readStart;
+    if (elapsed > stats.maxReadMs) stats.maxReadMs = elapsed;
+    
+    // Where the sound starts and ends, with a margin
+    const int16_t* samples = (const int16_t*)data;
+    uint32_t count = length / sizeof(int16_t);
+    uint32_t first = 0, last = count;
+    while (first < count && abs(samples[first]) < AUDIO_TRIM_LEVEL) first++;
+    while (last > first && abs(samples[last - 1]) < AUDIO_TRIM_LEVEL) last--;
+    if (first >= last) {
+        first = 0;                                  // All quiet: keep it whole
+        last = count;
+    }
+    uint32_t margin = sampleRate * AUDIO_TRIM_MARGIN_MS / 1000;
+    
+    CachedClip& cached = clipCache[slot];
+    cached.data = data;
+    cached.length = length;
+    cached.trimStart = (first > margin ? first - margin : 0) * sizeof(int16_t);
+    cached.trimEnd = min(count, last + margin) * sizeof(int16_t);
+    cached.sampleRate = sampleRate;
+    cached.hash = hash;
+    cached.lastUsed = ++cacheClock;
+    cached.refs = 0;
+    cached.pinned = pinned;
+    strncpy(cached.path, path, sizeof(cached.path) - 1);
+    cached.path[sizeof(cached.path) - 1] = '\0';
+    stats.cacheBytes += length;
+    stats.cacheEntries++;
+    if (pinned) stats.cachePinned++;
+    else stats.cacheLoads++;
+    return slot;
+}
+
+void AudioFeedbackManager::preloadClips() {
+    if (!psramFound()) {
+        Serial.println("[AudioManager] No PSRAM, all clips stream from SD");
+        return;
+    }
+    clipCache = (CachedClip*)ps_malloc(AUDIO_CACHE_ENTRIES * sizeof(CachedClip));
+    if (!clipCache) return;
+    memset(clipCache, 0, AUDIO_CACHE_ENTRIES * sizeof(CachedClip));
+    
+    for (size_t i = 0; i < sizeof(PINNED_CLIPS) / sizeof(PINNED_CLIPS[0]); i++) {
+        uint32_t length = 0, sampleRate = AUDIO_SAMPLE_RATE;
+        File file = SD.open(PINNED_CLIPS[i]);
+        if (!file || !parseWAVHeader(file, length, sampleRate) || length > AUDIO_CACHE_CLIP_MAX ||
+            cacheClip(file, PINNED_CLIPS[i], pathHash(PINNED_CLIPS[i]), length, sampleRate, true) < 0) {
+            Serial.printf("[AudioManager] Alert clip not preloaded: %s\n", PINNED_CLIPS[i]);
+        }
+        if (file) file.close();
+    }
+    Serial.printf("[AudioManager] %u alert clips preloaded to PSRAM (%lu KB)\n", stats.cachePinned,
+                  (unsigned long)(stats.cacheBytes / 1024));
 }
 
 void AudioFeedbackManager::announceSerialStatement(const String& statement) {
@@ -309,53 +899,58 @@ bool AudioFeedbackManager::playSerialStatementByNumber(int serialNumber) {
 void AudioFeedbackManager::announceDistanceReading(float distance) {
     if (!isAudioReady()) return;
     
-    if (distance < 30.0) {
-        playAudioFile("/audio/critical/obstacle_ahead.wav");
-        delay(500);
+    // Only the newest reading is worth hearing
+    bool obstacle = distance < 30.0;
+    beginPhrase(obstacle ? AUDIO_PRIORITY_CRITICAL : AUDIO_PRIORITY_INFO, AUDIO_KEY_DISTANCE,
+                AUDIO_MAX_AGE_READING_MS);
+    if (obstacle) {
+        addClip("/audio/critical/obstacle_ahead.wav", 0);
     }
     
     // Announce the distance
     announceFloat(distance, 0);
-    delay(300);
     announceUnit("centimeters");
+    endPhrase();
 }
 
 void AudioFeedbackManager::announceTemperature(float temperature) {
     if (!isAudioReady()) return;
     
+    beginPhrase(AUDIO_PRIORITY_INFO, AUDIO_KEY_TEMPERATURE);
     announceFloat(temperature, 1);
-    delay(300);
     announceUnit("celsius");
+    endPhrase();
 }
 
 void AudioFeedbackManager::announceLightLevel(float lux, const String& environment) {
     if (!isAudioReady()) return;
     
+    beginPhrase(AUDIO_PRIORITY_INFO, AUDIO_KEY_LIGHT);
     announceFloat(lux, 0);
-    delay(300);
     announceUnit("lux");
-    delay(500);
     
     // Announce environment type
     if (environment == "Dark") {
-        playAudioFile("/audio/environmental/dark_environment.wav");
+        addClip("/audio/environmental/dark_environment.wav", AUDIO_PHRASE_GAP_MS);
     } else if (environment == "Dim") {
-        playAudioFile("/audio/environmental/dim_light.wav");
+        addClip("/audio/environmental/dim_light.wav", AUDIO_PHRASE_GAP_MS);
     } else if (environment == "Bright") {
-        playAudioFile("/audio/environmental/bright_light.wav");
+        addClip("/audio/environmental/bright_light.wav", AUDIO_PHRASE_GAP_MS);
     }
+    endPhrase();
 }
 
 void AudioFeedbackManager::announceGPSStatus(const SensorData& data) {
     if (!isAudioReady()) return;
     
+    beginPhrase(AUDIO_PRIORITY_INFO, AUDIO_KEY_GPS);
     if (data.gpsSatellites > 0) {
         announceNumber(data.gpsSatellites);
-        delay(300);
-        playAudioFile("/audio/navigation/satellites_connected.wav");
+        addClip("/audio/navigation/satellites_connected.wav", AUDIO_PHRASE_GAP_MS);
     } else {
-        playAudioFile("/audio/critical/gps_no_signal.wav");
+        addClip("/audio/critical/gps_no_signal.wav", 0);
     }
+    endPhrase();
 }
 
 void AudioFeedbackManager::announceSystemReady() {
@@ -367,35 +962,33 @@ void AudioFeedbackManager::announceSystemReady() {
 void AudioFeedbackManager::announceNumber(int number) {
     if (!isAudioReady()) return;
     
+    beginPhrase(AUDIO_PRIORITY_INFO);
+    queueNumber(number, leadGap());
+    endPhrase();
+}
+
+// Words of 0-999; the first one after gapMs of silence
+void AudioFeedbackManager::queueNumber(int number, uint16_t gapMs) {
     if (number < 0 || number > 999) return;
     
     if (number < 10) {
-        String audioFile = String(DIGITS_AUDIO_PATH) + "/num" + String(number) + ".wav";
-        playAudioFile(audioFile);
+        addClip(String(DIGITS_AUDIO_PATH) + "/num" + String(number) + ".wav", gapMs);
     } else if (number < 100) {
         int tens = number / 10;
         int ones = number % 10;
         
-        String tensFile = String(DIGITS_AUDIO_PATH) + "/num" + String(tens * 10) + ".wav";
-        playAudioFile(tensFile);
-        delay(200);
-        
+        addClip(String(DIGITS_AUDIO_PATH) + "/num" + String(tens * 10) + ".wav", gapMs);
         if (ones > 0) {
-            String onesFile = String(DIGITS_AUDIO_PATH) + "/num" + String(ones) + ".wav";
-            playAudioFile(onesFile);
+            addClip(String(DIGITS_AUDIO_PATH) + "/num" + String(ones) + ".wav", AUDIO_WORD_GAP_MS);
         }
     } else {
         int hundreds = number / 100;
         int remainder = number % 100;
         
-        String hundredsFile = String(DIGITS_AUDIO_PATH) + "/num" + String(hundreds) + ".wav";
-        playAudioFile(hundredsFile);
-        delay(200);
-        playAudioFile(String(DIGITS_AUDIO_PATH) + "/hundred.wav");
-        delay(200);
-        
+        addClip(String(DIGITS_AUDIO_PATH) + "/num" + String(hundreds) + ".wav", gapMs);
+        addClip(String(DIGITS_AUDIO_PATH) + "/hundred.wav", AUDIO_WORD_GAP_MS);
         if (remainder > 0) {
-            announceNumber(remainder);
+            queueNumber(remainder, AUDIO_WORD_GAP_MS);
         }
     }
 }
@@ -403,72 +996,93 @@ void AudioFeedbackManager::announceNumber(int number) {
 void AudioFeedbackManager::announceFloat(float value, int decimals) {
     if (!isAudioReady()) return;
     
+    beginPhrase(AUDIO_PRIORITY_INFO);
     int intPart = (int)value;
     announceNumber(intPart);
     
     if (decimals > 0) {
-        delay(200);
-        playAudioFile(String(DIGITS_AUDIO_PATH) + "/point.wav");
-        delay(200);
+        addClip(String(DIGITS_AUDIO_PATH) + "/point.wav", AUDIO_WORD_GAP_MS);
         
         float fracPart = value - intPart;
         int fracInt = (int)(fracPart * pow(10, decimals));
-        announceNumber(fracInt);
+        queueNumber(fracInt, AUDIO_WORD_GAP_MS);
     }
+    endPhrase();
 }
 
 void AudioFeedbackManager::announceUnit(const String& unit) {
     if (!isAudioReady()) return;
     
     String audioFile = String(DIGITS_AUDIO_PATH) + "/" + unit + ".wav";
-    playAudioFile(audioFile);
+    addClip(audioFile, leadGap() ? AUDIO_UNIT_GAP_MS : 0);
 }
 
 // Critical alerts
 void AudioFeedbackManager::playObstacleAlert() {
-    playAudioFile("/audio/critical/obstacle_ahead.wav");
+    playClip("/audio/critical/obstacle_ahead.wav", AUDIO_PRIORITY_CRITICAL);
 }
 
 void AudioFeedbackManager::playDistanceSensorFailed() {
-    playAudioFile("/audio/critical/distance_sensor_failed.wav");
+    playClip("/audio/critical/distance_sensor_failed.wav", AUDIO_PRIORITY_CRITICAL);
 }
 
 void AudioFeedbackManager::playLowBattery() {
-    playAudioFile("/audio/critical/low_battery.wav");
+    playClip("/audio/critical/low_battery.wav", AUDIO_PRIORITY_CRITICAL);
 }
 
 void AudioFeedbackManager::playEmergencyAlert() {
-    playAudioFile("/audio/critical/emergency_alert.wav");
+    playClip("/audio/critical/emergency_alert.wav", AUDIO_PRIORITY_CRITICAL);
+}
+
+void AudioFeedbackManager::playFallDetected() {
+    playClip("/audio/critical/fall_detected.wav", AUDIO_PRIORITY_CRITICAL);
 }
 
 // Environmental feedback
 void AudioFeedbackManager::playWetSurface() {
-    playAudioFile("/audio/environmental/wet_surface.wav");
+    playClip("/audio/environmental/wet_surface.wav", AUDIO_PRIORITY_CRITICAL);
 }
 
 void AudioFeedbackManager::playUnevenGround() {
-    playAudioFile("/audio/environmental/uneven_ground.wav");
+    playClip("/audio/environmental/uneven_ground.wav", AUDIO_PRIORITY_CRITICAL);
 }
 
 void AudioFeedbackManager::playStairsAhead() {
-    playAudioFile("/audio/navigation/stairs_ahead.wav");
+    playClip("/audio/navigation/stairs_ahead.wav", AUDIO_PRIORITY_CRITICAL, AUDIO_KEY_HAZARD);
+}
+
+void AudioFeedbackManager::playStairsDown() {
+    playClip("/audio/navigation/stairs_down.wav", AUDIO_PRIORITY_CRITICAL, AUDIO_KEY_HAZARD);
 }
 
 // Navigation feedback
 void AudioFeedbackManager::playTurnLeft() {
-    playAudioFile("/audio/navigation/turn_left.wav");
+    playClip("/audio/navigation/turn_left.wav", AUDIO_PRIORITY_NAVIGATION);
 }
 
 void AudioFeedbackManager::playTurnRight() {
-    playAudioFile("/audio/navigation/turn_right.wav");
+    playClip("/audio/navigation/turn_right.wav", AUDIO_PRIORITY_NAVIGATION);
 }
 
 void AudioFeedbackManager::playGoStraight() {
-    playAudioFile("/audio/navigation/go_straight.wav");
+    playClip("/audio/navigation/go_straight.wav", AUDIO_PRIORITY_NAVIGATION);
 }
 
 void AudioFeedbackManager::playDestinationReached() {
-    playAudioFile("/audio/navigation/destination_reached.wav");
+    playClip("/audio/navigation/destination_reached.wav", AUDIO_PRIORITY_NAVIGATION);
+}
+
+void AudioFeedbackManager::announcePoi(uint8_t category, float distanceM) {
+    if (!isAudioReady()) return;
+    
+    // poi_0.wav ("point of interest") ... poi_7.wav ("bench"), ids from PoiDatabase.h
+    String audioFile = String(NAVIGATION_AUDIO_PATH) + "/poi_" + String(category) + ".wav";
+    if (!SDCard_fileExists(audioFile.c_str())) audioFile = String(NAVIGATION_AUDIO_PATH) + "/poi_0.wav";
+    beginPhrase(AUDIO_PRIORITY_NAVIGATION);
+    addClip(audioFile, leadGap());
+    announceNumber((int)(distanceM + 0.5f));
+    announceUnit("meters");
+    endPhrase();
 }
 
 void AudioFeedbackManager::announceSignificantChanges(const SensorData& data) {
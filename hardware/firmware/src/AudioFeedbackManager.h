@@ -4,6 +4,9 @@
 #include <Arduino.h>
 #include <SD.h>
 #include <driver/i2s.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
 #include "SensorData.h"
 
 // MAX98357A I2S Audio Amplifier Pin Definitions
@@ -25,6 +28,93 @@
 #define AUDIO_BITS_PER_SAMPLE 16
 #define AUDIO_CHANNELS 1
 
+// Playback runs off the caller's thread: play*/announce* queue a phrase (the
+// clips of one announcement, e.g. "obstacle ahead, twenty five centimeters")
+// and return. A reader task streams its WAVs from SD into ping-pong chunks
+// ahead of a writer task that feeds the I2S DMA, so the SD read of the next
+// chunk overlaps playback of the current one.
+//
+// Phrases are scheduled, not just queued: the highest priority plays first
+// and a critical phrase cuts off lower-priority speech (which is replayed
+// from its start afterwards if still current). A phrase with a key replaces
+// a waiting one with the same key, so only the latest distance is spoken, and
+// one that has waited past its deadline is dropped. A phrase is never split:
+// nothing else is heard between its clips.
+#define AUDIO_CHUNK_BYTES 4096
+#define AUDIO_CHUNK_POOL 2
+#define AUDIO_PHRASE_SLOTS 8            // Phrases waiting or playing
+#define AUDIO_PHRASE_CLIPS 12           // "obstacle ahead" + 123.4 + unit is 8
+#define AUDIO_PATH_MAX 64
+#define AUDIO_DMA_MS 512                // 8 x 1024 samples at 16 kHz still in the DMA after the last write
+#define AUDIO_WORD_GAP_MS 0             // Words of a number are joined with a crossfade
+#define AUDIO_UNIT_GAP_MS 80            // Between a number and its unit
+#define AUDIO_PHRASE_GAP_MS 250         // Between the parts of a phrase, or two phrases
+#define AUDIO_MAX_AGE_CRITICAL_MS 2000  // Default deadlines, from queueing to starting the SD read
+#define AUDIO_MAX_AGE_NAVIGATION_MS 6000
+#define AUDIO_MAX_AGE_INFO_MS 10000
+#define AUDIO_MAX_AGE_READING_MS 2500   // Distance readings go stale quickly
+
+// Clip cache in PSRAM. The critical alerts are loaded at boot and never
+// evicted; digit and unit clips (/audio/digits) are cached on first use and
+// evicted least recently used. A cached clip plays straight from memory with
+// its WAV header already parsed: no SD open, seek or read before the first
+// sample. Other clips, and every clip on a board without PSRAM, stream.
+//
+// Cached clips are also trimmed: the silence a recording or TTS export leaves
+// at either end is measured once when the clip is loaded and skipped on
+// every play. Consecutive cached words with no gap between them are joined
+// with a short linear crossfade, so a number and its unit are spoken as one
+// utterance in a single I2S stream.
+#define AUDIO_CACHE_ENTRIES 64
+#define AUDIO_CACHE_BYTES (1024 * 1024)     // PCM budget, pinned clips included
+#define AUDIO_CACHE_CLIP_MAX (96 * 1024)    // 3 s; longer clips always stream
+#define AUDIO_TRIM_LEVEL 400                // |sample| below this at a clip's ends is silence (about -38 dBFS)
+#define AUDIO_TRIM_MARGIN_MS 10             // Kept around the sound so onsets and decays are not cut
+#define AUDIO_CROSSFADE_MS 6
+
+enum AudioPriority : uint8_t {
+    AUDIO_PRIORITY_INFO,                // Status, sensor readings, serial statements
+    AUDIO_PRIORITY_NAVIGATION,          // Route instructions, points of interest
+    AUDIO_PRIORITY_CRITICAL             // Obstacles and hazards; preempts the others
+};
+
+// Coalescing keys: a new phrase replaces a waiting phrase with the same key.
+// Phrases without a key only replace an identical waiting phrase.
+enum AudioKey : uint8_t {
+    AUDIO_KEY_NONE,
+    AUDIO_KEY_DISTANCE,
+    AUDIO_KEY_TEMPERATURE,
+    AUDIO_KEY_LIGHT,
+    AUDIO_KEY_GPS,
+    AUDIO_KEY_HAZARD,
+    AUDIO_KEY_ROUTE
+};
+
+// Called once per phrase, played or not (failed, expired, replaced, cut off,
+// cleared); normally on the audio writer task, but on the caller of
+// endPhrase()/clearQueue() for a phrase dropped there. Keep it short.
+typedef void (*AudioDoneCallback)(uint32_t requestId, bool played);
+
+struct AudioStats {
+    uint32_t queued;            // Phrases
+    uint32_t played;
+    uint32_t failed;            // Missing or invalid WAV clips
+    uint32_t dropped;           // No free slot, or cleared
+    uint32_t coalesced;         // Replaced by a newer phrase with the same key
+    uint32_t expired;           // Waited past the deadline
+    uint32_t preempted;         // Cut off by a critical phrase and not replayed
+    uint32_t maxReadMs;         // Slowest SD chunk read
+    uint32_t lastPhraseMs;      // Audio of the last played phrase, gaps included
+    uint32_t cacheHits;         // Clips played from PSRAM
+    uint32_t cacheLoads;        // Cacheable clips read from SD into PSRAM
+    uint32_t cacheEvictions;
+    uint32_t cacheBytes;        // PCM held now
+    uint8_t cacheEntries;
+    uint8_t cachePinned;
+    uint32_t lastStartMs;       // Queued -> first sample handed to I2S
+    uint32_t maxStartMs;
+};
+
 class AudioFeedbackManager {
 public:
     AudioFeedbackManager();
@@ -35,7 +125,20 @@ public:
     bool isAudioReady() const;
     void testAudioSystem();
     
-    // Core audio playback functions
+    // Playback scheduler. Calls between beginPhrase() and endPhrase() form one
+    // phrase; they nest, so announce* calls can be grouped, and the phrase
+    // takes the highest priority used inside it. Without one, every play* and
+    // announce* call is its own phrase. Build phrases from one task (the loop).
+    void beginPhrase(AudioPriority priority, AudioKey key = AUDIO_KEY_NONE, uint32_t maxAgeMs = 0);
+    uint32_t endPhrase();                           // Phrase id, 0 if empty or dropped
+    void clearQueue();                              // Drops waiting phrases and stops the current one
+    bool isBusy() const;                            // Phrases queued or playing
+    bool waitUntilIdle(uint32_t timeoutMs);         // Includes the DMA tail; false on timeout
+    void setDoneCallback(AudioDoneCallback callback);
+    AudioStats getStats() const;
+    void printStatus();
+    
+    // Core audio playback functions (informational priority; false if not queued)
     bool playAudioFile(const String& filePath);
     bool playSerialStatement(const String& serialStatement);
     bool playSerialStatementByNumber(int serialNumber);
@@ -63,17 +166,20 @@ public:
     void playDistanceSensorFailed();
     void playLowBattery();
     void playEmergencyAlert();
+    void playFallDetected();
     
     // Environmental feedback
     void playWetSurface();
     void playUnevenGround();
     void playStairsAhead();
+    void playStairsDown();
     
     // Navigation feedback
     void playTurnLeft();
     void playTurnRight();
     void playGoStraight();
     void playDestinationReached();
+    void announcePoi(uint8_t category, float distanceM);  // PoiCategory clip, then the distance
     
 private:
     bool audioInitialized;
@@ -84,9 +190,92 @@ private:
     void deinitializeI2S();
     
     // Audio file handling
-    bool loadAndPlayWAV(const String& filePath);
     bool parseWAVHeader(File& file, uint32_t& dataSize, uint32_t& sampleRate);
-    void playAudioData(File& file, uint32_t dataSize);
+    
+    // Scheduler and streaming tasks
+    struct AudioClip {
+        uint16_t gapMs;                 // Silence before the clip
+        char path[AUDIO_PATH_MAX];
+    };
+    struct AudioPhrase {
+        uint32_t id;
+        uint32_t queuedMs;
+        uint32_t maxAgeMs;
+        uint32_t playSeq;               // Order of being taken by the reader
+        uint8_t state;                  // AUDIO_SLOT_*
+        uint8_t priority;
+        uint8_t key;
+        uint8_t clipCount;
+        AudioClip clips[AUDIO_PHRASE_CLIPS];
+    };
+    struct AudioChunk {
+        const uint8_t* data;            // In the chunk pool or a cached clip
+        uint8_t buffer;                 // Pool index, AUDIO_NO_BUFFER if none
+        uint8_t cacheEntry;             // AUDIO_NO_ENTRY if not from the cache
+        uint8_t flags;
+        uint8_t priority;
+        uint8_t slot;                   // Phrase slot
+        uint16_t length;
+        uint16_t gapMs;
+        uint32_t id;
+        uint32_t playSeq;
+        uint32_t sampleRate;
+        uint32_t queuedMs;
+    };
+    struct CachedClip {
+        uint8_t* data;                  // PCM in PSRAM; nullptr for a free entry
+        uint32_t length;
+        uint32_t trimStart;             // Bytes of data between which there is sound
+        uint32_t trimEnd;
+        uint32_t sampleRate;
+        uint32_t hash;                  // Of the path, compared first
+        uint32_t lastUsed;
+        volatile uint16_t refs;         // Chunks queued for the writer; not evicted while > 0
+        bool pinned;
+        char path[AUDIO_PATH_MAX];
+    };
+    AudioPhrase* phrases;               // AUDIO_PHRASE_SLOTS, in PSRAM
+    CachedClip* clipCache;              // AUDIO_CACHE_ENTRIES; nullptr without PSRAM
+    uint32_t cacheClock;
+    AudioPhrase building;
+    uint8_t buildDepth;
+    TaskHandle_t readerHandle;
+    QueueHandle_t freeChunks;
+    QueueHandle_t fullChunks;
+    uint8_t* chunkData;
+    uint32_t nextRequestId;
+    uint32_t playCounter;
+    volatile uint32_t preemptSeq;       // Phrases taken up to here are cut off unless critical
+    volatile uint32_t cancelSeq;        // ... and up to here regardless of priority
+    volatile uint32_t pendingRequests;
+    volatile uint32_t idleSinceMs;      // Writer finished its last phrase
+    AudioDoneCallback doneCallback;
+    AudioStats stats;
+    
+    void addClip(const String& filePath, uint16_t gapMs);
+    uint16_t leadGap() const;           // Gap before the next part of the phrase being built
+    bool playClip(const char* filePath, AudioPriority priority, AudioKey key = AUDIO_KEY_NONE);
+    void queueNumber(int number, uint16_t gapMs);
+    bool submitPhrase(const AudioPhrase& phrase);
+    bool sameClips(const AudioPhrase& a, const AudioPhrase& b) const;
+    int takeNextPhrase();
+    bool requeuePhrase(uint8_t slot);
+    void releasePhrase(uint8_t slot);
+    void finishPhrase(uint32_t id, bool played);
+    bool startTasks();
+    static void readerTask(void* parameter);
+    static void writerTask(void* parameter);
+    void streamPhrase(AudioPhrase& phrase);
+    bool isCutOff(uint32_t playSeq, uint8_t priority) const;
+    bool sendCached(AudioChunk& chunk, const AudioPhrase& phrase, int entry, uint32_t begin, uint32_t end);
+    bool sendCrossfade(AudioChunk& chunk, const AudioPhrase& phrase, int fromEntry, uint32_t fromOffset, int toEntry,
+                       uint32_t toOffset, uint32_t bytes);
+    bool sendFile(AudioChunk& chunk, const AudioPhrase& phrase, File& file, uint32_t remaining);
+    bool isCacheable(const char* path) const;
+    int findCachedClip(const char* path, uint32_t hash);
+    int cacheClip(File& file, const char* path, uint32_t hash, uint32_t length, uint32_t sampleRate, bool pinned);
+    void preloadClips();
+    size_t writeSilence(uint16_t ms, uint32_t sampleRate);    // Bytes written
     
     // Serial statement mapping
     struct SerialMapping {
@@ -100,26 +289,6 @@ private:
     String getDigitAudioFile(int digit);
     String getUnitAudioFile(const String& unit);
     
-    // Timing and queue management
-    unsigned long lastPlayTime;
-    static const unsigned long MIN_PLAY_INTERVAL = 500; // Minimum 500ms between audio plays
-    
-    // Audio queue for sequential playback
-    struct AudioQueueItem {
-        String filePath;
-        unsigned long delay;
-    };
-    
-    static const int MAX_QUEUE_SIZE = 10;
-    AudioQueueItem audioQueue[MAX_QUEUE_SIZE];
-    int queueHead;
-    int queueTail;
-    int queueSize;
-    
-    void addToQueue(const String& filePath, unsigned long delay = 0);
-    void processQueue();
-    void clearQueue();
-    
     // Helper functions
     bool fileExists(const String& path);
     void enableAmplifier();
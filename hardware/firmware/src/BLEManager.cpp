@@ -1,5 +1,6 @@
 #include "BLEManager.h"
 #include "ToF.h"
+#include "Log.h"
 
 // Static member initialization
 BLEServer* BLEManager::pServer = nullptr;
@@ -8,6 +9,8 @@ BLECharacteristic* BLEManager::pTxChr = nullptr;  // TX characteristic
 bool BLEManager::clientConnected = false;
 uint32_t BLEManager::connectedAt = 0;
 uint32_t BLEManager::lastSentStepCount = 0;  // Initialize step tracking
+uint32_t BLEManager::lastSentStrideCount = 0;
+uint32_t BLEManager::lastGaitSentAt = 0;
 
 // FreeRTOS components
 QueueHandle_t BLEManager::bleQueue = nullptr;
@@ -93,7 +96,7 @@ void BLEManager::sendLargeData(const char* data) {
     int dataLen = strlen(data);
     const int chunkSize = 60; // Leave room for newline
     
-    Serial.printf("🔧 [DEBUG] sendLargeData: Sending %d bytes in chunks of %d\n", dataLen, chunkSize);
+    LOG_DEBUG(LOG_CAT_BLE, "🔧 [DEBUG] sendLargeData: Sending %d bytes in chunks of %d\n", dataLen, chunkSize);
     
     for (int i = 0; i < dataLen; i += chunkSize) {
         char chunk[64];
@@ -104,7 +107,7 @@ void BLEManager::sendLargeData(const char* data) {
         chunk[currentChunkSize] = '\n';
         chunk[currentChunkSize + 1] = '\0';
         
-        Serial.printf("🔧 [DEBUG] Sending chunk %d: %d bytes\n", (i/chunkSize) + 1, currentChunkSize + 1);
+        LOG_DEBUG(LOG_CAT_BLE, "🔧 [DEBUG] Sending chunk %d: %d bytes\n", (i/chunkSize) + 1, currentChunkSize + 1);
         
         pChr->setValue((uint8_t*)chunk, currentChunkSize + 1);
         pChr->notify();
@@ -113,7 +116,7 @@ void BLEManager::sendLargeData(const char* data) {
         delay(10);
     }
     
-    Serial.println("🔧 [DEBUG] Large data transmission completed");
+    LOG_DEBUG(LOG_CAT_BLE, "🔧 [DEBUG] Large data transmission completed\n");
 }
 
 // Queue-based transmission (non-blocking) - for regular sensor data
@@ -327,10 +330,24 @@ void BLEManager::sendStepUpdateIfChanged(uint32_t currentStepCount) {
     if (currentStepCount != lastSentStepCount) {
         queueBLEMessage("STEP:%d", (int)currentStepCount);
         lastSentStepCount = currentStepCount;
-        Serial.printf("📊 Step update sent: %d\n", (int)currentStepCount);
+        LOG_INFO(LOG_CAT_BLE, "📊 Step update sent: %d\n", (int)currentStepCount);
     }
 }
 
+// Gait summary: cadence, stride mean (ms), stride CV, symmetry, speed, stride count
+#define GAIT_UPDATE_INTERVAL_MS 5000
+void BLEManager::sendGaitUpdateIfChanged(const GaitMetrics& gait) {
+    if (!clientConnected) return;
+    if (gait.strideCount == lastSentStrideCount) return;
+    if (millis() - lastGaitSentAt < GAIT_UPDATE_INTERVAL_MS) return;
+    
+    queueBLEMessage("GAIT:%.1f,%d,%.1f,%.1f,%.2f,%lu",
+                    gait.cadenceSpm, (int)(gait.strideTimeMean * 1000.0f), gait.strideTimeCv,
+                    gait.symmetryIndex, gait.walkingSpeed, (unsigned long)gait.strideCount);
+    lastSentStrideCount = gait.strideCount;
+    lastGaitSentAt = millis();
+}
+
 void BLEManager::sendBLEDataFast(const SensorData& s) {
     if (!clientConnected) return;
     
@@ -8,6 +8,7 @@
 #include <BLEServer.h>
 #include <BLE2902.h>
 #include "SensorData.h"
+#include "GaitAnalytics.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -41,6 +42,8 @@ private:
   
   // Step tracking for change detection
   static uint32_t lastSentStepCount;
+  static uint32_t lastSentStrideCount;
+  static uint32_t lastGaitSentAt;
   
   // FreeRTOS components for non-blocking operation
   static QueueHandle_t bleQueue;
@@ -75,6 +78,7 @@ public:
   static void sendBLEData(const SensorData& s);
   static void sendBLEDataFast(const SensorData& s);  // Optimized version
   static void sendStepUpdateIfChanged(uint32_t currentStepCount);  // Send step data only when changed
+  static void sendGaitUpdateIfChanged(const GaitMetrics& gait);    // Gait summary after new strides, rate limited
   static void sendRadarLiveData(int angle, int distance);  // For real-time radar data
   
   // Status queries
@@ -0,0 +1,261 @@
+#include "BlackBox.h"
+#include "SDCardManager.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <time.h>
+
+// ============= Capture Configuration =============
+static const uint32_t RING_SAMPLES = 4096;          // Power of two; 128KB of PSRAM, ~16s at 250 Hz
+static const uint32_t PRE_WINDOW_MS = 5000;         // Kept from before the trigger
+static const uint32_t POST_WINDOW_MS = 2000;        // Captured after the trigger
+static const size_t WRITE_CHUNK_SAMPLES = 128;      // 4KB per SD write
+static const char* const BLACKBOX_DIR = "/blackbox";
+#define BLACKBOX_TASK_STACK_SIZE 4096
+#define BLACKBOX_TASK_PRIORITY 1
+#define BLACKBOX_TASK_CORE 0
+
+// ============= File Format =============
+// [BlackBoxFileHeader][recordCount x BlackBoxSample][CRC-32 of the records]
+static const uint32_t BLACKBOX_MAGIC = 0x58424243;  // "CBBX"
+static const uint16_t BLACKBOX_VERSION = 1;
+
+struct BlackBoxFileHeader {   // 64 bytes
+  uint32_t magic;
+  uint16_t version;
+  uint16_t headerSize;
+  uint16_t recordSize;
+  uint16_t sampleRateHz;
+  uint32_t recordCount;
+  uint32_t preSamples;        // Records before the trigger sample
+  uint32_t triggerMicros;
+  uint32_t unixTime;          // 0 when wall time is not set
+  uint8_t reason;
+  uint8_t reserved[3];
+  float accelLsbPerG;
+  float gyroLsbPerDps;
+  float fallImpactThresholdG;
+  float fallFreeThresholdG;
+  int16_t accelOffsets[3];
+  int16_t gyroOffsets[3];
+  uint32_t droppedSamples;    // Samples lost while this window was being written
+};
+
+// ============= Ring State =============
+// Single producer (IMU task). Sample indices increase monotonically; the
+// slot is index & (RING_SAMPLES - 1). head is published after the slot is
+// written, so the writer task only ever reads completed samples.
+enum CaptureState : uint8_t { CAPTURE_ARMED, CAPTURE_POST, CAPTURE_FROZEN };
+
+static BlackBoxSample* ring = nullptr;
+static volatile uint32_t head = 0;
+static volatile CaptureState captureState = CAPTURE_ARMED;
+static volatile uint8_t pendingTrigger = 0;      // BlackBoxReason from any task, 0 = none
+static volatile uint16_t latestRangeMm = 0;
+static uint32_t captureStart = 0;                // First index of the frozen window
+static uint32_t captureTrigger = 0;              // Index of the trigger sample
+static uint32_t captureEnd = 0;                  // One past the last index
+static uint32_t postRemaining = 0;
+static uint8_t captureReason = 0;
+static uint32_t captureTriggerMicros = 0;
+static volatile uint32_t droppedSamples = 0;
+
+static BlackBoxImuInfo imuInfo;
+static TaskHandle_t writerTaskHandle = nullptr;
+static uint32_t preSamples = 0;
+static uint32_t postSamples = 0;
+static uint16_t nextFileIndex = 0;
+
+// Status
+static uint32_t capturesWritten = 0;
+static uint32_t captureFailures = 0;
+static uint32_t triggersIgnored = 0;
+static char lastFile[32] = "";
+
+static void findNextFileIndex() {
+  if (!SD.exists(BLACKBOX_DIR)) SD.mkdir(BLACKBOX_DIR);
+  File dir = SD.open(BLACKBOX_DIR);
+  if (!dir) return;
+  File entry = dir.openNextFile();
+  while (entry) {
+    unsigned index;
+    const char* name = entry.name();
+    const char* slash = strrchr(name, '/');
+    if (slash) name = slash + 1;
+    if (sscanf(name, "bb_%5u.bin", &index) == 1 && index >= nextFileIndex) {
+      nextFileIndex = index + 1;
+    }
+    entry.close();
+    entry = dir.openNextFile();
+  }
+  dir.close();
+}
+
+static bool writeCapture() {
+  char path[32];
+  snprintf(path, sizeof(path), "%s/bb_%05u.bin", BLACKBOX_DIR, nextFileIndex);
+  File file = SD.open(path, FILE_WRITE);
+  if (!file) return false;
+
+  BlackBoxFileHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = BLACKBOX_MAGIC;
+  header.version = BLACKBOX_VERSION;
+  header.headerSize = sizeof(BlackBoxFileHeader);
+  header.recordSize = sizeof(BlackBoxSample);
+  header.sampleRateHz = imuInfo.sampleRateHz;
+  header.recordCount = captureEnd - captureStart;
+  header.preSamples = captureTrigger - captureStart;
+  header.triggerMicros = captureTriggerMicros;
+  time_t now = time(nullptr);
+  header.unixTime = (now > 24 * 60 * 60) ? (uint32_t)now : 0;
+  header.reason = captureReason;
+  header.accelLsbPerG = imuInfo.accelLsbPerG;
+  header.gyroLsbPerDps = imuInfo.gyroLsbPerDps;
+  header.fallImpactThresholdG = imuInfo.fallImpactThresholdG;
+  header.fallFreeThresholdG = imuInfo.fallFreeThresholdG;
+  memcpy(header.accelOffsets, imuInfo.accelOffsets, sizeof(header.accelOffsets));
+  memcpy(header.gyroOffsets, imuInfo.gyroOffsets, sizeof(header.gyroOffsets));
+  bool ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+
+  // Frozen slots are contiguous except where they wrap the ring
+  uint32_t crc = 0;
+  uint32_t index = captureStart;
+  while (ok && index != captureEnd) {
+    uint32_t slot = index & (RING_SAMPLES - 1);
+    uint32_t count = captureEnd - index;
+    if (count > WRITE_CHUNK_SAMPLES) count = WRITE_CHUNK_SAMPLES;
+    if (count > RING_SAMPLES - slot) count = RING_SAMPLES - slot;
+    const uint8_t* bytes = (const uint8_t*)&ring[slot];
+    size_t len = count * sizeof(BlackBoxSample);
+    crc = SDCard_crc32(bytes, len, crc);
+    ok = file.write(bytes, len) == len;
+    index += count;
+  }
+  if (ok) ok = file.write((const uint8_t*)&crc, sizeof(crc)) == sizeof(crc);
+  // Drops are only known once the records are out; patch the count into the header
+  if (ok) {
+    uint32_t dropped = droppedSamples;
+    ok = file.seek(offsetof(BlackBoxFileHeader, droppedSamples)) &&
+         file.write((const uint8_t*)&dropped, sizeof(dropped)) == sizeof(dropped);
+  }
+  file.close();
+
+  if (ok) {
+    strncpy(lastFile, path, sizeof(lastFile) - 1);
+    nextFileIndex++;
+  } else {
+    SD.remove(path);
+  }
+  return ok;
+}
+
+static void blackBoxWriterTask(void* parameter) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (captureState != CAPTURE_FROZEN) continue;
+    if (writeCapture()) {
+      capturesWritten++;
+      Serial.printf("📦 Black box saved: %s (%lu samples)\n", lastFile, captureEnd - captureStart);
+    } else {
+      captureFailures++;
+      Serial.println("❌ Black box write failed");
+    }
+    droppedSamples = 0;
+    __sync_synchronize();
+    captureState = CAPTURE_ARMED;  // Hand the ring back to the producer
+  }
+}
+
+bool BlackBox_begin(const BlackBoxImuInfo& info) {
+  imuInfo = info;
+  preSamples = (uint32_t)info.sampleRateHz * PRE_WINDOW_MS / 1000;
+  postSamples = (uint32_t)info.sampleRateHz * POST_WINDOW_MS / 1000;
+  if (ring) return true;
+
+  if (!psramFound()) {
+    Serial.println("⚠️ Black box disabled: no PSRAM");
+    return false;
+  }
+  ring = (BlackBoxSample*)ps_malloc(RING_SAMPLES * sizeof(BlackBoxSample));
+  if (!ring) {
+    Serial.println("⚠️ Black box disabled: PSRAM allocation failed");
+    return false;
+  }
+  findNextFileIndex();
+  xTaskCreatePinnedToCore(
+    blackBoxWriterTask,
+    "BlackBoxWriter",
+    BLACKBOX_TASK_STACK_SIZE,
+    nullptr,
+    BLACKBOX_TASK_PRIORITY,
+    &writerTaskHandle,
+    BLACKBOX_TASK_CORE
+  );
+  return writerTaskHandle != nullptr;
+}
+
+void BlackBox_setImuInfo(const BlackBoxImuInfo& info) {
+  imuInfo = info;
+}
+
+void BlackBox_setRange(uint16_t distanceMm) {
+  latestRangeMm = distanceMm;
+}
+
+bool BlackBox_trigger(BlackBoxReason reason) {
+  if (!ring || captureState != CAPTURE_ARMED || pendingTrigger != 0) {
+    triggersIgnored++;
+    return false;
+  }
+  pendingTrigger = reason;
+  return true;
+}
+
+void BlackBox_record(const BlackBoxSample& sample) {
+  if (!ring) return;
+
+  uint32_t index = head;
+  CaptureState state = captureState;
+  if (state == CAPTURE_FROZEN && index - captureStart >= RING_SAMPLES) {
+    droppedSamples++;  // Writer still owns this slot
+    return;
+  }
+
+  BlackBoxSample& slot = ring[index & (RING_SAMPLES - 1)];
+  slot = sample;
+  slot.tofMm = latestRangeMm;
+  __sync_synchronize();
+  head = index + 1;
+
+  if (state == CAPTURE_ARMED && pendingTrigger != 0) {
+    captureReason = pendingTrigger;
+    pendingTrigger = 0;
+    captureTrigger = index;
+    captureTriggerMicros = sample.timestampUs;
+    uint32_t history = (index < preSamples) ? index : preSamples;
+    captureStart = index - history;
+    postRemaining = postSamples;
+    captureState = CAPTURE_POST;
+  } else if (state == CAPTURE_POST && --postRemaining == 0) {
+    captureEnd = index + 1;
+    captureState = CAPTURE_FROZEN;
+    if (writerTaskHandle) xTaskNotifyGive(writerTaskHandle);
+  }
+}
+
+void BlackBox_printStatus() {
+  Serial.println("\n📦 Black Box:");
+  if (!ring) {
+    Serial.println("Disabled (no PSRAM ring)");
+    return;
+  }
+  const char* stateName = (captureState == CAPTURE_ARMED) ? "ARMED" :
+                          (captureState == CAPTURE_POST) ? "CAPTURING" : "WRITING";
+  Serial.printf("State: %s | Ring: %lu samples (%u KB PSRAM) | Samples seen: %lu\n",
+                stateName, RING_SAMPLES, (unsigned)(RING_SAMPLES * sizeof(BlackBoxSample) / 1024), head);
+  Serial.printf("Window: %lu ms before + %lu ms after trigger (%lu + %lu samples)\n",
+                PRE_WINDOW_MS, POST_WINDOW_MS, preSamples, postSamples);
+  Serial.printf("Captures: %lu saved, %lu failed, %lu triggers ignored\n",
+                capturesWritten, captureFailures, triggersIgnored);
+  if (lastFile[0]) Serial.printf("Last file: %s\n", lastFile);
+}
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+#include <Arduino.h>
+
+// Pre/post-event IMU recorder. The IMU sampling task writes every sample into
+// a PSRAM ring; a fall (or manual trigger) freezes the last few seconds plus
+// a post-window, and a background task writes that window to
+// /blackbox/bb_NNNNN.bin. Decode with hardware/tools/blackbox_decode.py.
+enum BlackBoxReason : uint8_t {
+  BLACKBOX_REASON_FALL = 1,
+  BLACKBOX_REASON_MANUAL = 2
+};
+
+// One sample on disk, little endian, 32 bytes
+struct BlackBoxSample {
+  uint32_t timestampUs;
+  int16_t raw[6];           // MPU6050 counts as read (ax, ay, az, gx, gy, gz), before offsets
+  int16_t rollCd;           // Fused attitude, centidegrees
+  int16_t pitchCd;
+  int16_t yawCd;
+  uint16_t motionMilli;     // Motion energy x 1000
+  uint16_t accelMagMg;      // Smoothed |a| in mg
+  uint16_t tofMm;           // Latest ToF range
+  uint8_t flags;            // BLACKBOX_FLAG_*
+  uint8_t fallState;        // FallState
+  uint16_t reserved;
+};
+
+#define BLACKBOX_FLAG_STEP   0x01   // Step state machine not idle
+#define BLACKBOX_FLAG_SLOPE  0x02   // Slope warning active
+
+// Stored in each file header so recordings can be decoded on their own
+struct BlackBoxImuInfo {
+  uint16_t sampleRateHz;
+  float accelLsbPerG;
+  float gyroLsbPerDps;
+  float fallImpactThresholdG;
+  float fallFreeThresholdG;
+  int16_t accelOffsets[3];
+  int16_t gyroOffsets[3];
+};
+
+bool BlackBox_begin(const BlackBoxImuInfo& info);   // Allocates the PSRAM ring, starts the writer
+void BlackBox_setImuInfo(const BlackBoxImuInfo& info);  // After recalibration
+void BlackBox_record(const BlackBoxSample& sample); // IMU sampling task only
+void BlackBox_setRange(uint16_t distanceMm);        // Latest ToF range, any task
+bool BlackBox_trigger(BlackBoxReason reason);       // false when a capture is already in progress
+void BlackBox_printStatus();
+
+#endif // BLACKBOX_H
@@ -0,0 +1,177 @@
+#include "DropOffDetector.h"
+#include <math.h>
+
+// ============= Mounting Geometry =============
+// Adjust to the physical build: sensor height above ground when the cane is
+// held normally, and beam angle below horizontal at IMU pitch 0.
+static const float CANE_SENSOR_HEIGHT_MM = 750.0f;
+static const float TOF_BEAM_DEPRESSION_DEG = 20.0f;
+static const float PITCH_TO_DEPRESSION_SIGN = 1.0f;   // +pitch tilts the beam further down
+static const float MIN_DEPRESSION_DEG = 8.0f;         // Flatter beams never see the ground in range
+
+// ============= Detection Thresholds =============
+static const float GROUND_TOLERANCE_MM = 50.0f;       // |surface height| below this = ground
+static const float DROP_MIN_DEPTH_MM = 80.0f;         // Surface this far below ground = drop-off
+static const float STEP_MIN_HEIGHT_MM = 60.0f;        // Low surface above ground = step/curb up
+static const float STEP_MAX_HEIGHT_MM = 300.0f;       // Higher than this is a normal obstacle
+static const float USABLE_RANGE_FRACTION = 0.85f;     // Expected ground must sit inside sensor range
+static const float PITCH_JITTER_DEG = 4.0f;           // Pitch jump between samples = cane swing
+
+static const uint8_t ARM_GROUND_SAMPLES = 5;
+static const uint8_t CONFIRM_SAMPLES = 3;
+static const uint32_t SUSPECT_TIMEOUT_MS = 400;
+static const uint32_t GROUND_LOST_TIMEOUT_MS = 3000;
+static const uint32_t ALERT_DURATION_MS = 1200;
+static const uint32_t COOLDOWN_MS = 3000;
+static const uint32_t ANNOUNCE_INTERVAL_MS = 5000;
+
+// ============= Detector State =============
+static DropOffState state = DROPOFF_UNARMED;
+static DropOffHazard suspectHazard = HAZARD_NONE;
+static DropOffHazard activeHazard = HAZARD_NONE;
+static DropOffHazard pendingAnnouncement = HAZARD_NONE;
+static uint8_t groundSamples = 0;
+static uint8_t suspectSamples = 0;
+static uint32_t suspectSince = 0;
+static uint32_t lastGroundTime = 0;
+static uint32_t cooldownUntil = 0;
+static uint32_t alertUntil = 0;
+static uint32_t lastAnnounceTime = 0;
+static float lastPitch = 0;
+static float expectedGround = 0;
+static float surfaceHeight = 0;
+
+static void enterTracking() {
+  state = DROPOFF_TRACKING;
+  suspectHazard = HAZARD_NONE;
+  suspectSamples = 0;
+}
+
+static void confirmHazard(DropOffHazard hazard, uint32_t currentTime) {
+  activeHazard = hazard;
+  alertUntil = currentTime + ALERT_DURATION_MS;
+  cooldownUntil = currentTime + COOLDOWN_MS;
+  state = DROPOFF_COOLDOWN;
+  if (currentTime - lastAnnounceTime >= ANNOUNCE_INTERVAL_MS || lastAnnounceTime == 0) {
+    pendingAnnouncement = hazard;
+    lastAnnounceTime = currentTime;
+  }
+  Serial.printf("⚠️ %s detected (surface %.0fmm vs ground, expected %.0fmm)\n",
+                hazard == HAZARD_DROP ? "DROP-OFF" : "STEP UP", surfaceHeight, expectedGround);
+}
+
+void DropOff_reset() {
+  state = DROPOFF_UNARMED;
+  suspectHazard = HAZARD_NONE;
+  activeHazard = HAZARD_NONE;
+  pendingAnnouncement = HAZARD_NONE;
+  groundSamples = 0;
+  suspectSamples = 0;
+  alertUntil = 0;
+}
+
+void DropOff_update(uint16_t distanceMm, float pitchDeg, uint16_t maxRangeMm, uint32_t currentTime) {
+  float pitchJump = fabs(pitchDeg - lastPitch);
+  lastPitch = pitchDeg;
+
+  // Expected ground intersection for the current cane attitude
+  float depressionDeg = TOF_BEAM_DEPRESSION_DEG + PITCH_TO_DEPRESSION_SIGN * pitchDeg;
+  if (depressionDeg < MIN_DEPRESSION_DEG) {
+    expectedGround = 0;
+    if (state != DROPOFF_COOLDOWN) DropOff_reset();
+    return;
+  }
+  float sinDepression = sinf(depressionDeg * DEG_TO_RAD);
+  expectedGround = CANE_SENSOR_HEIGHT_MM / sinDepression;
+  float usableRange = maxRangeMm * USABLE_RANGE_FRACTION;
+  if (expectedGround > usableRange) {
+    if (state != DROPOFF_COOLDOWN) DropOff_reset();
+    return;
+  }
+
+  // Out-of-range return where ground should be visible counts as a deep drop
+  bool noReturn = distanceMm >= maxRangeMm - 50;
+  surfaceHeight = noReturn ? -CANE_SENSOR_HEIGHT_MM : CANE_SENSOR_HEIGHT_MM - distanceMm * sinDepression;
+
+  DropOffHazard sampleHazard = HAZARD_NONE;
+  bool isGround = fabs(surfaceHeight) <= GROUND_TOLERANCE_MM;
+  if (surfaceHeight < -DROP_MIN_DEPTH_MM) sampleHazard = HAZARD_DROP;
+  else if (surfaceHeight > STEP_MIN_HEIGHT_MM && surfaceHeight < STEP_MAX_HEIGHT_MM) sampleHazard = HAZARD_STEP_UP;
+  if (isGround) lastGroundTime = currentTime;
+
+  switch (state) {
+    case DROPOFF_UNARMED:
+      // Arm only once the geometry is confirmed by steady ground returns
+      groundSamples = isGround ? groundSamples + 1 : 0;
+      if (groundSamples >= ARM_GROUND_SAMPLES) enterTracking();
+      break;
+
+    case DROPOFF_TRACKING:
+      if (currentTime - lastGroundTime > GROUND_LOST_TIMEOUT_MS) {
+        DropOff_reset();
+      } else if (sampleHazard != HAZARD_NONE && pitchJump < PITCH_JITTER_DEG) {
+        state = DROPOFF_SUSPECT;
+        suspectHazard = sampleHazard;
+        suspectSamples = 1;
+        suspectSince = currentTime;
+      }
+      break;
+
+    case DROPOFF_SUSPECT:
+      if (sampleHazard != suspectHazard || pitchJump >= PITCH_JITTER_DEG ||
+          currentTime - suspectSince > SUSPECT_TIMEOUT_MS) {
+        enterTracking();
+      } else if (++suspectSamples >= CONFIRM_SAMPLES) {
+        confirmHazard(suspectHazard, currentTime);
+      }
+      break;
+
+    case DROPOFF_COOLDOWN:
+      if ((int32_t)(currentTime - cooldownUntil) >= 0) {
+        if (isGround) enterTracking();
+        else DropOff_reset();
+      }
+      break;
+  }
+}
+
+bool DropOff_isAlertActive(uint32_t currentTime) {
+  if (activeHazard == HAZARD_NONE) return false;
+  if ((int32_t)(currentTime - alertUntil) >= 0) {
+    activeHazard = HAZARD_NONE;
+    return false;
+  }
+  return true;
+}
+
+DropOffHazard DropOff_getActiveHazard() {
+  return activeHazard;
+}
+
+DropOffHazard DropOff_takeAnnouncement() {
+  DropOffHazard hazard = pendingAnnouncement;
+  pendingAnnouncement = HAZARD_NONE;
+  return hazard;
+}
+
+DropOffState DropOff_getState() {
+  return state;
+}
+
+const char* DropOff_getStateName() {
+  switch (state) {
+    case DROPOFF_UNARMED: return "UNARMED";
+    case DROPOFF_TRACKING: return "TRACKING";
+    case DROPOFF_SUSPECT: return "SUSPECT";
+    case DROPOFF_COOLDOWN: return "COOLDOWN";
+  }
+  return "UNKNOWN";
+}
+
+float DropOff_getExpectedGroundMm() {
+  return expectedGround;
+}
+
+float DropOff_getSurfaceHeightMm() {
+  return surfaceHeight;
+}
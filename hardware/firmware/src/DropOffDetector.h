@@ -0,0 +1,34 @@
+#pragma once
+#ifndef DROPOFFDETECTOR_H
+#define DROPOFFDETECTOR_H
+
+#include <Arduino.h>
+
+// Drop-off (curb, down-stairs) and step-up detection from the ToF range
+// compared with the ground intersection expected from cane pitch and height.
+enum DropOffHazard : uint8_t {
+  HAZARD_NONE = 0,
+  HAZARD_DROP,      // Range longer than the ground: curb or stairs going down
+  HAZARD_STEP_UP    // Range hits a low surface above the ground: curb or stairs going up
+};
+
+enum DropOffState : uint8_t {
+  DROPOFF_UNARMED = 0,  // Ground not confirmed at the expected distance yet
+  DROPOFF_TRACKING,     // Ground seen where expected
+  DROPOFF_SUSPECT,      // Deviation seen, waiting for confirmation
+  DROPOFF_COOLDOWN      // Hazard reported, holding off repeats
+};
+
+void DropOff_reset();
+void DropOff_update(uint16_t distanceMm, float pitchDeg, uint16_t maxRangeMm, uint32_t currentTime);
+
+bool DropOff_isAlertActive(uint32_t currentTime);
+DropOffHazard DropOff_getActiveHazard();
+DropOffHazard DropOff_takeAnnouncement();  // Returns a pending hazard once, then HAZARD_NONE
+
+DropOffState DropOff_getState();
+const char* DropOff_getStateName();
+float DropOff_getExpectedGroundMm();
+float DropOff_getSurfaceHeightMm();  // Height of the ToF hit point relative to the ground
+
+#endif // DROPOFFDETECTOR_H
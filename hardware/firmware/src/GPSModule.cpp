@@ -2,29 +2,139 @@
 #include "Pins.h"
 #include "SensorHealth.h"
 #include "SDCardManager.h"
+#include "SatelliteTable.h"
+#include "UbxProtocol.h"
+#include "PdrFilter.h"
+#include "WaypointStore.h"
+#include "PoiDatabase.h"
+#include "RouteEngine.h"
+#include "TrackLogger.h"
 #include <TinyGPS++.h>
-#include <HardwareSerial.h>
 #include <math.h>
+#include <sys/time.h>
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
 
 #include "IMU.h"
 #include "ConnectivityManager.h"
 
-#define SAT_COUNT 32
 #define MAX_GNSS_SYSTEMS 4
 #define MIN_SIGNAL_STRENGTH -180 // Lower threshold to accept weaker signals
 #define ACCURACY_THRESHOLD 100.0 // Much higher threshold for speed
 #define VELOCITY_SMOOTHING_FACTOR 0.1  // Minimal smoothing for faster response
 #define HEADING_SMOOTHING_FACTOR 0.1   // Minimal smoothing for faster response
 
-static TinyGPSPlus gps;
-static HardwareSerial gpsSerial(1);
+static TinyGPSPlus gps;  // Owned by the GPS task once it is running
+
+// ============= UART Ingestion =============
+// The IDF UART driver buffers RX and raises a data event per burst; the GPS
+// task drains it and splits the byte stream into UBX frames and NMEA lines,
+// so loop() stalls no longer overflow the 128-byte hardware FIFO.
+#define GPS_UART_NUM UART_NUM_1
+#define GPS_UART_RX_BUFFER 2048       // Over a second of the planned output
+#define GPS_UART_EVENT_QUEUE 20
+#define GPS_READ_CHUNK 128
+#define GPS_LINK_BUDGET_PCT 60        // Planned output vs link capacity; headroom for bursts and ACKs
+#define GPS_LINK_WINDOW_US 1000000UL
+#define UBX_ACK_TIMEOUT_MS 300
+#define GPS_TASK_STACK_SIZE 4096
+#define GPS_TASK_PRIORITY 3
+#define GPS_TASK_CORE 0
+#define NMEA_MAX_SENTENCE 96          // NMEA allows 82 characters; vendor sentences run longer
+
+// Latest fix plus ingestion counters, written by the GPS task and handed to
+// loop() through a sequence-counted snapshot
+struct GpsFix {
+  double lat;
+  double lon;
+  double altitude;
+  float speedKmph;
+  float courseDeg;
+  float hdop;
+  uint8_t satellites;
+  bool locationValid;
+  bool altitudeValid;
+  bool satellitesValid;
+  bool hdopValid;
+  uint32_t fixCount;          // Position updates so far
+  uint8_t satellitesInView;   // GSV, all systems
+  uint8_t fixType;            // GSA: 1 = none, 2 = 2D, 3 = 3D
+  float pdop;
+  float vdop;
+  float meanSnr;              // Over tracked satellites, all systems
+  float accuracyM;            // UBX hAcc; 0 when the receiver is on NMEA
+  uint64_t utcMs;             // Receiver time of the fix, Unix ms; 0 until it is known
+  GPSUartStats uart;
+  // Last complete one-second window of link traffic
+  uint32_t windowBytes;
+  uint32_t windowMessages;
+  uint32_t windowLatencyAvgUs;  // Last byte on the wire -> parsed
+  uint32_t windowLatencyMaxUs;
+  uint32_t windowEndMicros;
+};
+
+static QueueHandle_t uartEventQueue = nullptr;
+static TaskHandle_t gpsTaskHandle = nullptr;
+static GpsFix working;                      // GPS task only
+static volatile GpsFix published;
+static volatile uint32_t publishSeq = 0;
+static volatile uint32_t byteMicros = 10000000UL / GPS_BAUD;  // 10 bits per byte on the wire
+
+// UBX state: the task decodes frames; CFG senders in loop()/setup() wait on
+// the ACK sequence it publishes
+static UbxParser ubxParser;                 // GPS task only
+static UbxNavPosllh pendingPosition;        // POSLLH waits for the epoch's NAV-SOL
+static uint32_t pendingPositionMicros = 0;
+static bool pendingPositionValid = false;
+static volatile uint32_t ackSeq = 0;
+static volatile uint16_t ackMessage = 0;    // class << 8 | id of the last ACK/NAK
+static volatile bool ackPositive = false;
+static bool ubxConfigured = false;
+static uint32_t ubxBaud = GPS_BAUD;
+static uint8_t baudSwitchFailures = 0;
+
+// Rates the driver tries, fastest first; the NEO-6M supports all of them
+static const uint32_t GPS_BAUD_CANDIDATES[] = {115200, 57600, 38400, 19200, 9600};
+
+// UBX frame sizes including the 8 bytes of framing
+#define UBX_POSLLH_BYTES 36
+#define UBX_SOL_BYTES 60
+#define UBX_VELNED_BYTES 44
+#define UBX_DOP_BYTES 26
+#define UBX_SVINFO_BYTES (16 + 12 * 16)   // 16 channels on u-blox 6
+
+// What the receiver is told to send, sized to the negotiated baud
+struct OutputPlan {
+  uint8_t navRate;            // Hz actually configured (may be below the requested rate)
+  bool dop;
+  uint8_t svinfoDivider;      // Navigation solutions per NAV-SVINFO, 0 = off
+  uint32_t budget;            // Bytes/s allowed by GPS_LINK_BUDGET_PCT
+  uint32_t bytesPerSecond;    // Planned output
+};
+static OutputPlan outputPlan = {0, false, 0, 0, 0};
+
+// Link window accumulators (GPS task only)
+static uint32_t windowStartMicros = 0;
+static uint32_t windowBytes = 0;
+static uint32_t windowMessages = 0;
+static uint32_t windowLatencySum = 0;
+static uint32_t windowLatencyMax = 0;
+
+// Satellite table: parsed by the GPS task, published whole (~1.5 KB) at most
+// once per wake-up and only when a GSV/GSA sentence arrived
+static SatelliteTable satTable;             // GPS task only
+static volatile SatelliteView publishedView;
+static volatile uint32_t viewSeq = 0;
+static bool viewDirty = false;
 
 // Enhanced GPS Configuration and Status
 static GPSConfig gpsConfig = {
   .updateRate = 5,           // 5Hz maximum for fastest updates
   .enableSBAS = false,       // Disable SBAS to reduce processing time
-  .enableMultiGNSS = true,   // Keep multi-constellation for more satellites
-  .dynamicModel = 0,         // Pedestrian model (fastest)
+  .enableMultiGNSS = false,  // NEO-6M tracks GPS (+SBAS) only
+  .dynamicModel = UBX_DYN_PEDESTRIAN,
   .elevationMask = 0,        // 0 degrees elevation mask to use all satellites
   // Jamming detection completely removed for performance
 };
@@ -42,10 +152,6 @@ static GPSStatus gpsStatus = {
   .timeToFirstFix = 0
 };
 
-// Reference "home" coordinates
-static const double REF_LAT = 25.382344;
-static const double REF_LON = 68.327323;
-
 // Enhanced tracking variables
 static uint32_t firstFixTime = 0;
 static bool firstFixAchieved = false;
@@ -56,182 +162,1039 @@ static int signalHistoryIndex = 0;
 static uint32_t configSaveTimer = 0;
 static bool configChanged = false;
 
-// Haversine distance function (meters)
-static double haversine(double lat1, double lon1, double lat2, double lon2) {
-  const double R = 6371000;
-  double dLat = radians(lat2 - lat1);
-  double dLon = radians(lon2 - lon1);
-  double a = sin(dLat/2) * sin(dLat/2) +
-             cos(radians(lat1)) * cos(radians(lat2)) *
-             sin(dLon/2) * sin(dLon/2);
-  double c = 2 * atan2(sqrt(a), sqrt(1-a));
-  return R * c;
-}
-
-struct Satellite {
-  int prn;
-  int elevation;
-  int azimuth;
-  int snr;
-  float quality;
-  bool active;
-  uint8_t system;
+// Reported position: the fused estimate, or the raw fix with fusion off
+static double latFiltered = 0.0;
+static double lonFiltered = 0.0;
+
+// ============= Dead Reckoning Fusion =============
+// Steps and yaw from IMU.cpp predict between fixes; fixes and course correct.
+// Runs on the loop task, after IMU_update() has filled the step count.
+#define PDR_DEFAULT_STEP_M 0.7f
+#define PDR_MIN_COURSE_KMPH 1.8f      // Below this the GPS course is noise
+#define PDR_COURSE_SIGMA_RAD 0.2f     // ~11 deg at walking speed
+#define PDR_NMEA_ACCURACY_PER_HDOP 5.0f
+static PdrFilter pdr;
+static bool pdrEnabled = true;
+static bool pdrStepsSynced = false;
+static uint32_t pdrLastSteps = 0;
+static uint32_t pdrLastFixCount = 0;
+static float pdrLastYawRad = 0;
+struct PdrCycleStats {
+  uint32_t count;
+  uint64_t total;
+  uint32_t max;
+  uint32_t overBudget;
 };
+static PdrCycleStats pdrPredictCycles = {0, 0, 0, 0};
+static PdrCycleStats pdrUpdateCycles = {0, 0, 0, 0};
 
-static Satellite satellites[SAT_COUNT];
-static int satCount = 0;
-static bool newSatData = false;
+// ============= Start-up Aiding =============
+// Without a backup battery the NEO-6M forgets everything at power-off and
+// needs ~30 s to find satellites and decode ephemerides. The last position,
+// the ephemerides and almanac it decoded, and the ESP32 clock when it
+// survived the reset are saved to the SD card and sent back as AID-INI,
+// AID-ALM and AID-EPH right after configuration. There is no shutdown hook,
+// so the aiding file is refreshed periodically while a fix is held.
+#define GPS_CONFIG_PATH "/config/gps_config.txt"
+#define GPS_AID_PATH "/config/gps_aid.bin"
+#define GPS_AID_TEMP_PATH "/config/gps_aid.tmp"
+#define GPS_TTFF_LOG_PATH "/config/gps_ttff.csv"
+#define GPS_AID_MAGIC 0x44494147          // "GAID"
+#define GPS_AID_VERSION 1
+#define GPS_AID_SVS 32
+#define GPS_AID_FIRST_SAVE_MS 60000       // After the first fix, once ephemerides are decoded
+#define GPS_AID_SAVE_MS 900000
+#define GPS_AID_POLL_MARGIN_MS 1000       // On top of the answers' wire time, see aidPollTimeoutMs()
+#define GPS_AID_POS_ACC_M 5000            // The cane may have been carried elsewhere since
+#define GPS_AID_TIME_ACC_MS 2000
+#define GPS_AID_EPH_MAX_AGE_S 14400       // Ephemerides are good for about 4 h
+#define GPS_AID_ALM_MAX_AGE_S 1209600     // Almanac: 2 weeks
+#define GPS_CLOCK_VALID_UNIX 1600000000   // System clock below this was never set
+#define GPS_CLOCK_SYNC_MS 1000            // Set the system clock when it is off by more
+#define GPS_CONFIG_SAVE_DELAY_MS 10000    // Settings are saved once they stop changing
+#define GPS_TTFF_HISTORY 256              // Log lines kept for the distribution
 
-// Simplified position variables for speed
-static double latFiltered = 0.0;
-static double lonFiltered = 0.0;
+struct GpsAidFile {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;
+  int32_t latE7;
+  int32_t lonE7;
+  int32_t altCm;
+  uint32_t hAccCm;
+  uint64_t utcMs;             // Time of the saved fix, 0 = unknown
+  uint32_t ephMask;           // Bit n-1: satellite n has an entry
+  uint32_t almMask;
+  uint8_t eph[GPS_AID_SVS][UBX_AID_EPH_BYTES];
+  uint8_t alm[GPS_AID_SVS][UBX_AID_ALM_BYTES];
+  uint32_t crc;               // Over everything before it
+};
 
-// Position averaging
-static const int POSITION_BUFFER_SIZE = 30;
-static double latBuffer[POSITION_BUFFER_SIZE];
-static double lonBuffer[POSITION_BUFFER_SIZE];
-static int bufferIndex = 0;
-static bool bufferFilled = false;
+static GpsAidFile* aidStore = nullptr;      // Live: the GPS task stores poll answers
+static GpsAidFile* aidSnapshot = nullptr;   // Loop task: file image
+static portMUX_TYPE aidMux = portMUX_INITIALIZER_UNLOCKED;
+static GPSAidStatus aidStatus = {};
+static GpsStartType startType = GPS_START_COLD;
+static uint32_t aidNextPollMs = 0;          // 0 = no fix yet
+static uint32_t aidPollMs = 0;              // Poll sent, saving when it settles
+static uint8_t aidPollAnswers = 0;          // EPH + ALM answers since the poll, under aidMux
+static bool aidPollRequested = false;
 
 // Display control
 static bool showRawData = false;
-static bool showSatellites = true;
-static bool showTop3 = true;
-static uint32_t lastSatDisplay = 0;
-static const uint32_t SAT_DISPLAY_INTERVAL = 5000;
-
-// GSV sentence parsing state
-static int gsvSentenceCount = 0;
-static int gsvSentenceNumber = 0;
-static int gsvSatsInView = 0;
-static bool newGSVData = false;
 
 // Prototypes
 static void handleCommands();
-static void parseNMEA(char c);
-static void processGSV(String sentence);
+static void startGPSTask();
+static bool ubxConfigure();
+static GpsFix readFix();
 static void displayStatus();
-static void displayTop3Satellites();
-static void displayAllSatellites();
-static void kalmanUpdate(double latMeasurement, double lonMeasurement);
-static void updatePositionBuffer(double lat, double lon);
-static double getAverageLat();
-static double getAverageLon();
-static void processPosition(double lat, double lon);
 static void printTwoDigits(int number);
 static void updateGPSStatus();
 static void updateSignalStrength(int strength);
-static void sendGPSCommand(const char* command);
-static uint8_t calculateChecksum(const char* sentence);
 static void saveConfigToSD();
 static void loadConfigFromSD();
+static void storeAidFrame(uint8_t msgId, const uint8_t* payload, uint16_t length);
+static GpsStartType injectAiding();
+static void serviceAiding(const GpsFix& fix);
+static void logTtff();
 
 void GPSModule_init() {
-  gpsSerial.begin(GPS_BAUD, SERIAL_8N1, GPS_RX, GPS_TX);
+  uart_config_t uartConfig = {};
+  uartConfig.baud_rate = GPS_BAUD;
+  uartConfig.data_bits = UART_DATA_8_BITS;
+  uartConfig.parity = UART_PARITY_DISABLE;
+  uartConfig.stop_bits = UART_STOP_BITS_1;
+  uartConfig.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+  uartConfig.source_clk = UART_SCLK_DEFAULT;
+  if (uart_driver_install(GPS_UART_NUM, GPS_UART_RX_BUFFER, 0, GPS_UART_EVENT_QUEUE, &uartEventQueue, 0) != ESP_OK ||
+      uart_param_config(GPS_UART_NUM, &uartConfig) != ESP_OK ||
+      uart_set_pin(GPS_UART_NUM, GPS_TX, GPS_RX, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK) {
+    SensorHealthManager::updateSensorHealth("neo6m", SENSOR_INIT_FAILED, nullptr, "GPS UART driver failed");
+    Serial.println("[GPS] UART driver install failed");
+    return;
+  }
   
-  delay(500);  // Minimal delay for speed
+  // Ingest from now on even if the receiver is still powering up
+  startGPSTask();
+  delay(500);
   
-  // Test GPS UART communication
-  gpsSerial.println("$PMTK000*32"); // Query release
-  delay(100);
+  if (SDCard_fileExists(GPS_CONFIG_PATH)) loadConfigFromSD();
+  firstFixTime = millis();
+  if (ubxConfigure()) {
+    startType = injectAiding();
+    SensorHealthManager::updateSensorHealth("neo6m", SENSOR_OK, "GPS initialized (UBX)");
+#ifdef SC_DEBUG_GPS
+    Serial.printf("[GPS] UBX configured: %uHz, %lu baud, pedestrian model\n", outputPlan.navRate, ubxBaud);
+#endif
+    return;
+  }
   
+  // No UBX ACK: an NMEA-only receiver keeps working through TinyGPS++
   bool responseReceived = false;
   uint32_t startTime = millis();
-  while (millis() - startTime < 1000) { // Wait up to 1 second for response
-    if (gpsSerial.available()) {
+  while (millis() - startTime < 1000) { // Wait up to 1 second for traffic
+    if (readFix().uart.sentences > 0) {
       responseReceived = true;
       break;
     }
+    delay(10);
   }
-  
   if (!responseReceived) {
     SensorHealthManager::updateSensorHealth("neo6m", SENSOR_DISCONNECTED, nullptr, "GPS UART failed");
     Serial.println("[GPS] NEO-6M UART communication failed");
     return;
   }
+  startType = GPS_START_NMEA;
+  SensorHealthManager::updateSensorHealth("neo6m", SENSOR_OK, "GPS initialized (NMEA only)");
+  Serial.println("[GPS] Receiver did not acknowledge UBX configuration, staying on NMEA");
+}
+
+// ============= Fix Time =============
+#define GPS_EPOCH_UNIX_S 315964800ULL      // 1980-01-06
+#define GPS_LEAP_SECONDS 18                // GPS - UTC since 2017
+
+static uint64_t gpsTimeToUnixMs(int16_t week, uint32_t iTOW) {
+  if (week <= 0) return 0;
+  return (GPS_EPOCH_UNIX_S + (uint64_t)week * 604800ULL - GPS_LEAP_SECONDS) * 1000ULL + iTOW;
+}
+
+static void unixMsToGpsTime(uint64_t unixMs, int16_t* week, uint32_t* towMs) {
+  uint64_t gpsMs = unixMs + GPS_LEAP_SECONDS * 1000ULL - GPS_EPOCH_UNIX_S * 1000ULL;
+  *week = (int16_t)(gpsMs / 604800000ULL);
+  *towMs = (uint32_t)(gpsMs % 604800000ULL);
+}
+
+// TinyGPS++ date and time of the latest RMC/GGA as Unix ms, 0 if not valid
+static uint64_t nmeaUtcMs() {
+  if (!gps.date.isValid() || !gps.time.isValid() || gps.date.year() < 2000) return 0;
+  int32_t y = gps.date.year();
+  uint32_t m = gps.date.month();
+  y -= m <= 2;
+  int32_t era = y / 400;
+  uint32_t yoe = y - era * 400;
+  uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + gps.date.day() - 1;
+  uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  int64_t days = (int64_t)era * 146097 + doe - 719468;   // Days since 1970-01-01
+  uint64_t seconds = days * 86400ULL + gps.time.hour() * 3600UL + gps.time.minute() * 60UL + gps.time.second();
+  return seconds * 1000ULL + gps.time.centisecond() * 10UL;
+}
+
+// ============= GPS Task =============
+static void publishFix() {
+  publishSeq++;
+  __sync_synchronize();
+  memcpy((void*)&published, &working, sizeof(working));
+  __sync_synchronize();
+  publishSeq++;
+}
+
+static void publishView() {
+  viewSeq++;
+  __sync_synchronize();
+  memcpy((void*)&publishedView, &satTable.view, sizeof(SatelliteView));
+  __sync_synchronize();
+  viewSeq++;
+}
+
+static void readView(SatelliteView* view) {
+  uint32_t seq;
+  do {
+    seq = viewSeq;
+    __sync_synchronize();
+    memcpy(view, (const void*)&publishedView, sizeof(SatelliteView));
+    __sync_synchronize();
+  } while ((seq & 1) || seq != viewSeq);
+}
+
+// Headline numbers from the satellite table into the fix snapshot
+static void summarizeView(const SatelliteView& view) {
+  uint16_t inView = 0;
+  uint16_t tracked = 0;
+  float snrSum = 0;
+  for (uint8_t system = 0; system < GNSS_COUNT; system++) {
+    inView += view.stats[system].inView;
+    tracked += view.stats[system].tracked;
+    snrSum += view.stats[system].meanSnr * view.stats[system].tracked;
+  }
+  working.satellitesInView = inView > 255 ? 255 : inView;
+  working.fixType = view.fixType;
+  working.pdop = view.pdop;
+  working.vdop = view.vdop;
+  working.meanSnr = tracked ? snrSum / tracked : 0;
+}
+
+static GpsFix readFix() {
+  GpsFix fix;
+  uint32_t seq;
+  do {
+    seq = publishSeq;
+    __sync_synchronize();
+    memcpy(&fix, (const void*)&published, sizeof(fix));
+    __sync_synchronize();
+  } while ((seq & 1) || seq != publishSeq);
+  return fix;
+}
+
+static uint8_t hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return 0xFF;
+}
+
+// "$...*HH" with the XOR of everything between '$' and '*'
+static bool nmeaChecksumValid(const char* sentence, size_t len) {
+  uint8_t checksum = 0;
+  size_t i = 1;
+  while (i < len && sentence[i] != '*') checksum ^= sentence[i++];
+  if (i + 2 >= len) return false;  // No "*HH"
+  uint8_t high = hexValue(sentence[i + 1]);
+  uint8_t low = hexValue(sentence[i + 2]);
+  return high != 0xFF && low != 0xFF && checksum == ((high << 4) | low);
+}
+
+// One '\n'-terminated line from the driver ring: checksum, then the satellite
+// table (GSV/GSA, tokenized in place) or TinyGPS++ for everything else
+static void parseSentence(char* line, size_t len, uint32_t rxMicros) {
+  while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) len--;
+  char* start = (char*)memchr(line, '$', len);
+  if (!start) return;  // Noise or the tail of a sentence lost to an overflow
+  len -= start - line;
+  if (!nmeaChecksumValid(start, len)) {
+    working.uart.checksumErrors++;
+    return;
+  }
+  working.uart.sentences++;
+  bool viewChanged = false;
+  if (SatTable_parse(satTable, start, len, millis(), &viewChanged)) {
+    if (viewChanged) summarizeView(satTable.view);
+    viewDirty = true;
+    return;
+  }
+  for (size_t i = 0; i < len; i++) gps.encode(start[i]);
+  gps.encode('\r');
+  gps.encode('\n');
+  if (gps.location.isUpdated()) {
+    working.lat = gps.location.lat();
+    working.lon = gps.location.lng();
+    working.locationValid = gps.location.isValid();
+    working.utcMs = nmeaUtcMs();
+    working.fixCount++;
+    working.uart.lastFixMicros = rxMicros;
+  }
+  if (gps.altitude.isUpdated()) {
+    working.altitude = gps.altitude.meters();
+    working.altitudeValid = gps.altitude.isValid();
+  }
+  if (gps.speed.isUpdated()) working.speedKmph = gps.speed.kmph();
+  if (gps.course.isUpdated()) working.courseDeg = gps.course.deg();
+  if (gps.satellites.isUpdated()) {
+    working.satellites = gps.satellites.value();
+    working.satellitesValid = gps.satellites.isValid();
+  }
+  if (gps.hdop.isUpdated()) {
+    working.hdop = gps.hdop.hdop();
+    working.hdopValid = gps.hdop.isValid();
+  }
+}
+
+// ============= UBX Frames =============
+static void handleAck() {
+  if (ubxParser.length != 2) return;
+  ackMessage = (ubxParser.payload[0] << 8) | ubxParser.payload[1];
+  ackPositive = ubxParser.msgId == UBX_ACK_ACK;
+  if (ackPositive) working.uart.acks++;
+  else working.uart.naks++;
+  __sync_synchronize();
+  ackSeq++;
+}
+
+// NAV messages of one epoch arrive in ID order: POSLLH, DOP, SOL, VELNED,
+// SVINFO. The position is held until NAV-SOL says whether the fix is good.
+static void handleUbxFrame(uint32_t rxMicros) {
+  const uint8_t* payload = ubxParser.payload;
+  uint16_t length = ubxParser.length;
+  if (ubxParser.msgClass == UBX_CLASS_ACK) {
+    handleAck();
+    return;
+  }
+  if (ubxParser.msgClass == UBX_CLASS_AID) {
+    storeAidFrame(ubxParser.msgId, payload, length);
+    return;
+  }
+  if (ubxParser.msgClass != UBX_CLASS_NAV) return;
+  switch (ubxParser.msgId) {
+    case UBX_NAV_POSLLH:
+      pendingPositionValid = Ubx_decodePosllh(payload, length, &pendingPosition);
+      pendingPositionMicros = rxMicros;
+      break;
+    case UBX_NAV_SOL: {
+      UbxNavSol sol;
+      if (!Ubx_decodeSol(payload, length, &sol)) break;
+      bool fixOk = (sol.flags & 0x01) && sol.gpsFix >= 2 && sol.gpsFix <= 4;
+      working.fixType = (sol.gpsFix == 2) ? 2 : (sol.gpsFix == 3 || sol.gpsFix == 4) ? 3 : 1;
+      working.satellites = sol.numSV;
+      working.satellitesValid = true;
+      satTable.view.fixType = working.fixType;
+      viewDirty = true;
+      if (pendingPositionValid && pendingPosition.iTOW == sol.iTOW) {
+        working.lat = pendingPosition.lat * 1e-7;
+        working.lon = pendingPosition.lon * 1e-7;
+        working.altitude = pendingPosition.hMslMm / 1000.0;
+        working.altitudeValid = fixOk && working.fixType == 3;
+        working.accuracyM = pendingPosition.hAccMm / 1000.0f;
+        working.locationValid = fixOk;
+        working.utcMs = (sol.flags & 0x0C) == 0x0C ? gpsTimeToUnixMs(sol.week, sol.iTOW) : 0;
+        working.fixCount++;
+        working.uart.lastFixMicros = pendingPositionMicros;
+        pendingPositionValid = false;
+      }
+      break;
+    }
+    case UBX_NAV_VELNED: {
+      UbxNavVelned velned;
+      if (!Ubx_decodeVelned(payload, length, &velned)) break;
+      working.speedKmph = velned.gSpeedCms * 0.036f;
+      working.courseDeg = velned.heading * 1e-5f;
+      break;
+    }
+    case UBX_NAV_DOP: {
+      UbxNavDop dop;
+      if (!Ubx_decodeDop(payload, length, &dop)) break;
+      working.hdop = satTable.view.hdop = dop.hDop * 0.01f;
+      working.hdopValid = true;
+      working.pdop = satTable.view.pdop = dop.pDop * 0.01f;
+      working.vdop = satTable.view.vdop = dop.vDop * 0.01f;
+      viewDirty = true;
+      break;
+    }
+    case UBX_NAV_SVINFO: {
+      static Satellite channels[SATS_PER_SYSTEM];
+      uint32_t now = millis();
+      for (uint8_t system = 0; system < GNSS_COUNT; system++) {
+        uint8_t count = Ubx_decodeSvInfo(payload, length, system, channels, SATS_PER_SYSTEM);
+        if (count > 0 || satTable.view.count[system] > 0) {
+          SatTable_setSystem(satTable, system, channels, count, now);
+        }
+      }
+      summarizeView(satTable.view);
+      viewDirty = true;
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// ============= Stream Demux =============
+// UBX frames start with B5 62, NMEA lines with '$'; neither byte occurs in
+// the other protocol's framing, so one pass splits the stream.
+static char nmeaLine[NMEA_MAX_SENTENCE + 1];  // GPS task only
+static size_t nmeaLength = 0;
+static bool nmeaActive = false;
+static uint32_t batchMessages = 0;
+
+static void countMessage(uint32_t rxMicros) {
+  uint32_t latency = micros() - rxMicros;
+  batchMessages++;
+  windowMessages++;
+  windowLatencySum += latency;
+  if (latency > windowLatencyMax) windowLatencyMax = latency;
+}
+
+// Rolls the one-second window into the snapshot; runs on every wake-up
+static void rollLinkWindow(uint32_t nowMicros) {
+  if (nowMicros - windowStartMicros < GPS_LINK_WINDOW_US) return;
+  uint32_t elapsed = nowMicros - windowStartMicros;
+  // Scale to bytes per second when wake-ups do not line up with the window
+  working.windowBytes = (uint32_t)((uint64_t)windowBytes * GPS_LINK_WINDOW_US / elapsed);
+  working.windowMessages = (uint32_t)((uint64_t)windowMessages * GPS_LINK_WINDOW_US / elapsed);
+  working.windowLatencyAvgUs = windowMessages ? windowLatencySum / windowMessages : 0;
+  working.windowLatencyMaxUs = windowLatencyMax;
+  working.windowEndMicros = nowMicros;
+  windowStartMicros = nowMicros;
+  windowBytes = windowMessages = windowLatencySum = windowLatencyMax = 0;
+}
+
+static void ingestByte(uint8_t byte, uint32_t rxMicros) {
+  if (!nmeaActive || byte == UBX_SYNC_1) {
+    UbxFeedResult result = Ubx_feed(ubxParser, byte);
+    if (result == UBX_FRAME) {
+      handleUbxFrame(rxMicros);
+      countMessage(rxMicros);
+      return;
+    }
+    if (result == UBX_CONSUMED) {
+      nmeaActive = false;  // A frame start aborts a truncated line
+      return;
+    }
+  }
+  if (byte == '$') {
+    nmeaActive = true;
+    nmeaLength = 0;
+  }
+  if (!nmeaActive) return;  // Noise between messages
+  if (nmeaLength >= NMEA_MAX_SENTENCE) {
+    // Not NMEA (or two sentences glued by a lost '\n'): discard it
+    working.uart.oversized++;
+    nmeaActive = false;
+    return;
+  }
+  nmeaLine[nmeaLength++] = byte;
+  if (byte == '\n') {
+    nmeaLine[nmeaLength] = '\0';
+    parseSentence(nmeaLine, nmeaLength, rxMicros);
+    nmeaActive = false;
+    countMessage(rxMicros);
+  }
+}
+
+// Everything the driver holds, in one pass. Each message is back-dated from
+// the bytes still queued behind its last byte.
+static void readStream(uint32_t wakeMicros) {
+  uint8_t chunk[GPS_READ_CHUNK];
+  size_t buffered = 0;
+  uart_get_buffered_data_len(GPS_UART_NUM, &buffered);
+  batchMessages = 0;
+  while (buffered > 0) {
+    int got = uart_read_bytes(GPS_UART_NUM, chunk, buffered > GPS_READ_CHUNK ? GPS_READ_CHUNK : buffered, 0);
+    if (got <= 0) break;
+    buffered = (buffered > (size_t)got) ? buffered - got : 0;
+    working.uart.bytes += got;
+    windowBytes += got;
+    uint32_t perByte = byteMicros;
+    for (int i = 0; i < got; i++) {
+      ingestByte(chunk[i], wakeMicros - (uint32_t)(got - 1 - i + buffered) * perByte);
+    }
+  }
+  working.uart.ubxFrames = ubxParser.frames;
+  working.uart.ubxChecksumErrors = ubxParser.checksumErrors;
+  if (batchMessages > 0) {
+    working.uart.batches++;
+    if (batchMessages > working.uart.maxBatch) working.uart.maxBatch = batchMessages;
+  }
+}
+
+static void recoverFromOverflow() {
+  working.uart.overflows++;
+  uart_flush_input(GPS_UART_NUM);
+  xQueueReset(uartEventQueue);
+  Ubx_reset(ubxParser);
+  nmeaActive = false;
+}
+
+static uint32_t trackedFixCount = 0;
+
+// Hands the new fix to the track logger, which only encodes into RAM
+static void recordTrackPoint() {
+  TrackPoint point;
+  point.utcMs = working.utcMs;
+  point.latE7 = (int32_t)lround(working.lat * 1e7);
+  point.lonE7 = (int32_t)lround(working.lon * 1e7);
+  point.altDm = working.altitudeValid ? (int32_t)lround(working.altitude * 10.0) : 0;
+  point.speedCms = (uint16_t)constrain(working.speedKmph * (100.0f / 3.6f), 0.0f, 65535.0f);
+  point.hdopCenti = working.hdopValid ? (uint16_t)constrain(working.hdop * 100.0f, 0.0f, 65535.0f) : 9999;
+  point.satellites = working.satellites;
+  TrackLog_record(point);
+}
+
+static void gpsTask(void* parameter) {
+  uart_event_t event;
+  for (;;) {
+    if (xQueueReceive(uartEventQueue, &event, portMAX_DELAY) != pdTRUE) continue;
+    uint32_t wakeMicros = micros();
+    switch (event.type) {
+      case UART_DATA:
+        readStream(wakeMicros);
+        break;
+      case UART_FIFO_OVF:
+      case UART_BUFFER_FULL:
+        recoverFromOverflow();
+        break;
+      default:
+        break;
+    }
+    rollLinkWindow(micros());
+    publishFix();
+    if (working.fixCount != trackedFixCount) {
+      trackedFixCount = working.fixCount;
+      if (working.locationValid) recordTrackPoint();
+    }
+    TrackLog_service();
+    if (viewDirty) {
+      publishView();
+      viewDirty = false;
+    }
+  }
+}
+
+static void startGPSTask() {
+  if (gpsTaskHandle) return;
+  Ubx_reset(ubxParser);
+  windowStartMicros = micros();
+  SatTable_reset(satTable);
+  summarizeView(satTable.view);
+  publishFix();
+  publishView();
+  xTaskCreatePinnedToCore(
+    gpsTask,
+    "GPS_UART",
+    GPS_TASK_STACK_SIZE,
+    nullptr,
+    GPS_TASK_PRIORITY,
+    &gpsTaskHandle,
+    GPS_TASK_CORE
+  );
+  if (!gpsTaskHandle) {
+    Serial.println("❌ GPS task could not be created");
+  }
+}
+
+// ============= UBX Configuration =============
+static void ubxSend(uint8_t msgClass, uint8_t msgId, const uint8_t* payload, uint16_t length) {
+  uint8_t frame[UBX_AID_EPH_BYTES + UBX_FRAME_OVERHEAD];
+  size_t size = Ubx_buildFrame(msgClass, msgId, payload, length, frame, sizeof(frame));
+  if (size) uart_write_bytes(GPS_UART_NUM, frame, size);
+}
+
+// CFG message, then wait for the GPS task to see its ACK; false on NAK or timeout
+static bool ubxCommand(uint8_t msgId, const uint8_t* payload, uint16_t length) {
+  uint16_t message = (UBX_CLASS_CFG << 8) | msgId;
+  uint32_t seq = ackSeq;
+  ubxSend(UBX_CLASS_CFG, msgId, payload, length);
+  uint32_t start = millis();
+  while (millis() - start < UBX_ACK_TIMEOUT_MS) {
+    if (ackSeq != seq) {
+      seq = ackSeq;
+      __sync_synchronize();
+      if (ackMessage == message) return ackPositive;
+    }
+    delay(5);
+  }
+  return false;
+}
+
+static void setLocalBaud(uint32_t baud) {
+  uart_wait_tx_done(GPS_UART_NUM, pdMS_TO_TICKS(100));
+  uart_set_baudrate(GPS_UART_NUM, baud);
+  byteMicros = 10000000UL / baud;
+}
+
+// CFG-RATE is harmless and always ACKed, so it doubles as a probe
+static bool ubxProbe() {
+  uint8_t payload[6];
+  return ubxCommand(UBX_CFG_RATE, payload, Ubx_cfgRate(payload, 1000));
+}
+
+// The receiver ACKs CFG-PRT at the old rate (often lost) and then switches;
+// the next ACK at the new rate confirms it
+static bool ubxSwitchBaud(uint32_t baud) {
+  uint8_t payload[20];
+  ubxSend(UBX_CLASS_CFG, UBX_CFG_PRT, payload, Ubx_cfgPrtUart(payload, baud));
+  setLocalBaud(baud);
+  delay(100);
+  if (ubxProbe()) {
+    ubxBaud = baud;
+    return true;
+  }
+  setLocalBaud(ubxBaud);
+  return false;
+}
+
+// Navigation rate and message set that fit the link budget. Position,
+// solution and velocity go out every epoch; the rate drops before they do.
+// DOP and satellite detail take what is left (SVINFO down to every 5 s).
+static OutputPlan planOutput(uint8_t requestedRate, uint32_t baud) {
+  OutputPlan plan;
+  plan.budget = baud / 10 * GPS_LINK_BUDGET_PCT / 100;
+  const uint32_t epochBytes = UBX_POSLLH_BYTES + UBX_SOL_BYTES + UBX_VELNED_BYTES;
+  uint8_t rate = requestedRate;
+  while (rate > 1 && epochBytes * rate > plan.budget) rate--;
+  plan.navRate = rate;
+  plan.bytesPerSecond = epochBytes * rate;
+  plan.dop = plan.bytesPerSecond + UBX_DOP_BYTES * rate <= plan.budget;
+  if (plan.dop) plan.bytesPerSecond += UBX_DOP_BYTES * rate;
+  plan.svinfoDivider = 0;
+  for (uint8_t seconds = 1; seconds <= 5; seconds++) {
+    if (plan.bytesPerSecond + UBX_SVINFO_BYTES / seconds <= plan.budget) {
+      plan.svinfoDivider = rate * seconds;
+      plan.bytesPerSecond += UBX_SVINFO_BYTES / seconds;
+      break;
+    }
+  }
+  return plan;
+}
+
+// Plans for the current baud and pushes CFG-RATE + CFG-MSG; returns NAK/timeout count
+static uint8_t ubxApplyPlan() {
+  outputPlan = planOutput(gpsConfig.updateRate, ubxBaud);
+  uint8_t payload[6];
+  uint8_t failures = 0;
+  if (!ubxCommand(UBX_CFG_RATE, payload, Ubx_cfgRate(payload, 1000 / outputPlan.navRate))) failures++;
+  const uint8_t rates[][2] = {
+    {UBX_NAV_POSLLH, 1},
+    {UBX_NAV_SOL, 1},
+    {UBX_NAV_VELNED, 1},
+    {UBX_NAV_DOP, (uint8_t)(outputPlan.dop ? 1 : 0)},
+    {UBX_NAV_SVINFO, outputPlan.svinfoDivider},
+  };
+  for (const auto& entry : rates) {
+    if (!ubxCommand(UBX_CFG_MSG, payload, Ubx_cfgMsg(payload, UBX_CLASS_NAV, entry[0], entry[1]))) failures++;
+  }
+  if (outputPlan.navRate < gpsConfig.updateRate) {
+    Serial.printf("[GPS] %lu baud link budget allows %uHz (requested %uHz)\n",
+                  (unsigned long)ubxBaud, outputPlan.navRate, gpsConfig.updateRate);
+  }
+  return failures;
+}
+
+// CFG-RST is not acknowledged; the port settings survive a GPS-only reset
+static void ubxReset(uint16_t navBbrMask) {
+  uint8_t payload[4];
+  ubxSend(UBX_CLASS_CFG, UBX_CFG_RST, payload, Ubx_cfgRst(payload, navBbrMask));
+}
+
+static bool ubxApplyNav5() {
+  uint8_t payload[36];
+  return ubxCommand(UBX_CFG_NAV5, payload, Ubx_cfgNav5(payload, gpsConfig.dynamicModel, gpsConfig.elevationMask));
+}
+
+static bool ubxApplySbas() {
+  uint8_t payload[8];
+  return ubxCommand(UBX_CFG_SBAS, payload, Ubx_cfgSbas(payload, gpsConfig.enableSBAS));
+}
+
+// NEO-6M boots at 9600, but after an ESP32-only reset it is still on
+// whatever rate was negotiated last time
+static bool ubxFindBaud() {
+  setLocalBaud(GPS_BAUD);
+  if (ubxProbe()) {
+    ubxBaud = GPS_BAUD;
+    return true;
+  }
+  for (uint32_t baud : GPS_BAUD_CANDIDATES) {
+    if (baud == GPS_BAUD) continue;
+    setLocalBaud(baud);
+    if (ubxProbe()) {
+      ubxBaud = baud;
+      return true;
+    }
+  }
+  setLocalBaud(GPS_BAUD);
+  ubxBaud = GPS_BAUD;
+  return false;
+}
+
+// Fastest rate that verifies, trying from the top; each failure falls back
+// to the next candidate
+static void ubxNegotiateBaud() {
+  for (uint32_t baud : GPS_BAUD_CANDIDATES) {
+    if (baud <= ubxBaud) return;
+    if (ubxSwitchBaud(baud)) return;
+    baudSwitchFailures++;
+    // The receiver may have switched even though its ACK never arrived
+    if (!ubxProbe() && !ubxFindBaud()) return;
+  }
+}
+
+static bool ubxConfigure() {
+  if (!ubxFindBaud()) return false;
+  ubxConfigured = true;
+  ubxNegotiateBaud();
   
-  // Speed-optimized GPS configuration
-  // Set maximum update rate (5Hz = 200ms)
-  gpsSerial.println("$PMTK220,200*2C");
-  delay(50);
-  
-  // Disable SBAS for faster processing
-  gpsSerial.println("$PMTK313,0*2F");
-  delay(50);
-  
-  // Enable all GNSS for maximum satellite availability
-  gpsSerial.println("$PMTK353,1,1,1,1,1*2B");  // GPS+GLONASS+Galileo+BeiDou+QZSS
-  delay(50);
-  
-  // Set portable dynamic model (fastest acquisition)
-  gpsSerial.println("$PMTK886,0*28");
-  delay(50);
-  
-  // Minimal output sentences for speed
-  gpsSerial.println("$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*29");
-  delay(50);
-  
-  // Disable elevation mask (use all satellites)
-  gpsSerial.println("$PMTK397,0*23");
-  delay(50);
-  
-  // Enable hot start for fastest subsequent fixes
-  gpsSerial.println("$PMTK101*32");
-  
-  firstFixTime = millis();
-  
-  // Report successful initialization
-  SensorHealthManager::updateSensorHealth("neo6m", SENSOR_OK, "GPS initialized");
-  
+  uint8_t payload[3];
+  uint8_t failures = 0;
+  static const uint8_t NMEA_IDS[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05};  // GGA GLL GSA GSV RMC VTG
+  for (uint8_t id : NMEA_IDS) {
+    if (!ubxCommand(UBX_CFG_MSG, payload, Ubx_cfgMsg(payload, UBX_CLASS_NMEA, id, 0))) failures++;
+  }
+  if (!ubxApplyNav5()) failures++;
+  if (!ubxApplySbas()) failures++;
+  failures += ubxApplyPlan();
+  if (failures > 0) {
+    Serial.printf("[GPS] %u UBX configuration messages not acknowledged\n", failures);
+  }
+  return true;
+}
+
+// Aiding data: GPS task side. Poll answers replace the stored entry; the
+// short form means the receiver no longer has data for that satellite.
+static void storeAidFrame(uint8_t msgId, const uint8_t* payload, uint16_t length) {
+  if (!aidStore || length < UBX_AID_EMPTY_BYTES) return;
+  uint8_t sv = payload[0];
+  if (sv < 1 || sv > GPS_AID_SVS) return;
+  uint32_t bit = 1UL << (sv - 1);
+  portENTER_CRITICAL(&aidMux);
+  if (aidPollAnswers < 2 * GPS_AID_SVS) aidPollAnswers++;
+  if (msgId == UBX_AID_EPH) {
+    if (length == UBX_AID_EPH_BYTES) {
+      memcpy(aidStore->eph[sv - 1], payload, length);
+      aidStore->ephMask |= bit;
+    } else {
+      aidStore->ephMask &= ~bit;
+    }
+  } else if (msgId == UBX_AID_ALM) {
+    if (length == UBX_AID_ALM_BYTES) {
+      memcpy(aidStore->alm[sv - 1], payload, length);
+      aidStore->almMask |= bit;
+    } else {
+      aidStore->almMask &= ~bit;
+    }
+  }
+  portEXIT_CRITICAL(&aidMux);
+}
+
+static bool systemClockMs(uint64_t* unixMs) {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  if (tv.tv_sec < GPS_CLOCK_VALID_UNIX) return false;
+  *unixMs = (uint64_t)tv.tv_sec * 1000ULL + tv.tv_usec / 1000;
+  return true;
+}
+
+static bool loadAidFile() {
+  File file = SD.open(GPS_AID_PATH, FILE_READ);
+  if (!file) return false;
+  size_t got = file.read((uint8_t*)aidSnapshot, sizeof(GpsAidFile));
+  file.close();
+  return got == sizeof(GpsAidFile) && aidSnapshot->magic == GPS_AID_MAGIC &&
+         aidSnapshot->version == GPS_AID_VERSION && aidSnapshot->size == sizeof(GpsAidFile) &&
+         aidSnapshot->crc == SDCard_crc32((const uint8_t*)aidSnapshot, offsetof(GpsAidFile, crc));
+}
+
+// Loop task, after ubxConfigure(): position and time first, then almanac
+// and ephemerides (not acknowledged on u-blox 6; ~5 KB on the wire)
+static GpsStartType injectAiding() {
+  if (!aidStore) {
+    aidStore = (GpsAidFile*)(psramFound() ? ps_malloc(2 * sizeof(GpsAidFile)) : malloc(2 * sizeof(GpsAidFile)));
+    if (!aidStore) return GPS_START_COLD;
+    aidSnapshot = aidStore + 1;
+  }
+  memset(aidStore, 0, sizeof(GpsAidFile));
+  if (!SDCard_fileExists(GPS_AID_PATH) || !loadAidFile()) return GPS_START_COLD;
+  portENTER_CRITICAL(&aidMux);
+  memcpy(aidStore, aidSnapshot, sizeof(GpsAidFile));
+  portEXIT_CRITICAL(&aidMux);
+  aidStatus.ephemerisSaved = __builtin_popcount(aidSnapshot->ephMask);
+  aidStatus.almanacSaved = __builtin_popcount(aidSnapshot->almMask);
+
+  uint64_t nowMs = 0;
+  bool timeKnown = systemClockMs(&nowMs);
+  // Without a clock the age is unknown; the receiver drops stale data itself
+  int64_t ageS = (timeKnown && aidSnapshot->utcMs) ? (int64_t)(nowMs - aidSnapshot->utcMs) / 1000 : -1;
+  int16_t week = 0;
+  uint32_t towMs = 0;
+  if (timeKnown) unixMsToGpsTime(nowMs, &week, &towMs);
+  uint8_t payload[48];
+  uint32_t accCm = max(aidSnapshot->hAccCm, (uint32_t)GPS_AID_POS_ACC_M * 100);
+  ubxSend(UBX_CLASS_AID, UBX_AID_INI, payload,
+          Ubx_aidIni(payload, aidSnapshot->latE7, aidSnapshot->lonE7, aidSnapshot->altCm, accCm, week, towMs,
+                     GPS_AID_TIME_ACC_MS));
+  aidStatus.positionInjected = true;
+  aidStatus.timeInjected = timeKnown;
+  if (ageS < GPS_AID_ALM_MAX_AGE_S) {
+    for (uint8_t i = 0; i < GPS_AID_SVS; i++) {
+      if (!(aidSnapshot->almMask & (1UL << i))) continue;
+      ubxSend(UBX_CLASS_AID, UBX_AID_ALM, aidSnapshot->alm[i], UBX_AID_ALM_BYTES);
+      aidStatus.almanacInjected++;
+    }
+  }
+  if (ageS < GPS_AID_EPH_MAX_AGE_S) {
+    for (uint8_t i = 0; i < GPS_AID_SVS; i++) {
+      if (!(aidSnapshot->ephMask & (1UL << i))) continue;
+      ubxSend(UBX_CLASS_AID, UBX_AID_EPH, aidSnapshot->eph[i], UBX_AID_EPH_BYTES);
+      aidStatus.ephemerisInjected++;
+    }
+  }
 #ifdef SC_DEBUG_GPS
-  Serial.println("[GPS] MAXIMUM SPEED initialization complete");
-  Serial.println("[GPS] 5Hz update rate, all GNSS enabled, no accuracy filtering");
-  Serial.println("Commands: [r]aw, [s]ats, [t]op3, [v]iew, [d]status");
+  Serial.printf("[GPS] Aiding: position%s, %u ephemerides, %u almanac entries\n", timeKnown ? " + time" : "",
+                aidStatus.ephemerisInjected, aidStatus.almanacInjected);
 #endif
+  if (aidStatus.ephemerisInjected == 0) return GPS_START_POSITION;
+  return timeKnown ? GPS_START_FULL : GPS_START_EPHEMERIS;
 }
 
-void GPSModule_update(SensorData* data) {
-  // Ultra-fast GPS processing - minimal overhead
-  static uint32_t lastGPSHealthCheck = 0;
-  bool dataReceived = false;
-  
-  while (gpsSerial.available() > 0) {
-    dataReceived = true;
-    if (gps.encode(gpsSerial.read())) {
-      // Record TTFF only once
-      if (!firstFixAchieved && gps.location.isValid()) {
-        gpsStatus.timeToFirstFix = millis() - firstFixTime;
-        firstFixAchieved = true;
-        SensorHealthManager::updateSensorHealth("neo6m", SENSOR_OK, "First fix achieved");
-      }
-      
-      // Process position immediately without filtering
-      if (gps.location.isValid()) {
-        latFiltered = gps.location.lat();
-        lonFiltered = gps.location.lng();
-        
-        // Update health with satellite count
-        uint8_t satCount = gps.satellites.isValid() ? gps.satellites.value() : 0;
-        SensorHealthManager::updateSensorHealth("neo6m", SENSOR_OK, String(satCount).c_str());
-        
-        // Direct assignment - no smoothing for maximum speed
-        if (gps.speed.isValid()) {
-          smoothedVelocity = gps.speed.kmph();
-        }
-        if (gps.course.isValid()) {
-          smoothedHeading = gps.course.deg();
+// Temp file + rename: a power cut mid-write keeps the previous file
+static bool writeAidFile() {
+  portENTER_CRITICAL(&aidMux);
+  memcpy(aidSnapshot, aidStore, sizeof(GpsAidFile));
+  portEXIT_CRITICAL(&aidMux);
+  aidSnapshot->magic = GPS_AID_MAGIC;
+  aidSnapshot->version = GPS_AID_VERSION;
+  aidSnapshot->size = sizeof(GpsAidFile);
+  aidSnapshot->crc = SDCard_crc32((const uint8_t*)aidSnapshot, offsetof(GpsAidFile, crc));
+  if (SD.exists(GPS_AID_TEMP_PATH)) SD.remove(GPS_AID_TEMP_PATH);
+  File file = SD.open(GPS_AID_TEMP_PATH, FILE_WRITE);
+  if (!file) return false;
+  bool ok = file.write((const uint8_t*)aidSnapshot, sizeof(GpsAidFile)) == sizeof(GpsAidFile);
+  file.close();
+  if (!ok) {
+    SD.remove(GPS_AID_TEMP_PATH);
+    return false;
+  }
+  SD.remove(GPS_AID_PATH);
+  if (!SD.rename(GPS_AID_TEMP_PATH, GPS_AID_PATH)) return false;
+  aidStatus.ephemerisSaved = __builtin_popcount(aidSnapshot->ephMask);
+  aidStatus.almanacSaved = __builtin_popcount(aidSnapshot->almMask);
+  aidStatus.saves++;
+  aidStatus.lastSaveMs = millis();
+  return true;
+}
+
+// The receiver answers a poll with one frame per satellite (~5 KB in all),
+// sharing the link with the navigation output: allow twice the wire time
+static uint32_t aidPollTimeoutMs() {
+  uint32_t bytes = GPS_AID_SVS * (UBX_AID_EPH_BYTES + UBX_AID_ALM_BYTES + 2 * UBX_FRAME_OVERHEAD);
+  return bytes * 10UL * 1000UL / ubxBaud * 2 + GPS_AID_POLL_MARGIN_MS;
+}
+
+// Loop task, per update: poll ephemerides/almanac on schedule, save once
+// every satellite has been answered (or the poll times out)
+static void serviceAiding(const GpsFix& fix) {
+  if (!aidStore || !ubxConfigured) return;
+  uint32_t now = millis();
+  if (aidPollMs) {
+    portENTER_CRITICAL(&aidMux);
+    uint8_t answers = aidPollAnswers;
+    portEXIT_CRITICAL(&aidMux);
+    bool complete = answers >= 2 * GPS_AID_SVS;
+    if (!complete && now - aidPollMs < aidPollTimeoutMs()) return;
+    aidPollMs = 0;
+    if (!complete) Serial.printf("[GPS] Aiding poll timed out, %u of %u answers\n", answers, 2 * GPS_AID_SVS);
+    if (!writeAidFile()) Serial.println("[GPS] Could not save aiding data");
+    aidNextPollMs = now + GPS_AID_SAVE_MS;
+    return;
+  }
+  if (!fix.locationValid) return;
+  if (aidNextPollMs == 0) aidNextPollMs = now + GPS_AID_FIRST_SAVE_MS;
+  if (!aidPollRequested && (int32_t)(now - aidNextPollMs) < 0) return;
+  aidPollRequested = false;
+  uint64_t utcMs = fix.utcMs;
+  if (!utcMs) systemClockMs(&utcMs);
+  portENTER_CRITICAL(&aidMux);
+  aidStore->latE7 = (int32_t)lround(fix.lat * 1e7);
+  aidStore->lonE7 = (int32_t)lround(fix.lon * 1e7);
+  aidStore->altCm = fix.altitudeValid ? (int32_t)lround(fix.altitude * 100.0) : 0;
+  aidStore->hAccCm = fix.accuracyM > 0 ? (uint32_t)(fix.accuracyM * 100.0f) : 0;
+  aidStore->utcMs = utcMs;
+  aidPollAnswers = 0;
+  portEXIT_CRITICAL(&aidMux);
+  uint8_t none = 0;
+  ubxSend(UBX_CLASS_AID, UBX_AID_EPH, &none, 0);
+  ubxSend(UBX_CLASS_AID, UBX_AID_ALM, &none, 0);
+  aidPollMs = now ? now : 1;
+}
+
+// The ESP32 clock survives software resets and deep sleep: it is the time
+// source for the next start's AID-INI, and gives BlackBox a wall time
+static void syncSystemClock(const GpsFix& fix) {
+  if (!fix.utcMs) return;
+  uint64_t fixNowMs = fix.utcMs + (micros() - fix.uart.lastFixMicros) / 1000;
+  uint64_t clockMs = 0;
+  systemClockMs(&clockMs);
+  if (clockMs > fixNowMs - GPS_CLOCK_SYNC_MS && clockMs < fixNowMs + GPS_CLOCK_SYNC_MS) return;
+  struct timeval tv;
+  tv.tv_sec = fixNowMs / 1000;
+  tv.tv_usec = (fixNowMs % 1000) * 1000;
+  settimeofday(&tv, nullptr);
+}
+
+static void logTtff() {
+  char line[48];
+  uint64_t unixMs = 0;
+  systemClockMs(&unixMs);
+  int len = snprintf(line, sizeof(line), "%s,%lu,%lu\n", GPSModule_startTypeName(startType),
+                     (unsigned long)gpsStatus.timeToFirstFix, (unsigned long)(unixMs / 1000));
+  SDCard_appendFile(GPS_TTFF_LOG_PATH, (const uint8_t*)line, len);
+}
+
+// Driver counters into SensorHealth; an error report wins over an OK one
+static void reportIngestHealth(const GpsFix& fix) {
+  static uint32_t seenOverflows = 0;
+  static uint32_t seenChecksumErrors = 0;
+  static uint32_t seenFixes = 0;
+  char message[48];
+  if (fix.uart.overflows != seenOverflows) {
+    snprintf(message, sizeof(message), "GPS UART overflow (%lu total)", (unsigned long)fix.uart.overflows);
+    SensorHealthManager::updateSensorHealth("neo6m", SENSOR_ERROR, nullptr, message);
+  } else if (fix.uart.checksumErrors + fix.uart.ubxChecksumErrors != seenChecksumErrors) {
+    snprintf(message, sizeof(message), "GPS checksum errors (%lu total)",
+             (unsigned long)(fix.uart.checksumErrors + fix.uart.ubxChecksumErrors));
+    SensorHealthManager::updateSensorHealth("neo6m", SENSOR_ERROR, nullptr, message);
+  } else if (fix.fixCount != seenFixes && fix.locationValid) {
+    // Update health with satellite count
+    uint8_t satCount = fix.satellitesValid ? fix.satellites : 0;
+    SensorHealthManager::updateSensorHealth("neo6m", SENSOR_OK, String(satCount).c_str());
+  }
+  seenOverflows = fix.uart.overflows;
+  seenChecksumErrors = fix.uart.checksumErrors + fix.uart.ubxChecksumErrors;
+  seenFixes = fix.fixCount;
+}
+
+static void recordCycles(PdrCycleStats& stats, uint32_t cycles) {
+  stats.count++;
+  stats.total += cycles;
+  if (cycles > stats.max) stats.max = cycles;
+  if (cycles > PDR_UPDATE_CYCLE_BUDGET) stats.overBudget++;
+}
+
+// New steps predict, a new fix updates; the output falls back to the raw fix
+// until the filter has a position (or when fusion is off)
+static void fusePosition(const GpsFix& fix, const SensorData& data) {
+  // imuYaw is smoothed as a unit vector, so it does not swing at 0/360
+  float yawRad = data.imuYaw * (float)DEG_TO_RAD;
+  pdrLastYawRad = yawRad;
+  if (!pdrStepsSynced || data.totalSteps < pdrLastSteps) {
+    pdrLastSteps = data.totalSteps;   // First call, or the count was reset
+    pdrStepsSynced = true;
+  }
+  uint32_t newSteps = data.totalSteps - pdrLastSteps;
+  pdrLastSteps = data.totalSteps;
+
+  if (pdrEnabled && pdr.initialized) {
+    for (uint32_t i = 0; i < newSteps; i++) {
+      uint32_t start = ESP.getCycleCount();
+      Pdr_predictStep(pdr, yawRad);
+      recordCycles(pdrPredictCycles, ESP.getCycleCount() - start);
+    }
+  }
+
+  if (fix.locationValid && fix.fixCount != pdrLastFixCount) {
+    pdrLastFixCount = fix.fixCount;
+    float accuracy = fix.accuracyM > 0 ? fix.accuracyM
+                   : fix.hdopValid ? fix.hdop * PDR_NMEA_ACCURACY_PER_HDOP : gpsStatus.accuracy;
+    if (pdrEnabled) {
+      uint32_t start = ESP.getCycleCount();
+      if (!pdr.initialized) {
+        float stepLength = IMU_getGaitMetrics().stepLengthM;
+        Pdr_init(pdr, fix.lat, fix.lon, accuracy, stepLength > 0 ? stepLength : PDR_DEFAULT_STEP_M);
+      } else {
+        Pdr_updateFix(pdr, fix.lat, fix.lon, accuracy);
+        if (fix.speedKmph >= PDR_MIN_COURSE_KMPH) {
+          Pdr_updateCourse(pdr, fix.courseDeg * (float)DEG_TO_RAD, yawRad, PDR_COURSE_SIGMA_RAD);
         }
       }
-      
+      recordCycles(pdrUpdateCycles, ESP.getCycleCount() - start);
+    }
+    if (!pdrEnabled || !pdr.initialized) {
+      latFiltered = fix.lat;
+      lonFiltered = fix.lon;
     }
   }
+  if (pdrEnabled && pdr.initialized) Pdr_getPosition(pdr, &latFiltered, &lonFiltered);
+}
+
+void GPSModule_update(SensorData* data) {
+  static uint32_t lastGPSHealthCheck = 0;
+  static uint32_t sentencesAtLastCheck = 0;
+  static uint32_t waypointFixCount = 0;
+  GpsFix fix = readFix();
+  
+  // Record TTFF only once
+  if (!firstFixAchieved && fix.locationValid) {
+    gpsStatus.timeToFirstFix = millis() - firstFixTime;
+    firstFixAchieved = true;
+    SensorHealthManager::updateSensorHealth("neo6m", SENSOR_OK, "First fix achieved");
+    logTtff();
+  }
+  reportIngestHealth(fix);
+  serviceAiding(fix);
+  if (configChanged && millis() - configSaveTimer > GPS_CONFIG_SAVE_DELAY_MS) {
+    saveConfigToSD();
+    configChanged = false;
+  }
+  
+  if (fix.locationValid) {
+    smoothedVelocity = fix.speedKmph;
+    smoothedHeading = fix.courseDeg;
+  }
+  if (data) fusePosition(fix, *data);
+  if (fix.locationValid && fix.fixCount != waypointFixCount) {
+    waypointFixCount = fix.fixCount;
+    syncSystemClock(fix);
+    Waypoint_update(latFiltered, lonFiltered);   // Geofence events for the loop to announce
+    Poi_updatePosition(latFiltered, lonFiltered); // Nearby POIs, looked up off the loop task
+    Route_update(latFiltered, lonFiltered);       // Turn-by-turn progress along a planned route
+  }
+  gpsStatus.isFixed = fix.locationValid;
+  gpsStatus.satellitesUsed = fix.satellitesValid ? fix.satellites : 0;
+  if (fix.hdopValid) gpsStatus.hdop = fix.hdop;
+  gpsStatus.satellitesVisible = fix.satellitesInView;
+  gpsStatus.fixType = fix.fixType >= 2 ? fix.fixType : 0;
+  gpsStatus.pdop = fix.pdop;
+  gpsStatus.vdop = fix.vdop;
+  gpsStatus.signalStrength = (int8_t)lroundf(fix.meanSnr);
+  if (fix.accuracyM > 0) gpsStatus.accuracy = fix.accuracyM;
   
   // Check for GPS timeout (no data received)
   if (millis() - lastGPSHealthCheck > 5000) { // Check every 5 seconds
     lastGPSHealthCheck = millis();
-    if (!dataReceived && !gps.location.isValid()) {
+    bool dataReceived = fix.uart.sentences + fix.uart.ubxFrames != sentencesAtLastCheck;
+    sentencesAtLastCheck = fix.uart.sentences + fix.uart.ubxFrames;
+    if (!dataReceived && !fix.locationValid) {
       SensorHealthManager::updateSensorHealth("neo6m", SENSOR_TIMEOUT, nullptr, "No GPS data");
-    } else if (!gps.location.isValid()) {
+    } else if (!fix.locationValid) {
       SensorHealthManager::updateSensorHealth("neo6m", SENSOR_ERROR, nullptr, "No GPS fix");
     }
   }
@@ -240,111 +1203,176 @@ void GPSModule_update(SensorData* data) {
    if (data) {
      data->gpsLat = latFiltered;
      data->gpsLon = lonFiltered;
-     data->gpsAlt = gps.altitude.isValid() ? gps.altitude.meters() : 0;
+     data->gpsAlt = fix.altitudeValid ? fix.altitude : 0;
      data->gpsSpeed = smoothedVelocity;
-     data->gpsSatellites = gps.satellites.isValid() ? gps.satellites.value() : 0;
+     data->gpsSatellites = fix.satellitesValid ? fix.satellites : 0;
    }
 }
 
-// --- All static helper functions below (from v7.ino) ---
-static void parseNMEA(char c) {
-  static String nmeaBuffer;
-  static bool inSentence = false;
-  if (c == '$') {
-    nmeaBuffer = "$";
-    inSentence = true;
-    return;
+void GPSModule_enableFusion(bool enable) {
+  if (enable && !pdrEnabled) Pdr_reset(pdr);  // Restart from the next fix
+  pdrEnabled = enable;
+}
+
+bool GPSModule_isFusionEnabled() {
+  return pdrEnabled;
+}
+
+static void printCycleStats(const char* name, const PdrCycleStats& stats) {
+  Serial.printf("   %s: %lu runs, %lu cycles avg, %lu max, %lu over budget\n", name,
+                (unsigned long)stats.count, (unsigned long)(stats.count ? stats.total / stats.count : 0),
+                (unsigned long)stats.max, (unsigned long)stats.overBudget);
+}
+
+void GPSModule_printFilterStatus() {
+  Serial.println("\n🧭 GPS/Step Fusion:");
+  Serial.printf("   Fusion: %s\n", pdrEnabled ? "ON" : "OFF (raw fixes)");
+  if (!pdr.initialized) {
+    Serial.println("   State: waiting for the first fix");
+  } else {
+    double lat, lon;
+    Pdr_getPosition(pdr, &lat, &lon);
+    Serial.printf("   Position: %.7f, %.7f (+/-%.1f m)\n", lat, lon, Pdr_positionSigma(pdr));
+    if (pdr.headingLocked) {
+      Serial.printf("   Heading: %.1f° (offset %.1f° +/-%.1f°)\n", Pdr_headingDeg(pdr, pdrLastYawRad),
+                    pdr.x[PDR_STATE_HEADING_OFFSET] * RAD_TO_DEG,
+                    sqrtf(pdr.P[PDR_STATE_HEADING_OFFSET][PDR_STATE_HEADING_OFFSET]) * RAD_TO_DEG);
+    } else {
+      Serial.println("   Heading: waiting for GPS course while walking");
+    }
+    Serial.printf("   Step length: %.2f m (+/-%.2f)\n", pdr.x[PDR_STATE_STEP_LENGTH],
+                  sqrtf(pdr.P[PDR_STATE_STEP_LENGTH][PDR_STATE_STEP_LENGTH]));
   }
-  if (inSentence) {
-    if (c == '\r' || c == '\n') {
-      inSentence = false;
-      if (nmeaBuffer.startsWith("$GPGSV") || 
-          nmeaBuffer.startsWith("$GLGSV") || 
-          nmeaBuffer.startsWith("$GAGSV")) {
-        processGSV(nmeaBuffer);
-      }
-      nmeaBuffer = "";
-    } else if (nmeaBuffer.length() < 120) {
-      nmeaBuffer += c;
-    }
-  }
-}
-static void processGSV(String sentence) {
-  int params[20] = {0};
-  int paramCount = 0;
-  int start = 0;
-  for (int i = 0; i < sentence.length(); i++) {
-    if (sentence[i] == ',' || sentence[i] == '*') {
-      String param = sentence.substring(start, i);
-      start = i + 1;
-      if (paramCount < 20) {
-        params[paramCount] = (param.length() > 0 && param[0] >= '0') ? param.toInt() : 0;
-      }
-      paramCount++;
-    }
-  }
-  if (paramCount >= 4) {
-    gsvSentenceCount = params[1];
-    gsvSentenceNumber = params[2];
-    gsvSatsInView = params[3];
-    if (gsvSentenceNumber == 1) satCount = 0;
-    uint8_t systemID = 0;
-    if (sentence.startsWith("$GLGSV")) systemID = 1;
-    if (sentence.startsWith("$GAGSV")) systemID = 2;
-    for (int i = 4; i < paramCount && i < 20; i += 4) {
-      if (params[i] > 0 && satCount < SAT_COUNT) {
-        satellites[satCount].system = systemID;
-        satellites[satCount].prn = params[i];
-        satellites[satCount].elevation = (i+1 < paramCount) ? params[i+1] : 0;
-        satellites[satCount].azimuth = (i+2 < paramCount) ? params[i+2] : 0;
-        satellites[satCount].snr = (i+3 < paramCount) ? params[i+3] : 0;
-        float elevFactor = 0.5 + (satellites[satCount].elevation / 180.0);
-        satellites[satCount].quality = satellites[satCount].snr * elevFactor;
-        satellites[satCount].active = false;
-        if (gps.satellites.isValid() && satCount < gps.satellites.value()) {
-          satellites[satCount].active = true;
-        }
-        satCount++;
-      }
+  Serial.printf("   Steps %lu, fixes %lu, course updates %lu, rejected %lu, resets %lu\n",
+                (unsigned long)pdr.steps, (unsigned long)pdr.fixes, (unsigned long)pdr.headingUpdates,
+                (unsigned long)pdr.rejected, (unsigned long)pdr.resets);
+  Serial.printf("   Cycle budget: %lu per run\n", (unsigned long)PDR_UPDATE_CYCLE_BUDGET);
+  printCycleStats("Predict", pdrPredictCycles);
+  printCycleStats("Update", pdrUpdateCycles);
+}
+
+GPSUartStats GPSModule_getUartStats() {
+  return readFix().uart;
+}
+
+GPSLinkStats GPSModule_getLinkStats() {
+  GpsFix fix = readFix();
+  GPSLinkStats link = {};
+  link.baud = ubxBaud;
+  link.capacity = ubxBaud / 10;
+  link.budget = outputPlan.budget;
+  link.plannedBytesPerSecond = outputPlan.bytesPerSecond;
+  link.navRate = outputPlan.navRate;
+  link.dopEnabled = outputPlan.dop;
+  link.svinfoDivider = outputPlan.svinfoDivider;
+  link.baudSwitchFailures = baudSwitchFailures;
+  // A window older than two seconds means the receiver went quiet
+  if (fix.windowEndMicros != 0 && micros() - fix.windowEndMicros < 2 * GPS_LINK_WINDOW_US) {
+    link.bytesPerSecond = fix.windowBytes;
+    link.messagesPerSecond = fix.windowMessages;
+    link.latencyAvgUs = fix.windowLatencyAvgUs;
+    link.latencyMaxUs = fix.windowLatencyMaxUs;
+  }
+  link.utilization = link.capacity ? (float)link.bytesPerSecond / link.capacity : 0;
+  if (outputPlan.navRate) {
+    link.epochWireUs = (uint32_t)((uint64_t)outputPlan.bytesPerSecond * byteMicros / outputPlan.navRate);
+  }
+  return link;
+}
+
+void GPSModule_printLinkStatus() {
+  GPSLinkStats link = GPSModule_getLinkStats();
+  GpsFix fix = readFix();
+  Serial.println("📍 GPS Status:");
+  Serial.printf("   Fix: %s | Satellites used: %u | HDOP: %.1f | Accuracy: %.1fm\n",
+                fix.locationValid ? (fix.fixType == 3 ? "3D" : "2D") : "none",
+                fix.satellitesValid ? fix.satellites : 0, fix.hdop, gpsStatus.accuracy);
+  Serial.printf("   Protocol: %s @ %lu baud (%u failed baud switches)\n",
+                ubxConfigured ? "UBX" : "NMEA", (unsigned long)link.baud, link.baudSwitchFailures);
+  if (ubxConfigured) {
+    Serial.printf("   Output plan: %uHz POSLLH+SOL+VELNED%s", link.navRate, link.dopEnabled ? "+DOP" : "");
+    if (link.svinfoDivider) Serial.printf(", SVINFO every %u epochs", link.svinfoDivider);
+    Serial.printf(" (requested %uHz)\n", gpsConfig.updateRate);
+    Serial.printf("   Budget: %lu of %lu B/s | Planned: %lu B/s | Epoch on wire: %.1f ms\n",
+                  (unsigned long)link.budget, (unsigned long)link.capacity,
+                  (unsigned long)link.plannedBytesPerSecond, link.epochWireUs / 1000.0f);
+  }
+  Serial.printf("   Measured: %lu B/s, %lu msg/s | Utilization: %.1f%%\n",
+                (unsigned long)link.bytesPerSecond, (unsigned long)link.messagesPerSecond,
+                link.utilization * 100.0f);
+  Serial.printf("   Receive latency: avg %lu us, max %lu us\n",
+                (unsigned long)link.latencyAvgUs, (unsigned long)link.latencyMaxUs);
+}
+
+void GPSModule_getSatelliteView(SatelliteView* view) {
+  readView(view);
+}
+
+static SatelliteView commandView;  // Too large for the loop task stack
+
+static void printSatelliteRow(const Satellite& sat) {
+  Serial.printf("   %s %3u  %3d°  %3u°  %2u  %5.1f %s\n", SatTable_systemName(sat.system), sat.prn,
+                sat.elevation, sat.azimuth, sat.snr, sat.quality, sat.active ? "✅" : "");
+}
+
+void GPSModule_printSatellites() {
+  readView(&commandView);
+  Serial.println("🛰️ Satellites by Constellation:");
+  uint32_t now = millis();
+  bool any = false;
+  for (uint8_t system = 0; system < GNSS_COUNT; system++) {
+    const GnssSnrStats& stats = commandView.stats[system];
+    if (commandView.updatedMs[system] == 0) continue;
+    any = true;
+    Serial.printf("   %s: %u in view, %u tracked, %u used", SatTable_systemName(system),
+                  stats.inView, stats.tracked, stats.used);
+    if (stats.tracked > 0) {
+      Serial.printf(" | SNR %u-%u dB-Hz (mean %.1f)", stats.minSnr, stats.maxSnr, stats.meanSnr);
     }
-    if (gsvSentenceNumber == gsvSentenceCount) {
-      newSatData = true;
-      newGSVData = true;
+    Serial.printf(" | %lu ms ago\n", (unsigned long)(now - commandView.updatedMs[system]));
+  }
+  if (!any) Serial.println("   No GSV data received yet");
+  Serial.printf("   Fix: %s | PDOP %.1f HDOP %.1f VDOP %.1f\n",
+                commandView.fixType == 3 ? "3D" : commandView.fixType == 2 ? "2D" : "none",
+                commandView.pdop, commandView.hdop, commandView.vdop);
+  Serial.printf("   GSV: %lu | GSA: %lu | Malformed: %lu\n", (unsigned long)commandView.gsvSentences,
+                (unsigned long)commandView.gsaSentences, (unsigned long)commandView.malformed);
+}
+
+void GPSModule_printTopSatellites(uint8_t count) {
+  Satellite top[8];
+  if (count > 8) count = 8;
+  readView(&commandView);
+  uint8_t found = SatTable_top(commandView, top, count);
+  Serial.printf("🛰️ Top %u Satellites by Quality:\n", count);
+  if (found == 0) {
+    Serial.println("   No tracked satellites");
+    return;
+  }
+  Serial.println("   SYS PRN  Elev  Azim SNR  Qual Used");
+  for (uint8_t i = 0; i < found; i++) printSatelliteRow(top[i]);
+}
+
+void GPSModule_printSatelliteView() {
+  readView(&commandView);
+  Serial.println("🛰️ All Satellites in View:");
+  Serial.println("   SYS PRN  Elev  Azim SNR  Qual Used");
+  uint8_t total = 0;
+  for (uint8_t system = 0; system < GNSS_COUNT; system++) {
+    for (uint8_t i = 0; i < commandView.count[system]; i++) {
+      printSatelliteRow(commandView.sats[system][i]);
+      total++;
     }
   }
+  Serial.printf("   Total: %u satellites\n", total);
 }
+
+// --- All static helper functions below (from v7.ino) ---
 static void handleCommands() {
   // GPS module no longer processes individual characters to avoid conflicts
   // with main serial command processing. GPS commands are now handled
   // through the main command system in SmartCaneMain.ino
 }
-// Removed Kalman filtering for maximum speed
-static void updatePositionBuffer(double lat, double lon) {
-  latBuffer[bufferIndex] = lat;
-  lonBuffer[bufferIndex] = lon;
-  bufferIndex = (bufferIndex + 1) % POSITION_BUFFER_SIZE;
-  if (bufferIndex == 0) bufferFilled = true;
-}
-static double getAverageLat() {
-  double sum = 0.0;
-  int count = bufferFilled ? POSITION_BUFFER_SIZE : bufferIndex;
-  if (count == 0) return 0.0;
-  for (int i = 0; i < count; i++) sum += latBuffer[i];
-  return sum / count;
-}
-static double getAverageLon() {
-  double sum = 0.0;
-  int count = bufferFilled ? POSITION_BUFFER_SIZE : bufferIndex;
-  if (count == 0) return 0.0;
-  for (int i = 0; i < count; i++) sum += lonBuffer[i];
-  return sum / count;
-}
-static void processPosition(double lat, double lon) {
-  // Direct assignment for maximum speed - no filtering
-  latFiltered = lat;
-  lonFiltered = lon;
-  updatePositionBuffer(lat, lon);
-}
 static void displayStatus() {
   static uint32_t lastDisplay = 0;
   if (millis() - lastDisplay < 1000) return;
@@ -392,19 +1420,21 @@ static void displayStatus() {
     Serial.print(latFiltered, 9);
     Serial.print("  FILT LON: ");
     Serial.print(lonFiltered, 9);
-    if (bufferFilled || bufferIndex > 4) {
-      Serial.print("\nAVG LAT: ");
-      Serial.print(getAverageLat(), 9);
-      Serial.print("  AVG LON: ");
-      Serial.print(getAverageLon(), 9);
+    if (pdr.initialized) {
+      Serial.print("  (+/-");
+      Serial.print(Pdr_positionSigma(pdr), 1);
+      Serial.print(" m)");
     }
     Serial.println();
-    double distance = haversine(latFiltered, lonFiltered, REF_LAT, REF_LON);
-    Serial.print("Distance from reference: ");
-    Serial.print(distance, 2);
-    Serial.println(" meters");
-    if (distance < 10) {
-      Serial.println("\u2705 You are at the reference point!");
+    Waypoint home;
+    if (Waypoint_getHome(&home)) {
+      float distance = Waypoint_distance(home, latFiltered, lonFiltered, nullptr);
+      Serial.print("Distance from home: ");
+      Serial.print(distance, 2);
+      Serial.println(" meters");
+      if (distance < home.radiusM) {
+        Serial.println("\u2705 You are at home!");
+      }
     }
     if (gps.altitude.isValid()) {
       Serial.print("ALT: ");
@@ -436,7 +1466,7 @@ static void displayStatus() {
     Serial.print("--");
   }
   Serial.print("  Sats in view: ");
-  Serial.print(satCount);
+  Serial.print(gpsStatus.satellitesVisible);
   Serial.print("  HDOP: ");
   if (gps.hdop.isValid()) {
     float hdop = gps.hdop.value() / 100.0;
@@ -467,80 +1497,6 @@ static void printTwoDigits(int number) {
   Serial.print(number);
 #endif
 }
-static void displayTop3Satellites() {
-#ifdef SC_DEBUG_GPS
-  Serial.println("\n--- TOP 3 SATELLITES BY QUALITY ---");
-#endif
-  if (satCount == 0) {
-#ifdef SC_DEBUG_GPS
-    Serial.println("No satellites detected");
-#endif
-    return;
-  }
-  for (int i = 0; i < satCount - 1; i++) {
-    for (int j = i + 1; j < satCount; j++) {
-      if (satellites[j].quality > satellites[i].quality) {
-        Satellite temp = satellites[i];
-        satellites[i] = satellites[j];
-        satellites[j] = temp;
-      }
-    }
-  }
-#ifdef SC_DEBUG_GPS
-  Serial.println("SYS PRN Elev Azim SNR Qual");
-  Serial.println("-------------------------");
-#endif
-  int displayCount = min(3, satCount);
-  int validCount = 0;
-  for (int i = 0; i < displayCount; i++) {
-    if (satellites[i].prn > 0) {
-      switch(satellites[i].system) {
-        case 0: Serial.print("GPS "); break;
-        case 1: Serial.print("GLO "); break;
-        case 2: Serial.print("GAL "); break;
-        default: Serial.print("UNK "); break;
-      }
-      Serial.print(satellites[i].prn);
-      Serial.print("   ");
-      if (satellites[i].elevation < 100) Serial.print(" ");
-      Serial.print(satellites[i].elevation);
-      Serial.print("\u00b0");
-      Serial.print("  ");
-      if (satellites[i].azimuth < 100) Serial.print(" ");
-      if (satellites[i].azimuth < 10) Serial.print(" ");
-      Serial.print(satellites[i].azimuth);
-      Serial.print("\u00b0");
-      Serial.print("  ");
-      Serial.print(satellites[i].snr);
-      Serial.print("  ");
-      Serial.print(satellites[i].quality, 1);
-      Serial.println();
-      validCount++;
-    }
-  }
-  if (validCount == 0) {
-#ifdef SC_DEBUG_GPS
-    Serial.println("No valid satellites detected");
-#endif
-  }
-#ifdef SC_DEBUG_GPS
-  Serial.print("Total tracked: ");
-  Serial.println(satCount);
-#endif
-}
-static void displayAllSatellites() {
-  if (!newGSVData) {
-#ifdef SC_DEBUG_GPS
-    Serial.println("\nNo recent satellite data. Wait for GSV update.");
-#endif
-    return;
-  }
-#ifdef SC_DEBUG_GPS
-  Serial.println("\n--- DETAILED SATELLITE INFO ---");
-  // Rest of function continues...
-#endif
-}
-
 // ===== ENHANCED GPS FUNCTIONS =====
 
 static void updateGPSStatus() {
@@ -559,21 +1515,6 @@ static void updateSignalStrength(int strength) {
   // Signal strength tracking disabled for speed
 }
 
-static void sendGPSCommand(const char* command) {
-  uint8_t checksum = calculateChecksum(command);
-  gpsSerial.print(command);
-  gpsSerial.printf("%02X\r\n", checksum);
-  delay(100);
-}
-
-static uint8_t calculateChecksum(const char* sentence) {
-  uint8_t checksum = 0;
-  for (int i = 1; sentence[i] != '*' && sentence[i] != '\0'; i++) {
-    checksum ^= sentence[i];
-  }
-  return checksum;
-}
-
 static void saveConfigToSD() {
   String configData = String(gpsConfig.updateRate) + "," +
                      String(gpsConfig.enableSBAS) + "," +
@@ -582,11 +1523,11 @@ static void saveConfigToSD() {
                      String(gpsConfig.elevationMask) + "," +
                      String(false); // Jamming detection removed
   
-  SDCard_writeFile("/config/gps_config.txt", configData.c_str());
+  SDCard_writeFile(GPS_CONFIG_PATH, configData.c_str());
 }
 
 static void loadConfigFromSD() {
-  String configData = SDCard_readFile("/config/gps_config.txt");
+  String configData = SDCard_readFile(GPS_CONFIG_PATH);
   if (configData.length() > 0) {
     int commaIndex = 0;
     int lastIndex = 0;
@@ -596,7 +1537,7 @@ static void loadConfigFromSD() {
       String param = configData.substring(lastIndex, commaIndex);
       
       switch (paramIndex) {
-        case 0: gpsConfig.updateRate = param.toInt(); break;
+        case 0: gpsConfig.updateRate = constrain(param.toInt(), 1, 5); break;
         case 1: gpsConfig.enableSBAS = param.toInt(); break;
         case 2: gpsConfig.enableMultiGNSS = param.toInt(); break;
         case 3: gpsConfig.dynamicModel = param.toInt(); break;
@@ -615,28 +1556,24 @@ static void loadConfigFromSD() {
 void GPSModule_setUpdateRate(uint8_t rate) {
   if (rate >= 1 && rate <= 5) {
     gpsConfig.updateRate = rate;
-    String cmd = "$PMTK220," + String(1000 / rate) + "*";
-    sendGPSCommand(cmd.c_str());
+    if (ubxConfigured) ubxApplyPlan();
     configChanged = true;
+    configSaveTimer = millis();
   }
 }
 
 void GPSModule_enableSBAS(bool enable) {
   gpsConfig.enableSBAS = enable;
-  if (enable) {
-    sendGPSCommand("$PMTK313,1*");  // Enable SBAS
-    sendGPSCommand("$PMTK301,2*");  // Enable DGPS
-  } else {
-    sendGPSCommand("$PMTK313,0*");  // Disable SBAS
-  }
+  if (ubxConfigured) ubxApplySbas();
   configChanged = true;
+  configSaveTimer = millis();
 }
 
 void GPSModule_setDynamicModel(uint8_t model) {
   gpsConfig.dynamicModel = model;
-  String cmd = "$PMTK886," + String(model) + "*";
-  sendGPSCommand(cmd.c_str());
+  if (ubxConfigured) ubxApplyNav5();
   configChanged = true;
+  configSaveTimer = millis();
 }
 
 void GPSModule_enableAntiJamming(bool enable) {
@@ -644,27 +1581,30 @@ void GPSModule_enableAntiJamming(bool enable) {
 }
 
 void GPSModule_performColdStart() {
-  sendGPSCommand("$PMTK104*");  // Cold start
+  ubxReset(0xFFFF);  // Cold start
   firstFixTime = millis();
   firstFixAchieved = false;
+  startType = GPS_START_RESET_COLD;
 #ifdef SC_DEBUG_GPS
   Serial.println("[GPS] Cold start initiated");
 #endif
 }
 
 void GPSModule_performWarmStart() {
-  sendGPSCommand("$PMTK102*");  // Warm start
+  ubxReset(0x0001);  // Warm start
   firstFixTime = millis();
   firstFixAchieved = false;
+  startType = GPS_START_RESET_WARM;
 #ifdef SC_DEBUG_GPS
   Serial.println("[GPS] Warm start initiated");
 #endif
 }
 
 void GPSModule_performHotStart() {
-  sendGPSCommand("$PMTK101*");  // Hot start
+  ubxReset(0x0000);  // Hot start
   firstFixTime = millis();
   firstFixAchieved = false;
+  startType = GPS_START_RESET_HOT;
 #ifdef SC_DEBUG_GPS
   Serial.println("[GPS] Hot start initiated");
 #endif
@@ -678,6 +1618,14 @@ GPSConfig GPSModule_getConfig() {
   return gpsConfig;
 }
 
+bool GPSModule_isUbxActive() {
+  return ubxConfigured;
+}
+
+uint32_t GPSModule_getBaud() {
+  return ubxBaud;
+}
+
 void GPSModule_saveConfig() {
   saveConfigToSD();
   configChanged = false;
@@ -705,12 +1653,94 @@ uint32_t GPSModule_getTimeToFirstFix() {
   return gpsStatus.timeToFirstFix;
 }
 
-void GPSModule_enablePowerSaving(bool enable) {
-  if (enable) {
-    sendGPSCommand("$PMTK225,4*");  // Backup mode
-  } else {
-    sendGPSCommand("$PMTK225,0*");  // Normal mode
+GPSAidStatus GPSModule_getAidStatus() {
+  GPSAidStatus status = aidStatus;
+  status.startType = startType;
+  return status;
+}
+
+const char* GPSModule_startTypeName(GpsStartType type) {
+  static const char* NAMES[GPS_START_TYPES] = {
+    "cold", "position", "ephemeris", "full", "nmea", "reset-cold", "reset-warm", "reset-hot"
+  };
+  return type < GPS_START_TYPES ? NAMES[type] : "?";
+}
+
+void GPSModule_printTtffStats() {
+  GPSAidStatus status = GPSModule_getAidStatus();
+  Serial.println("\n⏱️ Time to First Fix:");
+  Serial.printf("   This start: %s", GPSModule_startTypeName(status.startType));
+  if (firstFixAchieved) Serial.printf(", first fix after %.1f s\n", gpsStatus.timeToFirstFix / 1000.0f);
+  else Serial.printf(", no fix yet (%.0f s)\n", (millis() - firstFixTime) / 1000.0f);
+  if (status.positionInjected) {
+    Serial.printf("   Injected: position%s, %u ephemerides, %u almanac entries\n", status.timeInjected ? " + time" : "",
+                  status.ephemerisInjected, status.almanacInjected);
+  }
+  Serial.printf("   Aiding file: %u ephemerides, %u almanac entries", status.ephemerisSaved, status.almanacSaved);
+  if (status.lastSaveMs) Serial.printf(", saved %lu s ago\n", (unsigned long)((millis() - status.lastSaveMs) / 1000));
+  else Serial.println(", not saved this session");
+
+  // Distribution over the last GPS_TTFF_HISTORY logged starts
+  static uint8_t types[GPS_TTFF_HISTORY];
+  static uint32_t ttffs[GPS_TTFF_HISTORY];
+  static uint32_t sorted[GPS_TTFF_HISTORY];
+  uint16_t count = 0, head = 0;
+  File file = SD.open(GPS_TTFF_LOG_PATH, FILE_READ);
+  while (file && file.available()) {
+    String line = file.readStringUntil('\n');
+    int comma = line.indexOf(',');
+    if (comma <= 0) continue;
+    String name = line.substring(0, comma);
+    uint8_t type = 0;
+    while (type < GPS_START_TYPES && name != GPSModule_startTypeName((GpsStartType)type)) type++;
+    if (type == GPS_START_TYPES) continue;
+    types[head] = type;
+    ttffs[head] = line.substring(comma + 1).toInt();
+    head = (head + 1) % GPS_TTFF_HISTORY;
+    if (count < GPS_TTFF_HISTORY) count++;
+  }
+  if (file) file.close();
+  if (count == 0) {
+    Serial.println("   No logged starts yet");
+    return;
   }
+  Serial.printf("   Last %u starts (%s):\n", count, GPS_TTFF_LOG_PATH);
+  Serial.println("   start        count  median    p90     max");
+  for (uint8_t type = 0; type < GPS_START_TYPES; type++) {
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < count; i++) {
+      if (types[i] != type) continue;
+      uint32_t value = ttffs[i];
+      uint16_t j = n++;
+      for (; j > 0 && sorted[j - 1] > value; j--) sorted[j] = sorted[j - 1];
+      sorted[j] = value;
+    }
+    if (n == 0) continue;
+    Serial.printf("   %-11s %6u %6.1fs %6.1fs %6.1fs\n", GPSModule_startTypeName((GpsStartType)type), n,
+                  sorted[n / 2] / 1000.0f, sorted[min(n - 1, n * 9 / 10)] / 1000.0f, sorted[n - 1] / 1000.0f);
+  }
+}
+
+bool GPSModule_saveAiding() {
+  if (!aidStore || !ubxConfigured || !gpsStatus.isFixed) return false;
+  aidPollRequested = true;
+  return true;
+}
+
+void GPSModule_clearAiding() {
+  if (aidStore) {
+    portENTER_CRITICAL(&aidMux);
+    memset(aidStore, 0, sizeof(GpsAidFile));
+    portEXIT_CRITICAL(&aidMux);
+  }
+  SD.remove(GPS_AID_PATH);
+  aidStatus.ephemerisSaved = aidStatus.almanacSaved = 0;
+  aidNextPollMs = 0;
+}
+
+void GPSModule_enablePowerSaving(bool enable) {
+  uint8_t payload[2];
+  if (ubxConfigured) ubxCommand(UBX_CFG_RXM, payload, Ubx_cfgRxm(payload, enable));  // Power save / continuous
 #ifdef SC_DEBUG_GPS
   Serial.printf("[GPS] Power saving %s\n", enable ? "enabled" : "disabled");
 #endif
@@ -719,8 +1749,8 @@ void GPSModule_enablePowerSaving(bool enable) {
 void GPSModule_setElevationMask(uint8_t degrees) {
   if (degrees <= 90) {
     gpsConfig.elevationMask = degrees;
-    String cmd = "$PMTK307," + String(degrees) + "*";
-    sendGPSCommand(cmd.c_str());
+    if (ubxConfigured) ubxApplyNav5();
     configChanged = true;
+    configSaveTimer = millis();
   }
 }
\ No newline at end of file
@@ -2,13 +2,14 @@
 #ifndef GPSMODULE_H
 #define GPSMODULE_H
 #include "SensorData.h"
+#include "SatelliteTable.h"
 
 // GPS Configuration and Status
 struct GPSConfig {
   uint16_t updateRate;        // Navigation update rate (1-5Hz)
   bool enableSBAS;            // SBAS (WAAS/EGNOS) support
   bool enableMultiGNSS;       // Multi-constellation support
-  uint8_t dynamicModel;       // Dynamic platform model
+  uint8_t dynamicModel;       // u-blox NAV5 model: 0 portable, 3 pedestrian, 4 automotive
   uint16_t elevationMask;     // Satellite elevation mask (degrees)
   // Jamming detection completely removed for performance
 };
@@ -26,6 +27,66 @@ struct GPSStatus {
   uint32_t timeToFirstFix;    // TTFF in milliseconds
 };
 
+// UART ingestion counters (GPS task)
+struct GPSUartStats {
+  uint32_t sentences;         // Sentences with a valid checksum
+  uint32_t checksumErrors;
+  uint32_t overflows;         // Driver ring, hardware FIFO or pattern queue overflows
+  uint32_t oversized;         // Lines too long to be NMEA, discarded
+  uint32_t batches;           // Task wake-ups that parsed at least one sentence
+  uint32_t maxBatch;          // Most sentences parsed in one wake-up
+  uint32_t lastFixMicros;     // UART receive time of the latest position message
+  uint32_t ubxFrames;         // UBX frames with a valid checksum
+  uint32_t ubxChecksumErrors;
+  uint32_t acks;              // CFG messages acknowledged / rejected
+  uint32_t naks;
+  uint32_t bytes;             // Everything read from the UART
+};
+
+// Link budget: what was negotiated and planned vs what is measured
+struct GPSLinkStats {
+  uint32_t baud;
+  uint32_t capacity;          // Bytes/s the baud rate can carry (10 bits per byte)
+  uint32_t budget;            // Share of the capacity the output plan may use
+  uint32_t plannedBytesPerSecond;
+  uint8_t navRate;            // Hz configured; below GPSConfig.updateRate when the budget is short
+  bool dopEnabled;
+  uint8_t svinfoDivider;      // Solutions per NAV-SVINFO, 0 = off
+  uint8_t baudSwitchFailures;
+  uint32_t bytesPerSecond;    // Measured over the last second
+  uint32_t messagesPerSecond;
+  float utilization;          // bytesPerSecond / capacity
+  uint32_t latencyAvgUs;      // Last byte received -> message parsed
+  uint32_t latencyMaxUs;
+  uint32_t epochWireUs;       // Time one epoch of planned output spends on the wire
+};
+
+// How the receiver started, for the TTFF log; aided starts inject what was
+// saved from the last session before navigation is requested
+enum GpsStartType : uint8_t {
+  GPS_START_COLD = 0,         // Nothing saved
+  GPS_START_POSITION,         // Last position (and almanac)
+  GPS_START_EPHEMERIS,        // + ephemerides; the receiver still decodes the time
+  GPS_START_FULL,             // + time from the ESP32 clock (kept through a reset or deep sleep)
+  GPS_START_NMEA,             // Receiver not on UBX, nothing can be injected
+  GPS_START_RESET_COLD,       // gpscoldstart / gpswarmstart / gpshotstart
+  GPS_START_RESET_WARM,
+  GPS_START_RESET_HOT,
+  GPS_START_TYPES
+};
+
+struct GPSAidStatus {
+  GpsStartType startType;
+  bool positionInjected;
+  bool timeInjected;
+  uint8_t ephemerisInjected;  // Satellites
+  uint8_t almanacInjected;
+  uint8_t ephemerisSaved;     // In the aiding file as of the last save
+  uint8_t almanacSaved;
+  uint32_t saves;
+  uint32_t lastSaveMs;        // millis() of the last save, 0 = none this boot
+};
+
 // Enhanced GPS Functions
 void GPSModule_init();
 void GPSModule_update(SensorData* data);
@@ -37,12 +98,29 @@ void GPSModule_performColdStart();
 void GPSModule_performWarmStart();
 void GPSModule_performHotStart();
 GPSStatus GPSModule_getStatus();
+GPSUartStats GPSModule_getUartStats();
+GPSLinkStats GPSModule_getLinkStats();
+void GPSModule_printLinkStatus();
+void GPSModule_getSatelliteView(SatelliteView* view);
+void GPSModule_printSatellites();             // Per-constellation SNR summary
+void GPSModule_printTopSatellites(uint8_t count);
+void GPSModule_printSatelliteView();          // Every satellite in view
+void GPSModule_enableFusion(bool enable);     // Step/IMU dead reckoning fused with fixes (default on)
+bool GPSModule_isFusionEnabled();
+void GPSModule_printFilterStatus();
 GPSConfig GPSModule_getConfig();
+bool GPSModule_isUbxActive();               // Receiver configured over UBX (else NMEA only)
+uint32_t GPSModule_getBaud();
 void GPSModule_saveConfig();
 void GPSModule_loadConfig();
 bool GPSModule_isJammingDetected(); // Completely removed, always returns false
 float GPSModule_getPositionAccuracy();
 uint32_t GPSModule_getTimeToFirstFix();
+GPSAidStatus GPSModule_getAidStatus();
+const char* GPSModule_startTypeName(GpsStartType type);
+void GPSModule_printTtffStats();            // This start, then the logged TTFF distribution per start type
+bool GPSModule_saveAiding();                // Poll ephemerides/almanac now and save them with the fix
+void GPSModule_clearAiding();               // Next boot starts cold
 void GPSModule_enablePowerSaving(bool enable);
 void GPSModule_setElevationMask(uint8_t degrees);
 
@@ -0,0 +1,152 @@
+#include "GaitAnalytics.h"
+#include <math.h>
+
+// ============= Gait Configuration =============
+static const uint8_t STEP_WINDOW = 16;                // Recent steps kept; even so ring slot parity = step parity
+static const uint32_t MIN_STEP_INTERVAL_US = 250000;  // Faster is a double detection
+static const uint32_t MAX_STEP_INTERVAL_US = 2000000; // Slower ends the walking bout
+static const uint8_t MIN_WINDOW_STEPS = 2;
+
+// Weinberg step length: K * (a_max - a_min)^(1/4), vertical accel in m/s^2.
+// K depends on where the IMU sits; 0.42 matches a typical cane user's 0.65m step.
+static const float WEINBERG_K = 0.42f;
+static const float GRAVITY_MS2 = 9.80665f;
+static const uint16_t MIN_STEP_LENGTH_MM = 200;
+static const uint16_t MAX_STEP_LENGTH_MM = 1200;
+
+// ============= Gait State =============
+// Ring of the current bout's step intervals and step lengths, with running
+// sums. Integer units keep add/subtract sums exact over long walks.
+static uint32_t intervalUs[STEP_WINDOW];
+static uint16_t lengthMm[STEP_WINDOW];
+static uint8_t ringHead = 0;
+static uint8_t ringCount = 0;
+static uint32_t intervalSum = 0;
+static uint32_t lengthSum = 0;
+static uint32_t paritySum[2] = {0, 0};   // Interval sums of even / odd ring slots
+static uint8_t parityCount[2] = {0, 0};
+
+static uint32_t lastStepMicros = 0;
+static uint32_t previousInterval = 0;   // 0 = no interval yet in this bout
+
+// Vertical acceleration extremes since the last step
+static float stepAccelMax = -INFINITY;
+static float stepAccelMin = INFINITY;
+
+// Welford running statistics over stride times (s)
+static uint32_t strideCount = 0;
+static float strideMean = 0;
+static float strideM2 = 0;
+
+static void clearBout() {
+  ringHead = 0;
+  ringCount = 0;
+  intervalSum = 0;
+  lengthSum = 0;
+  paritySum[0] = paritySum[1] = 0;
+  parityCount[0] = parityCount[1] = 0;
+  previousInterval = 0;
+}
+
+static uint16_t estimateStepLengthMm() {
+  if (stepAccelMax <= stepAccelMin) return 0;
+  float swing = (stepAccelMax - stepAccelMin) * GRAVITY_MS2;
+  float length = WEINBERG_K * sqrtf(sqrtf(swing)) * 1000.0f;
+  return (uint16_t)constrain(length, (float)MIN_STEP_LENGTH_MM, (float)MAX_STEP_LENGTH_MM);
+}
+
+static void pushStep(uint32_t interval, uint16_t length) {
+  uint8_t parity = ringHead & 1;
+  if (ringCount == STEP_WINDOW) {
+    // Evict the oldest step, which sits in the slot being overwritten
+    intervalSum -= intervalUs[ringHead];
+    lengthSum -= lengthMm[ringHead];
+    paritySum[parity] -= intervalUs[ringHead];
+    parityCount[parity]--;
+  } else {
+    ringCount++;
+  }
+  intervalUs[ringHead] = interval;
+  lengthMm[ringHead] = length;
+  intervalSum += interval;
+  lengthSum += length;
+  paritySum[parity] += interval;
+  parityCount[parity]++;
+  ringHead = (ringHead + 1 == STEP_WINDOW) ? 0 : ringHead + 1;
+}
+
+static void addStride(float strideSeconds) {
+  strideCount++;
+  float delta = strideSeconds - strideMean;
+  strideMean += delta / strideCount;
+  strideM2 += delta * (strideSeconds - strideMean);
+}
+
+void Gait_reset() {
+  clearBout();
+  lastStepMicros = 0;
+  stepAccelMax = -INFINITY;
+  stepAccelMin = INFINITY;
+  strideCount = 0;
+  strideMean = 0;
+  strideM2 = 0;
+}
+
+void Gait_addSample(float verticalAccelG) {
+  if (verticalAccelG > stepAccelMax) stepAccelMax = verticalAccelG;
+  if (verticalAccelG < stepAccelMin) stepAccelMin = verticalAccelG;
+}
+
+void Gait_onStep(uint32_t stepMicros) {
+  uint16_t length = estimateStepLengthMm();
+  stepAccelMax = -INFINITY;
+  stepAccelMin = INFINITY;
+
+  if (lastStepMicros == 0) {
+    lastStepMicros = stepMicros;
+    return;
+  }
+  uint32_t interval = stepMicros - lastStepMicros;
+  if (interval < MIN_STEP_INTERVAL_US) return;  // Keep the earlier step as reference
+  lastStepMicros = stepMicros;
+  if (interval > MAX_STEP_INTERVAL_US) {
+    clearBout();  // Pause in walking: next interval starts a new bout
+    return;
+  }
+
+  pushStep(interval, length);
+  // Stride = two consecutive steps (same foot to same foot)
+  if (previousInterval != 0) {
+    addStride((previousInterval + interval) / 1000000.0f);
+  }
+  previousInterval = interval;
+}
+
+GaitMetrics Gait_getMetrics(uint32_t nowMicros) {
+  GaitMetrics metrics;
+  metrics.strideCount = strideCount;
+  if (strideCount > 0) {
+    metrics.strideTimeMean = strideMean;
+    metrics.strideTimeStdDev = (strideCount > 1) ? sqrtf(strideM2 / (strideCount - 1)) : 0;
+    metrics.strideTimeCv = (strideMean > 0) ? metrics.strideTimeStdDev / strideMean * 100.0f : 0;
+  }
+
+  metrics.walking = ringCount >= MIN_WINDOW_STEPS && lastStepMicros != 0 &&
+                    nowMicros - lastStepMicros <= MAX_STEP_INTERVAL_US;
+  if (ringCount > 0) {
+    metrics.stepLengthM = lengthSum / (float)ringCount / 1000.0f;
+  }
+  if (!metrics.walking) return metrics;
+
+  float meanInterval = intervalSum / (float)ringCount / 1000000.0f;
+  metrics.cadenceSpm = 60.0f / meanInterval;
+  metrics.walkingSpeed = metrics.stepLengthM / meanInterval;
+
+  // Robinson symmetry index between alternate steps
+  if (parityCount[0] > 0 && parityCount[1] > 0) {
+    float even = paritySum[0] / (float)parityCount[0];
+    float odd = paritySum[1] / (float)parityCount[1];
+    metrics.symmetryIndex = fabsf(even - odd) / (0.5f * (even + odd)) * 100.0f;
+  }
+  return metrics;
+}
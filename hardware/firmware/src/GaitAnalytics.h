@@ -0,0 +1,27 @@
+#pragma once
+#ifndef GAITANALYTICS_H
+#define GAITANALYTICS_H
+
+#include <Arduino.h>
+
+// Streaming gait analytics fed by the IMU step detector. Every call is O(1):
+// recent steps live in a fixed ring with running sums, stride-time
+// statistics use Welford's update.
+struct GaitMetrics {
+  float cadenceSpm = 0;          // Steps per minute over the recent window, 0 when not walking
+  float strideTimeMean = 0;      // Seconds, over all strides inside walking bouts
+  float strideTimeStdDev = 0;    // Seconds
+  float strideTimeCv = 0;        // %, std dev / mean (variability)
+  float symmetryIndex = 0;       // %, 0 = alternate steps take equal time
+  float stepLengthM = 0;         // Weinberg estimate from vertical acceleration
+  float walkingSpeed = 0;        // m/s, 0 when not walking
+  uint32_t strideCount = 0;
+  bool walking = false;
+};
+
+void Gait_reset();
+void Gait_addSample(float verticalAccelG);   // Every IMU sample
+void Gait_onStep(uint32_t stepMicros);       // Every step counted by the detector
+GaitMetrics Gait_getMetrics(uint32_t nowMicros);
+
+#endif // GAITANALYTICS_H
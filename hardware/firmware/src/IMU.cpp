@@ -4,27 +4,49 @@
 #include <Wire.h>
 #include <MadgwickAHRS.h>
 #include "SDCardManager.h"
+#include "SignalFilters.h"
+#include "GaitAnalytics.h"
+#include "StepJournal.h"
+#include "BlackBox.h"
+#include "Log.h"
 #include <math.h>
 #include <time.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #include "ConnectivityManager.h"
 
+#ifdef SC_IMU_USE_DMP
+#include <MPU6050_6Axis_MotionApps20.h>
+#endif
+
 #define MPU_ADDR 0x68
-constexpr uint32_t SAMPLE_US = 1000000 / 100;  // 100 Hz
 
-// EEPROM addresses for step data
-const int STEP_DATA_ADDR = 64;  // After calibration data
-const uint32_t STEP_DATA_MAGIC = 0x53544550; // "STEP" in ASCII
+// ============= Acquisition =============
+// Samples are queued in the MPU6050 FIFO at the sensor ODR and drained in
+// bursts by the sampling task (FIFO holds ~340ms at 250 Hz).
+#ifdef SC_IMU_USE_DMP
+constexpr uint32_t IMU_SAMPLE_HZ = 100;          // MotionApps 2.0 DMP packet rate
+constexpr float GYRO_LSB_PER_DPS = 16.4f;        // DMP requires +-2000 dps
+#else
+constexpr uint32_t IMU_SAMPLE_HZ = 250;          // 1 kHz / (1 + SMPLRT_DIV 3)
+constexpr float GYRO_LSB_PER_DPS = 32.8f;        // +-1000 dps
+#endif
+constexpr float ACCEL_LSB_PER_G = 4096.0f;       // +-8 g
+constexpr uint32_t SAMPLE_US = 1000000 / IMU_SAMPLE_HZ;
+constexpr uint32_t DRAIN_INTERVAL_US = 10000;    // Sampling task wakes every 10ms
+constexpr uint8_t FIFO_SAMPLE_BYTES = 12;        // Accel XYZ + gyro XYZ, big endian
+constexpr uint8_t FIFO_BURST_SAMPLES = 10;       // 120 bytes fits the 128-byte Wire buffer
+constexpr uint16_t FIFO_MAX_SAMPLES_PER_UPDATE = 40;
 
-struct StepData {
-  uint32_t magic;
-  uint32_t dailySteps;
-  uint32_t totalSteps;
-  uint8_t lastResetDay;
-  uint8_t lastResetMonth;
-  uint16_t lastResetYear;
-  uint32_t checksum;
-};
+#define MPU_REG_FIFO_EN     0x23
+#define MPU_REG_INT_ENABLE  0x38
+#define MPU_REG_INT_STATUS  0x3A
+#define MPU_REG_USER_CTRL   0x6A
+#define MPU_REG_FIFO_COUNTH 0x72
+#define MPU_REG_FIFO_R_W    0x74
+#define MPU_INT_FIFO_OFLOW  0x10
 
 struct CalibrationData {
   uint16_t magic;
@@ -34,10 +56,14 @@ struct CalibrationData {
 };
 const int EEPROM_ADDR = 0;
 const uint16_t EEPROM_MAGIC = 0xCAFE;
+#ifdef SC_IMU_USE_DMP
+const uint8_t EEPROM_VERSION = 0x81;  // Gyro offsets are in +-2000 dps units
+#else
 const uint8_t EEPROM_VERSION = 1;
+#endif
 
 static uint8_t i2cErrorCount = 0;
-static bool i2cErrorFlag = false;
+static volatile bool i2cErrorFlag = false;
 
 enum FeedbackState {
   FB_IDLE, FB_CALIBRATING, FB_CALIB_COMPLETE, FB_FALL_ALERT, FB_I2C_ERROR
@@ -46,20 +72,95 @@ static FeedbackState fbState = FB_IDLE;
 static uint32_t fbTimer = 0;
 
 static Madgwick filter;
-static uint32_t nextMicros = 0;
+static uint32_t nextServiceMicros = 0;
+static uint32_t lastSampleMicros = 0;   // Timestamp of the last processed sample, 0 = resync
+
+// ============= Sampling Task =============
+// FIFO draining, fusion and the detectors run in a dedicated task woken by an
+// esp_timer, so announce(), feedback delays and SD writes in loop() cannot
+// stretch the sample period. Anything slow (SD, Serial, feedback pins) is
+// handed back to IMU_update() through the flags and snapshot below.
+// Wire serializes whole transactions with its bus lock, so the task can share
+// the I2C bus with the ToF and light sensors read from loop().
+#define IMU_TASK_STACK_SIZE 4096
+#define IMU_TASK_PRIORITY 5   // Above loop(), BLE TX and radar scanning
+#define IMU_TASK_CORE 1
+static TaskHandle_t imuTaskHandle = nullptr;
+static esp_timer_handle_t imuPaceTimer = nullptr;
+static volatile bool pauseRequested = false;     // Set by loop() around calibration
+static volatile bool samplingPaused = false;     // Acknowledged by the task
+static volatile bool stepResetRequested = false; // loop() -> task: zero daily steps
+static volatile bool stepSavePending = false;    // task -> loop(): stage step data in the journal
+static volatile bool stepFlushPending = false;   // task -> loop(): commit step data now (reset)
+static volatile bool reconfigurePending = false; // task -> loop(): repeated I2C errors, reconfigure the MPU6050
+
+// Wake-up jitter: |measured period - DRAIN_INTERVAL_US|, last bin is open-ended
+static const uint8_t JITTER_BINS = 8;
+static const uint32_t JITTER_BIN_LIMIT_US[JITTER_BINS - 1] = {50, 100, 250, 500, 1000, 2000, 5000};
+static uint32_t jitterHistogram[JITTER_BINS] = {0};
+static uint32_t maxJitterUs = 0;
+static uint32_t maxBusyUs = 0;      // Longest drain + fusion pass
+static uint32_t lastWakeMicros = 0;  // 0 = skip the next period measurement
+
+// Published state. Single writer (the sampling task), any number of readers:
+// publishSeq is odd while the writer is mid-update, readers retry until they
+// copy the snapshot under an unchanged even sequence.
+struct ImuSnapshot {
+  float roll, pitch, yaw;
+  float motionEnergy;
+  float accelMagnitude;
+  uint32_t dailySteps;
+  uint32_t totalSteps;
+  uint32_t stepEvents;        // Increments once per detected step
+  float lastStepPeak;
+  uint32_t lastStepMicros;
+  float stepIntervalAvg;
+  uint32_t samplesProcessed;
+  FallState fallState;
+  bool stepInProgress;
+  bool slopeWarningActive;
+  GaitMetrics gait;
+};
+static ImuSnapshot published;
+static volatile uint32_t publishSeq = 0;
 
-static int16_t axBuf[5], ayBuf[5], azBuf[5];
-static int16_t gxBuf[5], gyBuf[5], gzBuf[5];
-static uint8_t bufIdx = 0;
+// FIFO statistics
+static uint32_t samplesProcessed = 0;
+static volatile uint32_t fifoOverflows = 0;  // Reported to sensor health by IMU_update()
+static uint16_t maxFifoBacklog = 0;
+static uint32_t timestampResyncs = 0;
+
+#ifdef SC_IMU_USE_DMP
+static MPU6050 dmpMpu(MPU_ADDR);
+static uint16_t dmpPacketSize = 0;
+static bool dmpReady = false;
+#endif
+
+// Six-axis preprocessing, lanes in ImuAxis order
+enum ImuAxis : uint8_t { AXIS_AX = 0, AXIS_AY, AXIS_AZ, AXIS_GX, AXIS_GY, AXIS_GZ };
+struct AxisFilterState {
+  AxisMedian5 history;              // Offset-corrected raw counts
+  float smooth[AXIS_CHANNELS];      // g and dps after the EMA
+};
+static AxisFilterState axisFilter;
 
 static int16_t gyroOffsets[3] = {0};
 static int16_t accelOffsets[3] = {0};
 
 static float smoothRoll = 0, smoothPitch = 0, smoothYaw = 0;
-static float smoothAx = 0, smoothAy = 0, smoothAz = 0;
-static float smoothGx = 0, smoothGy = 0, smoothGz = 0;
-static const float SMOOTH_ALPHA = 0.15;
-static const float FAST_ALPHA = 0.4;
+static AngleEma yawSmoother;        // Yaw wraps at 360, so it is smoothed as a unit vector
+// Reciprocals so scaling is one multiply per lane instead of a divide
+static const float AXIS_SCALE[AXIS_CHANNELS] = {
+  1.0f / ACCEL_LSB_PER_G, 1.0f / ACCEL_LSB_PER_G, 1.0f / ACCEL_LSB_PER_G,
+  1.0f / GYRO_LSB_PER_DPS, 1.0f / GYRO_LSB_PER_DPS, 1.0f / GYRO_LSB_PER_DPS
+};
+// Gains were tuned at 100 Hz; rescale so the time constants hold at IMU_SAMPLE_HZ
+static float rateScaledAlpha(float alphaAt100Hz) {
+  return 1.0f - powf(1.0f - alphaAt100Hz, 100.0f / IMU_SAMPLE_HZ);
+}
+static const float SMOOTH_ALPHA = rateScaledAlpha(0.15f);
+static const float FAST_ALPHA = rateScaledAlpha(0.4f);
+static const float MOTION_ALPHA = rateScaledAlpha(0.05f);
 
 static float motionEnergy = 0;
 static const float MOTION_THRESH = 0.5;
@@ -70,6 +171,8 @@ static const uint32_t STEP_MIN_PERIOD = 400000;
 static const uint32_t STEP_MAX_PERIOD = 1200000;
 static uint32_t stepStartTime = 0;
 static uint32_t stepCount = 0;
+static uint32_t stepEvents = 0;
+static float lastStepPeak = 0;
 static uint32_t dailySteps = 0;
 static uint32_t totalSteps = 0;
 static uint8_t lastResetDay = 0;
@@ -78,6 +181,9 @@ static uint16_t lastResetYear = 0;
 enum StepState { STEP_IDLE, STEP_RISING, STEP_PEAK, STEP_FALLING };
 static StepState stepState = STEP_IDLE;
 static float stepPeakValue = 0;
+static uint32_t lastStepMicros = 0;   // timestamp of the last counted step
+static float stepIntervalAvg = 0;     // smoothed step interval in seconds
+static const uint32_t CADENCE_TIMEOUT_US = 2000000; // no step for 2s = not walking
 
 static const float FALL_IMPACT_THRESHOLD = 3.0f;
 static const float FALL_FREE_THRESHOLD = 0.4f;
@@ -91,14 +197,32 @@ static const float SLOPE_THRESHOLD_HIGH = 16.0f;
 static const float SLOPE_THRESHOLD_LOW = 12.0f;
 static bool slopeWarningActive = false;
 
-inline void swap16(int16_t &a, int16_t &b) { int16_t t = a; a = b; b = t; }
-static int16_t median5(int16_t samples[5]) {
-  for (int i = 0; i < 4; i++) {
-    for (int j = i+1; j < 5; j++) {
-      if (samples[j] < samples[i]) swap16(samples[i], samples[j]);
-    }
+static float smoothedAccelMagnitude() {
+  const float* a = axisFilter.smooth;
+  return sqrtf(a[AXIS_AX]*a[AXIS_AX] + a[AXIS_AY]*a[AXIS_AY] + a[AXIS_AZ]*a[AXIS_AZ]);
+}
+
+// Offsets, median, scale and EMA for all six lanes of one sample.
+// Returns the motion energy input (accel deviation + 0.1 * gyro deviation).
+static float preprocessAxes(AxisFilterState& state, const int16_t raw[AXIS_CHANNELS], float alpha) {
+  int16_t corrected[AXIS_CHANNELS];
+  for (uint8_t i = 0; i < 3; i++) {
+    corrected[i] = raw[i] - accelOffsets[i];
+    corrected[i + 3] = raw[i + 3] - gyroOffsets[i];
+  }
+  state.history.push(corrected);
+  AxisBlock median;
+  state.history.median(median);
+  
+  float deviation[AXIS_CHANNELS];
+  for (uint8_t i = 0; i < AXIS_CHANNELS; i++) {
+    float value = median.lane[i] * AXIS_SCALE[i];
+    state.smooth[i] += alpha * (value - state.smooth[i]);
+    deviation[i] = fabsf(value - state.smooth[i]);
   }
-  return samples[2];
+  float accelDelta = deviation[AXIS_AX] + deviation[AXIS_AY] + deviation[AXIS_AZ];
+  float gyroDelta = deviation[AXIS_GX] + deviation[AXIS_GY] + deviation[AXIS_GZ];
+  return accelDelta + gyroDelta * 0.1f;
 }
 
 // EEPROM
@@ -125,83 +249,40 @@ static void factoryResetEEPROM() {
   // Delete calibration file
   SDCard_deleteFile("/data/imu_calib.dat");
   
-  // Delete step data file
-  SDCard_deleteFile("/data/step_data.dat");
+  // Delete the step journal and the legacy step file
+  if (!StepJournal_erase()) Serial.println("⚠️ Step journal could not be erased");
   
   Serial.println("Factory Reset - Calibration and step data cleared");
 }
 
 // Step data management functions
-static uint32_t calculateChecksum(const StepData& data) {
-  uint32_t sum = 0;
-  const uint8_t* bytes = (const uint8_t*)&data;
-  for (size_t i = 0; i < sizeof(StepData) - sizeof(uint32_t); i++) {
-    sum += bytes[i];
-  }
-  return sum;
-}
-
-static void saveStepDataToEEPROM() {
-  StepData data;
-  data.magic = STEP_DATA_MAGIC;
-  data.dailySteps = dailySteps;
-  data.totalSteps = totalSteps;
-  data.lastResetDay = lastResetDay;
-  data.lastResetMonth = lastResetMonth;
-  data.lastResetYear = lastResetYear;
-  data.checksum = calculateChecksum(data);
-  
-  SDCard_writeFile("/data/step_data.dat", (uint8_t*)&data, sizeof(StepData));
+// Step counts go to the append-only journal; the background task batches the writes
+static void saveStepData(bool flush) {
+  StepCounts counts;
+  counts.dailySteps = dailySteps;
+  counts.totalSteps = totalSteps;
+  counts.lastResetDay = lastResetDay;
+  counts.lastResetMonth = lastResetMonth;
+  counts.lastResetYear = lastResetYear;
+  bool posted = flush ? StepJournal_flush(counts) : StepJournal_stage(counts);
+  if (!posted) Serial.println("⚠️ Step counts could not be saved to the journal");
 #ifdef SC_DEBUG_IMU
-  Serial.printf("Saved step data: Daily=%lu, Total=%lu, Date=%02d/%02d/%04d\n", 
+  Serial.printf("%s step data: Daily=%lu, Total=%lu, Date=%02d/%02d/%04d\n", flush ? "Flushed" : "Staged",
                 dailySteps, totalSteps, lastResetDay, lastResetMonth, lastResetYear);
 #endif
 }
 
-static bool loadStepDataFromEEPROM() {
-  StepData data;
-  size_t bytesRead;
-  if (!SDCard_readFile("/data/step_data.dat", (uint8_t*)&data, sizeof(StepData), &bytesRead) || bytesRead != sizeof(StepData)) {
-#ifdef SC_DEBUG_IMU
-    Serial.println("No valid step data found on SD card");
-#endif
-    return false;
-  }
-  
-  if (data.magic != STEP_DATA_MAGIC) {
-#ifdef SC_DEBUG_IMU
-    Serial.println("No valid step data found on SD card");
-#endif
-    return false;
-  }
-  
-  uint32_t expectedChecksum = calculateChecksum(data);
-  if (data.checksum != expectedChecksum) {
-#ifdef SC_DEBUG_IMU
-    Serial.println("Step data checksum mismatch - using defaults");
-#endif
-    return false;
-  }
-  
-  dailySteps = data.dailySteps;
-  totalSteps = data.totalSteps;
-  lastResetDay = data.lastResetDay;
-  lastResetMonth = data.lastResetMonth;
-  lastResetYear = data.lastResetYear;
-  
-#ifdef SC_DEBUG_IMU
-  Serial.printf("Loaded step data: Daily=%lu, Total=%lu, Date=%02d/%02d/%04d\n", 
-                dailySteps, totalSteps, lastResetDay, lastResetMonth, lastResetYear);
-#endif
-  return true;
-}
-
 static void resetDailySteps() {
-  dailySteps = 0;
   lastResetDay = 0;
   lastResetMonth = 0;
   lastResetYear = 0;
-  saveStepDataToEEPROM();
+  if (imuTaskHandle) {
+    // The counters belong to the sampling task; it zeroes them and asks for the save
+    stepResetRequested = true;
+  } else {
+    dailySteps = 0;
+    saveStepData(true);
+  }
 #ifdef SC_DEBUG_IMU
   Serial.println("Daily steps reset");
 #endif
@@ -312,10 +393,17 @@ static void configureMPU() {
   uint8_t error = 0;
   Wire.beginTransmission(MPU_ADDR); Wire.write(0x6B); Wire.write(0x01); error += Wire.endTransmission();
   Wire.beginTransmission(MPU_ADDR); Wire.write(0x1A); Wire.write(0x03); error += Wire.endTransmission();
-  Wire.beginTransmission(MPU_ADDR); Wire.write(0x19); Wire.write(0x04); error += Wire.endTransmission();
+  Wire.beginTransmission(MPU_ADDR); Wire.write(0x19); Wire.write(1000 / IMU_SAMPLE_HZ - 1); error += Wire.endTransmission();
   Wire.beginTransmission(MPU_ADDR); Wire.write(0x1C); Wire.write(0x10); error += Wire.endTransmission();
   Wire.beginTransmission(MPU_ADDR); Wire.write(0x1B); Wire.write(0x10); error += Wire.endTransmission();
   
+  // FIFO: accel + gyro at the sample rate, overflow flag latched in INT_STATUS
+  Wire.beginTransmission(MPU_ADDR); Wire.write(MPU_REG_USER_CTRL); Wire.write(0x04); error += Wire.endTransmission();
+  Wire.beginTransmission(MPU_ADDR); Wire.write(MPU_REG_FIFO_EN); Wire.write(0x78); error += Wire.endTransmission();
+  Wire.beginTransmission(MPU_ADDR); Wire.write(MPU_REG_INT_ENABLE); Wire.write(MPU_INT_FIFO_OFLOW); error += Wire.endTransmission();
+  Wire.beginTransmission(MPU_ADDR); Wire.write(MPU_REG_USER_CTRL); Wire.write(0x40); error += Wire.endTransmission();
+  lastSampleMicros = 0;
+  
   if (error == 0) {
     SensorHealthManager::updateSensorHealth("mpu6050", SENSOR_OK, "MPU6050 configured");
     i2cErrorCount = 0;
@@ -323,6 +411,25 @@ static void configureMPU() {
     SensorHealthManager::updateSensorHealth("mpu6050", SENSOR_ERROR, nullptr, "MPU6050 config failed");
   }
 }
+#ifdef SC_IMU_USE_DMP
+// DMP owns the FIFO: 42-byte MotionApps 2.0 packets with quaternion, gyro and accel
+static void configureDMP() {
+  dmpMpu.initialize();
+  dmpReady = false;
+  if (dmpMpu.dmpInitialize() != 0) {
+    SensorHealthManager::updateSensorHealth("mpu6050", SENSOR_INIT_FAILED, nullptr, "DMP init failed");
+    return;
+  }
+  dmpMpu.setFullScaleAccelRange(MPU6050_ACCEL_FS_8);
+  dmpMpu.setDMPEnabled(true);
+  dmpPacketSize = dmpMpu.dmpGetFIFOPacketSize();
+  dmpReady = true;
+  lastSampleMicros = 0;
+  SensorHealthManager::updateSensorHealth("mpu6050", SENSOR_OK, "MPU6050 DMP configured");
+  i2cErrorCount = 0;
+}
+#endif
+
 static bool readMPUData(int16_t& ax, int16_t& ay, int16_t& az, int16_t& gx, int16_t& gy, int16_t& gz) {
   Wire.beginTransmission(MPU_ADDR); Wire.write(0x3B);
   if (Wire.endTransmission(false) != 0) {
@@ -347,13 +454,58 @@ static bool readMPUData(int16_t& ax, int16_t& ay, int16_t& az, int16_t& gx, int1
   SensorHealthManager::updateSensorHealth("mpu6050", SENSOR_OK, String(accelMag, 3).c_str());
   return true;
 }
+// Only counts; the reconfiguration (delays, health reports) runs in IMU_update()
 static void handleI2CError() {
   i2cErrorCount++;
   if (i2cErrorCount == 1) i2cErrorFlag = true;
-  if (i2cErrorCount >= 5) { configureMPU(); i2cErrorCount = 0; nextMicros = micros() + SAMPLE_US; }
+  if (i2cErrorCount >= 5) {
+    reconfigurePending = true;
+    i2cErrorCount = 0;
+  }
+}
+
+static bool readRegisters(uint8_t reg, uint8_t* buffer, uint8_t length) {
+  Wire.beginTransmission(MPU_ADDR); Wire.write(reg);
+  if (Wire.endTransmission(false) != 0) return false;
+  if (Wire.requestFrom((uint8_t)MPU_ADDR, length) != length) return false;
+  for (uint8_t i = 0; i < length; i++) buffer[i] = Wire.read();
+  return true;
+}
+
+static void resetFIFO() {
+#ifdef SC_IMU_USE_DMP
+  dmpMpu.resetFIFO();
+#else
+  Wire.beginTransmission(MPU_ADDR); Wire.write(MPU_REG_USER_CTRL); Wire.write(0x04); Wire.endTransmission();
+  Wire.beginTransmission(MPU_ADDR); Wire.write(MPU_REG_USER_CTRL); Wire.write(0x40); Wire.endTransmission();
+#endif
+  lastSampleMicros = 0;
+}
+
+// Queued samples are back-dated from the drain time; consecutive samples
+// stay on the sensor's own period unless that drifts more than two periods.
+// queued is the whole FIFO backlog, not the capped drain, so a truncated
+// drain still dates its samples relative to the newest one in the FIFO.
+static uint32_t nextSampleTimestamp(uint32_t readMicros, uint16_t queued, uint16_t index) {
+  uint32_t backdated = readMicros - (uint32_t)(queued - 1 - index) * SAMPLE_US;
+  uint32_t expected = lastSampleMicros + SAMPLE_US;
+  int32_t drift = (int32_t)(expected - backdated);
+  if (lastSampleMicros == 0 || drift > (int32_t)(2 * SAMPLE_US) || drift < -(int32_t)(2 * SAMPLE_US)) {
+    if (lastSampleMicros != 0) timestampResyncs++;
+    expected = backdated;
+  }
+  lastSampleMicros = expected;
+  return expected;
+}
+
+static void handleFIFOOverflow() {
+  fifoOverflows++;
+  resetFIFO();
 }
 
 // Feedback
+static uint32_t stepPulseUntil = 0;   // Short vibration per step, shown while idle
+
 static void updateFeedback() {
   uint32_t currentMillis = millis();
   
@@ -368,8 +520,9 @@ static void updateFeedback() {
         digitalWrite(FEEDBACK_PIN, LOW);
       }
       if (feedbackMode == FEEDBACK_MODE_BOTH || feedbackMode == FEEDBACK_MODE_VIBRATION) {
-        digitalWrite(VIB1_PIN, LOW);
-        digitalWrite(VIB2_PIN, LOW);
+        bool stepPulse = (int32_t)(stepPulseUntil - currentMillis) > 0;
+        digitalWrite(VIB1_PIN, stepPulse ? HIGH : LOW);
+        digitalWrite(VIB2_PIN, stepPulse ? HIGH : LOW);
       }
       break;
     case FB_CALIBRATING:
@@ -469,13 +622,14 @@ static void calibrateSensors() {
   Serial.printf("Accel Offsets: X:%d Y:%d Z:%d\n", accelOffsets[0], accelOffsets[1], accelOffsets[2]);
   Serial.printf("Gyro Offsets: X:%d Y:%d Z:%d\n", gyroOffsets[0], gyroOffsets[1], gyroOffsets[2]);
   saveCalibrationToEEPROM();
+  resetFIFO();
   fbState = FB_CALIB_COMPLETE;
   fbTimer = millis();
 }
 
 // Step detection
 static void detectSteps(uint32_t now) {
-  float az = smoothAz;
+  float az = axisFilter.smooth[AXIS_AZ];
   switch (stepState) {
     case STEP_IDLE:
       if (az > STEP_THRESHOLD_HIGH && motionEnergy > MOTION_THRESH) {
@@ -498,23 +652,21 @@ static void detectSteps(uint32_t now) {
         dailySteps++;
         totalSteps++;
         
-        // Save step data every 10 steps to avoid excessive EEPROM writes
-        if (dailySteps % 10 == 0) {
-          saveStepDataToEEPROM();
+        // Track step interval for cadence (consumers: ToF time-to-contact)
+        if (lastStepMicros != 0 && now - lastStepMicros < CADENCE_TIMEOUT_US) {
+          float interval = (now - lastStepMicros) / 1000000.0f;
+          stepIntervalAvg = (stepIntervalAvg == 0) ? interval : 0.7f * stepIntervalAvg + 0.3f * interval;
+        } else {
+          stepIntervalAvg = 0; // first step of a new walking bout
         }
+        lastStepMicros = now;
+        lastStepPeak = stepPeakValue;
+        Gait_onStep(now);
+        stepEvents++;  // IMU_update() logs it and pulses the vibration motors
         
-        Serial.printf("Step detected! Daily: %lu, Total: %lu (Peak: %.2fg)\n", 
-                      dailySteps, totalSteps, stepPeakValue);
-        
-        // Step detection feedback - short vibration (respect feedback mode)
-        extern SensorData sensorData;
-        uint8_t feedbackMode = sensorData.feedbackMode;
-        if (feedbackMode == FEEDBACK_MODE_BOTH || feedbackMode == FEEDBACK_MODE_VIBRATION) {
-          digitalWrite(VIB1_PIN, HIGH);
-          digitalWrite(VIB2_PIN, HIGH);
-          delay(50);
-          digitalWrite(VIB1_PIN, LOW);
-          digitalWrite(VIB2_PIN, LOW);
+        // Save step data every 10 steps to avoid excessive EEPROM writes
+        if (dailySteps % 10 == 0) {
+          stepSavePending = true;
         }
         
         stepState = STEP_IDLE;
@@ -523,52 +675,72 @@ static void detectSteps(uint32_t now) {
   }
 }
 // Fall detection
-static void detectFalls(uint32_t now) {
+static void detectFalls(uint32_t nowMs) {
   static uint32_t lastActivityTime = 0;
-  float accelMag = sqrt(smoothAx*smoothAx + smoothAy*smoothAy + smoothAz*smoothAz);
-  if (accelMag > FALL_IMPACT_THRESHOLD && motionEnergy > MOTION_THRESH) { impactTime = millis(); }
+  float accelMag = smoothedAccelMagnitude();
+  if (accelMag > FALL_IMPACT_THRESHOLD && motionEnergy > MOTION_THRESH) { impactTime = nowMs; }
   if (accelMag < FALL_FREE_THRESHOLD) {
-    if (fallState == FALL_NONE) { fallState = FALL_DETECTED; fallStartTime = millis(); }
+    if (fallState == FALL_NONE) { fallState = FALL_DETECTED; fallStartTime = nowMs; }
   } else if (fallState == FALL_DETECTED) { fallState = FALL_NONE; }
   if (fallState == FALL_DETECTED && impactTime > fallStartTime) {
     if (motionEnergy < MOTION_THRESH * 0.3f) {
-      if (lastActivityTime == 0) { lastActivityTime = millis(); }
-      else if (millis() - lastActivityTime > FALL_INACTIVITY_TIME) {
-        fallState = FALL_CONFIRMED;
-        Serial.println("\n!!! FALL CONFIRMED - SENDING ALERT !!!");
-        fbState = FB_FALL_ALERT;
-        fbTimer = millis();
+      if (lastActivityTime == 0) { lastActivityTime = nowMs; }
+      else if (nowMs - lastActivityTime > FALL_INACTIVITY_TIME) {
+        fallState = FALL_CONFIRMED;  // Alert raised by IMU_update()
+        BlackBox_trigger(BLACKBOX_REASON_FALL);
       }
     } else { lastActivityTime = 0; }
   }
   if (fallState != FALL_NONE && motionEnergy > MOTION_THRESH) {
-    if (millis() - impactTime > FALL_INACTIVITY_TIME * 2) {
-      Serial.println("Fall alarm reset");
+    if (nowMs - impactTime > FALL_INACTIVITY_TIME * 2) {
       fallState = FALL_NONE;
       lastActivityTime = 0;
     }
   }
 }
-// Slope warning
+// Slope warning (messages are printed by IMU_update())
 static void detectSlope() {
-  static bool wasWarned = false;
   float absPitch = fabs(smoothPitch);
   float absRoll = fabs(smoothRoll);
   if (!slopeWarningActive && (absPitch > SLOPE_THRESHOLD_HIGH || absRoll > SLOPE_THRESHOLD_HIGH)) {
     slopeWarningActive = true;
-    wasWarned = true;
-    Serial.println("SLOPE WARNING: Steep terrain ahead!");
   } else if (slopeWarningActive && absPitch < SLOPE_THRESHOLD_LOW && absRoll < SLOPE_THRESHOLD_LOW) {
     slopeWarningActive = false;
-    Serial.println("Slope warning cleared");
-  }
-  static uint32_t lastWarnTime = 0;
-  if (slopeWarningActive && millis() - lastWarnTime > 5000) {
-    Serial.println("SLOPE WARNING: Still on steep terrain");
-    lastWarnTime = millis();
   }
 }
 
+static BlackBoxImuInfo blackBoxInfo() {
+  BlackBoxImuInfo info;
+  info.sampleRateHz = IMU_SAMPLE_HZ;
+  info.accelLsbPerG = ACCEL_LSB_PER_G;
+  info.gyroLsbPerDps = GYRO_LSB_PER_DPS;
+  info.fallImpactThresholdG = FALL_IMPACT_THRESHOLD;
+  info.fallFreeThresholdG = FALL_FREE_THRESHOLD;
+  memcpy(info.accelOffsets, accelOffsets, sizeof(accelOffsets));
+  memcpy(info.gyroOffsets, gyroOffsets, sizeof(gyroOffsets));
+  return info;
+}
+
+// Raw sample plus fused state into the black box ring
+static void recordBlackBox(const int16_t raw[6], uint32_t sampleMicros) {
+  BlackBoxSample sample;
+  sample.timestampUs = sampleMicros;
+  memcpy(sample.raw, raw, sizeof(sample.raw));
+  sample.rollCd = (int16_t)(smoothRoll * 100.0f);
+  sample.pitchCd = (int16_t)(smoothPitch * 100.0f);
+  sample.yawCd = (int16_t)((smoothYaw > 180.0f ? smoothYaw - 360.0f : smoothYaw) * 100.0f);
+  sample.motionMilli = (uint16_t)constrain(motionEnergy * 1000.0f, 0.0f, 65535.0f);
+  sample.accelMagMg = (uint16_t)constrain(smoothedAccelMagnitude() * 1000.0f, 0.0f, 65535.0f);
+  sample.tofMm = 0;  // Filled in by the black box
+  sample.flags = (stepState != STEP_IDLE ? BLACKBOX_FLAG_STEP : 0) |
+                 (slopeWarningActive ? BLACKBOX_FLAG_SLOPE : 0);
+  sample.fallState = (uint8_t)fallState;
+  sample.reserved = 0;
+  BlackBox_record(sample);
+}
+
+static void startSamplingTask();
+
 void IMU_init() {
   Wire.begin(I2C_SDA, I2C_SCL, 400000);
   pinMode(CALIB_BUTTON_PIN, INPUT_PULLUP);
@@ -580,15 +752,18 @@ void IMU_init() {
   pinMode(VIB2_PIN, OUTPUT);
   digitalWrite(VIB1_PIN, LOW);
   digitalWrite(VIB2_PIN, LOW);
+#ifdef SC_IMU_USE_DMP
+  configureDMP();
+#else
   configureMPU();
-  filter.begin(100);
+#endif
+  filter.begin(IMU_SAMPLE_HZ);
+  Gait_reset();
   delay(500);
   int16_t ax, ay, az, gx, gy, gz;
   if (readMPUData(ax, ay, az, gx, gy, gz)) {
-    for (uint8_t i = 0; i < 5; i++) {
-      axBuf[i] = ax; ayBuf[i] = ay; azBuf[i] = az;
-      gxBuf[i] = gx; gyBuf[i] = gy; gzBuf[i] = gz;
-    }
+    int16_t seed[AXIS_CHANNELS] = {ax, ay, az, gx, gy, gz};
+    axisFilter.history.fill(seed);
     SensorHealthManager::updateSensorHealth("mpu6050", SENSOR_OK, "MPU6050 initialized");
   } else {
     SensorHealthManager::updateSensorHealth("mpu6050", SENSOR_INIT_FAILED, nullptr, "MPU6050 init failed");
@@ -602,9 +777,15 @@ void IMU_init() {
     calibrateSensors();
   }
   
-  // Load step data from EEPROM
-  if (loadStepDataFromEEPROM()) {
-    Serial.println("Loaded step data from EEPROM");
+  // Recover step data from the journal, which migrates the legacy file on first boot
+  StepCounts recovered;
+  if (StepJournal_begin(recovered)) {
+    dailySteps = recovered.dailySteps;
+    totalSteps = recovered.totalSteps;
+    lastResetDay = recovered.lastResetDay;
+    lastResetMonth = recovered.lastResetMonth;
+    lastResetYear = recovered.lastResetYear;
+    Serial.println("Recovered step data from journal");
   } else {
     Serial.println("No valid step data found - starting fresh");
     dailySteps = 0;
@@ -618,7 +799,12 @@ void IMU_init() {
   Serial.print("Time source: ");
   Serial.println(IMU_getTimeSource());
   
-  nextMicros = micros() + SAMPLE_US;
+  BlackBox_begin(blackBoxInfo());
+
+  // Drop whatever queued up during calibration and SD access
+  resetFIFO();
+  startSamplingTask();
+  nextServiceMicros = micros() + DRAIN_INTERVAL_US;
 #ifdef SC_DEBUG_IMU
   Serial.println("\nSmart Cane System Ready");
   Serial.println("Features: Robust step detection, Advanced fall detection, Slope warning, Recalibration");
@@ -630,10 +816,288 @@ void IMU_init() {
 #endif
 }
 
+// One queued sample through filtering, fusion and the detectors.
+// quat is the DMP quaternion (w, x, y, z) or nullptr for software Madgwick.
+static void processSample(const int16_t raw[6], uint32_t sampleMicros, uint32_t sampleMillis, const float* quat) {
+  float energyInput = preprocessAxes(axisFilter, raw, SMOOTH_ALPHA);
+  motionEnergy = (1 - MOTION_ALPHA) * motionEnergy + MOTION_ALPHA * energyInput;
+  float roll, pitch, yaw;
+  if (quat) {
+    // Same conventions as MadgwickAHRS getRoll/getPitch/getYaw
+    float q0 = quat[0], q1 = quat[1], q2 = quat[2], q3 = quat[3];
+    roll = atan2f(q0*q1 + q2*q3, 0.5f - q1*q1 - q2*q2) * RAD_TO_DEG;
+    pitch = asinf(constrain(-2.0f * (q1*q3 - q0*q2), -1.0f, 1.0f)) * RAD_TO_DEG;
+    yaw = atan2f(q1*q2 + q0*q3, 0.5f - q2*q2 - q3*q3) * RAD_TO_DEG + 180.0f;
+  } else {
+    // Madgwick assumes a fixed period, which FIFO samples now honour
+    const float* smooth = axisFilter.smooth;
+    filter.updateIMU(
+      smooth[AXIS_GX] * DEG_TO_RAD,
+      smooth[AXIS_GY] * DEG_TO_RAD,
+      smooth[AXIS_GZ] * DEG_TO_RAD,
+      smooth[AXIS_AX], smooth[AXIS_AY], smooth[AXIS_AZ]
+    );
+    roll = filter.getRoll();
+    pitch = filter.getPitch();
+    yaw = filter.getYaw();
+  }
+  float currentAlpha = (motionEnergy > MOTION_THRESH) ? FAST_ALPHA : SMOOTH_ALPHA;
+  smoothRoll = currentAlpha * roll + (1 - currentAlpha) * smoothRoll;
+  smoothPitch = currentAlpha * pitch + (1 - currentAlpha) * smoothPitch;
+  smoothYaw = yawSmoother.update(yaw, currentAlpha);
+  Gait_addSample(axisFilter.smooth[AXIS_AZ]);
+  detectSteps(sampleMicros);
+  detectFalls(sampleMillis);
+  detectSlope();
+  recordBlackBox(raw, sampleMicros);
+  samplesProcessed++;
+}
+
+
+#ifdef SC_IMU_USE_DMP
+static bool drainSamples(uint32_t readMicros) {
+  if (!dmpReady) return false;
+  uint32_t readMillis = millis();
+  uint8_t intStatus = dmpMpu.getIntStatus();
+  uint16_t fifoBytes = dmpMpu.getFIFOCount();
+  if ((intStatus & MPU_INT_FIFO_OFLOW) || fifoBytes >= 1024) {
+    handleFIFOOverflow();
+    return true;
+  }
+  uint16_t queued = fifoBytes / dmpPacketSize;
+  if (queued > maxFifoBacklog) maxFifoBacklog = queued;
+  uint16_t pending = (queued > FIFO_MAX_SAMPLES_PER_UPDATE) ? FIFO_MAX_SAMPLES_PER_UPDATE : queued;
+  uint8_t packet[64];
+  for (uint16_t i = 0; i < pending; i++) {
+    dmpMpu.getFIFOBytes(packet, dmpPacketSize);
+    Quaternion q;
+    VectorInt16 accel, gyro;
+    dmpMpu.dmpGetQuaternion(&q, packet);
+    dmpMpu.dmpGetAccel(&accel, packet);
+    dmpMpu.dmpGetGyro(&gyro, packet);
+    int16_t raw[6] = {accel.x, accel.y, accel.z, gyro.x, gyro.y, gyro.z};
+    float quat[4] = {q.w, q.x, q.y, q.z};
+    uint32_t t = nextSampleTimestamp(readMicros, queued, i);
+    processSample(raw, t, readMillis - (readMicros - t) / 1000, quat);
+  }
+  return true;
+}
+#else
+// Drain queued FIFO samples in order, in bursts that fit the Wire buffer
+static bool drainSamples(uint32_t readMicros) {
+  uint32_t readMillis = millis();
+  uint8_t header[2];
+  if (!readRegisters(MPU_REG_INT_STATUS, header, 1)) return false;
+  if (header[0] & MPU_INT_FIFO_OFLOW) {
+    handleFIFOOverflow();
+    return true;
+  }
+  if (!readRegisters(MPU_REG_FIFO_COUNTH, header, 2)) return false;
+  uint16_t queued = ((header[0] << 8) | header[1]) / FIFO_SAMPLE_BYTES;
+  if (queued > maxFifoBacklog) maxFifoBacklog = queued;
+  // Anything beyond the cap stays queued for the next call
+  uint16_t pending = (queued > FIFO_MAX_SAMPLES_PER_UPDATE) ? FIFO_MAX_SAMPLES_PER_UPDATE : queued;
+  
+  uint8_t burst[FIFO_BURST_SAMPLES * FIFO_SAMPLE_BYTES];
+  uint16_t index = 0;
+  while (index < pending) {
+    uint8_t count = (pending - index > FIFO_BURST_SAMPLES) ? FIFO_BURST_SAMPLES : pending - index;
+    if (!readRegisters(MPU_REG_FIFO_R_W, burst, count * FIFO_SAMPLE_BYTES)) {
+      resetFIFO(); // Partial read leaves the FIFO misaligned
+      return false;
+    }
+    for (uint8_t k = 0; k < count; k++, index++) {
+      const uint8_t* p = burst + k * FIFO_SAMPLE_BYTES;
+      int16_t raw[6];
+      for (uint8_t axis = 0; axis < 6; axis++) {
+        raw[axis] = (int16_t)((p[axis * 2] << 8) | p[axis * 2 + 1]);
+      }
+      uint32_t t = nextSampleTimestamp(readMicros, queued, index);
+      processSample(raw, t, readMillis - (readMicros - t) / 1000, nullptr);
+    }
+  }
+  return true;
+}
+#endif
+
+// ============= Sampling Task =============
+static void publishSnapshot() {
+  publishSeq++;
+  __sync_synchronize();
+  published.roll = smoothRoll;
+  published.pitch = smoothPitch;
+  published.yaw = smoothYaw;
+  published.motionEnergy = motionEnergy;
+  published.accelMagnitude = smoothedAccelMagnitude();
+  published.dailySteps = dailySteps;
+  published.totalSteps = totalSteps;
+  published.stepEvents = stepEvents;
+  published.lastStepPeak = lastStepPeak;
+  published.lastStepMicros = lastStepMicros;
+  published.stepIntervalAvg = stepIntervalAvg;
+  published.samplesProcessed = samplesProcessed;
+  published.fallState = fallState;
+  published.stepInProgress = stepState != STEP_IDLE;
+  published.slopeWarningActive = slopeWarningActive;
+  published.gait = Gait_getMetrics(micros());
+  __sync_synchronize();
+  publishSeq++;
+}
+
+static ImuSnapshot readSnapshot() {
+  ImuSnapshot snapshot;
+  uint32_t seq;
+  do {
+    seq = publishSeq;
+    __sync_synchronize();
+    memcpy(&snapshot, (const void*)&published, sizeof(snapshot));
+    __sync_synchronize();
+  } while ((seq & 1) || seq != publishSeq);
+  return snapshot;
+}
+
+static void recordWakeJitter(uint32_t wakeMicros) {
+  if (lastWakeMicros != 0) {
+    int32_t deviation = (int32_t)(wakeMicros - lastWakeMicros) - (int32_t)DRAIN_INTERVAL_US;
+    uint32_t jitter = deviation < 0 ? -deviation : deviation;
+    uint8_t bin = 0;
+    while (bin < JITTER_BINS - 1 && jitter >= JITTER_BIN_LIMIT_US[bin]) bin++;
+    jitterHistogram[bin]++;
+    if (jitter > maxJitterUs) maxJitterUs = jitter;
+  }
+  lastWakeMicros = wakeMicros;
+}
+
+static void onPaceTimer(void* arg) {
+  // esp_timer dispatches from its own task, so a plain notify is enough
+  xTaskNotifyGive(imuTaskHandle);
+}
+
+static void imuSamplingTask(void* parameter) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    uint32_t wake = micros();
+    if (pauseRequested) {
+      samplingPaused = true;
+      lastWakeMicros = 0;
+      continue;
+    }
+    samplingPaused = false;
+    recordWakeJitter(wake);
+    
+    if (stepResetRequested) {
+      dailySteps = 0;
+      stepResetRequested = false;
+      stepFlushPending = true;
+    }
+    if (drainSamples(wake)) {
+      i2cErrorCount = 0;
+    } else {
+      handleI2CError();
+    }
+    publishSnapshot();
+    
+    uint32_t busy = micros() - wake;
+    if (busy > maxBusyUs) maxBusyUs = busy;
+  }
+}
+
+static void startSamplingTask() {
+  publishSnapshot();
+  xTaskCreatePinnedToCore(
+    imuSamplingTask,
+    "IMU_Sampling",
+    IMU_TASK_STACK_SIZE,
+    nullptr,
+    IMU_TASK_PRIORITY,
+    &imuTaskHandle,
+    IMU_TASK_CORE
+  );
+  if (!imuTaskHandle) {
+    Serial.println("❌ IMU sampling task could not be created");
+    return;
+  }
+  
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = &onPaceTimer;
+  timerArgs.name = "imu_pace";
+  if (esp_timer_create(&timerArgs, &imuPaceTimer) != ESP_OK ||
+      esp_timer_start_periodic(imuPaceTimer, DRAIN_INTERVAL_US) != ESP_OK) {
+    Serial.println("❌ IMU pace timer could not be started");
+  }
+}
+
+// Stops FIFO draining so loop() can own the MPU6050 (calibration)
+static void pauseSampling() {
+  if (!imuTaskHandle) return;
+  pauseRequested = true;
+  uint32_t start = millis();
+  while (!samplingPaused && millis() - start < 100) delay(1);
+}
+
+static void resumeSampling() {
+  pauseRequested = false;
+}
+
+// Loop-side reporting of what the task detected since the last call
+static void reportEvents(const ImuSnapshot& snapshot) {
+  static uint32_t seenStepEvents = 0;
+  static FallState seenFallState = FALL_NONE;
+  static bool seenSlopeWarning = false;
+  static uint32_t lastSlopeReminder = 0;
+  uint32_t nowMs = millis();
+  
+  if (snapshot.stepEvents != seenStepEvents) {
+    seenStepEvents = snapshot.stepEvents;
+    Serial.printf("Step detected! Daily: %lu, Total: %lu (Peak: %.2fg)\n", 
+                  snapshot.dailySteps, snapshot.totalSteps, snapshot.lastStepPeak);
+    // Step detection feedback - short vibration (respect feedback mode, see updateFeedback)
+    stepPulseUntil = nowMs + 50;
+  }
+  
+  if (snapshot.fallState != seenFallState) {
+    if (snapshot.fallState == FALL_CONFIRMED) {
+      Serial.println("\n!!! FALL CONFIRMED - SENDING ALERT !!!");
+      fbState = FB_FALL_ALERT;
+      fbTimer = nowMs;
+    } else if (snapshot.fallState == FALL_NONE) {
+      Serial.println("Fall alarm reset");
+    }
+    seenFallState = snapshot.fallState;
+  }
+  
+  if (snapshot.slopeWarningActive != seenSlopeWarning) {
+    seenSlopeWarning = snapshot.slopeWarningActive;
+    Serial.println(seenSlopeWarning ? "SLOPE WARNING: Steep terrain ahead!" : "Slope warning cleared");
+    lastSlopeReminder = nowMs;
+  } else if (seenSlopeWarning && nowMs - lastSlopeReminder > 5000) {
+    Serial.println("SLOPE WARNING: Still on steep terrain");
+    lastSlopeReminder = nowMs;
+  }
+}
+
+static void reportSampleHealth(const ImuSnapshot& snapshot) {
+  static uint32_t seenSamples = 0;
+  static uint32_t seenOverflows = 0;
+  if (fifoOverflows != seenOverflows) {
+    seenOverflows = fifoOverflows;
+    SensorHealthManager::updateSensorHealth("mpu6050", SENSOR_ERROR, nullptr, "FIFO overflow - samples lost");
+#ifdef SC_DEBUG_IMU
+    Serial.println("⚠️ MPU6050 FIFO overflow - buffer reset");
+#endif
+    return;
+  }
+  if (snapshot.samplesProcessed == seenSamples) return;
+  seenSamples = snapshot.samplesProcessed;
+  char value[16];
+  snprintf(value, sizeof(value), "%.3f", snapshot.accelMagnitude);
+  SensorHealthManager::updateSensorHealth("mpu6050", SENSOR_OK, value);
+}
+
 void IMU_update(SensorData* data) {
   uint32_t now = micros();
-  if (now < nextMicros) return;
-  nextMicros += SAMPLE_US;
+  if ((int32_t)(now - nextServiceMicros) < 0) return;
+  nextServiceMicros = now + DRAIN_INTERVAL_US;
   updateFeedback();
   static uint32_t buttonPressTime = 0;
   static bool buttonActive = false;
@@ -665,56 +1129,35 @@ void IMU_update(SensorData* data) {
   } else if (buttonActive) {
     buttonActive = false;
     if (!factoryResetDone && !stepResetDone && millis() - buttonPressTime < 3000) {
+      pauseSampling();
       calibrateSensors();
+      BlackBox_setImuInfo(blackBoxInfo());
+      resumeSampling();
     }
     factoryResetDone = false;
     stepResetDone = false;
   }
-  int16_t axr, ayr, azr, gxr, gyr, gzr;
-  if (!readMPUData(axr, ayr, azr, gxr, gyr, gzr)) { handleI2CError(); return; }
-  i2cErrorCount = 0;
-  axr -= accelOffsets[0]; ayr -= accelOffsets[1]; azr -= accelOffsets[2];
-  gxr -= gyroOffsets[0]; gyr -= gyroOffsets[1]; gzr -= gyroOffsets[2];
-  float ax_g = axr / 4096.0f;
-  float ay_g = ayr / 4096.0f;
-  float az_g = azr / 4096.0f;
-  float gx_dps = gxr / 32.8f;
-  float gy_dps = gyr / 32.8f;
-  float gz_dps = gzr / 32.8f;
-  axBuf[bufIdx] = axr; ayBuf[bufIdx] = ayr; azBuf[bufIdx] = azr;
-  gxBuf[bufIdx] = gxr; gyBuf[bufIdx] = gyr; gzBuf[bufIdx] = gzr;
-  bufIdx = (bufIdx + 1) % 5;
-  float ax = median5(axBuf) / 4096.0f;
-  float ay = median5(ayBuf) / 4096.0f;
-  float az = median5(azBuf) / 4096.0f;
-  float gx = median5(gxBuf) / 32.8f;
-  float gy = median5(gyBuf) / 32.8f;
-  float gz = median5(gzBuf) / 32.8f;
-  smoothAx = SMOOTH_ALPHA * ax + (1 - SMOOTH_ALPHA) * smoothAx;
-  smoothAy = SMOOTH_ALPHA * ay + (1 - SMOOTH_ALPHA) * smoothAy;
-  smoothAz = SMOOTH_ALPHA * az + (1 - SMOOTH_ALPHA) * smoothAz;
-  smoothGx = SMOOTH_ALPHA * gx + (1 - SMOOTH_ALPHA) * smoothGx;
-  smoothGy = SMOOTH_ALPHA * gy + (1 - SMOOTH_ALPHA) * smoothGy;
-  smoothGz = SMOOTH_ALPHA * gz + (1 - SMOOTH_ALPHA) * smoothGz;
-  float accelDelta = abs(ax - smoothAx) + abs(ay - smoothAy) + abs(az - smoothAz);
-  float gyroDelta = abs(gx - smoothGx) + abs(gy - smoothGy) + abs(gz - smoothGz);
-  motionEnergy = 0.95f * motionEnergy + 0.05f * (accelDelta + gyroDelta * 0.1f);
-  filter.updateIMU(
-    smoothGx * DEG_TO_RAD,
-    smoothGy * DEG_TO_RAD,
-    smoothGz * DEG_TO_RAD,
-    smoothAx, smoothAy, smoothAz
-  );
-  float roll = filter.getRoll();
-  float pitch = filter.getPitch();
-  float yaw = filter.getYaw();
-  float currentAlpha = (motionEnergy > MOTION_THRESH) ? FAST_ALPHA : SMOOTH_ALPHA;
-  smoothRoll = currentAlpha * roll + (1 - currentAlpha) * smoothRoll;
-  smoothPitch = currentAlpha * pitch + (1 - currentAlpha) * smoothPitch;
-  smoothYaw = currentAlpha * yaw + (1 - currentAlpha) * smoothYaw;
-  detectSteps(now);
-  detectFalls(now);
-  detectSlope();
+  if (reconfigurePending) {
+    reconfigurePending = false;
+    pauseSampling();
+#ifdef SC_IMU_USE_DMP
+    configureDMP();
+#else
+    configureMPU();
+#endif
+    resumeSampling();
+  }
+  ImuSnapshot snapshot = readSnapshot();
+  reportEvents(snapshot);
+  reportSampleHealth(snapshot);
+  if (stepFlushPending) {
+    stepFlushPending = false;
+    stepSavePending = false;
+    saveStepData(true);
+  } else if (stepSavePending) {
+    stepSavePending = false;
+    saveStepData(false);
+  }
   
   // Check for daily step reset
   static uint32_t lastResetCheck = 0;
@@ -728,27 +1171,30 @@ void IMU_update(SensorData* data) {
   static uint32_t lastPrint = 0;
   if (now - lastPrint >= 100000) {
     lastPrint = now;
-    char stepIndicator = (stepState != STEP_IDLE) ? 'S' : ' ';
-    char fallIndicator = (fallState != FALL_NONE) ? 'F' : ' ';
-    char slopeIndicator = slopeWarningActive ? 'W' : ' ';
-    Serial.printf("[%c%c%c] Daily:%lu Total:%lu | R:%5.1f P:%5.1f | Motion:%4.2f | Time:%s\n",
-      stepIndicator, fallIndicator, slopeIndicator,
-      dailySteps, totalSteps, smoothRoll, smoothPitch, motionEnergy, IMU_getTimeSource().c_str());
-    Serial.print("Pitch: [");
-    int pitchPos = map(constrain(smoothPitch, -30, 30), -30, 30, 0, 20);
+    char stepIndicator = snapshot.stepInProgress ? 'S' : ' ';
+    char fallIndicator = (snapshot.fallState != FALL_NONE) ? 'F' : ' ';
+    char slopeIndicator = snapshot.slopeWarningActive ? 'W' : ' ';
+    // Two records, admitted together so the rate limit never cuts the line in half
+    if (LOG_ENABLED(LOG_CAT_IMU, LOG_LEVEL_INFO) && Log_admit(LOG_CAT_IMU)) {
+      LOG_ADMITTED(LOG_CAT_IMU, LOG_LEVEL_INFO, "[%c%c%c] Daily:%lu Total:%lu ",
+        stepIndicator, fallIndicator, slopeIndicator, snapshot.dailySteps, snapshot.totalSteps);
+      LOG_ADMITTED(LOG_CAT_IMU, LOG_LEVEL_INFO, "| R:%5.1f P:%5.1f | Motion:%4.2f | Time:%s\n",
+        snapshot.roll, snapshot.pitch, snapshot.motionEnergy, IMU_getTimeSource().c_str());
+    }
+    char pitchBar[21];
+    int pitchPos = map(constrain(snapshot.pitch, -30, 30), -30, 30, 0, 20);
     for (int i = 0; i < 20; i++) {
-      Serial.print(i == pitchPos ? '^' : (i == 10 ? '|' : ' '));
+      pitchBar[i] = (i == pitchPos) ? '^' : (i == 10 ? '|' : ' ');
     }
-    Serial.print("] ");
-    Serial.print(smoothPitch, 1);
-    Serial.println("°");
+    pitchBar[20] = '\0';
+    LOG_INFO(LOG_CAT_IMU, "Pitch: [%s] %.1f°\n", pitchBar, snapshot.pitch);
   }
   if (data) {
-    data->imuPitch = smoothPitch;
-    data->imuRoll = smoothRoll;
-    data->imuYaw = smoothYaw;
-    data->dailySteps = dailySteps;
-    data->totalSteps = totalSteps;
+    data->imuPitch = snapshot.pitch;
+    data->imuRoll = snapshot.roll;
+    data->imuYaw = snapshot.yaw;
+    data->dailySteps = snapshot.dailySteps;
+    data->totalSteps = snapshot.totalSteps;
     data->lastResetDay = lastResetDay;
     data->lastResetMonth = lastResetMonth;
     data->lastResetYear = lastResetYear;
@@ -757,13 +1203,151 @@ void IMU_update(SensorData* data) {
 
 // Getter functions for BLE access
 FallState IMU_getFallState() {
-  return fallState;
+  return readSnapshot().fallState;
+}
+
+void IMU_printAcquisitionStats() {
+  Serial.println("\n📈 IMU Acquisition:");
+#ifdef SC_IMU_USE_DMP
+  Serial.printf("Source: DMP FIFO (%s), %lu Hz\n", dmpReady ? "ready" : "not ready", IMU_SAMPLE_HZ);
+#else
+  Serial.printf("Source: raw FIFO, %lu Hz, bursts of %d\n", IMU_SAMPLE_HZ, FIFO_BURST_SAMPLES);
+#endif
+  Serial.printf("Samples processed: %lu\n", samplesProcessed);
+  Serial.printf("FIFO overflows: %lu | Max backlog: %u samples | Timestamp resyncs: %lu\n",
+                fifoOverflows, maxFifoBacklog, timestampResyncs);
+  
+  if (!imuTaskHandle) {
+    Serial.println("Sampling task: not running");
+    return;
+  }
+  Serial.printf("Sampling task: core %d, prio %d, period %lu us, stack free %u bytes%s\n",
+                IMU_TASK_CORE, IMU_TASK_PRIORITY, DRAIN_INTERVAL_US,
+                uxTaskGetStackHighWaterMark(imuTaskHandle), samplingPaused ? " (paused)" : "");
+  Serial.printf("Max wake jitter: %lu us | Max busy: %lu us\n", maxJitterUs, maxBusyUs);
+  uint32_t wakeups = 0;
+  for (uint8_t i = 0; i < JITTER_BINS; i++) wakeups += jitterHistogram[i];
+  for (uint8_t i = 0; i < JITTER_BINS; i++) {
+    uint32_t percent = wakeups ? (jitterHistogram[i] * 100) / wakeups : 0;
+    if (i < JITTER_BINS - 1) {
+      Serial.printf("  < %4lu us: %8lu (%3lu%%)\n", JITTER_BIN_LIMIT_US[i], jitterHistogram[i], percent);
+    } else {
+      Serial.printf("  >=%4lu us: %8lu (%3lu%%)\n", JITTER_BIN_LIMIT_US[i - 1], jitterHistogram[i], percent);
+    }
+  }
+}
+
+void IMU_runPreprocessBenchmark() {
+  static const uint16_t BENCH_SAMPLES = 2000;
+  Serial.println("\n⏱️ IMU Preprocess Benchmark:");
+  Serial.println("================================");
+#ifdef SC_AXIS_MEDIAN_SIMD
+  Serial.println("Median path: ESP32-S3 PIE (EE.VMIN/VMAX.S16)");
+#else
+  Serial.println("Median path: scalar");
+#endif
+  
+  // Deterministic walking-like trace with noise, saturation and sign flips
+  uint32_t seed = 0x2468ACE;
+  auto nextRandom = [&seed]() { seed = seed * 1664525UL + 1013904223UL; return seed >> 16; };
+  static int16_t trace[BENCH_SAMPLES][AXIS_CHANNELS];
+  for (uint16_t i = 0; i < BENCH_SAMPLES; i++) {
+    for (uint8_t lane = 0; lane < AXIS_CHANNELS; lane++) {
+      int32_t base = (lane == AXIS_AZ) ? 4096 : 0;
+      int32_t value = base + (int32_t)((i * (lane + 3)) % 800) - 400 + (int32_t)(nextRandom() % 201) - 100;
+      uint32_t r = nextRandom() % 100;
+      if (r < 2) value = 32767;
+      else if (r < 4) value = -32768;
+      else if (r < 6) value = -value;
+      trace[i][lane] = (int16_t)constrain(value, -32768, 32767);
+    }
+  }
+  
+  // Golden: dispatched median == scalar network == full sort of the same window
+  AxisMedian5 window;
+  AxisBlock fast, scalar;
+  int16_t reference[AXIS_HISTORY];
+  uint16_t mismatches = 0;
+  window.fill(trace[0]);
+  for (uint16_t i = 0; i < BENCH_SAMPLES; i++) {
+    window.push(trace[i]);
+    window.median(fast);
+    window.medianScalar(scalar);
+    if (memcmp(&fast, &scalar, sizeof(AxisBlock)) != 0) { mismatches++; continue; }
+    if (i + 1 < AXIS_HISTORY) continue;
+    for (uint8_t lane = 0; lane < AXIS_CHANNELS; lane++) {
+      for (uint8_t k = 0; k < AXIS_HISTORY; k++) reference[k] = trace[i + 1 - AXIS_HISTORY + k][lane];
+      MedianN<AXIS_HISTORY, int16_t>::insertionSort(reference, AXIS_HISTORY);
+      if (fast.lane[lane] != reference[AXIS_HISTORY >> 1]) { mismatches++; break; }
+    }
+  }
+  Serial.printf("Median golden check: %s (%u/%u mismatches)\n",
+                mismatches == 0 ? "✅ PASS" : "❌ FAIL", mismatches, BENCH_SAMPLES);
+  
+  // Cycles per sample: per-channel sort + divide (old layout) vs lane-wise
+  volatile float sink = 0;
+  int16_t channel[AXIS_HISTORY];
+  uint32_t start = ESP.getCycleCount();
+  for (uint16_t i = AXIS_HISTORY; i < BENCH_SAMPLES; i++) {
+    for (uint8_t lane = 0; lane < AXIS_CHANNELS; lane++) {
+      for (uint8_t k = 0; k < AXIS_HISTORY; k++) channel[k] = trace[i - k][lane];
+      MedianN<AXIS_HISTORY, int16_t>::insertionSort(channel, AXIS_HISTORY);
+      sink = channel[2] / (lane < 3 ? ACCEL_LSB_PER_G : GYRO_LSB_PER_DPS);
+    }
+  }
+  uint32_t perChannelCycles = ESP.getCycleCount() - start;
+  
+  start = ESP.getCycleCount();
+  for (uint16_t i = 0; i < BENCH_SAMPLES; i++) {
+    window.push(trace[i]);
+    window.medianScalar(scalar);
+  }
+  uint32_t scalarCycles = ESP.getCycleCount() - start;
+  
+  start = ESP.getCycleCount();
+  for (uint16_t i = 0; i < BENCH_SAMPLES; i++) {
+    window.push(trace[i]);
+    window.median(fast);
+  }
+  uint32_t dispatchCycles = ESP.getCycleCount() - start;
+  
+  // Full preprocess on a scratch state so the live filter is untouched
+  AxisFilterState scratch;
+  memset(scratch.smooth, 0, sizeof(scratch.smooth));
+  start = ESP.getCycleCount();
+  for (uint16_t i = 0; i < BENCH_SAMPLES; i++) {
+    sink = preprocessAxes(scratch, trace[i], SMOOTH_ALPHA);
+  }
+  uint32_t preprocessCycles = ESP.getCycleCount() - start;
+  (void)sink;
+  
+  Serial.printf("Per-channel sort+divide: %lu cycles/sample\n", perChannelCycles / (BENCH_SAMPLES - AXIS_HISTORY));
+  Serial.printf("Six-lane median scalar:  %lu cycles/sample\n", scalarCycles / BENCH_SAMPLES);
+  Serial.printf("Six-lane median active:  %lu cycles/sample\n", dispatchCycles / BENCH_SAMPLES);
+  Serial.printf("Full preprocess (active): %lu cycles/sample\n", preprocessCycles / BENCH_SAMPLES);
+  Serial.println("================================\n");
+}
+
+float IMU_getPitch() {
+  return readSnapshot().pitch;
 }
 
 float IMU_getMotionEnergy() {
-  return motionEnergy;
+  return readSnapshot().motionEnergy;
+}
+
+float IMU_getStepCadence() {
+  // Steps per second, 0 when no step has been seen recently
+  ImuSnapshot snapshot = readSnapshot();
+  if (snapshot.lastStepMicros == 0 || snapshot.stepIntervalAvg <= 0) return 0;
+  if (micros() - snapshot.lastStepMicros > CADENCE_TIMEOUT_US) return 0;
+  return 1.0f / snapshot.stepIntervalAvg;
 }
 
 bool IMU_getSlopeWarningActive() {
-  return slopeWarningActive;
+  return readSnapshot().slopeWarningActive;
+}
+
+GaitMetrics IMU_getGaitMetrics() {
+  return readSnapshot().gait;
 }
\ No newline at end of file
@@ -2,15 +2,21 @@
 #ifndef IMU_H
 #define IMU_H
 #include "SensorData.h"
+#include "GaitAnalytics.h"
 
 #include <Arduino.h>
 void IMU_init();
 void IMU_update(SensorData* data);
 void IMU_setTime(uint8_t hour, uint8_t minute, uint8_t day, uint8_t month, uint16_t year);
 String IMU_getTimeSource();
+void IMU_printAcquisitionStats();
+void IMU_runPreprocessBenchmark();
 
 // Getter functions for BLE access
 FallState IMU_getFallState();
+float IMU_getPitch();
 float IMU_getMotionEnergy();
+float IMU_getStepCadence();
 bool IMU_getSlopeWarningActive();
+GaitMetrics IMU_getGaitMetrics();
 #endif
\ No newline at end of file
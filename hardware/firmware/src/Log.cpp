@@ -0,0 +1,321 @@
+#include "Log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// ============= Ring Configuration =============
+#define LOG_RING_SIZE 128                 // Power of two; 80 bytes per record
+#define LOG_TASK_STACK_SIZE 4096
+#define LOG_TASK_PRIORITY 1
+#define LOG_TASK_CORE 0
+static const uint32_t LOG_IDLE_POLL_MS = 10;
+static const uint32_t DROP_REPORT_INTERVAL_MS = 1000;
+
+// ============= Binary Frames =============
+// A5 5A | len | payload | sum8(payload)
+// payload: (level << 4 | category), timestampMs u32, fmt address u32,
+//          argCount u8, types u32, args u32 x slots, stringBytes u8, strings
+static const uint8_t FRAME_SYNC0 = 0xA5;
+static const uint8_t FRAME_SYNC1 = 0x5A;
+
+// ============= Lock-Free Ring =============
+// Bounded multi-producer queue (per-cell sequence numbers): producers claim a
+// position with a CAS and publish the cell by advancing its sequence; the
+// writer task is the only consumer. No producer ever waits on the UART.
+struct LogCell {
+  volatile uint32_t sequence;
+  LogRecord record;
+};
+
+static LogCell ring[LOG_RING_SIZE];
+static uint32_t enqueuePos = 0;
+static uint32_t dequeuePos = 0;
+static TaskHandle_t logTaskHandle = nullptr;
+static volatile bool binaryMode = false;
+
+// ============= Rate Limits and Stats =============
+struct CategoryLimit {
+  uint16_t perSecond;     // 0 = unlimited
+  uint16_t burst;
+  uint32_t tokensMilli;   // Tokens x 1000
+  uint32_t lastRefillMs;
+};
+
+static const char* const CATEGORY_NAMES[LOG_CAT_COUNT] = {"SYS", "IMU", "TOF", "BLE", "GPS", "TABLE"};
+static CategoryLimit limits[LOG_CAT_COUNT] = {
+  {0, 0, 0, 0},       // SYS
+  {25, 25, 0, 0},     // IMU: status line + pitch bar at 10 Hz
+  {25, 25, 0, 0},     // TOF
+  {20, 20, 0, 0},     // BLE
+  {20, 20, 0, 0},     // GPS
+  {2, 2, 0, 0}        // TABLE: rows, admitted once per row
+};
+static portMUX_TYPE limitMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t droppedFull[LOG_CAT_COUNT] = {0};
+static volatile uint32_t rateLimited[LOG_CAT_COUNT] = {0};
+static uint32_t recordsWritten = 0;
+static uint32_t ringHighWater = 0;
+static uint32_t reportedDrops = 0;
+static uint32_t lastDropReport = 0;
+
+const char* Log_getCategoryName(LogCategory category) {
+  return category < LOG_CAT_COUNT ? CATEGORY_NAMES[category] : "?";
+}
+
+// ============= Formatting =============
+static uint64_t slotValue64(const LogRecord& record, uint8_t slot) {
+  return (uint64_t)record.args[slot] | ((uint64_t)record.args[slot + 1] << 32);
+}
+
+// printf one record. Conversions are re-typed from the stored argument, so a
+// %d given a float (or the reverse) prints a sensible value instead of garbage.
+static size_t formatRecord(const LogRecord& record, char* out, size_t size) {
+  size_t len = 0;
+  uint8_t arg = 0, slot = 0;
+  const char* p = record.fmt;
+  while (*p && len < size - 1) {
+    if (*p != '%') { out[len++] = *p++; continue; }
+    if (p[1] == '%') { out[len++] = '%'; p += 2; continue; }
+
+    // Flags, width and precision are kept; length modifiers are rebuilt below
+    char spec[20];
+    size_t n = 0;
+    spec[n++] = *p++;
+    while (*p && !strchr("diouxXcfFeEgGsp", *p)) {
+      if (!strchr("hlzjtLq", *p) && n < sizeof(spec) - 4) spec[n++] = *p;
+      p++;
+    }
+    if (!*p) break;
+    char conv = *p++;
+    if (arg >= record.argCount) {
+      out[len++] = '?';
+      continue;
+    }
+    uint8_t type = (record.types >> (arg * 4)) & 0xF;
+    arg++;
+
+    double real = 0;
+    int64_t integer = 0;
+    const char* text = "?";
+    switch (type) {
+      case LOG_ARG_I32: integer = (int32_t)record.args[slot]; real = integer; slot++; break;
+      case LOG_ARG_U32: integer = record.args[slot]; real = integer; slot++; break;
+      case LOG_ARG_F32: {
+        float f;
+        memcpy(&f, &record.args[slot++], sizeof(f));
+        real = f;
+        integer = (int64_t)f;
+        break;
+      }
+      case LOG_ARG_F64: {
+        uint64_t bits = slotValue64(record, slot);
+        slot += 2;
+        memcpy(&real, &bits, sizeof(real));
+        integer = (int64_t)real;
+        break;
+      }
+      case LOG_ARG_I64: integer = (int64_t)slotValue64(record, slot); real = integer; slot += 2; break;
+      case LOG_ARG_U64: integer = (int64_t)slotValue64(record, slot); real = (double)(uint64_t)integer; slot += 2; break;
+      case LOG_ARG_STR: text = record.strings + record.args[slot++]; break;
+    }
+    bool wide = (type == LOG_ARG_I64 || type == LOG_ARG_U64);
+
+    int written;
+    if (strchr("fFeEgG", conv)) {
+      spec[n++] = conv; spec[n] = '\0';
+      written = snprintf(out + len, size - len, spec, real);
+    } else if (conv == 's') {
+      spec[n++] = 's'; spec[n] = '\0';
+      written = snprintf(out + len, size - len, spec, text);
+    } else if (conv == 'c') {
+      spec[n++] = 'c'; spec[n] = '\0';
+      written = snprintf(out + len, size - len, spec, (int)integer);
+    } else if (conv == 'p') {
+      spec[n++] = 'p'; spec[n] = '\0';
+      written = snprintf(out + len, size - len, spec, (void*)(uintptr_t)integer);
+    } else {
+      spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = '\0';
+      if (conv == 'd' || conv == 'i') {
+        long long value = wide ? (long long)integer : (long long)(int32_t)integer;
+        written = snprintf(out + len, size - len, spec, value);
+      } else {
+        unsigned long long value = wide ? (unsigned long long)integer : (unsigned long long)(uint32_t)integer;
+        written = snprintf(out + len, size - len, spec, value);
+      }
+    }
+    if (written > 0) len += ((size_t)written < size - len) ? written : size - len - 1;
+  }
+  out[len] = '\0';
+  return len;
+}
+
+static size_t encodeFrame(const LogRecord& record, uint8_t* frame) {
+  uint8_t slots = 0;
+  for (uint8_t i = 0; i < record.argCount; i++) {
+    uint8_t type = (record.types >> (i * 4)) & 0xF;
+    slots += (type == LOG_ARG_F64 || type == LOG_ARG_I64 || type == LOG_ARG_U64) ? 2 : 1;
+  }
+  uint8_t* payload = frame + 3;
+  size_t n = 0;
+  uint32_t fmtAddress = (uint32_t)(uintptr_t)record.fmt;
+  payload[n++] = (record.level << 4) | record.category;
+  memcpy(payload + n, &record.timestampMs, 4); n += 4;
+  memcpy(payload + n, &fmtAddress, 4); n += 4;
+  payload[n++] = record.argCount;
+  memcpy(payload + n, &record.types, 4); n += 4;
+  memcpy(payload + n, record.args, slots * 4); n += slots * 4;
+  payload[n++] = record.stringBytes;
+  memcpy(payload + n, record.strings, record.stringBytes); n += record.stringBytes;
+
+  uint8_t sum = 0;
+  for (size_t i = 0; i < n; i++) sum += payload[i];
+  frame[0] = FRAME_SYNC0;
+  frame[1] = FRAME_SYNC1;
+  frame[2] = (uint8_t)n;
+  frame[3 + n] = sum;
+  return n + 4;
+}
+
+static void emitRecord(const LogRecord& record) {
+  if (binaryMode) {
+    uint8_t frame[sizeof(LogRecord) + 8];
+    size_t len = encodeFrame(record, frame);
+    Serial.write(frame, len);
+  } else {
+    char line[256];
+    size_t len = formatRecord(record, line, sizeof(line));
+    Serial.write((const uint8_t*)line, len);
+  }
+}
+
+// ============= Producer Side =============
+bool Log_admit(LogCategory category) {
+  if (category >= LOG_CAT_COUNT) return false;
+  CategoryLimit& limit = limits[category];
+  if (limit.perSecond == 0) return true;
+
+  bool admitted = false;
+  uint32_t now = millis();
+  portENTER_CRITICAL(&limitMux);
+  uint32_t elapsed = now - limit.lastRefillMs;
+  limit.lastRefillMs = now;
+  uint32_t capacity = (uint32_t)limit.burst * 1000;
+  limit.tokensMilli += (elapsed > 60000 ? 60000 : elapsed) * limit.perSecond;
+  if (limit.tokensMilli > capacity) limit.tokensMilli = capacity;
+  if (limit.tokensMilli >= 1000) {
+    limit.tokensMilli -= 1000;
+    admitted = true;
+  }
+  portEXIT_CRITICAL(&limitMux);
+  if (!admitted) rateLimited[category]++;
+  return admitted;
+}
+
+void Log_commit(const LogRecord& record) {
+  if (!logTaskHandle) {
+    emitRecord(record);  // Before Log_begin(): print synchronously as before
+    return;
+  }
+  uint32_t pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+  for (;;) {
+    LogCell& cell = ring[pos & (LOG_RING_SIZE - 1)];
+    int32_t diff = (int32_t)(__atomic_load_n(&cell.sequence, __ATOMIC_ACQUIRE) - pos);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&enqueuePos, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        cell.record = record;
+        __atomic_store_n(&cell.sequence, pos + 1, __ATOMIC_RELEASE);
+        return;
+      }
+    } else if (diff < 0) {
+      __atomic_fetch_add(&droppedFull[record.category], 1, __ATOMIC_RELAXED);  // Ring full
+      return;
+    } else {
+      pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+// ============= Writer Task =============
+static uint32_t totalDropped() {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < LOG_CAT_COUNT; i++) total += droppedFull[i];
+  return total;
+}
+
+static bool takeRecord(LogRecord& record) {
+  LogCell& cell = ring[dequeuePos & (LOG_RING_SIZE - 1)];
+  if (__atomic_load_n(&cell.sequence, __ATOMIC_ACQUIRE) != dequeuePos + 1) return false;
+  record = cell.record;
+  __atomic_store_n(&cell.sequence, dequeuePos + LOG_RING_SIZE, __ATOMIC_RELEASE);
+  dequeuePos++;
+  return true;
+}
+
+static void logWriterTask(void* parameter) {
+  LogRecord record;
+  for (;;) {
+    uint32_t backlog = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED) - dequeuePos;
+    if (backlog > ringHighWater) ringHighWater = backlog;
+    bool wrote = false;
+    while (takeRecord(record)) {
+      emitRecord(record);
+      recordsWritten++;
+      wrote = true;
+    }
+
+    uint32_t now = millis();
+    uint32_t dropped = totalDropped();
+    if (dropped != reportedDrops && now - lastDropReport >= DROP_REPORT_INTERVAL_MS) {
+      Serial.printf("⚠️ Log: %lu records dropped (ring full)\n", dropped - reportedDrops);
+      reportedDrops = dropped;
+      lastDropReport = now;
+    }
+    if (!wrote) vTaskDelay(pdMS_TO_TICKS(LOG_IDLE_POLL_MS));
+  }
+}
+
+void Log_begin() {
+  if (logTaskHandle) return;
+  for (uint32_t i = 0; i < LOG_RING_SIZE; i++) ring[i].sequence = i;
+  enqueuePos = 0;
+  dequeuePos = 0;
+  xTaskCreatePinnedToCore(
+    logWriterTask,
+    "LogWriter",
+    LOG_TASK_STACK_SIZE,
+    nullptr,
+    LOG_TASK_PRIORITY,
+    &logTaskHandle,
+    LOG_TASK_CORE
+  );
+}
+
+void Log_setBinary(bool binary) {
+  binaryMode = binary;
+}
+
+bool Log_isBinary() {
+  return binaryMode;
+}
+
+void Log_setRateLimit(LogCategory category, uint16_t perSecond, uint16_t burst) {
+  if (category >= LOG_CAT_COUNT) return;
+  portENTER_CRITICAL(&limitMux);
+  limits[category].perSecond = perSecond;
+  limits[category].burst = burst ? burst : perSecond;
+  limits[category].tokensMilli = (uint32_t)limits[category].burst * 1000;
+  portEXIT_CRITICAL(&limitMux);
+}
+
+void Log_printStats() {
+  Serial.println("\n📝 Deferred Log:");
+  Serial.printf("Writer: %s | Output: %s | Level: %d | Ring: %d records (%u bytes), high water %lu\n",
+                logTaskHandle ? "running" : "not started", binaryMode ? "binary" : "text",
+                SC_LOG_LEVEL, LOG_RING_SIZE, (unsigned)sizeof(ring), ringHighWater);
+  Serial.printf("Records written: %lu | Dropped (ring full): %lu\n", recordsWritten, totalDropped());
+  Serial.println("Category  Limit/s  Burst  Dropped  RateLimited");
+  for (uint8_t i = 0; i < LOG_CAT_COUNT; i++) {
+    Serial.printf("%-8s  %7u  %5u  %7lu  %11lu\n", CATEGORY_NAMES[i],
+                  limits[i].perSecond, limits[i].burst, droppedFull[i], rateLimited[i]);
+  }
+}
@@ -0,0 +1,177 @@
+#pragma once
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include <type_traits>
+
+// Deferred logger for hot paths. A LOG_* call copies the format string
+// pointer and its raw arguments into a lock-free ring (no formatting, no
+// UART); a low-priority task formats and prints them, or emits compact
+// binary frames decoded on the host by hardware/tools/log_decode.py.
+// A full ring drops the record and counts it instead of blocking.
+//
+// Compile-time filtering: SC_LOG_LEVEL (default LOG_LEVEL_INFO) and the
+// SC_LOG_CATEGORIES bit mask remove calls entirely.
+// Format strings must be literals; %s arguments are copied into the record.
+// Arguments must fit LOG_MAX_ARGS slots, which is checked at compile time.
+
+enum LogLevel : uint8_t {
+  LOG_LEVEL_ERROR = 0,
+  LOG_LEVEL_WARN,
+  LOG_LEVEL_INFO,
+  LOG_LEVEL_DEBUG
+};
+
+enum LogCategory : uint8_t {
+  LOG_CAT_SYS = 0,
+  LOG_CAT_IMU,
+  LOG_CAT_TOF,
+  LOG_CAT_BLE,
+  LOG_CAT_GPS,
+  LOG_CAT_TABLE,    // Periodic sensor table rows
+  LOG_CAT_COUNT
+};
+
+#ifndef SC_LOG_LEVEL
+#define SC_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#ifndef SC_LOG_CATEGORIES
+#define SC_LOG_CATEGORIES 0xFF
+#endif
+
+#define LOG_MAX_ARGS 8          // 32-bit slots; doubles and 64-bit integers take two
+#define LOG_STRING_POOL 32      // Bytes shared by the %s arguments of one record
+
+// Argument type tags, 4 bits per argument
+enum LogArgType : uint8_t {
+  LOG_ARG_I32 = 1,
+  LOG_ARG_U32,
+  LOG_ARG_F32,
+  LOG_ARG_F64,
+  LOG_ARG_I64,
+  LOG_ARG_U64,
+  LOG_ARG_STR    // Slot holds the offset into the string pool
+};
+
+struct LogRecord {
+  const char* fmt;              // Format string ID (address in flash)
+  uint32_t timestampMs;
+  uint8_t category;
+  uint8_t level;
+  uint8_t argCount;
+  uint8_t stringBytes;
+  uint32_t types;
+  uint32_t args[LOG_MAX_ARGS];
+  char strings[LOG_STRING_POOL];
+};
+
+void Log_begin();
+void Log_setBinary(bool binary);             // Binary frames instead of text
+bool Log_isBinary();
+void Log_setRateLimit(LogCategory category, uint16_t perSecond, uint16_t burst);  // 0 = unlimited
+void Log_printStats();
+const char* Log_getCategoryName(LogCategory category);
+
+// Producer side, used by the macros below
+bool Log_admit(LogCategory category);        // Rate limit check; counts rejects
+void Log_commit(const LogRecord& record);    // Copies into the ring or counts a drop
+
+namespace LogDetail {
+
+// Slots one argument takes; LOG_* calls are checked against LOG_MAX_ARGS when compiled
+template <typename T>
+constexpr uint8_t slotsFor() {
+  return ((std::is_floating_point<T>::value && !std::is_same<T, float>::value) ||
+          (std::is_integral<T>::value && sizeof(T) > 4)) ? 2 : 1;
+}
+
+struct Builder {
+  LogRecord record;
+  uint8_t slot = 0;
+
+  void put(uint8_t type, uint32_t value) {
+    record.types |= (uint32_t)type << (record.argCount * 4);
+    record.argCount++;
+    record.args[slot++] = value;
+  }
+  void put64(uint8_t type, uint64_t value) {
+    record.types |= (uint32_t)type << (record.argCount * 4);
+    record.argCount++;
+    record.args[slot++] = (uint32_t)value;
+    record.args[slot++] = (uint32_t)(value >> 32);
+  }
+  void putString(const char* text) {
+    uint8_t offset = record.stringBytes;
+    if (!text) text = "(null)";
+    while (*text && record.stringBytes < LOG_STRING_POOL - 1) {
+      record.strings[record.stringBytes++] = *text++;
+    }
+    record.strings[record.stringBytes++] = '\0';
+    put(LOG_ARG_STR, offset);
+  }
+
+  template <typename T>
+  void add(T value) {
+    if constexpr (std::is_same<T, const char*>::value || std::is_same<T, char*>::value) {
+      putString(value);
+    } else if constexpr (std::is_same<T, float>::value) {
+      uint32_t bits;
+      memcpy(&bits, &value, sizeof(bits));
+      put(LOG_ARG_F32, bits);
+    } else if constexpr (std::is_floating_point<T>::value) {
+      double wide = value;
+      uint64_t bits;
+      memcpy(&bits, &wide, sizeof(bits));
+      put64(LOG_ARG_F64, bits);
+    } else if constexpr (std::is_enum<T>::value) {
+      put(LOG_ARG_I32, (uint32_t)(int32_t)value);
+    } else if constexpr (std::is_integral<T>::value && sizeof(T) > 4) {
+      put64(std::is_signed<T>::value ? LOG_ARG_I64 : LOG_ARG_U64, (uint64_t)value);
+    } else if constexpr (std::is_integral<T>::value) {
+      if (std::is_signed<T>::value) put(LOG_ARG_I32, (uint32_t)(int32_t)value);
+      else put(LOG_ARG_U32, (uint32_t)value);
+    } else {
+      static_assert(std::is_integral<T>::value, "LOG_* argument type is not supported");
+    }
+  }
+};
+
+template <typename... Args>
+inline void write(bool admit, LogCategory category, LogLevel level, const char* fmt, Args... args) {
+  static_assert((0 + ... + slotsFor<Args>()) <= LOG_MAX_ARGS,
+                "Too many LOG_* arguments for one record; split the line with LOG_ADMITTED");
+  if (admit && !Log_admit(category)) return;
+  Builder builder;
+  memset(&builder.record, 0, offsetof(LogRecord, args));
+  builder.record.fmt = fmt;
+  builder.record.timestampMs = millis();
+  builder.record.category = category;
+  builder.record.level = level;
+  (builder.add(args), ...);
+  Log_commit(builder.record);
+}
+
+}  // namespace LogDetail
+
+#define LOG_ENABLED(category, level) \
+  ((level) <= SC_LOG_LEVEL && ((SC_LOG_CATEGORIES >> (category)) & 1))
+
+#define LOG_AT(category, level, fmt, ...) \
+  do { \
+    if (LOG_ENABLED(category, level)) LogDetail::write(true, category, level, fmt, ##__VA_ARGS__); \
+  } while (0)
+
+// Multi-record lines: the caller passes Log_admit() once and emits every part
+// with LOG_ADMITTED, so the rate limit never cuts a line in half.
+#define LOG_ADMITTED(category, level, fmt, ...) \
+  do { \
+    if (LOG_ENABLED(category, level)) LogDetail::write(false, category, level, fmt, ##__VA_ARGS__); \
+  } while (0)
+
+#define LOG_ERROR(category, fmt, ...) LOG_AT(category, LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_WARN(category, fmt, ...)  LOG_AT(category, LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_INFO(category, fmt, ...)  LOG_AT(category, LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(category, fmt, ...) LOG_AT(category, LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+
+#endif // LOG_H
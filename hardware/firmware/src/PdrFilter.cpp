@@ -0,0 +1,295 @@
+#include "PdrFilter.h"
+#include <math.h>
+
+// Madgwick yaw turns counter-clockwise seen from above; compass headings
+// turn clockwise. The offset state absorbs the (unknown) yaw reference.
+#define PDR_YAW_SIGN -1.0f
+
+// Process noise per step
+#define PDR_Q_POSITION 0.01f        // (0.1 m)^2 cane sway, missed foot placement
+#define PDR_Q_OFFSET 7.6e-5f        // (0.5 deg)^2 yaw drift
+#define PDR_Q_STEP_LENGTH 1e-4f     // (0.01 m)^2
+
+#define PDR_MIN_ACCURACY_M 2.0f     // Receivers report optimistic hAcc in the open
+#define PDR_GATE_CHI2 13.8f         // 2 DOF, 99.9%
+#define PDR_MAX_REJECTS 5           // Then the filter is wrong, not the fixes
+#define PDR_OFFSET_SIGMA0 0.35f     // ~20 deg after initialization from course
+#define PDR_STEP_SIGMA0 0.15f
+#define PDR_STEP_MIN_M 0.3f
+#define PDR_STEP_MAX_M 1.2f
+
+static const float EARTH_RADIUS_M = 6371000.0f;
+
+static float wrapPi(float angle) {
+  while (angle > (float)M_PI) angle -= 2.0f * (float)M_PI;
+  while (angle < -(float)M_PI) angle += 2.0f * (float)M_PI;
+  return angle;
+}
+
+// Keeps P symmetric and its diagonal positive after rounding
+static void conditionCovariance(PdrFilter& filter) {
+  for (uint8_t i = 0; i < PDR_STATE_COUNT; i++) {
+    if (filter.P[i][i] < 1e-6f) filter.P[i][i] = 1e-6f;
+    for (uint8_t j = i + 1; j < PDR_STATE_COUNT; j++) {
+      float mean = 0.5f * (filter.P[i][j] + filter.P[j][i]);
+      filter.P[i][j] = filter.P[j][i] = mean;
+    }
+  }
+}
+
+void Pdr_reset(PdrFilter& filter) {
+  memset(&filter, 0, sizeof(filter));
+}
+
+void Pdr_init(PdrFilter& filter, double lat, double lon, float accuracyM, float stepLengthM) {
+  uint32_t steps = filter.steps, fixes = filter.fixes, headingUpdates = filter.headingUpdates;
+  uint32_t rejected = filter.rejected, resets = filter.resets;
+  Pdr_reset(filter);
+  filter.steps = steps;
+  filter.fixes = fixes;
+  filter.headingUpdates = headingUpdates;
+  filter.rejected = rejected;
+  filter.resets = resets;
+
+  filter.originLat = lat;
+  filter.originLon = lon;
+  filter.metersPerDegLat = EARTH_RADIUS_M * (float)M_PI / 180.0f;
+  filter.metersPerDegLon = filter.metersPerDegLat * cosf(lat * (float)M_PI / 180.0f);
+  float variance = fmaxf(accuracyM, PDR_MIN_ACCURACY_M);
+  variance *= variance;
+  filter.x[PDR_STATE_STEP_LENGTH] = constrain(stepLengthM, PDR_STEP_MIN_M, PDR_STEP_MAX_M);
+  filter.P[PDR_STATE_X_NORTH][PDR_STATE_X_NORTH] = variance;
+  filter.P[PDR_STATE_X_EAST][PDR_STATE_X_EAST] = variance;
+  filter.P[PDR_STATE_HEADING_OFFSET][PDR_STATE_HEADING_OFFSET] = (float)(M_PI * M_PI);
+  filter.P[PDR_STATE_STEP_LENGTH][PDR_STATE_STEP_LENGTH] = PDR_STEP_SIGMA0 * PDR_STEP_SIGMA0;
+  filter.initialized = true;
+}
+
+void Pdr_predictStep(PdrFilter& filter, float imuYawRad) {
+  if (!filter.initialized || !filter.headingLocked) return;
+  float* x = filter.x;
+  float heading = PDR_YAW_SIGN * imuYawRad + x[PDR_STATE_HEADING_OFFSET];
+  float c = cosf(heading);
+  float s = sinf(heading);
+  float length = x[PDR_STATE_STEP_LENGTH];
+  x[PDR_STATE_X_NORTH] += length * c;
+  x[PDR_STATE_X_EAST] += length * s;
+
+  // P = F P F^T + Q with F = I except the two position rows
+  float F[PDR_STATE_COUNT][PDR_STATE_COUNT] = {
+    {1, 0, -length * s, c},
+    {0, 1, length * c, s},
+    {0, 0, 1, 0},
+    {0, 0, 0, 1}
+  };
+  float FP[PDR_STATE_COUNT][PDR_STATE_COUNT];
+  for (uint8_t i = 0; i < PDR_STATE_COUNT; i++) {
+    for (uint8_t j = 0; j < PDR_STATE_COUNT; j++) {
+      float sum = 0;
+      for (uint8_t k = 0; k < PDR_STATE_COUNT; k++) sum += F[i][k] * filter.P[k][j];
+      FP[i][j] = sum;
+    }
+  }
+  for (uint8_t i = 0; i < PDR_STATE_COUNT; i++) {
+    for (uint8_t j = i; j < PDR_STATE_COUNT; j++) {
+      float sum = 0;
+      for (uint8_t k = 0; k < PDR_STATE_COUNT; k++) sum += FP[i][k] * F[j][k];
+      filter.P[i][j] = filter.P[j][i] = sum;
+    }
+  }
+  filter.P[PDR_STATE_X_NORTH][PDR_STATE_X_NORTH] += PDR_Q_POSITION;
+  filter.P[PDR_STATE_X_EAST][PDR_STATE_X_EAST] += PDR_Q_POSITION;
+  filter.P[PDR_STATE_HEADING_OFFSET][PDR_STATE_HEADING_OFFSET] += PDR_Q_OFFSET;
+  filter.P[PDR_STATE_STEP_LENGTH][PDR_STATE_STEP_LENGTH] += PDR_Q_STEP_LENGTH;
+  filter.steps++;
+}
+
+bool Pdr_updateFix(PdrFilter& filter, double lat, double lon, float accuracyM) {
+  if (!filter.initialized) return false;
+  float r = fmaxf(accuracyM, PDR_MIN_ACCURACY_M);
+  r *= r;
+  float* x = filter.x;
+  float (*P)[PDR_STATE_COUNT] = filter.P;
+  float yN = (float)(lat - filter.originLat) * filter.metersPerDegLat - x[PDR_STATE_X_NORTH];
+  float yE = (float)(lon - filter.originLon) * filter.metersPerDegLon - x[PDR_STATE_X_EAST];
+
+  // S = H P H^T + R for H = [I2 0], inverted in closed form
+  float s00 = P[0][0] + r, s01 = P[0][1], s11 = P[1][1] + r;
+  float det = s00 * s11 - s01 * s01;
+  if (det <= 0) return false;
+  float i00 = s11 / det, i01 = -s01 / det, i11 = s00 / det;
+  float mahalanobis = yN * (i00 * yN + i01 * yE) + yE * (i01 * yN + i11 * yE);
+  if (mahalanobis > PDR_GATE_CHI2) {
+    filter.rejected++;
+    if (++filter.consecutiveRejects >= PDR_MAX_REJECTS) {
+      // Dead reckoning has drifted off: restart at the fix, keep the learned step length
+      filter.resets++;
+      Pdr_init(filter, lat, lon, accuracyM, x[PDR_STATE_STEP_LENGTH]);
+    }
+    return false;
+  }
+  filter.consecutiveRejects = 0;
+
+  // K = P H^T S^-1 (4x2), then x += K y and P -= K H P
+  float K[PDR_STATE_COUNT][2];
+  for (uint8_t i = 0; i < PDR_STATE_COUNT; i++) {
+    K[i][0] = P[i][0] * i00 + P[i][1] * i01;
+    K[i][1] = P[i][0] * i01 + P[i][1] * i11;
+  }
+  for (uint8_t i = 0; i < PDR_STATE_COUNT; i++) x[i] += K[i][0] * yN + K[i][1] * yE;
+  float row0[PDR_STATE_COUNT], row1[PDR_STATE_COUNT];
+  memcpy(row0, P[0], sizeof(row0));
+  memcpy(row1, P[1], sizeof(row1));
+  for (uint8_t i = 0; i < PDR_STATE_COUNT; i++) {
+    for (uint8_t j = 0; j < PDR_STATE_COUNT; j++) P[i][j] -= K[i][0] * row0[j] + K[i][1] * row1[j];
+  }
+  x[PDR_STATE_HEADING_OFFSET] = wrapPi(x[PDR_STATE_HEADING_OFFSET]);
+  x[PDR_STATE_STEP_LENGTH] = constrain(x[PDR_STATE_STEP_LENGTH], PDR_STEP_MIN_M, PDR_STEP_MAX_M);
+  conditionCovariance(filter);
+  filter.fixes++;
+  return true;
+}
+
+void Pdr_updateCourse(PdrFilter& filter, float courseRad, float imuYawRad, float sigmaRad) {
+  if (!filter.initialized) return;
+  float* x = filter.x;
+  float (*P)[PDR_STATE_COUNT] = filter.P;
+  if (!filter.headingLocked) {
+    // The offset is an angle with no prior: set it directly instead of
+    // linearizing across a +/-180 degree uncertainty
+    x[PDR_STATE_HEADING_OFFSET] = wrapPi(courseRad - PDR_YAW_SIGN * imuYawRad);
+    for (uint8_t i = 0; i < PDR_STATE_COUNT; i++) P[i][PDR_STATE_HEADING_OFFSET] = P[PDR_STATE_HEADING_OFFSET][i] = 0;
+    P[PDR_STATE_HEADING_OFFSET][PDR_STATE_HEADING_OFFSET] = PDR_OFFSET_SIGMA0 * PDR_OFFSET_SIGMA0;
+    filter.headingLocked = true;
+    filter.headingUpdates++;
+    return;
+  }
+  const uint8_t h = PDR_STATE_HEADING_OFFSET;
+  float y = wrapPi(courseRad - (PDR_YAW_SIGN * imuYawRad + x[h]));
+  float s = P[h][h] + sigmaRad * sigmaRad;
+  float K[PDR_STATE_COUNT];
+  for (uint8_t i = 0; i < PDR_STATE_COUNT; i++) K[i] = P[i][h] / s;
+  for (uint8_t i = 0; i < PDR_STATE_COUNT; i++) x[i] += K[i] * y;
+  float row[PDR_STATE_COUNT];
+  memcpy(row, P[h], sizeof(row));
+  for (uint8_t i = 0; i < PDR_STATE_COUNT; i++) {
+    for (uint8_t j = 0; j < PDR_STATE_COUNT; j++) P[i][j] -= K[i] * row[j];
+  }
+  x[h] = wrapPi(x[h]);
+  x[PDR_STATE_STEP_LENGTH] = constrain(x[PDR_STATE_STEP_LENGTH], PDR_STEP_MIN_M, PDR_STEP_MAX_M);
+  conditionCovariance(filter);
+  filter.headingUpdates++;
+}
+
+void Pdr_getPosition(const PdrFilter& filter, double* lat, double* lon) {
+  *lat = filter.originLat + filter.x[PDR_STATE_X_NORTH] / filter.metersPerDegLat;
+  *lon = filter.originLon + filter.x[PDR_STATE_X_EAST] / filter.metersPerDegLon;
+}
+
+float Pdr_positionSigma(const PdrFilter& filter) {
+  return sqrtf(fmaxf(filter.P[PDR_STATE_X_NORTH][PDR_STATE_X_NORTH], filter.P[PDR_STATE_X_EAST][PDR_STATE_X_EAST]));
+}
+
+float Pdr_headingDeg(const PdrFilter& filter, float imuYawRad) {
+  float heading = wrapPi(PDR_YAW_SIGN * imuYawRad + filter.x[PDR_STATE_HEADING_OFFSET]) * 180.0f / (float)M_PI;
+  return heading < 0 ? heading + 360.0f : heading;
+}
+
+// ============= Synthetic Walk Benchmark =============
+// Rectangle walk with a drifting, noisy IMU yaw, noisy 1 Hz fixes and a
+// stretch with no GPS at all (tree cover): the filter must beat the raw
+// fixes and coast through the outage on steps alone.
+void Pdr_runBenchmark() {
+  static const uint16_t LEG_STEPS = 100;
+  static const uint16_t WALK_STEPS = 4 * LEG_STEPS;
+  static const uint16_t OUTAGE_START = 250;
+  static const uint16_t OUTAGE_STEPS = 60;
+  static const float TRUE_STEP_M = 0.72f;
+  static const float FIX_NOISE_M = 7.0f;          // Uniform +/-7 m, sigma ~4 m
+  static const double ORIGIN_LAT = 25.382344;
+  static const double ORIGIN_LON = 68.327323;
+  Serial.println("\n⏱️ PDR Filter Benchmark:");
+  Serial.println("================================");
+
+  uint32_t seed = 0x5EED41;
+  auto nextRandom = [&seed]() { seed = seed * 1664525UL + 1013904223UL; return seed >> 16; };
+  auto noise = [&nextRandom](float amplitude) { return ((nextRandom() & 0xFFFF) / 32767.5f - 1.0f) * amplitude; };
+
+  static PdrFilter filter;
+  Pdr_reset(filter);
+  float metersPerDegLat = EARTH_RADIUS_M * (float)M_PI / 180.0f;
+  float metersPerDegLon = metersPerDegLat * cosf(ORIGIN_LAT * (float)M_PI / 180.0f);
+  float trueNorth = 0, trueEast = 0;
+  float yawDrift = 0;
+  double fusedSquared = 0, rawSquared = 0;
+  uint16_t scored = 0;
+  float outageMax = 0;
+  uint32_t predictCycles = 0, updateCycles = 0, predictMax = 0, updateMax = 0;
+  uint16_t updates = 0;
+
+  for (uint16_t step = 0; step < WALK_STEPS; step++) {
+    float heading = (step / LEG_STEPS) * (float)M_PI / 2.0f;   // N, E, S, W
+    trueNorth += TRUE_STEP_M * cosf(heading);
+    trueEast += TRUE_STEP_M * sinf(heading);
+    yawDrift += 0.0003f;                                        // ~7 deg over the walk
+    // IMU yaw in its own frame: opposite sense, arbitrary zero, drift and jitter
+    float imuYaw = (heading - 0.65f) / PDR_YAW_SIGN + yawDrift + noise(0.03f);
+
+    uint32_t start = ESP.getCycleCount();
+    Pdr_predictStep(filter, imuYaw);
+    uint32_t cycles = ESP.getCycleCount() - start;
+    predictCycles += cycles;
+    if (cycles > predictMax) predictMax = cycles;
+
+    bool outage = step >= OUTAGE_START && step < OUTAGE_START + OUTAGE_STEPS;
+    if (outage) {
+      double lat, lon;
+      Pdr_getPosition(filter, &lat, &lon);
+      float dN = (float)(lat - ORIGIN_LAT) * metersPerDegLat - trueNorth;
+      float dE = (float)(lon - ORIGIN_LON) * metersPerDegLon - trueEast;
+      outageMax = fmaxf(outageMax, sqrtf(dN * dN + dE * dE));
+      continue;
+    }
+    if (step % 2) continue;                                     // ~1.8 steps per fix
+
+    float rawNorth = trueNorth + noise(FIX_NOISE_M);
+    float rawEast = trueEast + noise(FIX_NOISE_M);
+    double rawLat = ORIGIN_LAT + rawNorth / metersPerDegLat;
+    double rawLon = ORIGIN_LON + rawEast / metersPerDegLon;
+    start = ESP.getCycleCount();
+    if (!filter.initialized) {
+      Pdr_init(filter, rawLat, rawLon, 4.0f, 0.65f);
+    } else {
+      Pdr_updateFix(filter, rawLat, rawLon, 4.0f);
+      Pdr_updateCourse(filter, heading + noise(0.1f), imuYaw, 0.1f);
+    }
+    cycles = ESP.getCycleCount() - start;
+    updateCycles += cycles;
+    if (cycles > updateMax) updateMax = cycles;
+    updates++;
+
+    // Score after the filter has had the first leg to settle
+    if (step < LEG_STEPS / 2) continue;
+    double lat, lon;
+    Pdr_getPosition(filter, &lat, &lon);
+    float dN = (float)(lat - ORIGIN_LAT) * metersPerDegLat - trueNorth;
+    float dE = (float)(lon - ORIGIN_LON) * metersPerDegLon - trueEast;
+    fusedSquared += dN * dN + dE * dE;
+    rawSquared += (rawNorth - trueNorth) * (rawNorth - trueNorth) + (rawEast - trueEast) * (rawEast - trueEast);
+    scored++;
+  }
+
+  float fusedRms = scored ? sqrtf(fusedSquared / scored) : 0;
+  float rawRms = scored ? sqrtf(rawSquared / scored) : 0;
+  Serial.printf("Fused vs raw RMS: %s (%.2f m vs %.2f m over %u fixes)\n",
+                fusedRms < rawRms ? "✅ PASS" : "❌ FAIL", fusedRms, rawRms, scored);
+  Serial.printf("%u-step outage: %s (max error %.2f m)\n", OUTAGE_STEPS,
+                outageMax < 10.0f ? "✅ PASS" : "❌ FAIL", outageMax);
+  Serial.printf("Step length: %.3f m learned (true %.2f m)\n", filter.x[PDR_STATE_STEP_LENGTH], TRUE_STEP_M);
+  Serial.printf("Fixes applied/rejected: %lu/%lu, resets %lu\n", (unsigned long)filter.fixes,
+                (unsigned long)filter.rejected, (unsigned long)filter.resets);
+  Serial.printf("Predict: %lu cycles avg, %lu max\n", (unsigned long)(predictCycles / WALK_STEPS), (unsigned long)predictMax);
+  Serial.printf("Update: %lu cycles avg, %lu max (budget %lu)\n", (unsigned long)(updates ? updateCycles / updates : 0),
+                (unsigned long)updateMax, (unsigned long)PDR_UPDATE_CYCLE_BUDGET);
+  Serial.println("================================");
+}
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef PDRFILTER_H
+#define PDRFILTER_H
+
+#include <Arduino.h>
+
+// Pedestrian dead reckoning fused with GPS in a 4-state EKF. State, in a
+// local north/east plane around the first fix:
+//   x = [north m, east m, heading offset rad, step length m]
+// Each detected step predicts the position along IMU yaw + offset; GPS fixes
+// correct the position (weighted by their accuracy) and GPS course corrects
+// the offset while walking. Fixed-size, no allocation.
+
+// Predict or update on the loop task; 100 us at 240 MHz
+#define PDR_UPDATE_CYCLE_BUDGET 24000
+enum PdrState : uint8_t {
+  PDR_STATE_X_NORTH = 0,
+  PDR_STATE_X_EAST,
+  PDR_STATE_HEADING_OFFSET,
+  PDR_STATE_STEP_LENGTH,
+  PDR_STATE_COUNT
+};
+
+struct PdrFilter {
+  float x[PDR_STATE_COUNT];
+  float P[PDR_STATE_COUNT][PDR_STATE_COUNT];
+  bool initialized;             // Position known (first fix)
+  bool headingLocked;           // Offset initialized from GPS course; steps move the position
+  double originLat;
+  double originLon;
+  float metersPerDegLat;
+  float metersPerDegLon;
+  uint8_t consecutiveRejects;
+  uint32_t steps;               // Predict steps applied
+  uint32_t fixes;               // Position updates applied
+  uint32_t headingUpdates;
+  uint32_t rejected;            // Fixes outside the innovation gate
+  uint32_t resets;              // Re-initializations after repeated rejects
+};
+
+void Pdr_reset(PdrFilter& filter);
+// First fix: origin of the local plane and the initial position uncertainty
+void Pdr_init(PdrFilter& filter, double lat, double lon, float accuracyM, float stepLengthM);
+// One step along the IMU yaw (radians, Madgwick convention)
+void Pdr_predictStep(PdrFilter& filter, float imuYawRad);
+// GPS position with its 1-sigma horizontal accuracy; false when gated out
+bool Pdr_updateFix(PdrFilter& filter, double lat, double lon, float accuracyM);
+// GPS course over ground (radians from north) with the IMU yaw at the same time
+void Pdr_updateCourse(PdrFilter& filter, float courseRad, float imuYawRad, float sigmaRad);
+void Pdr_getPosition(const PdrFilter& filter, double* lat, double* lon);
+float Pdr_positionSigma(const PdrFilter& filter);   // sqrt of the larger position variance
+float Pdr_headingDeg(const PdrFilter& filter, float imuYawRad);
+void Pdr_runBenchmark();                            // Synthetic walk with a GPS outage
+
+#endif // PDRFILTER_H
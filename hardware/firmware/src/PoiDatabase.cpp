@@ -0,0 +1,509 @@
+#include "PoiDatabase.h"
+#include "SDCardManager.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <math.h>
+
+#define POI_TASK_STACK_SIZE 4096
+#define POI_TASK_PRIORITY 1
+#define POI_TASK_CORE 0
+#define POI_ANNOUNCE_QUEUE 4
+#define POI_RECENT_SLOTS 32              // POIs announced recently, not repeated
+#define POI_REANNOUNCE_MS 600000UL
+#define POI_STACK_DEPTH 96               // Tree traversal; levels x fanout
+
+// ============= File Format =============
+// [PoiFileHeader][nodeCount x PoiNode, root level first][pad to a page]
+// [pageCount x 1 KiB pages]. A page holds up to recordsPerPage PoiRecords
+// and ends with the CRC-32 of everything before it. Little-endian, natural
+// alignment; build_poi_index.py writes the same layout.
+static const uint32_t POI_MAGIC = 0x31494F50;   // "POI1"
+static const uint16_t POI_VERSION = 1;
+static const uint16_t POI_PAGE_SIZE = 1024;
+static const uint16_t POI_NODE_LEAF = 0x0001;
+
+struct PoiFileHeader {          // 60 bytes
+  uint32_t magic;
+  uint16_t version;
+  uint16_t headerSize;
+  uint16_t recordSize;
+  uint16_t recordsPerPage;
+  uint32_t poiCount;
+  uint32_t pageCount;
+  uint16_t topCount;            // Entries in the root level
+  uint16_t levels;
+  uint32_t nodeCount;
+  uint32_t nodesOffset;
+  uint32_t pagesOffset;
+  int32_t minLatE7;
+  int32_t minLonE7;
+  int32_t maxLatE7;
+  int32_t maxLonE7;
+  uint32_t nodesCrc;
+  uint32_t headerCrc;           // Of every field above
+};
+
+struct PoiNode {                // 24 bytes
+  int32_t minLatE7;
+  int32_t minLonE7;
+  int32_t maxLatE7;
+  int32_t maxLonE7;
+  uint32_t first;               // Child node, or page for a leaf
+  uint16_t count;               // Children, or records in the page
+  uint16_t flags;
+};
+
+struct PoiRecord {              // 32 bytes
+  int32_t latE7;
+  int32_t lonE7;
+  uint8_t category;
+  uint8_t reserved;
+  char name[22];                // UTF-8, zero padded
+};
+
+#define METERS_PER_E7_LAT 0.011119493f
+
+// ============= State =============
+struct PoiCacheEntry {
+  uint32_t page;
+  uint32_t lastUse;
+  bool valid;
+};
+
+static PoiFileHeader header;
+static PoiNode* nodes = nullptr;            // PSRAM
+static uint8_t* cacheBuffers = nullptr;     // PSRAM, POI_CACHE_PAGES pages
+static PoiCacheEntry cache[POI_CACHE_PAGES];
+static uint32_t cacheClock = 0;
+static File indexFile;
+static bool databaseOpen = false;
+static SemaphoreHandle_t poiMutex = nullptr;  // Cache, file handle and counters
+
+static QueueHandle_t positionMailbox = nullptr;
+static QueueHandle_t announceQueue = nullptr;
+static TaskHandle_t poiTaskHandle = nullptr;
+static volatile bool announcementsEnabled = true;
+
+struct PoiPosition {
+  double lat;
+  double lon;
+};
+
+struct RecentPoi {
+  uint32_t id;
+  uint32_t atMs;
+};
+static RecentPoi recent[POI_RECENT_SLOTS];  // Lookup task only
+static uint8_t recentNext = 0;
+
+static PoiStats stats = {};
+
+static const char* const CATEGORY_NAMES[POI_CATEGORY_COUNT] = {
+  "Point", "Crossing", "Bus stop", "Entrance", "Traffic signals", "Steps", "Station", "Bench"
+};
+
+const char* Poi_categoryName(uint8_t category) {
+  return category < POI_CATEGORY_COUNT ? CATEGORY_NAMES[category] : CATEGORY_NAMES[POI_OTHER];
+}
+
+// ============= Page Cache =============
+static bool readPage(uint32_t page, uint8_t* buffer) {
+  if (!indexFile.seek(header.pagesOffset + page * (uint32_t)POI_PAGE_SIZE)) return false;
+  if (indexFile.read(buffer, POI_PAGE_SIZE) != POI_PAGE_SIZE) return false;
+  uint32_t stored;
+  memcpy(&stored, buffer + POI_PAGE_SIZE - 4, sizeof(stored));
+  if (stored != SDCard_crc32(buffer, POI_PAGE_SIZE - 4)) {
+    stats.crcErrors++;
+    return false;
+  }
+  return true;
+}
+
+// Caller holds poiMutex; nullptr when the page cannot be read
+static const uint8_t* fetchPage(uint32_t page, bool* miss) {
+  uint8_t victim = 0;
+  for (uint8_t i = 0; i < POI_CACHE_PAGES; i++) {
+    if (cache[i].valid && cache[i].page == page) {
+      cache[i].lastUse = ++cacheClock;
+      stats.cacheHits++;
+      *miss = false;
+      return cacheBuffers + i * POI_PAGE_SIZE;
+    }
+    if (!cache[i].valid || (cache[victim].valid && cache[i].lastUse < cache[victim].lastUse)) victim = i;
+  }
+  *miss = true;
+  stats.pageReads++;
+  uint8_t* buffer = cacheBuffers + victim * POI_PAGE_SIZE;
+  cache[victim].valid = false;
+  if (!readPage(page, buffer)) return nullptr;
+  cache[victim].page = page;
+  cache[victim].lastUse = ++cacheClock;
+  cache[victim].valid = true;
+  return buffer;
+}
+
+// ============= Query =============
+struct PoiCandidate {
+  uint32_t node;
+  float minDistanceSq;          // From the query point to the page's box
+};
+
+static inline float boxDistanceSq(const PoiNode& node, int32_t latE7, int32_t lonE7, float metersPerE7Lon) {
+  int32_t dLat = latE7 < node.minLatE7 ? node.minLatE7 - latE7 : latE7 > node.maxLatE7 ? latE7 - node.maxLatE7 : 0;
+  int32_t dLon = lonE7 < node.minLonE7 ? node.minLonE7 - lonE7 : lonE7 > node.maxLonE7 ? lonE7 - node.maxLonE7 : 0;
+  float north = dLat * METERS_PER_E7_LAT;
+  float east = dLon * metersPerE7Lon;
+  return north * north + east * east;
+}
+
+static void insertResult(PoiResult* out, uint8_t& found, uint8_t maxResults, const PoiResult& result) {
+  if (found == maxResults && result.distanceM >= out[found - 1].distanceM) return;
+  uint8_t i = found < maxResults ? found++ : found - 1;
+  while (i > 0 && out[i - 1].distanceM > result.distanceM) {
+    out[i] = out[i - 1];
+    i--;
+  }
+  out[i] = result;
+}
+
+uint8_t Poi_query(double lat, double lon, float radiusM, PoiResult* out, uint8_t maxResults,
+                  PoiQueryStats* queryStats) {
+  PoiQueryStats local = {};
+  if (!databaseOpen || maxResults == 0) {
+    if (queryStats) *queryStats = local;
+    return 0;
+  }
+  uint32_t start = micros();
+  radiusM = fminf(radiusM, POI_MAX_QUERY_RADIUS_M);
+  float radiusSq = radiusM * radiusM;
+  int32_t latE7 = (int32_t)lround(lat * 1e7);
+  int32_t lonE7 = (int32_t)lround(lon * 1e7);
+  float metersPerE7Lon = METERS_PER_E7_LAT * cosf(lat * DEG_TO_RAD);
+
+  // Pages whose box comes within the radius, nearest POI_MAX_PAGES_PER_QUERY kept
+  PoiCandidate candidates[POI_MAX_PAGES_PER_QUERY];
+  uint8_t candidateCount = 0;
+  uint32_t stack[POI_STACK_DEPTH];
+  uint8_t depth = 0;
+  for (uint16_t i = header.topCount; i > 0 && depth < POI_STACK_DEPTH; i--) stack[depth++] = i - 1;
+  while (depth > 0) {
+    const PoiNode& node = nodes[stack[--depth]];
+    float distanceSq = boxDistanceSq(node, latE7, lonE7, metersPerE7Lon);
+    if (distanceSq > radiusSq) continue;
+    if (++local.nodesVisited > POI_MAX_NODE_VISITS) {
+      local.truncated = true;
+      break;
+    }
+    if (node.flags & POI_NODE_LEAF) {
+      if (candidateCount == POI_MAX_PAGES_PER_QUERY) {
+        local.truncated = true;
+        if (distanceSq >= candidates[candidateCount - 1].minDistanceSq) continue;
+        candidateCount--;
+      }
+      uint8_t i = candidateCount++;
+      while (i > 0 && candidates[i - 1].minDistanceSq > distanceSq) {
+        candidates[i] = candidates[i - 1];
+        i--;
+      }
+      candidates[i].node = &node - nodes;
+      candidates[i].minDistanceSq = distanceSq;
+      continue;
+    }
+    if (node.first + node.count > header.nodeCount) continue;   // Corrupt link
+    for (uint16_t c = node.count; c > 0; c--) {
+      if (depth == POI_STACK_DEPTH) {
+        local.truncated = true;
+        break;
+      }
+      stack[depth++] = node.first + c - 1;
+    }
+  }
+
+  uint8_t found = 0;
+  xSemaphoreTake(poiMutex, portMAX_DELAY);
+  for (uint8_t c = 0; c < candidateCount; c++) {
+    const PoiNode& node = nodes[candidates[c].node];
+    bool miss;
+    const uint8_t* page = fetchPage(node.first, &miss);
+    local.pagesTouched++;
+    if (miss) local.pageReads++;
+    if (!page) continue;
+    uint16_t records = min(node.count, header.recordsPerPage);
+    for (uint16_t r = 0; r < records; r++) {
+      PoiRecord record;
+      memcpy(&record, page + r * sizeof(PoiRecord), sizeof(record));
+      float north = (record.latE7 - latE7) * METERS_PER_E7_LAT;
+      float east = (record.lonE7 - lonE7) * metersPerE7Lon;
+      float distanceSq = north * north + east * east;
+      if (distanceSq > radiusSq) continue;
+      PoiResult result;
+      result.id = node.first * header.recordsPerPage + r;
+      result.category = record.category;
+      result.distanceM = sqrtf(distanceSq);
+      float bearing = atan2f(east, north) * RAD_TO_DEG;
+      if (bearing < 0) bearing += 360.0f;
+      result.bearingDeg = bearing >= 360.0f ? 0.0f : bearing;
+      memcpy(result.name, record.name, sizeof(record.name));
+      result.name[sizeof(record.name)] = '\0';
+      insertResult(out, found, maxResults, result);
+    }
+  }
+  local.micros = micros() - start;
+  stats.queries++;
+  if (local.truncated) stats.truncated++;
+  stats.lastQueryUs = local.micros;
+  if (local.micros > stats.maxQueryUs) stats.maxQueryUs = local.micros;
+  xSemaphoreGive(poiMutex);
+  if (queryStats) *queryStats = local;
+  return found;
+}
+
+// ============= Lookup Task =============
+static bool announcedRecently(uint32_t id, uint32_t nowMs) {
+  for (uint8_t i = 0; i < POI_RECENT_SLOTS; i++) {
+    if (recent[i].atMs != 0 && recent[i].id == id && nowMs - recent[i].atMs < POI_REANNOUNCE_MS) return true;
+  }
+  return false;
+}
+
+static void poiTask(void* parameter) {
+  PoiPosition position;
+  PoiResult results[POI_MAX_RESULTS];
+  for (;;) {
+    if (xQueueReceive(positionMailbox, &position, portMAX_DELAY) != pdTRUE) continue;
+    if (!announcementsEnabled) continue;
+    uint8_t found = Poi_query(position.lat, position.lon, POI_ANNOUNCE_RADIUS_M, results, POI_MAX_RESULTS);
+    uint32_t nowMs = millis();
+    for (uint8_t i = 0; i < found; i++) {
+      if (announcedRecently(results[i].id, nowMs)) continue;
+      if (xQueueSend(announceQueue, &results[i], 0) != pdTRUE) {
+        stats.announcementsDropped++;
+        break;
+      }
+      recent[recentNext].id = results[i].id;
+      recent[recentNext].atMs = nowMs ? nowMs : 1;
+      recentNext = (recentNext + 1) % POI_RECENT_SLOTS;
+      stats.announced++;
+    }
+  }
+}
+
+// ============= Public API =============
+static bool loadIndex() {
+  indexFile = SD.open(POI_INDEX_PATH, FILE_READ);
+  if (!indexFile) return false;
+  if (indexFile.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+      header.magic != POI_MAGIC || header.version != POI_VERSION ||
+      header.headerCrc != SDCard_crc32((const uint8_t*)&header, offsetof(PoiFileHeader, headerCrc)) ||
+      header.recordSize != sizeof(PoiRecord) || header.recordsPerPage * sizeof(PoiRecord) > POI_PAGE_SIZE - 4u ||
+      header.topCount == 0 || header.topCount > header.nodeCount) {
+    Serial.println("❌ POI index: bad header");
+    return false;
+  }
+  size_t nodeBytes = header.nodeCount * sizeof(PoiNode);
+  nodes = (PoiNode*)(psramFound() ? ps_malloc(nodeBytes) : malloc(nodeBytes));
+  if (!nodes) {
+    Serial.printf("❌ POI index: no memory for %lu tree nodes\n", (unsigned long)header.nodeCount);
+    return false;
+  }
+  if (!indexFile.seek(header.nodesOffset) || indexFile.read((uint8_t*)nodes, nodeBytes) != nodeBytes ||
+      SDCard_crc32((const uint8_t*)nodes, nodeBytes) != header.nodesCrc) {
+    Serial.println("❌ POI index: tree corrupt");
+    free(nodes);
+    nodes = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool Poi_begin() {
+  if (databaseOpen) return true;
+  if (!poiMutex) poiMutex = xSemaphoreCreateMutex();
+  if (!cacheBuffers) {
+    size_t bytes = POI_CACHE_PAGES * POI_PAGE_SIZE;
+    cacheBuffers = (uint8_t*)(psramFound() ? ps_malloc(bytes) : malloc(bytes));
+  }
+  if (!poiMutex || !cacheBuffers) return false;
+  if (!SDCard_fileExists(POI_INDEX_PATH)) {
+    Serial.println("📍 No POI index on SD card (" POI_INDEX_PATH ")");
+    return false;
+  }
+  if (!loadIndex()) {
+    indexFile.close();
+    return false;
+  }
+  memset(cache, 0, sizeof(cache));
+  databaseOpen = true;
+  stats.open = true;
+  stats.poiCount = header.poiCount;
+  stats.pageCount = header.pageCount;
+  stats.nodeCount = header.nodeCount;
+
+  if (!positionMailbox) positionMailbox = xQueueCreate(1, sizeof(PoiPosition));
+  if (!announceQueue) announceQueue = xQueueCreate(POI_ANNOUNCE_QUEUE, sizeof(PoiResult));
+  if (positionMailbox && announceQueue && !poiTaskHandle) {
+    xTaskCreatePinnedToCore(poiTask, "PoiLookup", POI_TASK_STACK_SIZE, nullptr, POI_TASK_PRIORITY,
+                            &poiTaskHandle, POI_TASK_CORE);
+  }
+  Serial.printf("📍 POI index: %lu POIs, %lu pages, %lu tree nodes (%u levels)\n",
+                (unsigned long)header.poiCount, (unsigned long)header.pageCount,
+                (unsigned long)header.nodeCount, header.levels);
+  return true;
+}
+
+bool Poi_isOpen() {
+  return databaseOpen;
+}
+
+void Poi_updatePosition(double lat, double lon) {
+  if (!databaseOpen || !positionMailbox || !announcementsEnabled) return;
+  PoiPosition position = {lat, lon};
+  xQueueOverwrite(positionMailbox, &position);
+}
+
+bool Poi_takeAnnouncement(PoiResult* out) {
+  return announceQueue && xQueueReceive(announceQueue, out, 0) == pdTRUE;
+}
+
+void Poi_enableAnnouncements(bool enable) {
+  announcementsEnabled = enable;
+}
+
+bool Poi_areAnnouncementsEnabled() {
+  return announcementsEnabled;
+}
+
+PoiStats Poi_getStats() {
+  return stats;
+}
+
+void Poi_printStatus() {
+  Serial.println("\n📍 POI Database:");
+  if (!databaseOpen) {
+    Serial.println("   Not loaded (build with hardware/tools/build_poi_index.py, copy to " POI_INDEX_PATH ")");
+    return;
+  }
+  Serial.printf("   %lu POIs in %lu pages, %lu tree nodes, %u levels\n", (unsigned long)stats.poiCount,
+                (unsigned long)stats.pageCount, (unsigned long)stats.nodeCount, header.levels);
+  Serial.printf("   Area: %.5f,%.5f to %.5f,%.5f\n", header.minLatE7 * 1e-7, header.minLonE7 * 1e-7,
+                header.maxLatE7 * 1e-7, header.maxLonE7 * 1e-7);
+  uint32_t lookups = stats.cacheHits + stats.pageReads;
+  Serial.printf("   Cache: %u pages, %lu hits / %lu reads (%.0f%% hit), %lu CRC errors\n", POI_CACHE_PAGES,
+                (unsigned long)stats.cacheHits, (unsigned long)stats.pageReads,
+                lookups ? 100.0f * stats.cacheHits / lookups : 0.0f, (unsigned long)stats.crcErrors);
+  Serial.printf("   Queries: %lu, last %lu us, max %lu us, %lu truncated\n", (unsigned long)stats.queries,
+                (unsigned long)stats.lastQueryUs, (unsigned long)stats.maxQueryUs, (unsigned long)stats.truncated);
+  Serial.printf("   Announcements: %s, %lu queued, %lu dropped (within %u m)\n",
+                announcementsEnabled ? "ON" : "OFF", (unsigned long)stats.announced,
+                (unsigned long)stats.announcementsDropped, POI_ANNOUNCE_RADIUS_M);
+}
+
+void Poi_printNearby(double lat, double lon) {
+  PoiResult results[POI_MAX_RESULTS];
+  PoiQueryStats queryStats;
+  uint8_t found = Poi_query(lat, lon, POI_MAX_QUERY_RADIUS_M, results, POI_MAX_RESULTS, &queryStats);
+  Serial.printf("📍 %u POIs within %u m (%u nodes, %u pages, %u read, %lu us%s)\n", found,
+                POI_MAX_QUERY_RADIUS_M, queryStats.nodesVisited, queryStats.pagesTouched, queryStats.pageReads,
+                (unsigned long)queryStats.micros, queryStats.truncated ? ", truncated" : "");
+  for (uint8_t i = 0; i < found; i++) {
+    Serial.printf("   %-15s %-22s %4.0f m @ %3.0f°\n", Poi_categoryName(results[i].category),
+                  results[i].name, results[i].distanceM, results[i].bearingDeg);
+  }
+}
+
+// ============= Benchmark =============
+// Golden: nearest POIs from the tree equal a scan of every page (reads the
+// whole file, so only a few positions). Then a walk (cache warm) and random
+// jumps across the area (cache cold).
+void Poi_runBenchmark() {
+  static const uint8_t GOLDEN_QUERIES = 3;
+  static const uint16_t WALK_QUERIES = 300;
+  static const uint16_t JUMP_QUERIES = 100;
+  Serial.println("\n⏱️ POI Index Benchmark:");
+  Serial.println("================================");
+  if (!databaseOpen) {
+    Serial.println("❌ No POI index loaded");
+    return;
+  }
+  uint32_t seed = 0x9017;
+  auto nextRandom = [&seed]() { seed = seed * 1664525UL + 1013904223UL; return seed >> 16; };
+  auto randomIn = [&nextRandom](int32_t low, int32_t high) {
+    return low + (int32_t)((((uint32_t)nextRandom() << 16) | nextRandom()) % (uint32_t)(high - low + 1));
+  };
+  static uint8_t scanPage[POI_PAGE_SIZE];
+  PoiResult tree[POI_MAX_RESULTS], scan[POI_MAX_RESULTS];
+  uint16_t mismatches = 0;
+  uint32_t goldenFound = 0;
+  for (uint8_t q = 0; q < GOLDEN_QUERIES; q++) {
+    int32_t latE7 = randomIn(header.minLatE7, header.maxLatE7);
+    int32_t lonE7 = randomIn(header.minLonE7, header.maxLonE7);
+    double lat = latE7 * 1e-7, lon = lonE7 * 1e-7;
+    uint8_t treeFound = Poi_query(lat, lon, POI_MAX_QUERY_RADIUS_M, tree, POI_MAX_RESULTS);
+    float metersPerE7Lon = METERS_PER_E7_LAT * cosf(lat * DEG_TO_RAD);
+    uint8_t scanFound = 0;
+    xSemaphoreTake(poiMutex, portMAX_DELAY);
+    for (uint32_t node = 0; node < header.nodeCount; node++) {
+      if (!(nodes[node].flags & POI_NODE_LEAF) || !readPage(nodes[node].first, scanPage)) continue;
+      for (uint16_t r = 0; r < nodes[node].count; r++) {
+        PoiRecord record;
+        memcpy(&record, scanPage + r * sizeof(PoiRecord), sizeof(record));
+        float north = (record.latE7 - latE7) * METERS_PER_E7_LAT;
+        float east = (record.lonE7 - lonE7) * metersPerE7Lon;
+        float distance = sqrtf(north * north + east * east);
+        if (distance > POI_MAX_QUERY_RADIUS_M) continue;
+        PoiResult result = {};
+        result.id = nodes[node].first * header.recordsPerPage + r;
+        result.distanceM = distance;
+        insertResult(scan, scanFound, POI_MAX_RESULTS, result);
+      }
+    }
+    xSemaphoreGive(poiMutex);
+    if (treeFound != scanFound) mismatches++;
+    for (uint8_t i = 0; i < treeFound && i < scanFound; i++) {
+      if (tree[i].id != scan[i].id && fabsf(tree[i].distanceM - scan[i].distanceM) > 0.01f) mismatches++;
+    }
+    goldenFound += scanFound;
+  }
+  Serial.printf("Tree vs full scan: %s (%u mismatches, %lu POIs over %u positions)\n",
+                mismatches == 0 ? "✅ PASS" : "❌ FAIL", mismatches, (unsigned long)goldenFound, GOLDEN_QUERIES);
+
+  // Walk: ~1 m steps in a slowly turning direction, as the lookup task sees it
+  PoiQueryStats queryStats;
+  uint32_t walkMax = 0, walkTotal = 0, walkReads = 0, truncated = 0;
+  double lat = (header.minLatE7 + (header.maxLatE7 - header.minLatE7) / 2) * 1e-7;
+  double lon = (header.minLonE7 + (header.maxLonE7 - header.minLonE7) / 2) * 1e-7;
+  float heading = 0;
+  for (uint16_t q = 0; q < WALK_QUERIES; q++) {
+    heading += ((int32_t)(nextRandom() % 21) - 10) * 0.01f;
+    lat += cosf(heading) * 1.0 / 111194.93;
+    lon += sinf(heading) * 1.0 / (111194.93 * cos(lat * DEG_TO_RAD));
+    Poi_query(lat, lon, POI_ANNOUNCE_RADIUS_M * 5, tree, POI_MAX_RESULTS, &queryStats);
+    walkTotal += queryStats.micros;
+    walkReads += queryStats.pageReads;
+    if (queryStats.micros > walkMax) walkMax = queryStats.micros;
+    if (queryStats.truncated) truncated++;
+  }
+  uint32_t jumpMax = 0, jumpTotal = 0, jumpReads = 0;
+  uint16_t maxVisits = 0;
+  for (uint16_t q = 0; q < JUMP_QUERIES; q++) {
+    double jumpLat = randomIn(header.minLatE7, header.maxLatE7) * 1e-7;
+    double jumpLon = randomIn(header.minLonE7, header.maxLonE7) * 1e-7;
+    Poi_query(jumpLat, jumpLon, POI_MAX_QUERY_RADIUS_M, tree, POI_MAX_RESULTS, &queryStats);
+    jumpTotal += queryStats.micros;
+    jumpReads += queryStats.pageReads;
+    if (queryStats.micros > jumpMax) jumpMax = queryStats.micros;
+    if (queryStats.nodesVisited > maxVisits) maxVisits = queryStats.nodesVisited;
+    if (queryStats.truncated) truncated++;
+  }
+  Serial.printf("POIs: %lu in %lu pages\n", (unsigned long)header.poiCount, (unsigned long)header.pageCount);
+  Serial.printf("Walk (%u m radius): %lu us avg, %lu us max, %.2f page reads/query\n", POI_ANNOUNCE_RADIUS_M * 5,
+                (unsigned long)(walkTotal / WALK_QUERIES), (unsigned long)walkMax, (float)walkReads / WALK_QUERIES);
+  Serial.printf("Jumps (%u m radius): %lu us avg, %lu us max, %.2f page reads/query, max %u nodes\n",
+                POI_MAX_QUERY_RADIUS_M, (unsigned long)(jumpTotal / JUMP_QUERIES), (unsigned long)jumpMax,
+                (float)jumpReads / JUMP_QUERIES, maxVisits);
+  Serial.printf("Truncated queries: %lu (caps: %u nodes, %u pages)\n", (unsigned long)truncated,
+                POI_MAX_NODE_VISITS, POI_MAX_PAGES_PER_QUERY);
+  Serial.println("================================");
+}
@@ -0,0 +1,82 @@
+#pragma once
+#ifndef POIDATABASE_H
+#define POIDATABASE_H
+
+#include <Arduino.h>
+
+// Offline points of interest (crossings, bus stops, entrances...) from
+// /poi/poi.idx, built on a PC by hardware/tools/build_poi_index.py. POIs
+// are Hilbert-sorted into 1 KiB pages under a packed R-tree; the tree is
+// held in PSRAM and only the pages a query touches are read, through a
+// small LRU cache. Node visits and page reads per query are capped, so a
+// query costs the same with 1k or 100k POIs. A background task looks up
+// each new fix and queues nearby POIs for announcement.
+#define POI_INDEX_PATH "/poi/poi.idx"
+#define POI_NAME_LEN 23                 // 22 bytes in the file + terminator
+#define POI_CACHE_PAGES 16
+#define POI_MAX_PAGES_PER_QUERY 8       // Nearest pages first when more intersect
+#define POI_MAX_NODE_VISITS 128
+#define POI_MAX_QUERY_RADIUS_M 200
+#define POI_ANNOUNCE_RADIUS_M 20
+#define POI_MAX_RESULTS 8
+
+enum PoiCategory : uint8_t {
+  POI_OTHER = 0,
+  POI_CROSSING,
+  POI_BUS_STOP,
+  POI_ENTRANCE,
+  POI_TRAFFIC_SIGNALS,
+  POI_STEPS,
+  POI_STATION,
+  POI_BENCH,
+  POI_CATEGORY_COUNT
+};
+
+struct PoiResult {
+  uint32_t id;                  // Page * records per page + slot; stable for one index file
+  uint8_t category;
+  float distanceM;
+  float bearingDeg;             // From the query position, 0 = north
+  char name[POI_NAME_LEN];
+};
+
+struct PoiQueryStats {
+  uint16_t nodesVisited;
+  uint8_t pagesTouched;
+  uint8_t pageReads;            // Cache misses
+  bool truncated;               // A cap was hit; the farthest pages were skipped
+  uint32_t micros;
+};
+
+struct PoiStats {
+  bool open;
+  uint32_t poiCount;
+  uint32_t pageCount;
+  uint32_t nodeCount;
+  uint32_t queries;
+  uint32_t cacheHits;
+  uint32_t pageReads;
+  uint32_t crcErrors;
+  uint32_t truncated;
+  uint32_t lastQueryUs;
+  uint32_t maxQueryUs;
+  uint32_t announced;
+  uint32_t announcementsDropped;
+};
+
+bool Poi_begin();                   // Open the index, load the tree, start the lookup task
+bool Poi_isOpen();
+// Nearest POIs within radiusM (capped at POI_MAX_QUERY_RADIUS_M), nearest first; any task
+uint8_t Poi_query(double lat, double lon, float radiusM, PoiResult* out, uint8_t maxResults,
+                  PoiQueryStats* stats = nullptr);
+void Poi_updatePosition(double lat, double lon);    // Per fix; the lookup task takes the newest
+bool Poi_takeAnnouncement(PoiResult* out);          // Loop: next nearby POI to announce
+void Poi_enableAnnouncements(bool enable);
+bool Poi_areAnnouncementsEnabled();
+const char* Poi_categoryName(uint8_t category);
+PoiStats Poi_getStats();
+void Poi_printStatus();
+void Poi_printNearby(double lat, double lon);
+void Poi_runBenchmark();            // Tree vs full scan, then cached and cold query times
+
+#endif // POIDATABASE_H
@@ -0,0 +1,994 @@
+#include "RouteEngine.h"
+#include "SDCardManager.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <math.h>
+
+#define ROUTE_TASK_STACK_SIZE 6144
+#define ROUTE_TASK_PRIORITY 1
+#define ROUTE_TASK_CORE 0
+#define ROUTE_EVENT_QUEUE 8
+#define ROUTE_TABLE_BITS 14              // 16384 slots, ROUTE_MAX_NODES at 75% load
+#define ROUTE_TABLE_SIZE (1u << ROUTE_TABLE_BITS)
+#define ROUTE_NAME_LEN 24
+#define ROUTE_TRACK_WINDOW 40            // Segments ahead searched per fix
+#define ROUTE_OFF_ROUTE_FIXES 3
+#define ROUTE_REPLAN_MS 15000
+#define ROUTE_TURN_MIN_DEG 40.0f
+#define ROUTE_TURN_SHARP_DEG 60.0f       // A bend in one way with no junction
+#define ROUTE_TURN_SPAN_M 10.0f          // Bearings measured this far either side of a vertex
+#define ROUTE_STEPS_FACTOR 2.0f
+#define ROUTE_ROAD_FACTOR 1.3f
+#define ROUTE_CROSSING_PENALTY_M 15.0f
+#define ROUTE_TURN_PENALTY_M 12.0f       // Turning at a junction; favours fewer, simpler instructions
+#define ROUTE_TURN_COS 0.7071f           // Over 45 degrees counts as a turn
+#define ROUTE_PLAN_BUDGET_MS 500
+
+// ============= File Format =============
+// [RouteFileHeader][tileCount x RouteTileEntry, by key][tile blobs]. A tile
+// blob is nodeCount RouteNodeRecords then edgeCount RouteEdgeRecords; node
+// ids are global and numbered tile by tile, so a tile owns one id range.
+// Edges are stored in both directions. build_route_graph.py writes the same.
+static const uint32_t ROUTE_MAGIC = 0x31475452;   // "RTG1"
+static const uint16_t ROUTE_VERSION = 1;
+static const uint16_t EDGE_CROSSING = 0x0001;
+static const uint16_t EDGE_STEPS = 0x0002;
+static const uint16_t EDGE_ROAD = 0x0004;         // No sidewalk mapped
+
+struct RouteFileHeader {        // 68 bytes
+  uint32_t magic;
+  uint16_t version;
+  uint16_t headerSize;
+  uint32_t tileE7;              // Tile side, 1e-7 deg
+  int32_t originLatE7;          // South-west corner of tile (0, 0)
+  int32_t originLonE7;
+  uint16_t tileRows;
+  uint16_t tileCols;            // key = row * tileCols + col
+  uint32_t tileCount;           // Non-empty tiles in the directory
+  uint32_t nodeCount;
+  uint32_t edgeCount;           // Directed
+  uint32_t maxTileBytes;
+  uint32_t directoryOffset;
+  int32_t minLatE7;
+  int32_t minLonE7;
+  int32_t maxLatE7;
+  int32_t maxLonE7;
+  uint32_t directoryCrc;
+  uint32_t headerCrc;           // Of every field above
+};
+
+struct RouteTileEntry {         // 24 bytes
+  uint32_t key;
+  uint32_t firstNode;
+  uint16_t nodeCount;
+  uint16_t edgeCount;
+  uint32_t offset;
+  uint32_t size;
+  uint32_t crc;
+};
+
+struct RouteNodeRecord {        // 12 bytes
+  int32_t latE7;
+  int32_t lonE7;
+  uint16_t firstEdge;           // Within the tile
+  uint8_t edgeCount;
+  uint8_t flags;
+};
+
+struct RouteEdgeRecord {        // 8 bytes
+  uint32_t target;
+  uint16_t lengthDm;
+  uint16_t flags;
+};
+
+#define METERS_PER_E7_LAT 0.011119493f
+
+// ============= State =============
+struct TileSlot {
+  int32_t tile;                 // Directory index, -1 = empty
+  uint32_t lastUse;
+  bool pinned;                  // Node being expanded; never the eviction victim
+};
+
+struct TileView {
+  const RouteNodeRecord* nodes;
+  const RouteEdgeRecord* edges;
+  const RouteTileEntry* entry;
+  uint8_t slot;
+};
+
+struct SearchNode {             // 24 bytes
+  uint32_t node;                // UINT32_MAX = empty slot
+  int32_t latE7;
+  int32_t lonE7;
+  float g;                      // Best cost so far
+  int32_t parent;               // Table slot, -1 at the start
+  uint8_t closed;
+  uint8_t degree;
+  uint16_t reserved;
+};
+
+struct OpenEntry {
+  float f;
+  float g;                      // g when pushed; older duplicates are skipped
+  uint32_t slot;
+  int32_t parent;               // Applied when popped, so a dropped entry cannot leave a stale parent
+};
+
+struct RoutePoint {             // 16 bytes
+  int32_t latE7;
+  int32_t lonE7;
+  float along;                  // Meters from the first point
+  uint8_t degree;               // Ways meeting here
+  uint8_t reserved[3];
+};
+
+struct RouteManeuver {
+  uint16_t point;
+  uint8_t type;                 // RouteManeuverType
+  uint8_t stage;                // 0 pending, 1 prepared, 2 announced
+  float along;
+  float turnDeg;                // Negative = left
+};
+
+struct RoutePath {
+  RoutePoint* points;           // PSRAM, ROUTE_MAX_POINTS
+  uint16_t pointCount;
+  RouteManeuver maneuvers[ROUTE_MAX_MANEUVERS];
+  uint16_t maneuverCount;
+  float lengthM;
+  int32_t destLatE7;
+  int32_t destLonE7;
+  char name[ROUTE_NAME_LEN];
+};
+
+struct RouteRequest {
+  int32_t fromLatE7;
+  int32_t fromLonE7;
+  int32_t toLatE7;
+  int32_t toLonE7;
+  uint32_t generation;
+  bool replan;
+  char name[ROUTE_NAME_LEN];
+};
+
+static RouteFileHeader header;
+static RouteTileEntry* directory = nullptr;     // PSRAM
+static uint8_t* tileBuffers = nullptr;          // PSRAM, slotCount x slotBytes
+static uint8_t* slotOfTile = nullptr;           // PSRAM, per directory entry
+static const uint8_t SLOT_NONE = 0xFF;
+static uint32_t slotBytes = 0;
+static uint8_t slotCount = 0;
+static TileSlot slots[ROUTE_MAX_TILE_SLOTS];
+static uint32_t tileClock = 0;
+static File graphFile;
+static bool graphLoaded = false;
+
+static SearchNode* table = nullptr;             // PSRAM
+static OpenEntry* openSet = nullptr;            // PSRAM
+static uint16_t openCount = 0;
+static uint32_t tableCount = 0;
+static uint16_t planTileLoads = 0;
+
+static RoutePath paths[2];                      // Active one followed, the other planned into
+static uint8_t activeIndex = 0;
+
+// Planner side: tile cache, file, search tables, the inactive path
+static SemaphoreHandle_t planMutex = nullptr;
+// Tracking side: which path is active and progress along it
+static SemaphoreHandle_t stateMutex = nullptr;
+static QueueHandle_t requestMailbox = nullptr;
+static QueueHandle_t eventQueue = nullptr;
+static TaskHandle_t plannerHandle = nullptr;
+static volatile uint32_t generation = 0;        // Bumped by request/cancel; stale plans are dropped
+
+static bool routeActive = false;
+static uint16_t trackSegment = 0;
+static uint16_t nextManeuver = 0;
+static uint8_t offRouteFixes = 0;
+static uint32_t lastReplanMs = 0;
+static float remainingM = 0;
+static float offRouteM = 0;
+
+static RouteStats stats = {};
+
+const char* Route_errorName(RouteError error) {
+  switch (error) {
+    case ROUTE_OK: return "OK";
+    case ROUTE_ERR_NO_GRAPH: return "no route graph";
+    case ROUTE_ERR_NO_START: return "start not near a path";
+    case ROUTE_ERR_NO_GOAL: return "destination not near a path";
+    case ROUTE_ERR_UNREACHABLE: return "unreachable";
+    case ROUTE_ERR_SEARCH_LIMIT: return "search limit";
+    case ROUTE_ERR_TOO_LONG: return "route too long";
+    case ROUTE_ERR_IO: return "graph read error";
+    default: return "unknown";
+  }
+}
+
+static void pushEvent(RouteEventType type, RouteManeuverType maneuver, RouteError error, float distanceM,
+                      float nextDistanceM) {
+  RouteEvent event = {type, maneuver, error, distanceM, nextDistanceM};
+  if (xQueueSend(eventQueue, &event, 0) != pdTRUE) stats.eventsDropped++;
+}
+
+static inline float metersPerE7Lon(int32_t latE7) {
+  return METERS_PER_E7_LAT * cosf(latE7 * 1e-7f * DEG_TO_RAD);
+}
+
+static inline float distanceM(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2, float lonScale) {
+  float north = (lat2 - lat1) * METERS_PER_E7_LAT;
+  float east = (lon2 - lon1) * lonScale;
+  return sqrtf(north * north + east * east);
+}
+
+static inline float bearingDeg(const RoutePoint& from, const RoutePoint& to, float lonScale) {
+  return atan2f((to.lonE7 - from.lonE7) * lonScale, (to.latE7 - from.latE7) * METERS_PER_E7_LAT) * RAD_TO_DEG;
+}
+
+// ============= Tile Cache =============
+// Caller holds planMutex. The tile of the node being expanded is pinned, so
+// loading a neighbour's tile never evicts the edge list being walked.
+static bool openTile(int32_t tile, TileView* view) {
+  int16_t victim = slotOfTile[tile] == SLOT_NONE ? -1 : slotOfTile[tile];
+  const RouteTileEntry& entry = directory[tile];
+  if (victim >= 0) {
+    slots[victim].lastUse = ++tileClock;
+    stats.tileHits++;
+  } else {
+    for (uint8_t i = 0; i < slotCount; i++) {
+      if (slots[i].pinned) continue;
+      if (victim < 0 || slots[i].tile < 0 || (slots[victim].tile >= 0 && slots[i].lastUse < slots[victim].lastUse)) {
+        victim = i;
+      }
+    }
+    if (victim < 0 || entry.size > slotBytes) return false;
+    uint8_t* buffer = tileBuffers + victim * slotBytes;
+    if (slots[victim].tile >= 0) slotOfTile[slots[victim].tile] = SLOT_NONE;
+    slots[victim].tile = -1;
+    stats.tileLoads++;
+    planTileLoads++;
+    if (!graphFile.seek(entry.offset) || graphFile.read(buffer, entry.size) != entry.size) return false;
+    if (SDCard_crc32(buffer, entry.size) != entry.crc) {
+      stats.crcErrors++;
+      return false;
+    }
+    slots[victim].tile = tile;
+    slots[victim].lastUse = ++tileClock;
+    slotOfTile[tile] = victim;
+  }
+  const uint8_t* buffer = tileBuffers + victim * slotBytes;
+  view->nodes = (const RouteNodeRecord*)buffer;
+  view->edges = (const RouteEdgeRecord*)(buffer + entry.nodeCount * sizeof(RouteNodeRecord));
+  view->entry = &entry;
+  view->slot = victim;
+  return true;
+}
+
+static int32_t tileOfNode(uint32_t node) {
+  int32_t low = 0, high = (int32_t)header.tileCount - 1;
+  while (low < high) {
+    int32_t mid = (low + high + 1) / 2;
+    if (directory[mid].firstNode <= node) low = mid;
+    else high = mid - 1;
+  }
+  const RouteTileEntry& entry = directory[low];
+  return node >= entry.firstNode && node < entry.firstNode + entry.nodeCount ? low : -1;
+}
+
+static int32_t tileOfKey(uint32_t key) {
+  int32_t low = 0, high = (int32_t)header.tileCount - 1;
+  while (low <= high) {
+    int32_t mid = (low + high) / 2;
+    if (directory[mid].key == key) return mid;
+    if (directory[mid].key < key) low = mid + 1;
+    else high = mid - 1;
+  }
+  return -1;
+}
+
+static const RouteNodeRecord* nodeRecord(uint32_t node, TileView* view) {
+  int32_t tile = tileOfNode(node);
+  if (tile < 0 || !openTile(tile, view)) return nullptr;
+  return &view->nodes[node - view->entry->firstNode];
+}
+
+static void clearTileCache() {
+  for (uint8_t i = 0; i < slotCount; i++) {
+    slots[i].tile = -1;
+    slots[i].pinned = false;
+  }
+  memset(slotOfTile, SLOT_NONE, header.tileCount);
+}
+
+// Nearest node with edges in the 3x3 tiles around a position
+static bool snapToGraph(int32_t latE7, int32_t lonE7, uint32_t* node, bool* ioError) {
+  int32_t row = (int32_t)floorf((latE7 - header.originLatE7) / (float)header.tileE7);
+  int32_t col = (int32_t)floorf((lonE7 - header.originLonE7) / (float)header.tileE7);
+  float lonScale = metersPerE7Lon(latE7);
+  float best = ROUTE_SNAP_MAX_M;
+  bool found = false;
+  for (int32_t r = row - 1; r <= row + 1; r++) {
+    for (int32_t c = col - 1; c <= col + 1; c++) {
+      if (r < 0 || c < 0 || r >= header.tileRows || c >= header.tileCols) continue;
+      int32_t tile = tileOfKey(r * header.tileCols + c);
+      if (tile < 0) continue;
+      TileView view;
+      if (!openTile(tile, &view)) {
+        *ioError = true;
+        continue;
+      }
+      for (uint16_t i = 0; i < view.entry->nodeCount; i++) {
+        if (view.nodes[i].edgeCount == 0) continue;
+        float d = distanceM(latE7, lonE7, view.nodes[i].latE7, view.nodes[i].lonE7, lonScale);
+        if (d < best) {
+          best = d;
+          *node = view.entry->firstNode + i;
+          found = true;
+        }
+      }
+    }
+  }
+  return found;
+}
+
+// ============= Search Tables =============
+static int32_t findSlot(uint32_t node, bool insert) {
+  uint32_t i = (node * 2654435761u) >> (32 - ROUTE_TABLE_BITS);
+  for (;;) {
+    if (table[i].node == node) return i;
+    if (table[i].node == UINT32_MAX) {
+      if (!insert || tableCount >= ROUTE_MAX_NODES) return -1;
+      table[i].node = node;
+      table[i].closed = 0;
+      table[i].g = INFINITY;
+      tableCount++;
+      return i;
+    }
+    i = (i + 1) & (ROUTE_TABLE_SIZE - 1);
+  }
+}
+
+static void siftUp(uint16_t i) {
+  OpenEntry entry = openSet[i];
+  while (i > 0) {
+    uint16_t parent = (i - 1) / 2;
+    if (openSet[parent].f <= entry.f) break;
+    openSet[i] = openSet[parent];
+    i = parent;
+  }
+  openSet[i] = entry;
+}
+
+// Full open set: the worst leaf makes way (its node can be reached again)
+static void openPush(float f, float g, uint32_t slot, int32_t parent, RoutePlanStats* planStats) {
+  uint16_t i = openCount;
+  if (openCount == ROUTE_MAX_OPEN) {
+    i = ROUTE_MAX_OPEN / 2;
+    for (uint16_t j = i + 1; j < ROUTE_MAX_OPEN; j++) {
+      if (openSet[j].f > openSet[i].f) i = j;
+    }
+    planStats->openDropped++;
+    if (openSet[i].f <= f) {
+      if (table[slot].g == g) table[slot].g = INFINITY;
+      return;
+    }
+    SearchNode& dropped = table[openSet[i].slot];
+    if (!dropped.closed && dropped.g == openSet[i].g) dropped.g = INFINITY;
+  } else {
+    openCount++;
+  }
+  openSet[i] = {f, g, slot, parent};
+  siftUp(i);
+}
+
+static OpenEntry openPop() {
+  OpenEntry top = openSet[0];
+  OpenEntry last = openSet[--openCount];
+  uint16_t i = 0;
+  for (;;) {
+    uint16_t child = 2 * i + 1;
+    if (child >= openCount) break;
+    if (child + 1 < openCount && openSet[child + 1].f < openSet[child].f) child++;
+    if (last.f <= openSet[child].f) break;
+    openSet[i] = openSet[child];
+    i = child;
+  }
+  if (openCount > 0) openSet[i] = last;
+  return top;
+}
+
+// ============= Planning =============
+static float edgeCost(const RouteEdgeRecord& edge) {
+  float cost = edge.lengthDm * 0.1f;
+  if (edge.flags & EDGE_STEPS) cost *= ROUTE_STEPS_FACTOR;
+  else if (edge.flags & EDGE_ROAD) cost *= ROUTE_ROAD_FACTOR;
+  if (edge.flags & EDGE_CROSSING) cost += ROUTE_CROSSING_PENALTY_M;
+  return cost;
+}
+
+static void buildManeuvers(RoutePath* path, float lonScale) {
+  path->maneuverCount = 0;
+  const RoutePoint* p = path->points;
+  for (uint16_t i = 1; i + 1 < path->pointCount; i++) {
+    uint16_t back = i, ahead = i;
+    while (back > 0 && p[i].along - p[back].along < ROUTE_TURN_SPAN_M) back--;
+    while (ahead + 1 < path->pointCount && p[ahead].along - p[i].along < ROUTE_TURN_SPAN_M) ahead++;
+    float turn = bearingDeg(p[i], p[ahead], lonScale) - bearingDeg(p[back], p[i], lonScale);
+    if (turn > 180.0f) turn -= 360.0f;
+    if (turn <= -180.0f) turn += 360.0f;
+    if (fabsf(turn) < ROUTE_TURN_MIN_DEG || (p[i].degree < 3 && fabsf(turn) < ROUTE_TURN_SHARP_DEG)) continue;
+    RouteManeuver maneuver = {i, (uint8_t)(turn > 0 ? ROUTE_TURN_RIGHT : ROUTE_TURN_LEFT), 0, p[i].along, turn};
+    // One turn spread over several vertices (a rounded corner) is one maneuver
+    if (path->maneuverCount > 0) {
+      RouteManeuver& previous = path->maneuvers[path->maneuverCount - 1];
+      if (p[i].along - previous.along < ROUTE_TURN_SPAN_M && (previous.turnDeg > 0) == (turn > 0)) {
+        if (fabsf(turn) > fabsf(previous.turnDeg)) previous = maneuver;
+        continue;
+      }
+    }
+    if (path->maneuverCount < ROUTE_MAX_MANEUVERS - 1) path->maneuvers[path->maneuverCount++] = maneuver;
+  }
+  uint16_t last = path->pointCount - 1;
+  path->maneuvers[path->maneuverCount++] = {last, ROUTE_ARRIVE, 0, p[last].along, 0.0f};
+}
+
+enum PlanMode : uint8_t {
+  PLAN_HEURISTIC = 0x01,        // A*; without it Dijkstra, for the self-test
+  PLAN_TURN_COST = 0x02,        // Junction turn penalty (node-based, so not exact; off in the self-test)
+  PLAN_ROUTE = PLAN_HEURISTIC | PLAN_TURN_COST
+};
+
+// Caller holds planMutex. From the node nearest one position to the node
+// nearest another.
+static RouteError planRoute(int32_t fromLatE7, int32_t fromLonE7, int32_t toLatE7, int32_t toLonE7, uint8_t mode,
+                            RoutePath* out, RoutePlanStats* planStats) {
+  memset(planStats, 0, sizeof(*planStats));
+  planTileLoads = 0;
+  uint32_t start = millis();
+  uint32_t startNode = 0, goalNode = 0;
+  bool ioError = false;
+  if (!snapToGraph(fromLatE7, fromLonE7, &startNode, &ioError)) return ioError ? ROUTE_ERR_IO : ROUTE_ERR_NO_START;
+  if (!snapToGraph(toLatE7, toLonE7, &goalNode, &ioError)) return ioError ? ROUTE_ERR_IO : ROUTE_ERR_NO_GOAL;
+
+  TileView view;
+  const RouteNodeRecord* goal = nodeRecord(goalNode, &view);
+  if (!goal) return ROUTE_ERR_IO;
+  int32_t goalLat = goal->latE7, goalLon = goal->lonE7;
+  const RouteNodeRecord* first = nodeRecord(startNode, &view);
+  if (!first) return ROUTE_ERR_IO;
+  float lonScale = metersPerE7Lon((fromLatE7 + toLatE7) / 2);
+  float heuristicScale = (mode & PLAN_HEURISTIC) ? 0.99f : 0.0f;   // Stays below true distance (rounded lengths)
+  float direct = distanceM(first->latE7, first->lonE7, goalLat, goalLon, lonScale);
+  float limit = direct * ROUTE_DETOUR_FACTOR + 200.0f;
+
+  for (uint32_t i = 0; i < ROUTE_TABLE_SIZE; i++) table[i].node = UINT32_MAX;
+  tableCount = 0;
+  openCount = 0;
+  int32_t slot = findSlot(startNode, true);
+  table[slot] = {startNode, first->latE7, first->lonE7, 0.0f, -1, 0, first->edgeCount, 0};
+  openPush(direct * heuristicScale, 0.0f, slot, -1, planStats);
+
+  RouteError result = ROUTE_ERR_UNREACHABLE;
+  int32_t goalSlot = -1;
+  while (openCount > 0) {
+    OpenEntry entry = openPop();
+    SearchNode& current = table[entry.slot];
+    if (current.closed || entry.g > current.g) continue;
+    current.g = entry.g;
+    current.parent = entry.parent;
+    current.closed = 1;
+    planStats->expanded++;
+    if (current.node == goalNode) {
+      goalSlot = entry.slot;
+      break;
+    }
+    const RouteNodeRecord* record = nodeRecord(current.node, &view);
+    if (!record) {
+      result = ROUTE_ERR_IO;
+      break;
+    }
+    slots[view.slot].pinned = true;
+    const RouteEdgeRecord* edges = view.edges + record->firstEdge;
+    float inN = 0, inE = 0;
+    bool junction = (mode & PLAN_TURN_COST) && current.parent >= 0 && current.degree >= 3;
+    if (junction) {
+      inN = (current.latE7 - table[current.parent].latE7) * METERS_PER_E7_LAT;
+      inE = (current.lonE7 - table[current.parent].lonE7) * lonScale;
+    }
+    for (uint8_t e = 0; e < record->edgeCount; e++) {
+      const RouteEdgeRecord& edge = edges[e];
+      float g = current.g + edgeCost(edge);
+      int32_t next = findSlot(edge.target, false);
+      if (next >= 0 && (table[next].closed || g >= table[next].g)) continue;
+      int32_t latE7, lonE7;
+      uint8_t degree;
+      if (next >= 0) {
+        latE7 = table[next].latE7;
+        lonE7 = table[next].lonE7;
+        degree = table[next].degree;
+      } else {
+        TileView targetView;
+        const RouteNodeRecord* target = nodeRecord(edge.target, &targetView);
+        if (!target) {
+          result = ROUTE_ERR_IO;
+          break;
+        }
+        latE7 = target->latE7;
+        lonE7 = target->lonE7;
+        degree = target->edgeCount;
+      }
+      if (junction) {
+        float outN = (latE7 - current.latE7) * METERS_PER_E7_LAT, outE = (lonE7 - current.lonE7) * lonScale;
+        float dot = inN * outN + inE * outE;
+        if (dot < ROUTE_TURN_COS * sqrtf((inN * inN + inE * inE) * (outN * outN + outE * outE))) {
+          g += ROUTE_TURN_PENALTY_M;
+          if (next >= 0 && g >= table[next].g) continue;
+        }
+      }
+      float h = distanceM(latE7, lonE7, goalLat, goalLon, lonScale);
+      if (g + h > limit) {
+        planStats->pruned++;
+        continue;
+      }
+      if (next < 0) {
+        next = findSlot(edge.target, true);
+        if (next < 0) {
+          result = ROUTE_ERR_SEARCH_LIMIT;
+          break;
+        }
+        table[next].latE7 = latE7;
+        table[next].lonE7 = lonE7;
+        table[next].degree = degree;
+      }
+      table[next].g = g;
+      openPush(g + h * heuristicScale, g, next, entry.slot, planStats);
+    }
+    slots[view.slot].pinned = false;
+    if (result == ROUTE_ERR_IO || result == ROUTE_ERR_SEARCH_LIMIT) break;
+  }
+  planStats->reached = tableCount;
+  planStats->tileLoads = planTileLoads;
+  if (goalSlot < 0) {
+    planStats->error = result;
+    planStats->millis = millis() - start;
+    return result;
+  }
+
+  uint32_t count = 0;
+  for (int32_t s = goalSlot; s >= 0; s = table[s].parent) count++;
+  if (count > ROUTE_MAX_POINTS) {
+    planStats->error = ROUTE_ERR_TOO_LONG;
+    planStats->millis = millis() - start;
+    return ROUTE_ERR_TOO_LONG;
+  }
+  out->pointCount = count;
+  for (int32_t s = goalSlot; s >= 0; s = table[s].parent) {
+    RoutePoint& point = out->points[--count];
+    point.latE7 = table[s].latE7;
+    point.lonE7 = table[s].lonE7;
+    point.degree = table[s].degree;
+  }
+  out->points[0].along = 0;
+  for (uint16_t i = 1; i < out->pointCount; i++) {
+    const RoutePoint& a = out->points[i - 1];
+    RoutePoint& b = out->points[i];
+    b.along = a.along + distanceM(a.latE7, a.lonE7, b.latE7, b.lonE7, lonScale);
+  }
+  out->lengthM = out->points[out->pointCount - 1].along;
+  out->destLatE7 = toLatE7;
+  out->destLonE7 = toLonE7;
+  buildManeuvers(out, lonScale);
+
+  planStats->costM = table[goalSlot].g;
+  planStats->lengthM = out->lengthM;
+  planStats->points = out->pointCount;
+  planStats->maneuvers = out->maneuverCount;
+  planStats->millis = millis() - start;
+  return ROUTE_OK;
+}
+
+// ============= Planner Task =============
+static void plannerTask(void* parameter) {
+  RouteRequest request;
+  for (;;) {
+    if (xQueueReceive(requestMailbox, &request, portMAX_DELAY) != pdTRUE) continue;
+    xSemaphoreTake(planMutex, portMAX_DELAY);
+    RoutePath* staging = &paths[activeIndex ^ 1];
+    RoutePlanStats planStats;
+    RouteError error = planRoute(request.fromLatE7, request.fromLonE7, request.toLatE7, request.toLonE7, PLAN_ROUTE,
+                                 staging, &planStats);
+    planStats.error = error;
+    stats.last = planStats;
+    stats.plans++;
+    if (request.replan) stats.replans++;
+    if (error != ROUTE_OK) stats.failures++;
+    xSemaphoreTake(stateMutex, portMAX_DELAY);
+    if (request.generation != generation) {
+      // Cancelled or superseded while planning
+    } else if (error == ROUTE_OK) {
+      memcpy(staging->name, request.name, sizeof(staging->name));
+      activeIndex ^= 1;
+      routeActive = true;
+      trackSegment = 0;
+      nextManeuver = 0;
+      offRouteFixes = 0;
+      remainingM = staging->lengthM;
+      offRouteM = 0;
+      pushEvent(ROUTE_EVENT_PLANNED, (RouteManeuverType)staging->maneuvers[0].type, ROUTE_OK, staging->lengthM,
+                staging->maneuvers[0].along);
+    } else {
+      pushEvent(ROUTE_EVENT_FAILED, ROUTE_ARRIVE, error, 0, 0);
+    }
+    xSemaphoreGive(stateMutex);
+    xSemaphoreGive(planMutex);
+  }
+}
+
+// ============= Public API =============
+static bool loadGraph() {
+  graphFile = SD.open(ROUTE_GRAPH_PATH, FILE_READ);
+  if (!graphFile) return false;
+  if (graphFile.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+      header.magic != ROUTE_MAGIC || header.version != ROUTE_VERSION ||
+      header.headerCrc != SDCard_crc32((const uint8_t*)&header, offsetof(RouteFileHeader, headerCrc)) ||
+      header.tileCount == 0 || header.tileE7 == 0) {
+    Serial.println("❌ Route graph: bad header");
+    return false;
+  }
+  slotBytes = (header.maxTileBytes + 3) & ~3u;
+  slotCount = min<uint32_t>(ROUTE_TILE_BUDGET / max<uint32_t>(slotBytes, 1), ROUTE_MAX_TILE_SLOTS);
+  if (slotCount < ROUTE_MIN_TILE_SLOTS) {
+    Serial.printf("❌ Route graph: tiles up to %lu bytes exceed the cache budget; rebuild with a smaller --tile\n",
+                  (unsigned long)header.maxTileBytes);
+    return false;
+  }
+  size_t directoryBytes = header.tileCount * sizeof(RouteTileEntry);
+  directory = (RouteTileEntry*)ps_malloc(directoryBytes);
+  tileBuffers = (uint8_t*)ps_malloc(slotBytes * slotCount);
+  slotOfTile = (uint8_t*)ps_malloc(header.tileCount);
+  table = (SearchNode*)ps_malloc(ROUTE_TABLE_SIZE * sizeof(SearchNode));
+  openSet = (OpenEntry*)ps_malloc(ROUTE_MAX_OPEN * sizeof(OpenEntry));
+  paths[0].points = (RoutePoint*)ps_malloc(ROUTE_MAX_POINTS * sizeof(RoutePoint));
+  paths[1].points = (RoutePoint*)ps_malloc(ROUTE_MAX_POINTS * sizeof(RoutePoint));
+  if (!directory || !tileBuffers || !slotOfTile || !table || !openSet || !paths[0].points || !paths[1].points) {
+    Serial.println("❌ Route graph: out of PSRAM");
+    return false;
+  }
+  if (!graphFile.seek(header.directoryOffset) || graphFile.read((uint8_t*)directory, directoryBytes) != directoryBytes ||
+      SDCard_crc32((const uint8_t*)directory, directoryBytes) != header.directoryCrc) {
+    Serial.println("❌ Route graph: tile directory corrupt");
+    return false;
+  }
+  return true;
+}
+
+static void releaseGraph() {
+  graphFile.close();
+  free(directory);
+  free(tileBuffers);
+  free(slotOfTile);
+  free(table);
+  free(openSet);
+  free(paths[0].points);
+  free(paths[1].points);
+  directory = nullptr;
+  tileBuffers = nullptr;
+  slotOfTile = nullptr;
+  table = nullptr;
+  openSet = nullptr;
+  paths[0].points = paths[1].points = nullptr;
+}
+
+bool Route_begin() {
+  if (graphLoaded) return true;
+  if (!SDCard_fileExists(ROUTE_GRAPH_PATH)) {
+    Serial.println("🧭 No route graph on SD card (" ROUTE_GRAPH_PATH ")");
+    return false;
+  }
+  if (!psramFound()) {
+    Serial.println("❌ Routing needs PSRAM");
+    return false;
+  }
+  if (!loadGraph()) {
+    releaseGraph();
+    return false;
+  }
+  clearTileCache();
+  planMutex = xSemaphoreCreateMutex();
+  stateMutex = xSemaphoreCreateMutex();
+  requestMailbox = xQueueCreate(1, sizeof(RouteRequest));
+  eventQueue = xQueueCreate(ROUTE_EVENT_QUEUE, sizeof(RouteEvent));
+  if (!planMutex || !stateMutex || !requestMailbox || !eventQueue) {
+    releaseGraph();
+    return false;
+  }
+  xTaskCreatePinnedToCore(plannerTask, "RoutePlanner", ROUTE_TASK_STACK_SIZE, nullptr, ROUTE_TASK_PRIORITY,
+                          &plannerHandle, ROUTE_TASK_CORE);
+  graphLoaded = true;
+  stats.graphLoaded = true;
+  stats.tiles = header.tileCount;
+  stats.nodes = header.nodeCount;
+  stats.edges = header.edgeCount / 2;
+  stats.tileBytes = slotBytes * slotCount;
+  stats.searchBytes = ROUTE_TABLE_SIZE * sizeof(SearchNode) + ROUTE_MAX_OPEN * sizeof(OpenEntry) +
+                      2 * ROUTE_MAX_POINTS * sizeof(RoutePoint);
+  Serial.printf("🧭 Route graph: %lu nodes, %lu edges in %lu tiles; %lu KB tile cache, %lu KB search tables\n",
+                (unsigned long)stats.nodes, (unsigned long)stats.edges, (unsigned long)stats.tiles,
+                (unsigned long)(stats.tileBytes / 1024), (unsigned long)(stats.searchBytes / 1024));
+  return true;
+}
+
+bool Route_isAvailable() {
+  return graphLoaded;
+}
+
+static void queueRequest(int32_t fromLatE7, int32_t fromLonE7, int32_t toLatE7, int32_t toLonE7, const char* name,
+                         bool replan) {
+  RouteRequest request = {fromLatE7, fromLonE7, toLatE7, toLonE7, generation, replan, ""};
+  strncpy(request.name, name ? name : "", sizeof(request.name) - 1);
+  xQueueOverwrite(requestMailbox, &request);
+}
+
+RouteError Route_request(double fromLat, double fromLon, double toLat, double toLon, const char* name) {
+  if (!graphLoaded) return ROUTE_ERR_NO_GRAPH;
+  xSemaphoreTake(stateMutex, portMAX_DELAY);
+  generation++;
+  xSemaphoreGive(stateMutex);
+  queueRequest((int32_t)lround(fromLat * 1e7), (int32_t)lround(fromLon * 1e7), (int32_t)lround(toLat * 1e7),
+               (int32_t)lround(toLon * 1e7), name, false);
+  return ROUTE_OK;
+}
+
+void Route_cancel() {
+  if (!graphLoaded) return;
+  xSemaphoreTake(stateMutex, portMAX_DELAY);
+  generation++;
+  routeActive = false;
+  xSemaphoreGive(stateMutex);
+}
+
+bool Route_isActive() {
+  return routeActive;
+}
+
+// Nearest point on the path, searched from the current segment forward
+void Route_update(double lat, double lon) {
+  if (!graphLoaded || !routeActive) return;
+  xSemaphoreTake(stateMutex, portMAX_DELAY);
+  const RoutePath& path = paths[activeIndex];
+  if (path.pointCount < 2) {     // Start and destination snapped to the same node
+    routeActive = false;
+    pushEvent(ROUTE_EVENT_ARRIVED, ROUTE_ARRIVE, ROUTE_OK, 0, 0);
+    xSemaphoreGive(stateMutex);
+    return;
+  }
+  int32_t latE7 = (int32_t)lround(lat * 1e7);
+  int32_t lonE7 = (int32_t)lround(lon * 1e7);
+  float lonScale = metersPerE7Lon(latE7);
+  float bestDistance = INFINITY, bestAlong = 0;
+  uint16_t bestSegment = trackSegment;
+  uint16_t from = trackSegment > 2 ? trackSegment - 2 : 0;
+  uint16_t to = min<uint32_t>(trackSegment + ROUTE_TRACK_WINDOW, path.pointCount - 1);
+  for (uint16_t s = from; s < to; s++) {
+    const RoutePoint& a = path.points[s];
+    const RoutePoint& b = path.points[s + 1];
+    float segmentN = (b.latE7 - a.latE7) * METERS_PER_E7_LAT, segmentE = (b.lonE7 - a.lonE7) * lonScale;
+    float pointN = (latE7 - a.latE7) * METERS_PER_E7_LAT, pointE = (lonE7 - a.lonE7) * lonScale;
+    float length2 = segmentN * segmentN + segmentE * segmentE;
+    float t = length2 > 0 ? constrain((pointN * segmentN + pointE * segmentE) / length2, 0.0f, 1.0f) : 0.0f;
+    float dN = pointN - t * segmentN, dE = pointE - t * segmentE;
+    float d = sqrtf(dN * dN + dE * dE);
+    if (d < bestDistance) {
+      bestDistance = d;
+      bestSegment = s;
+      bestAlong = a.along + t * (b.along - a.along);
+    }
+  }
+  offRouteM = bestDistance;
+  if (bestDistance > ROUTE_OFF_ROUTE_M) {
+    if (++offRouteFixes >= ROUTE_OFF_ROUTE_FIXES && millis() - lastReplanMs > ROUTE_REPLAN_MS) {
+      lastReplanMs = millis();
+      offRouteFixes = 0;
+      pushEvent(ROUTE_EVENT_OFF_ROUTE, ROUTE_ARRIVE, ROUTE_OK, remainingM, bestDistance);
+      queueRequest(latE7, lonE7, path.destLatE7, path.destLonE7, path.name, true);
+    }
+    xSemaphoreGive(stateMutex);
+    return;
+  }
+  offRouteFixes = 0;
+  trackSegment = bestSegment;
+  remainingM = path.lengthM - bestAlong;
+  if (remainingM <= ROUTE_ARRIVE_M) {
+    routeActive = false;
+    pushEvent(ROUTE_EVENT_ARRIVED, ROUTE_ARRIVE, ROUTE_OK, 0, 0);
+    xSemaphoreGive(stateMutex);
+    return;
+  }
+  // Turns passed without a fix close enough are skipped, not announced late
+  while (nextManeuver < path.maneuverCount && path.maneuvers[nextManeuver].along < bestAlong - ROUTE_TURN_NOW_M) {
+    nextManeuver++;
+  }
+  if (nextManeuver < path.maneuverCount) {
+    RouteManeuver& maneuver = paths[activeIndex].maneuvers[nextManeuver];
+    float ahead = maneuver.along - bestAlong;
+    RouteManeuverType type = (RouteManeuverType)maneuver.type;
+    if (type != ROUTE_ARRIVE && maneuver.stage == 0 && ahead <= ROUTE_PREPARE_M && ahead > ROUTE_TURN_NOW_M + 5) {
+      maneuver.stage = 1;
+      pushEvent(ROUTE_EVENT_PREPARE, type, ROUTE_OK, remainingM, ahead);
+    }
+    if (type != ROUTE_ARRIVE && ahead <= ROUTE_TURN_NOW_M) {
+      maneuver.stage = 2;
+      nextManeuver++;
+      float next = nextManeuver < path.maneuverCount ? path.maneuvers[nextManeuver].along - bestAlong : 0;
+      pushEvent(ROUTE_EVENT_TURN, type, ROUTE_OK, remainingM, next);
+    }
+  }
+  xSemaphoreGive(stateMutex);
+}
+
+bool Route_takeEvent(RouteEvent* event) {
+  return eventQueue && xQueueReceive(eventQueue, event, 0) == pdTRUE;
+}
+
+RouteStats Route_getStats() {
+  return stats;
+}
+
+static const char* maneuverName(uint8_t type) {
+  switch (type) {
+    case ROUTE_TURN_LEFT: return "Turn left";
+    case ROUTE_TURN_RIGHT: return "Turn right";
+    default: return "Arrive";
+  }
+}
+
+void Route_printStatus() {
+  Serial.println("\n🧭 Route Engine:");
+  if (!graphLoaded) {
+    Serial.println("   No graph (build with hardware/tools/build_route_graph.py, copy to " ROUTE_GRAPH_PATH ")");
+    return;
+  }
+  Serial.printf("   Graph: %lu nodes, %lu edges, %lu tiles of %.4f°\n", (unsigned long)stats.nodes,
+                (unsigned long)stats.edges, (unsigned long)stats.tiles, header.tileE7 * 1e-7);
+  Serial.printf("   RAM: %lu KB tile cache (%u slots), %lu KB search tables\n", (unsigned long)(stats.tileBytes / 1024),
+                slotCount, (unsigned long)(stats.searchBytes / 1024));
+  uint32_t lookups = stats.tileHits + stats.tileLoads;
+  Serial.printf("   Tiles: %lu loads, %.0f%% hit, %lu CRC errors\n", (unsigned long)stats.tileLoads,
+                lookups ? 100.0f * stats.tileHits / lookups : 0.0f, (unsigned long)stats.crcErrors);
+  Serial.printf("   Plans: %lu (%lu failed, %lu re-plans)\n", (unsigned long)stats.plans, (unsigned long)stats.failures,
+                (unsigned long)stats.replans);
+  if (stats.plans > 0) {
+    const RoutePlanStats& last = stats.last;
+    Serial.printf("   Last plan: %s, %.0f m, %lu ms, %lu expanded, %u tile loads\n", Route_errorName(last.error),
+                  last.lengthM, (unsigned long)last.millis, (unsigned long)last.expanded, last.tileLoads);
+  }
+  xSemaphoreTake(stateMutex, portMAX_DELAY);
+  if (routeActive) {
+    const RoutePath& path = paths[activeIndex];
+    Serial.printf("   Active: to %s, %.0f m left, %.0f m off the path\n", path.name[0] ? path.name : "destination",
+                  remainingM, offRouteM);
+  } else {
+    Serial.println("   Active: none");
+  }
+  xSemaphoreGive(stateMutex);
+}
+
+void Route_printDirections() {
+  if (!graphLoaded || !routeActive) {
+    Serial.println("🧭 No active route");
+    return;
+  }
+  xSemaphoreTake(stateMutex, portMAX_DELAY);
+  const RoutePath& path = paths[activeIndex];
+  Serial.printf("🧭 %s: %.0f m, %u points\n", path.name[0] ? path.name : "Route", path.lengthM, path.pointCount);
+  float previous = 0;
+  for (uint16_t i = 0; i < path.maneuverCount; i++) {
+    const RouteManeuver& maneuver = path.maneuvers[i];
+    Serial.printf("   %c %4.0f m  %-10s (%+.0f°)\n", i < nextManeuver ? ' ' : '>', maneuver.along - previous,
+                  maneuverName(maneuver.type), maneuver.turnDeg);
+    previous = maneuver.along;
+  }
+  xSemaphoreGive(stateMutex);
+}
+
+// ============= Benchmark =============
+// Golden: A* cost equals Dijkstra cost on short pairs. Then ~2 km plans
+// between random nodes with the tile cache emptied first, so each pays
+// its SD reads.
+static uint32_t benchSeed;
+static uint32_t benchRandom() {
+  benchSeed = benchSeed * 1664525UL + 1013904223UL;
+  return benchSeed >> 16;
+}
+
+static bool randomNode(int32_t* latE7, int32_t* lonE7) {
+  int32_t tile = benchRandom() % header.tileCount;
+  TileView view;
+  if (!openTile(tile, &view) || view.entry->nodeCount == 0) return false;
+  uint16_t i = benchRandom() % view.entry->nodeCount;
+  if (view.nodes[i].edgeCount == 0) return false;
+  *latE7 = view.nodes[i].latE7;
+  *lonE7 = view.nodes[i].lonE7;
+  return true;
+}
+
+static bool randomPair(float minM, float maxM, int32_t* pair) {
+  for (uint8_t attempt = 0; attempt < 200; attempt++) {
+    if (!randomNode(&pair[0], &pair[1]) || !randomNode(&pair[2], &pair[3])) continue;
+    float d = distanceM(pair[0], pair[1], pair[2], pair[3], metersPerE7Lon(pair[0]));
+    if (d >= minM && d <= maxM) return true;
+  }
+  return false;
+}
+
+void Route_runBenchmark() {
+  static const uint8_t GOLDEN_PAIRS = 4;
+  static const uint8_t TIMED_PAIRS = 10;
+  Serial.println("\n⏱️ Route Engine Benchmark:");
+  Serial.println("================================");
+  if (!graphLoaded) {
+    Serial.println("❌ No route graph loaded");
+    return;
+  }
+  xSemaphoreTake(planMutex, portMAX_DELAY);
+  RoutePath* scratch = &paths[activeIndex ^ 1];   // The planner only writes it under planMutex
+  RoutePlanStats astar, dijkstra;
+  benchSeed = 0x2044;
+  uint8_t goldenRun = 0, mismatches = 0;
+  uint32_t astarExpanded = 0, dijkstraExpanded = 0;
+  int32_t pair[4];
+  for (uint8_t i = 0; i < GOLDEN_PAIRS; i++) {
+    if (!randomPair(300, 800, pair)) continue;
+    RouteError a = planRoute(pair[0], pair[1], pair[2], pair[3], PLAN_HEURISTIC, scratch, &astar);
+    RouteError d = planRoute(pair[0], pair[1], pair[2], pair[3], 0, scratch, &dijkstra);
+    goldenRun++;
+    if (a != d || (a == ROUTE_OK && fabsf(astar.costM - dijkstra.costM) > 0.001f * dijkstra.costM + 0.5f)) {
+      mismatches++;
+      Serial.printf("   Pair %u: A* %s %.1f m vs Dijkstra %s %.1f m\n", i, Route_errorName(a), astar.costM,
+                    Route_errorName(d), dijkstra.costM);
+    }
+    astarExpanded += astar.expanded;
+    dijkstraExpanded += dijkstra.expanded;
+  }
+  Serial.printf("A* vs Dijkstra: %s (%u mismatches over %u pairs; %lu vs %lu nodes expanded)\n",
+                mismatches == 0 && goldenRun > 0 ? "✅ PASS" : "❌ FAIL", mismatches, goldenRun,
+                (unsigned long)astarExpanded, (unsigned long)dijkstraExpanded);
+
+  uint32_t totalMs = 0, maxMs = 0, maxExpanded = 0, maxDropped = 0;
+  uint16_t maxLoads = 0;
+  uint8_t planned = 0, failed = 0;
+  float totalLength = 0;
+  for (uint8_t i = 0; i < TIMED_PAIRS; i++) {
+    if (!randomPair(1500, 2500, pair)) continue;
+    clearTileCache();
+    RouteError error = planRoute(pair[0], pair[1], pair[2], pair[3], PLAN_ROUTE, scratch, &astar);
+    if (error != ROUTE_OK) {
+      failed++;
+      Serial.printf("   Pair %u: %s\n", i, Route_errorName(error));
+      continue;
+    }
+    planned++;
+    totalMs += astar.millis;
+    totalLength += astar.lengthM;
+    maxMs = max(maxMs, astar.millis);
+    maxExpanded = max(maxExpanded, astar.expanded);
+    maxDropped = max(maxDropped, astar.openDropped);
+    maxLoads = max(maxLoads, astar.tileLoads);
+  }
+  xSemaphoreGive(planMutex);
+  if (planned == 0) {
+    Serial.println("❌ No 1.5-2.5 km routes found in this graph");
+  } else {
+    Serial.printf("~2 km plans (cold cache): %u ok, %u failed, %.0f m avg\n", planned, failed, totalLength / planned);
+    Serial.printf("Time: %lu ms avg, %lu ms max (budget %u ms) %s\n", (unsigned long)(totalMs / planned),
+                  (unsigned long)maxMs, ROUTE_PLAN_BUDGET_MS, maxMs <= ROUTE_PLAN_BUDGET_MS ? "✅ PASS" : "❌ FAIL");
+    Serial.printf("Max per plan: %lu nodes expanded (limit %u), %u tile loads, %lu open-set drops\n",
+                  (unsigned long)maxExpanded, ROUTE_MAX_NODES, maxLoads, (unsigned long)maxDropped);
+  }
+  Serial.printf("Fixed RAM: %lu KB tiles + %lu KB search tables\n", (unsigned long)(stats.tileBytes / 1024),
+                (unsigned long)(stats.searchBytes / 1024));
+  Serial.println("================================");
+}
@@ -0,0 +1,109 @@
+#pragma once
+#ifndef ROUTEENGINE_H
+#define ROUTEENGINE_H
+
+#include <Arduino.h>
+
+// Offline pedestrian routing over /route/graph.bin, built on a PC by
+// hardware/tools/build_route_graph.py. The walkable graph is cut into square
+// lat/lon tiles; only the tile directory stays in RAM and tiles are read on
+// demand into a small LRU cache. A* runs on a planner task with fixed search
+// tables (node table plus a bounded open set), so a plan never allocates and
+// never needs more than ROUTE_MAX_NODES nodes. The loop tracks the fix
+// along the planned path and queues turn-by-turn events.
+#define ROUTE_GRAPH_PATH "/route/graph.bin"
+#define ROUTE_TILE_BUDGET 786432        // Tile cache bytes (PSRAM); each slot fits the largest tile
+#define ROUTE_MAX_TILE_SLOTS 64
+#define ROUTE_MIN_TILE_SLOTS 8          // Fewer (tiles too big): rebuild the graph with a smaller --tile
+#define ROUTE_MAX_NODES 12288           // Nodes reached per plan (table is 4/3 of this)
+#define ROUTE_MAX_OPEN 4096             // Open set; the worst entry is dropped when full
+#define ROUTE_MAX_POINTS 2048           // Vertices in a planned path
+#define ROUTE_MAX_MANEUVERS 128
+#define ROUTE_SNAP_MAX_M 60             // Start/goal to nearest graph node
+#define ROUTE_DETOUR_FACTOR 2.0f        // Nodes beyond this x straight distance (+200 m) are pruned
+#define ROUTE_OFF_ROUTE_M 20            // Off the path for 3 fixes: re-plan
+#define ROUTE_PREPARE_M 30              // "Turn left, 30 meters"
+#define ROUTE_TURN_NOW_M 8
+#define ROUTE_ARRIVE_M 8
+
+enum RouteError : uint8_t {
+  ROUTE_OK = 0,
+  ROUTE_ERR_NO_GRAPH,
+  ROUTE_ERR_NO_START,           // No graph node near the start
+  ROUTE_ERR_NO_GOAL,
+  ROUTE_ERR_UNREACHABLE,
+  ROUTE_ERR_SEARCH_LIMIT,       // Node table full
+  ROUTE_ERR_TOO_LONG,           // More than ROUTE_MAX_POINTS vertices
+  ROUTE_ERR_IO                  // Tile read or CRC failure
+};
+
+enum RouteManeuverType : uint8_t {
+  ROUTE_TURN_LEFT = 1,
+  ROUTE_TURN_RIGHT,
+  ROUTE_ARRIVE
+};
+
+enum RouteEventType : uint8_t {
+  ROUTE_EVENT_PLANNED = 1,      // distanceM = route length, nextDistanceM = to the first maneuver
+  ROUTE_EVENT_FAILED,           // error set
+  ROUTE_EVENT_PREPARE,          // Maneuver coming up in nextDistanceM
+  ROUTE_EVENT_TURN,             // Maneuver now
+  ROUTE_EVENT_OFF_ROUTE,        // Re-planning from the current position
+  ROUTE_EVENT_ARRIVED
+};
+
+struct RouteEvent {
+  RouteEventType type;
+  RouteManeuverType maneuver;
+  RouteError error;
+  float distanceM;              // Remaining route length
+  float nextDistanceM;          // To the maneuver
+};
+
+struct RoutePlanStats {
+  RouteError error;
+  uint32_t expanded;            // Nodes closed
+  uint32_t reached;             // Nodes in the table
+  uint32_t openDropped;         // Open set overflow
+  uint32_t pruned;              // Outside the detour ellipse
+  uint16_t tileLoads;
+  uint16_t points;
+  uint16_t maneuvers;
+  float lengthM;
+  float costM;                  // Length plus crossing/steps penalties
+  uint32_t millis;
+};
+
+struct RouteStats {
+  bool graphLoaded;
+  uint32_t tiles;
+  uint32_t nodes;
+  uint32_t edges;
+  uint32_t tileBytes;           // Cache budget in use
+  uint32_t searchBytes;         // Node table + open set + path buffers
+  uint32_t plans;
+  uint32_t failures;
+  uint32_t replans;
+  uint32_t tileLoads;
+  uint32_t tileHits;
+  uint32_t crcErrors;
+  uint32_t eventsDropped;
+  RoutePlanStats last;
+};
+
+bool Route_begin();                 // Open the graph, allocate tables, start the planner task
+bool Route_isAvailable();
+// Queue a plan from a position to a destination (replaces one not yet started);
+// the result arrives as an event
+RouteError Route_request(double fromLat, double fromLon, double toLat, double toLon, const char* name);
+void Route_cancel();
+bool Route_isActive();              // A planned route is being followed
+void Route_update(double lat, double lon);   // Per fix, on the loop task
+bool Route_takeEvent(RouteEvent* event);     // Oldest pending event, false when none
+const char* Route_errorName(RouteError error);
+RouteStats Route_getStats();
+void Route_printStatus();
+void Route_printDirections();       // Maneuvers of the active route
+void Route_runBenchmark();          // A* vs Dijkstra, then ~2 km plans from a cold cache
+
+#endif // ROUTEENGINE_H
@@ -177,6 +177,34 @@ bool SDCard_fileExists(const char* path) {
   return SD.exists(path);
 }
 
+bool SDCard_appendFile(const char* path, const uint8_t* data, size_t len) {
+  File file = SD.open(path, FILE_APPEND);
+  if (!file) {
+    Serial.printf("❌ Failed to open file for appending: %s\n", path);
+    return false;
+  }
+  
+  size_t written = file.write(data, len);
+  file.close();
+  
+  if (written != len) {
+    Serial.printf("❌ Append failed: %s (wrote %d of %d bytes)\n", path, written, len);
+    return false;
+  }
+  return true;
+}
+
+uint32_t SDCard_crc32(const uint8_t* data, size_t len, uint32_t crc) {
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
 bool SDCard_saveJSON(const char* path, JsonDocument& doc) {
   File file = SD.open(path, FILE_WRITE);
   if (!file) {
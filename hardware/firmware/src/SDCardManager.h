@@ -20,6 +20,11 @@ bool SDCard_readFile(const char* path, uint8_t* data, size_t maxLen, size_t* byt
 bool SDCard_deleteFile(const char* path);
 bool SDCard_fileExists(const char* path);
 
+// Append-only binary records (journals, logs); quiet on success
+bool SDCard_appendFile(const char* path, const uint8_t* data, size_t len);
+// CRC-32 (IEEE 802.3, reflected) for integrity-checked records; chain with crc
+uint32_t SDCard_crc32(const uint8_t* data, size_t len, uint32_t crc = 0);
+
 // JSON configuration helpers
 bool SDCard_saveJSON(const char* path, JsonDocument& doc);
 bool SDCard_loadJSON(const char* path, JsonDocument& doc);
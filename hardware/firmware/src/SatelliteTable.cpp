@@ -0,0 +1,366 @@
+#include "SatelliteTable.h"
+#include <stdlib.h>
+
+// ============= Tokenizer =============
+uint8_t Nmea_tokenize(char* sentence, size_t len, char* fields[], uint8_t maxFields) {
+  if (maxFields == 0 || len == 0) return 0;
+  uint8_t count = 0;
+  fields[count++] = sentence;
+  for (size_t i = 0; i < len; i++) {
+    char c = sentence[i];
+    if (c == '*' || c == '\0' || c == '\r' || c == '\n') {
+      sentence[i] = '\0';
+      return count;
+    }
+    if (c == ',') {
+      sentence[i] = '\0';
+      if (count >= maxFields) return count;  // Extra fields are ignored
+      fields[count++] = sentence + i + 1;
+    }
+  }
+  sentence[len] = '\0';
+  return count;
+}
+
+int32_t Nmea_parseInt(const char* field, int32_t fallback) {
+  if (!field) return fallback;
+  bool negative = (*field == '-');
+  if (negative) field++;
+  if (*field < '0' || *field > '9') return fallback;
+  int32_t value = 0;
+  for (uint8_t digits = 0; *field >= '0' && *field <= '9' && digits < 9; digits++) {
+    value = value * 10 + (*field++ - '0');
+  }
+  return negative ? -value : value;
+}
+
+static float parseFloatField(const char* field, float fallback) {
+  if (!field || *field == '\0') return fallback;
+  char* end;
+  float value = strtof(field, &end);
+  return end == field ? fallback : value;
+}
+
+// ============= Systems =============
+static const char* SYSTEM_NAMES[GNSS_COUNT] = {"GPS", "GLO", "GAL", "BDS"};
+
+const char* SatTable_systemName(uint8_t system) {
+  return system < GNSS_COUNT ? SYSTEM_NAMES[system] : "UNK";
+}
+
+// Talker ID of "$xxGSV"; GNSS_COUNT for GN (mixed) or anything unknown
+static uint8_t systemFromTalker(const char* tag) {
+  if (tag[1] == 'G' && tag[2] == 'P') return GNSS_GPS;
+  if (tag[1] == 'G' && tag[2] == 'L') return GNSS_GLONASS;
+  if (tag[1] == 'G' && tag[2] == 'A') return GNSS_GALILEO;
+  if ((tag[1] == 'G' && tag[2] == 'B') || (tag[1] == 'B' && tag[2] == 'D')) return GNSS_BEIDOU;
+  return GNSS_COUNT;
+}
+
+// Legacy NMEA numbering for mixed sentences: SBAS and QZSS count as GPS
+static uint8_t systemFromPrn(int32_t prn) {
+  if (prn >= 1 && prn <= 64) return GNSS_GPS;
+  if (prn >= 65 && prn <= 96) return GNSS_GLONASS;
+  if (prn >= 193 && prn <= 200) return GNSS_GPS;
+  if (prn >= 201 && prn <= 237) return GNSS_BEIDOU;
+  return GNSS_COUNT;
+}
+
+// ============= Table =============
+void SatTable_reset(SatelliteTable& table) {
+  memset(&table, 0, sizeof(table));
+  table.view.fixType = 1;
+  table.view.pdop = table.view.hdop = table.view.vdop = 99.9f;
+}
+
+static bool isUsed(const SatelliteTable& table, uint8_t system, uint8_t prn) {
+  for (uint8_t i = 0; i < table.usedCount[system]; i++) {
+    if (table.usedPrns[system][i] == prn) return true;
+  }
+  return false;
+}
+
+// Active flags from the latest GSA, then SNR statistics, for one system
+static void refreshSystem(SatelliteTable& table, uint8_t system) {
+  SatelliteView& view = table.view;
+  GnssSnrStats& stats = view.stats[system];
+  uint32_t snrSum = 0;
+  stats.tracked = 0;
+  stats.used = 0;
+  stats.minSnr = 0;
+  stats.maxSnr = 0;
+  for (uint8_t i = 0; i < view.count[system]; i++) {
+    Satellite& sat = view.sats[system][i];
+    sat.active = isUsed(table, system, sat.prn);
+    if (sat.active) stats.used++;
+    if (sat.snr == 0) continue;
+    if (stats.tracked == 0 || sat.snr < stats.minSnr) stats.minSnr = sat.snr;
+    if (sat.snr > stats.maxSnr) stats.maxSnr = sat.snr;
+    snrSum += sat.snr;
+    stats.tracked++;
+  }
+  stats.meanSnr = stats.tracked ? (float)snrSum / stats.tracked : 0.0f;
+}
+
+static void commitGroup(SatelliteTable& table, uint8_t system, uint32_t nowMs) {
+  SatelliteView& view = table.view;
+  memcpy(view.sats[system], table.staging[system], table.stagingCount[system] * sizeof(Satellite));
+  view.count[system] = table.stagingCount[system];
+  view.stats[system].inView = table.stagingInView[system];
+  view.updatedMs[system] = nowMs;
+  table.nextMessage[system] = 0;
+  refreshSystem(table, system);
+}
+
+// $xxGSV,total,number,inView{,prn,elevation,azimuth,snr}[,signal]
+static void parseGSV(SatelliteTable& table, char* fields[], uint8_t count, uint32_t nowMs, bool* viewChanged) {
+  table.view.gsvSentences++;
+  int32_t total = Nmea_parseInt(fields[1], 0);
+  int32_t number = Nmea_parseInt(fields[2], 0);
+  int32_t inView = Nmea_parseInt(fields[3], 0);
+  uint8_t system = systemFromTalker(fields[0]);
+  if (system == GNSS_COUNT && count > 4) system = systemFromPrn(Nmea_parseInt(fields[4], 0));
+  if (total < 1 || total > 9 || number < 1 || number > total || inView < 0 || system == GNSS_COUNT) {
+    table.view.malformed++;
+    return;
+  }
+
+  if (number == 1) {
+    table.stagingCount[system] = 0;
+    table.stagingInView[system] = inView > 255 ? 255 : inView;
+    table.groupSize[system] = total;
+    table.nextMessage[system] = 1;
+  } else if (number != table.nextMessage[system] || total != table.groupSize[system]) {
+    // A message was lost: drop the partial group and wait for the next one
+    table.view.malformed++;
+    table.nextMessage[system] = 0;
+    return;
+  }
+
+  for (uint8_t i = 4; i + 3 < count; i += 4) {
+    int32_t prn = Nmea_parseInt(fields[i], 0);
+    if (prn <= 0 || prn > 255) continue;
+    if (table.stagingCount[system] >= SATS_PER_SYSTEM) break;
+    Satellite& sat = table.staging[system][table.stagingCount[system]++];
+    sat.prn = prn;
+    sat.elevation = constrain(Nmea_parseInt(fields[i + 1], 0), -90, 90);
+    sat.azimuth = constrain(Nmea_parseInt(fields[i + 2], 0), 0, 359);
+    sat.snr = constrain(Nmea_parseInt(fields[i + 3], 0), 0, 99);
+    sat.system = system;
+    sat.active = false;
+    sat.quality = sat.snr * (0.5f + sat.elevation / 180.0f);
+  }
+
+  table.nextMessage[system]++;
+  if (number == total) {
+    commitGroup(table, system, nowMs);
+    *viewChanged = true;
+  }
+}
+
+// $xxGSA,mode,fix,prn x12,pdop,hdop,vdop[,systemId]
+static void parseGSA(SatelliteTable& table, char* fields[], uint8_t count, bool* viewChanged) {
+  table.view.gsaSentences++;
+  if (count < 15) {
+    table.view.malformed++;
+    return;
+  }
+  uint8_t system = GNSS_COUNT;
+  int32_t systemId = (count > 18) ? Nmea_parseInt(fields[18], 0) : 0;
+  if (systemId >= 1 && systemId <= 4) {
+    system = systemId - 1;  // NMEA 4.10: 1 GPS, 2 GLONASS, 3 Galileo, 4 BeiDou
+  } else if (systemId == 0) {
+    system = systemFromTalker(fields[0]);
+    if (system == GNSS_COUNT) system = systemFromPrn(Nmea_parseInt(fields[3], 0));
+  }
+
+  SatelliteView& view = table.view;
+  view.fixType = constrain(Nmea_parseInt(fields[2], 1), 1, 3);
+  if (count > 15) view.pdop = parseFloatField(fields[15], 99.9f);
+  if (count > 16) view.hdop = parseFloatField(fields[16], 99.9f);
+  if (count > 17) view.vdop = parseFloatField(fields[17], 99.9f);
+  if (system == GNSS_COUNT) {
+    *viewChanged = true;  // Unsupported system (or no fix): DOPs only
+    return;
+  }
+
+  table.usedCount[system] = 0;
+  for (uint8_t i = 3; i < 15; i++) {
+    int32_t prn = Nmea_parseInt(fields[i], 0);
+    if (prn > 0 && prn <= 255) table.usedPrns[system][table.usedCount[system]++] = prn;
+  }
+  refreshSystem(table, system);
+  *viewChanged = true;
+}
+
+bool SatTable_parse(SatelliteTable& table, char* sentence, size_t len, uint32_t nowMs, bool* viewChanged) {
+  // Look at the sentence type before touching the buffer
+  if (len < 6 || sentence[0] != '$') return false;
+  bool gsv = sentence[3] == 'G' && sentence[4] == 'S' && sentence[5] == 'V';
+  bool gsa = sentence[3] == 'G' && sentence[4] == 'S' && sentence[5] == 'A';
+  if (!gsv && !gsa) return false;
+
+  char* fields[NMEA_MAX_FIELDS];
+  uint8_t count = Nmea_tokenize(sentence, len, fields, NMEA_MAX_FIELDS);
+  bool changed = false;
+  if (gsv) {
+    if (count < 4) {
+      table.view.gsvSentences++;
+      table.view.malformed++;
+    } else {
+      parseGSV(table, fields, count, nowMs, &changed);
+    }
+  } else {
+    parseGSA(table, fields, count, &changed);
+  }
+  if (viewChanged) *viewChanged = changed;
+  return true;
+}
+
+void SatTable_setSystem(SatelliteTable& table, uint8_t system, const Satellite* sats, uint8_t count, uint32_t nowMs) {
+  if (system >= GNSS_COUNT) return;
+  if (count > SATS_PER_SYSTEM) count = SATS_PER_SYSTEM;
+  table.usedCount[system] = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    if (sats[i].active) {
+      table.usedPrns[system][table.usedCount[system]++] = sats[i].prn;
+    }
+  }
+  memcpy(table.staging[system], sats, count * sizeof(Satellite));
+  table.stagingCount[system] = count;
+  table.stagingInView[system] = count;
+  commitGroup(table, system, nowMs);
+}
+
+uint8_t SatTable_top(const SatelliteView& view, Satellite* out, uint8_t maxCount) {
+  uint8_t filled = 0;
+  for (uint8_t system = 0; system < GNSS_COUNT; system++) {
+    for (uint8_t i = 0; i < view.count[system]; i++) {
+      const Satellite& sat = view.sats[system][i];
+      if (sat.snr == 0) continue;
+      // Insertion into the short sorted list
+      uint8_t pos = filled < maxCount ? filled++ : maxCount;
+      while (pos > 0 && out[pos - 1].quality < sat.quality) {
+        if (pos < maxCount) out[pos] = out[pos - 1];
+        pos--;
+      }
+      if (pos < maxCount) out[pos] = sat;
+    }
+  }
+  return filled;
+}
+
+// ============= Self-test =============
+static const char* const GOLDEN_SENTENCES[] = {
+  "$GPGSA,A,3,04,05,09,12,,,,,,,,,2.5,1.3,2.1*3F",
+  "$GPGSV,3,1,11,04,45,120,42,05,30,200,38,09,60,045,45,12,15,300,30*7C",
+  "$GPGSV,3,2,11,17,05,090,,19,70,010,47,20,25,260,33,23,40,330,40*7F",
+  "$GPGSV,3,3,11,25,10,180,,28,50,100,36,31,08,020,22*45",
+  "$GLGSV,1,1,03,65,35,050,35,66,60,150,41,72,12,270,*54",
+  "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A",
+};
+static const uint8_t GOLDEN_COUNT = sizeof(GOLDEN_SENTENCES) / sizeof(GOLDEN_SENTENCES[0]);
+
+static uint8_t feedGolden(SatelliteTable& table, char* buffer, size_t bufferSize, uint8_t index, uint32_t nowMs) {
+  size_t len = strlen(GOLDEN_SENTENCES[index]);
+  if (len >= bufferSize) len = bufferSize - 1;
+  memcpy(buffer, GOLDEN_SENTENCES[index], len);
+  buffer[len] = '\0';
+  bool changed = false;
+  return SatTable_parse(table, buffer, len, nowMs, &changed) ? 1 : 0;
+}
+
+static bool viewIsSane(const SatelliteView& view) {
+  for (uint8_t system = 0; system < GNSS_COUNT; system++) {
+    const GnssSnrStats& stats = view.stats[system];
+    if (view.count[system] > SATS_PER_SYSTEM) return false;
+    if (stats.tracked > view.count[system] || stats.used > view.count[system]) return false;
+    if (stats.minSnr > stats.maxSnr || stats.maxSnr > 99) return false;
+    for (uint8_t i = 0; i < view.count[system]; i++) {
+      const Satellite& sat = view.sats[system][i];
+      if (sat.prn == 0 || sat.system != system || sat.azimuth > 359) return false;
+    }
+  }
+  return view.fixType >= 1 && view.fixType <= 3;
+}
+
+void SatTable_runBenchmark() {
+  static const uint16_t FUZZ_SENTENCES = 5000;
+  static const uint16_t BENCH_ROUNDS = 500;
+  static SatelliteTable table;
+  char buffer[100];
+  Serial.println("\n⏱️ NMEA Satellite Parser Benchmark:");
+  Serial.println("================================");
+  uint32_t heapBefore = ESP.getFreeHeap();
+
+  // Golden: known GSA + GSV groups
+  SatTable_reset(table);
+  uint8_t handled = 0;
+  for (uint8_t i = 0; i < GOLDEN_COUNT; i++) handled += feedGolden(table, buffer, sizeof(buffer), i, 1000);
+  const SatelliteView& view = table.view;
+  const GnssSnrStats& gpsStats = view.stats[GNSS_GPS];
+  const GnssSnrStats& gloStats = view.stats[GNSS_GLONASS];
+  Satellite top[3];
+  uint8_t topCount = SatTable_top(view, top, 3);
+  bool golden = handled == GOLDEN_COUNT - 1 &&
+                view.count[GNSS_GPS] == 11 && gpsStats.inView == 11 && gpsStats.tracked == 9 &&
+                gpsStats.used == 4 && gpsStats.minSnr == 22 && gpsStats.maxSnr == 47 &&
+                fabs(gpsStats.meanSnr - 37.0f) < 0.01f &&
+                view.count[GNSS_GLONASS] == 3 && gloStats.tracked == 2 && gloStats.meanSnr == 38.0f &&
+                view.fixType == 3 && fabs(view.pdop - 2.5f) < 0.01f &&
+                view.sats[GNSS_GPS][4].snr == 0 && view.sats[GNSS_GPS][5].elevation == 70 &&
+                topCount == 3 && top[0].prn == 19 && top[1].prn == 9 && top[2].prn == 66 &&
+                view.malformed == 0;
+
+  // A lost middle message must drop the group, not commit a partial one
+  feedGolden(table, buffer, sizeof(buffer), 1, 2000);
+  feedGolden(table, buffer, sizeof(buffer), 3, 2000);
+  golden = golden && view.malformed == 1 && view.updatedMs[GNSS_GPS] == 1000;
+  Serial.printf("Golden GSV/GSA check: %s\n", golden ? "✅ PASS" : "❌ FAIL");
+
+  // Fuzz: corrupted, truncated and spliced copies of the golden sentences
+  uint32_t seed = 0x5A7E11;
+  auto nextRandom = [&seed]() { seed = seed * 1664525UL + 1013904223UL; return seed >> 16; };
+  static const char ALPHABET[] = ",,,**$0123456789-.GSVAPL";
+  uint16_t violations = 0;
+  SatTable_reset(table);
+  for (uint16_t n = 0; n < FUZZ_SENTENCES; n++) {
+    const char* source = GOLDEN_SENTENCES[nextRandom() % GOLDEN_COUNT];
+    size_t len = strlen(source);
+    memcpy(buffer, source, len);
+    uint8_t edits = nextRandom() % 6;
+    for (uint8_t e = 0; e < edits; e++) {
+      size_t at = 1 + nextRandom() % (len - 1);
+      buffer[at] = (nextRandom() % 4 == 0) ? (char)(nextRandom() & 0xFF) : ALPHABET[nextRandom() % (sizeof(ALPHABET) - 1)];
+    }
+    if (nextRandom() % 4 == 0) len = 1 + nextRandom() % len;
+    buffer[len] = '\0';
+    bool changed = false;
+    SatTable_parse(table, buffer, len, n, &changed);
+    if (!viewIsSane(table.view)) violations++;
+  }
+  Serial.printf("Fuzz check: %s (%u sentences, %u bad views, %lu malformed)\n",
+                violations == 0 ? "✅ PASS" : "❌ FAIL", FUZZ_SENTENCES, violations,
+                (unsigned long)table.view.malformed);
+
+  // Cycles per sentence over the golden set
+  SatTable_reset(table);
+  uint32_t cycles = 0;
+  for (uint16_t round = 0; round < BENCH_ROUNDS; round++) {
+    for (uint8_t i = 0; i < GOLDEN_COUNT; i++) {
+      size_t len = strlen(GOLDEN_SENTENCES[i]);
+      memcpy(buffer, GOLDEN_SENTENCES[i], len + 1);
+      bool changed = false;
+      uint32_t start = ESP.getCycleCount();
+      SatTable_parse(table, buffer, len, round, &changed);
+      cycles += ESP.getCycleCount() - start;
+    }
+  }
+  uint32_t heapAfter = ESP.getFreeHeap();
+  Serial.printf("Heap check: %s (free heap %lu -> %lu bytes)\n",
+                heapAfter >= heapBefore ? "✅ PASS" : "❌ FAIL",
+                (unsigned long)heapBefore, (unsigned long)heapAfter);
+  Serial.printf("Parser: %lu cycles/sentence (%u sentences)\n",
+                (unsigned long)(cycles / (BENCH_ROUNDS * GOLDEN_COUNT)), BENCH_ROUNDS * GOLDEN_COUNT);
+  Serial.println("================================\n");
+}
@@ -0,0 +1,87 @@
+#pragma once
+#ifndef SATELLITETABLE_H
+#define SATELLITETABLE_H
+
+#include <Arduino.h>
+
+// Satellites in view from GSV groups (GPS, GLONASS, Galileo, BeiDou) and the
+// PRNs used in the fix from GSA. Sentences are tokenized in place: no String,
+// no heap, so it runs in the GPS task at full sentence rate.
+enum GnssSystem : uint8_t {
+  GNSS_GPS = 0,
+  GNSS_GLONASS,
+  GNSS_GALILEO,
+  GNSS_BEIDOU,
+  GNSS_COUNT
+};
+
+#define SATS_PER_SYSTEM 20      // GSV groups beyond this are truncated
+#define GSA_MAX_PRNS 12
+#define NMEA_MAX_FIELDS 24
+
+struct Satellite {
+  uint8_t prn;
+  int8_t elevation;             // Degrees
+  uint16_t azimuth;             // Degrees
+  uint8_t snr;                  // dB-Hz, 0 = not tracked
+  bool active;                  // Used in the fix (GSA)
+  uint8_t system;               // GnssSystem
+  float quality;                // SNR weighted by elevation
+};
+
+struct GnssSnrStats {
+  uint8_t inView;               // As reported by the receiver
+  uint8_t tracked;              // SNR reported
+  uint8_t used;
+  uint8_t minSnr;
+  uint8_t maxSnr;
+  float meanSnr;                // Over tracked satellites
+};
+
+// What the rest of the firmware reads: complete GSV groups only
+struct SatelliteView {
+  Satellite sats[GNSS_COUNT][SATS_PER_SYSTEM];
+  uint8_t count[GNSS_COUNT];
+  GnssSnrStats stats[GNSS_COUNT];
+  uint32_t updatedMs[GNSS_COUNT];
+  uint8_t fixType;              // From GSA: 1 = none, 2 = 2D, 3 = 3D
+  float pdop;
+  float hdop;
+  float vdop;
+  uint32_t gsvSentences;
+  uint32_t gsaSentences;
+  uint32_t malformed;           // Bad fields or out-of-sequence group messages
+};
+
+struct SatelliteTable {
+  SatelliteView view;
+  Satellite staging[GNSS_COUNT][SATS_PER_SYSTEM];   // Group being received
+  uint8_t stagingCount[GNSS_COUNT];
+  uint8_t stagingInView[GNSS_COUNT];
+  uint8_t groupSize[GNSS_COUNT];
+  uint8_t nextMessage[GNSS_COUNT];                  // 0 = waiting for message 1
+  uint8_t usedPrns[GNSS_COUNT][SATS_PER_SYSTEM];
+  uint8_t usedCount[GNSS_COUNT];
+};
+
+// Splits "$..,..*HH" in place at ',' and stops at '*'; sentence must have
+// room for len + 1 bytes. Returns the field count.
+uint8_t Nmea_tokenize(char* sentence, size_t len, char* fields[], uint8_t maxFields);
+// Decimal field; empty or non-numeric gives fallback
+int32_t Nmea_parseInt(const char* field, int32_t fallback);
+
+void SatTable_reset(SatelliteTable& table);
+// Handles GSV/GSA and returns true for them; they are tokenized in place.
+// Other sentences are left untouched. *viewChanged is set when the view moved.
+bool SatTable_parse(SatelliteTable& table, char* sentence, size_t len, uint32_t nowMs, bool* viewChanged);
+
+// Whole-system update from a binary receiver report (UBX NAV-SVINFO); the
+// active flags in sats become the used list
+void SatTable_setSystem(SatelliteTable& table, uint8_t system, const Satellite* sats, uint8_t count, uint32_t nowMs);
+
+const char* SatTable_systemName(uint8_t system);
+// Best tracked satellites by quality across all systems; returns how many were filled
+uint8_t SatTable_top(const SatelliteView& view, Satellite* out, uint8_t maxCount);
+void SatTable_runBenchmark();
+
+#endif // SATELLITETABLE_H
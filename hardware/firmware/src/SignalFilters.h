@@ -0,0 +1,365 @@
+#pragma once
+#ifndef SIGNALFILTERS_H
+#define SIGNALFILTERS_H
+
+#include <Arduino.h>
+#include <string.h>
+
+// ============= Fixed-Point Helpers =============
+// Distances are carried as Q4 (1/16 mm), filter gains as Q15.
+// 3500mm * 16 * 32768 still fits in int32, so blends need no 64-bit math.
+static const uint8_t Q_DIST_SHIFT = 4;
+static const uint8_t Q_GAIN_SHIFT = 15;
+
+static inline int32_t toQDist(float mm) {
+  return static_cast<int32_t>(mm * (1 << Q_DIST_SHIFT) + 0.5f);
+}
+
+static inline int32_t toQDist(uint16_t mm) {
+  return static_cast<int32_t>(mm) << Q_DIST_SHIFT;
+}
+
+static inline float fromQDist(int32_t q) {
+  return q * (1.0f / (1 << Q_DIST_SHIFT));
+}
+
+static inline int32_t qGain(float gain) {
+  return static_cast<int32_t>(gain * (1 << Q_GAIN_SHIFT) + 0.5f);
+}
+
+// from + (to - from) * gain: both the EMA step and partial jumps use this.
+// Rounded to nearest; a floored step biases a small-gain EMA low by ~1/gain LSB.
+static inline int32_t qBlend(int32_t from, int32_t to, int32_t gainQ15) {
+  return from + (((to - from) * gainQ15 + (1 << (Q_GAIN_SHIFT - 1))) >> Q_GAIN_SHIFT);
+}
+
+// ============= Stable EMA =============
+// Distance smoother of the ToF chain, in Q4 mm with Q15 gains. The first
+// 8 in-range samples are averaged. After that a closer obstacle is taken
+// at once, a cleared one is recovered almost at once, small changes get an
+// EMA whose gain grows with the change, and larger jumps move only part of
+// the way. speed picks the gains: 1 conservative, 2 balanced, 3 fast.
+static const float EMA_ALPHA_MIN = 0.07f;
+static const float EMA_ALPHA_MID = 0.22f;
+static const float EMA_ALPHA_MAX = 0.35f;
+static const float EMA_CHANGE_SMALL_MM = 3.0f;      // Below: EMA_ALPHA_MIN
+static const float EMA_CHANGE_LARGE_MM = 20.0f;     // Above: EMA_ALPHA_MAX
+static const uint16_t EMA_STABLE_CHANGE_MM = 15;
+static const uint16_t EMA_NORMAL_CHANGE_LIMIT_MM = 70;
+static const uint16_t EMA_NEW_OBSTACLE_DROP_MM = 25;
+static const uint16_t EMA_NEW_OBSTACLE_RANGE_MM = 1500;
+static const uint16_t EMA_OBSTACLE_REMOVED_RISE_MM = 35;
+static const uint16_t EMA_OBSTACLE_REMOVED_RANGE_MM = 800;
+// Indexed by speed
+static const float EMA_RECOVERY_RATE[4] = {0, 0.9f, 0.95f, 1.0f};
+static const float EMA_RECOVERY_ALPHA[4] = {0, EMA_ALPHA_MAX * 0.7f, EMA_ALPHA_MAX * 0.9f, EMA_ALPHA_MAX * 1.2f};
+static const float EMA_CONSERVATIVE_RATE[4] = {0, 0.08f, 0.12f, 0.18f};
+
+static const int32_t EMA_ALPHA_MIN_Q = qGain(EMA_ALPHA_MIN);
+static const int32_t EMA_ALPHA_MID_Q = qGain(EMA_ALPHA_MID);
+static const int32_t EMA_ALPHA_MAX_Q = qGain(EMA_ALPHA_MAX);
+static const int32_t EMA_CHANGE_SMALL_Q = toQDist(EMA_CHANGE_SMALL_MM);
+static const int32_t EMA_CHANGE_LARGE_Q = toQDist(EMA_CHANGE_LARGE_MM);
+static const int32_t EMA_STABLE_CHANGE_Q = toQDist(EMA_STABLE_CHANGE_MM);
+static const int32_t EMA_NORMAL_CHANGE_LIMIT_Q = toQDist(EMA_NORMAL_CHANGE_LIMIT_MM);
+static const int32_t EMA_NEW_OBSTACLE_DROP_Q = toQDist(EMA_NEW_OBSTACLE_DROP_MM);
+static const int32_t EMA_OBSTACLE_REMOVED_RISE_Q = toQDist(EMA_OBSTACLE_REMOVED_RISE_MM);
+static const int32_t EMA_OBSTACLE_REMOVED_RANGE_Q = toQDist(EMA_OBSTACLE_REMOVED_RANGE_MM);
+static const int32_t EMA_RECOVERY_RATE_Q[4] = {0, qGain(EMA_RECOVERY_RATE[1]), qGain(EMA_RECOVERY_RATE[2]),
+                                               qGain(EMA_RECOVERY_RATE[3])};
+static const int32_t EMA_RECOVERY_ALPHA_Q[4] = {0, qGain(EMA_RECOVERY_ALPHA[1]), qGain(EMA_RECOVERY_ALPHA[2]),
+                                                qGain(EMA_RECOVERY_ALPHA[3])};
+static const int32_t EMA_CONSERVATIVE_RATE_Q[4] = {0, qGain(EMA_CONSERVATIVE_RATE[1]), qGain(EMA_CONSERVATIVE_RATE[2]),
+                                                   qGain(EMA_CONSERVATIVE_RATE[3])};
+
+struct StableEmaState {
+  uint8_t initCount;
+  int32_t filtered;             // Output, Q4
+  int32_t lastStable;
+  uint32_t lastLargeChangeTime;
+  bool recoveringFromObstacle;
+  uint8_t consecutiveStableReadings;
+  int32_t minQ;                 // Valid range; the output is clamped to it
+  int32_t maxQ;
+};
+
+// Starts at maxMm, i.e. a clear path
+static inline StableEmaState stableEmaInit(uint16_t minMm, uint16_t maxMm) {
+  StableEmaState st = {0, toQDist(maxMm), toQDist(maxMm), 0, false, 0, toQDist(minMm), toQDist(maxMm)};
+  return st;
+}
+
+static inline void stableEmaStep(StableEmaState& st, uint16_t newDistance, uint32_t currentTime, uint8_t speed) {
+  const int32_t newQ = toQDist(newDistance);
+
+  if (st.initCount < 8) {
+    if (newQ >= st.minQ && newQ <= st.maxQ) {
+      st.filtered = (st.filtered * st.initCount + newQ) / (st.initCount + 1);
+      st.lastStable = st.filtered;
+      st.initCount++;
+    }
+    return;
+  }
+
+  const int32_t delta = newQ - st.lastStable;
+  const int32_t change = (delta < 0) ? -delta : delta;
+
+  // Safety first: a new obstacle is taken at once
+  if (delta < -EMA_NEW_OBSTACLE_DROP_Q && newDistance < EMA_NEW_OBSTACLE_RANGE_MM) {
+    st.recoveringFromObstacle = false;
+    st.consecutiveStableReadings = 0;
+    st.filtered = newQ;
+    st.lastStable = st.filtered;
+    return;
+  }
+
+  if (delta > EMA_OBSTACLE_REMOVED_RISE_Q && st.lastStable < EMA_OBSTACLE_REMOVED_RANGE_Q) {
+    // Obstacle removed: jump most or all of the way back
+    st.recoveringFromObstacle = true;
+    st.lastLargeChangeTime = currentTime;
+    st.consecutiveStableReadings = 0;
+    st.filtered = qBlend(st.lastStable, newQ, EMA_RECOVERY_RATE_Q[speed]);
+  } else if (change <= EMA_NORMAL_CHANGE_LIMIT_Q) {
+    int32_t alpha = EMA_ALPHA_MID_Q;
+    if (change > EMA_CHANGE_LARGE_Q) alpha = EMA_ALPHA_MAX_Q;
+    else if (change < EMA_CHANGE_SMALL_Q) alpha = EMA_ALPHA_MIN_Q;
+    if (st.recoveringFromObstacle && newQ > st.filtered) alpha = EMA_RECOVERY_ALPHA_Q[speed];
+    st.filtered = qBlend(st.filtered, newQ, alpha);
+    if (change < EMA_STABLE_CHANGE_Q) {
+      st.consecutiveStableReadings++;
+    } else {
+      st.consecutiveStableReadings = 0;
+    }
+  } else {
+    // Large change away from us: approach it conservatively
+    st.filtered = qBlend(st.lastStable, newQ, EMA_CONSERVATIVE_RATE_Q[speed]);
+    st.consecutiveStableReadings = 0;
+  }
+
+  uint32_t resetTimeout = (speed == 1) ? 3500 : (speed == 3) ? 2000 : 2500;
+  uint8_t requiredStableReadings = (speed == 1) ? 6 : (speed == 3) ? 3 : 4;
+  if (st.recoveringFromObstacle && (currentTime - st.lastLargeChangeTime > resetTimeout ||
+                                    st.consecutiveStableReadings > requiredStableReadings)) {
+    st.recoveringFromObstacle = false;
+  }
+
+  if (st.filtered > st.maxQ) st.filtered = st.maxQ;
+  if (st.filtered < st.minQ) st.filtered = st.minQ;
+  st.lastStable = st.filtered;
+}
+
+// ============= Running Median =============
+// Median over the last N samples of a ring buffer. A full window goes
+// through a branch-free compare-exchange network (min/max, no data
+// dependent jumps); while the window fills, the valid prefix is
+// insertion sorted instead.
+template <uint8_t N, typename T = uint16_t>
+class MedianN {
+public:
+  MedianN() : head(0), filled(0) {
+    memset(ring, 0, sizeof(ring));
+  }
+
+  void reset() {
+    head = 0;
+    filled = 0;
+  }
+
+  void push(T value) {
+    ring[head] = value;
+    head = (head + 1 == N) ? 0 : head + 1;
+    if (filled < N) filled++;
+  }
+
+  uint8_t count() const { return filled; }
+  bool full() const { return filled == N; }
+
+  T median() const {
+    if (filled == 0) return 0;
+    T v[N];
+    memcpy(v, ring, sizeof(v));
+    if (filled < N) {
+      insertionSort(v, filled);
+      return v[filled >> 1];
+    }
+    return medianOfFull(v);
+  }
+
+  // Median of exactly N values, reorders the array
+  static T medianOfFull(T* v) {
+    if (N == 5) {
+      // 7 comparators, verified against all 5-element inputs
+      compareExchange(v[0], v[1]); compareExchange(v[3], v[4]);
+      compareExchange(v[0], v[3]); compareExchange(v[1], v[4]);
+      compareExchange(v[1], v[2]); compareExchange(v[2], v[3]);
+      compareExchange(v[1], v[2]);
+      return v[2];
+    }
+    // Odd-even transposition network, N rounds sorts any input
+    for (uint8_t round = 0; round < N; round++) {
+      for (uint8_t i = round & 1; i + 1 < N; i += 2) {
+        compareExchange(v[i], v[i + 1]);
+      }
+    }
+    return v[N >> 1];
+  }
+
+  static inline void compareExchange(T& a, T& b) {
+    T lo = (a < b) ? a : b;  // min/max compile to MIN/MAX on Xtensa
+    T hi = (a < b) ? b : a;
+    a = lo;
+    b = hi;
+  }
+
+  static void insertionSort(T* v, uint8_t n) {
+    for (uint8_t i = 1; i < n; i++) {
+      T key = v[i];
+      int8_t j = i - 1;
+      while (j >= 0 && v[j] > key) {
+        v[j + 1] = v[j];
+        j--;
+      }
+      v[j + 1] = key;
+    }
+  }
+
+private:
+  T ring[N];
+  uint8_t head;
+  uint8_t filled;
+};
+
+// ============= Angle EMA =============
+// EMA of an angle in degrees, run on its unit vector. A plain EMA of a
+// 0-360 angle swings through 180 when the input crosses 359 -> 0; the
+// averaged sin/cos stay continuous there.
+class AngleEma {
+public:
+  AngleEma() : sinAvg(0), cosAvg(1) {}
+
+  void reset(float degrees) {
+    float rad = degrees * ((float)M_PI / 180.0f);
+    sinAvg = sinf(rad);
+    cosAvg = cosf(rad);
+  }
+
+  // Returns the smoothed angle in [0, 360)
+  float update(float degrees, float alpha) {
+    float rad = degrees * ((float)M_PI / 180.0f);
+    sinAvg += alpha * (sinf(rad) - sinAvg);
+    cosAvg += alpha * (cosf(rad) - cosAvg);
+    return value();
+  }
+
+  float value() const {
+    float degrees = atan2f(sinAvg, cosAvg) * (180.0f / (float)M_PI);
+    return (degrees < 0) ? degrees + 360.0f : degrees;
+  }
+
+private:
+  float sinAvg;
+  float cosAvg;
+};
+
+// ============= Six-Axis Median =============
+// Median of 5 for all six IMU channels at once. History is stored as
+// structure of arrays: 5 slots of one AxisBlock each (8 int16 lanes, lanes
+// 6-7 are padding), so a slot is exactly one 128-bit PIE vector on the
+// ESP32-S3. Both paths run the same 10 min/max ops (the 7-comparator
+// network with the outputs the median never reads dropped), so the SIMD
+// and scalar results are bit-identical.
+#if defined(CONFIG_IDF_TARGET_ESP32S3) && !defined(SC_IMU_NO_SIMD)
+#define SC_AXIS_MEDIAN_SIMD 1
+#endif
+
+static const uint8_t AXIS_CHANNELS = 6;
+static const uint8_t AXIS_LANES = 8;
+static const uint8_t AXIS_HISTORY = 5;
+
+struct alignas(16) AxisBlock {
+  int16_t lane[AXIS_LANES];
+};
+
+class AxisMedian5 {
+public:
+  AxisMedian5() : head(0) {
+    memset(slots, 0, sizeof(slots));
+  }
+
+  // Seed every slot so the first medians are not pulled toward zero
+  void fill(const int16_t values[AXIS_CHANNELS]) {
+    for (uint8_t s = 0; s < AXIS_HISTORY; s++) store(slots[s], values);
+    head = 0;
+  }
+
+  void push(const int16_t values[AXIS_CHANNELS]) {
+    store(slots[head], values);
+    head = (head + 1 == AXIS_HISTORY) ? 0 : head + 1;
+  }
+
+  // A median does not care about slot order, so the ring is read as is
+  void median(AxisBlock& out) const {
+#ifdef SC_AXIS_MEDIAN_SIMD
+    medianSimd(out);
+#else
+    medianScalar(out);
+#endif
+  }
+
+  void medianScalar(AxisBlock& out) const {
+    for (uint8_t i = 0; i < AXIS_LANES; i++) {
+      int16_t a0 = slots[0].lane[i], a1 = slots[1].lane[i], a2 = slots[2].lane[i];
+      int16_t a3 = slots[3].lane[i], a4 = slots[4].lane[i];
+      int16_t b0 = min16(a0, a1), b1 = max16(a0, a1);
+      int16_t b3 = min16(a3, a4), b4 = max16(a3, a4);
+      int16_t c3 = max16(b0, b3);
+      int16_t c1 = min16(b1, b4);
+      int16_t d1 = min16(c1, a2), d2 = max16(c1, a2);
+      int16_t e2 = min16(d2, c3);
+      out.lane[i] = max16(d1, e2);
+    }
+  }
+
+#ifdef SC_AXIS_MEDIAN_SIMD
+  // Same network on q registers: 5 vector loads, 10 EE.VMIN/VMAX.S16, 1 store
+  void medianSimd(AxisBlock& out) const {
+    const AxisBlock* src = slots;
+    AxisBlock* dst = &out;
+    asm volatile(
+      "ee.vld.128.ip   q0, %0, 16  \n"
+      "ee.vld.128.ip   q1, %0, 16  \n"
+      "ee.vld.128.ip   q2, %0, 16  \n"
+      "ee.vld.128.ip   q3, %0, 16  \n"
+      "ee.vld.128.ip   q4, %0, 16  \n"
+      "ee.vmin.s16     q5, q0, q1  \n"  // b0
+      "ee.vmax.s16     q1, q0, q1  \n"  // b1
+      "ee.vmin.s16     q6, q3, q4  \n"  // b3
+      "ee.vmax.s16     q4, q3, q4  \n"  // b4
+      "ee.vmax.s16     q3, q5, q6  \n"  // c3
+      "ee.vmin.s16     q1, q1, q4  \n"  // c1
+      "ee.vmin.s16     q5, q1, q2  \n"  // d1
+      "ee.vmax.s16     q2, q1, q2  \n"  // d2
+      "ee.vmin.s16     q2, q2, q3  \n"  // e2
+      "ee.vmax.s16     q0, q5, q2  \n"  // median
+      "ee.vst.128.ip   q0, %1, 16  \n"
+      : "+r"(src), "+r"(dst)
+      :
+      : "memory");
+  }
+#endif
+
+private:
+  static inline int16_t min16(int16_t a, int16_t b) { return (a < b) ? a : b; }
+  static inline int16_t max16(int16_t a, int16_t b) { return (a < b) ? b : a; }
+
+  static void store(AxisBlock& slot, const int16_t values[AXIS_CHANNELS]) {
+    memcpy(slot.lane, values, AXIS_CHANNELS * sizeof(int16_t));
+    slot.lane[6] = 0;
+    slot.lane[7] = 0;
+  }
+
+  AxisBlock slots[AXIS_HISTORY];
+  uint8_t head;
+};
+
+#endif // SIGNALFILTERS_H
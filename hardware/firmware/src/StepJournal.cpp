@@ -0,0 +1,352 @@
+#include "StepJournal.h"
+#include "SDCardManager.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// ============= Journal Layout =============
+// JOURNAL_SEGMENTS files of up to SEGMENT_RECORDS fixed-size records. The
+// active segment is only ever appended to; when it fills, the next segment
+// is truncated and becomes active, so the previous segments still hold
+// valid records if power fails mid-write.
+static const char* const SEGMENT_PATH_FORMAT = "/data/steps_%u.jnl";
+static const uint8_t JOURNAL_SEGMENTS = 4;
+static const uint16_t SEGMENT_RECORDS = 256;
+static const uint32_t RECORD_MAGIC = 0x314A5453;  // "STJ1"
+
+struct StepJournalRecord {
+  uint32_t magic;
+  uint32_t sequence;
+  uint32_t dailySteps;
+  uint32_t totalSteps;
+  uint8_t lastResetDay;
+  uint8_t lastResetMonth;
+  uint16_t lastResetYear;
+  uint32_t crc;   // CRC-32 of every field above
+};
+
+// ============= Legacy Step File =============
+// One checksummed block, rewritten in place on every save. Read only when
+// the card has no journal yet; its counts become the first record.
+static const char* const LEGACY_PATH = "/data/step_data.dat";
+static const uint32_t LEGACY_MAGIC = 0x53544550;  // "STEP"
+
+struct LegacyStepData {
+  uint32_t magic;
+  uint32_t dailySteps;
+  uint32_t totalSteps;
+  uint8_t lastResetDay;
+  uint8_t lastResetMonth;
+  uint16_t lastResetYear;
+  uint32_t checksum;   // Byte sum of every field above
+};
+
+// ============= Commit Batching =============
+static const uint32_t COMMIT_INTERVAL_MS = 60000;  // Staged counts wait at most this long
+static const uint32_t COMMIT_BATCH_STEPS = 100;    // ...or until this many new steps
+#define JOURNAL_TASK_STACK_SIZE 4096
+#define JOURNAL_TASK_PRIORITY 1
+#define JOURNAL_TASK_CORE 0
+
+// Requests are bits the commit task takes all at once: repeated STAGEs
+// coalesce into the newest counts, but a FLUSH or ERASE stays set until the
+// task has seen it. An ERASE discards counts posted before it.
+enum JournalOp : uint8_t { JOURNAL_STAGE = 0x01, JOURNAL_FLUSH = 0x02, JOURNAL_ERASE = 0x04 };
+static portMUX_TYPE journalMux = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t pendingOps = 0;
+static StepCounts postedCounts;     // Newest STAGE/FLUSH counts
+static TaskHandle_t journalTaskHandle = nullptr;
+
+// Journal position, owned by the commit task after StepJournal_begin()
+static uint8_t activeSegment = 0;
+static uint16_t activeRecords = 0;
+static uint32_t lastSequence = 0;
+static StepCounts committedCounts;   // Last counts on the card, for batch sizing
+
+// Status
+static uint32_t commits = 0;
+static uint32_t commitFailures = 0;
+static uint32_t lastCommitMs = 0;
+static uint16_t recoveredTornRecords = 0;
+static StepJournalSource recoveredFrom = STEP_SOURCE_NONE;
+
+static void segmentPath(uint8_t segment, char* path, size_t len) {
+  snprintf(path, len, SEGMENT_PATH_FORMAT, segment);
+}
+
+static uint32_t recordCrc(const StepJournalRecord& record) {
+  return SDCard_crc32((const uint8_t*)&record, offsetof(StepJournalRecord, crc));
+}
+
+static bool recordValid(const StepJournalRecord& record) {
+  return record.magic == RECORD_MAGIC && record.crc == recordCrc(record);
+}
+
+// Scan one segment: newest valid record, record slots used, and whether it
+// is safe to keep appending (no torn or corrupt records)
+static bool scanSegment(uint8_t segment, StepJournalRecord& newest, uint16_t& records, bool& clean) {
+  char path[32];
+  segmentPath(segment, path, sizeof(path));
+  records = 0;
+  clean = true;
+  File file = SD.open(path, FILE_READ);
+  if (!file) return false;
+
+  bool found = false;
+  size_t size = file.size();
+  if (size % sizeof(StepJournalRecord) != 0) clean = false;  // Torn tail
+  StepJournalRecord record;
+  while (file.read((uint8_t*)&record, sizeof(record)) == sizeof(record)) {
+    records++;
+    if (!recordValid(record)) {
+      clean = false;
+      recoveredTornRecords++;
+      continue;
+    }
+    if (!found || (int32_t)(record.sequence - newest.sequence) > 0) {
+      newest = record;
+      found = true;
+    }
+  }
+  file.close();
+  return found;
+}
+
+// Next segment starts empty; truncating it is the only rewrite in the journal
+static bool rotateSegment() {
+  activeSegment = (activeSegment + 1) % JOURNAL_SEGMENTS;
+  activeRecords = 0;
+  char path[32];
+  segmentPath(activeSegment, path, sizeof(path));
+  File file = SD.open(path, FILE_WRITE);
+  if (!file) return false;
+  file.close();
+  return true;
+}
+
+static bool readLegacy(StepCounts& counts) {
+  File file = SD.open(LEGACY_PATH, FILE_READ);
+  if (!file) return false;
+  LegacyStepData data;
+  size_t bytesRead = file.read((uint8_t*)&data, sizeof(data));
+  file.close();
+  if (bytesRead != sizeof(data) || data.magic != LEGACY_MAGIC) return false;
+  uint32_t sum = 0;
+  const uint8_t* bytes = (const uint8_t*)&data;
+  for (size_t i = 0; i < offsetof(LegacyStepData, checksum); i++) sum += bytes[i];
+  if (data.checksum != sum) return false;
+  counts.dailySteps = data.dailySteps;
+  counts.totalSteps = data.totalSteps;
+  counts.lastResetDay = data.lastResetDay;
+  counts.lastResetMonth = data.lastResetMonth;
+  counts.lastResetYear = data.lastResetYear;
+  return true;
+}
+
+static bool commitRecord(const StepCounts& counts) {
+  if (activeRecords >= SEGMENT_RECORDS && !rotateSegment()) return false;
+
+  StepJournalRecord record;
+  record.magic = RECORD_MAGIC;
+  record.sequence = lastSequence + 1;
+  record.dailySteps = counts.dailySteps;
+  record.totalSteps = counts.totalSteps;
+  record.lastResetDay = counts.lastResetDay;
+  record.lastResetMonth = counts.lastResetMonth;
+  record.lastResetYear = counts.lastResetYear;
+  record.crc = recordCrc(record);
+
+  char path[32];
+  segmentPath(activeSegment, path, sizeof(path));
+  if (!SDCard_appendFile(path, (const uint8_t*)&record, sizeof(record))) {
+    // A partial append leaves a torn record; continue in a fresh segment
+    rotateSegment();
+    return false;
+  }
+  activeRecords++;
+  lastSequence = record.sequence;
+  return true;
+}
+
+static bool eraseSegments() {
+  char path[32];
+  bool ok = true;
+  for (uint8_t segment = 0; segment < JOURNAL_SEGMENTS; segment++) {
+    segmentPath(segment, path, sizeof(path));
+    if (SD.exists(path) && !SD.remove(path)) ok = false;
+  }
+  if (SD.exists(LEGACY_PATH) && !SD.remove(LEGACY_PATH)) ok = false;
+  activeSegment = 0;
+  activeRecords = 0;
+  return ok;
+}
+
+static void journalTask(void* parameter) {
+  StepCounts pending;
+  bool havePending = false;
+  uint32_t pendingSince = 0;
+
+  for (;;) {
+    TickType_t wait = portMAX_DELAY;
+    if (havePending) {
+      uint32_t waited = millis() - pendingSince;
+      wait = (waited >= COMMIT_INTERVAL_MS) ? 0 : pdMS_TO_TICKS(COMMIT_INTERVAL_MS - waited);
+    }
+
+    ulTaskNotifyTake(pdTRUE, wait);
+    portENTER_CRITICAL(&journalMux);
+    uint8_t ops = pendingOps;
+    StepCounts posted = postedCounts;
+    pendingOps = 0;
+    portEXIT_CRITICAL(&journalMux);
+
+    if (ops & JOURNAL_ERASE) {
+      if (!eraseSegments()) commitFailures++;
+      havePending = false;
+    }
+    bool commitNow = false;
+    if (ops & (JOURNAL_STAGE | JOURNAL_FLUSH)) {
+      if (!havePending) pendingSince = millis();
+      pending = posted;
+      havePending = true;
+      commitNow = (ops & JOURNAL_FLUSH) ||
+                  pending.totalSteps - committedCounts.totalSteps >= COMMIT_BATCH_STEPS;
+    } else if (!ops) {
+      commitNow = havePending && millis() - pendingSince >= COMMIT_INTERVAL_MS;  // Batch interval elapsed
+    }
+
+    if (!commitNow) continue;
+    if (commitRecord(pending)) {
+      committedCounts = pending;
+      havePending = false;
+      commits++;
+      lastCommitMs = millis();
+    } else {
+      commitFailures++;
+      pendingSince = millis();  // Retry after another interval
+    }
+  }
+}
+
+bool StepJournal_begin(StepCounts& recovered) {
+  // Recovery scan: the valid record with the highest sequence wins
+  StepJournalRecord newest;
+  bool found = false;
+  uint8_t newestSegment = 0;
+  uint16_t newestSegmentRecords = 0;
+  bool newestSegmentClean = true;
+  recoveredTornRecords = 0;
+  for (uint8_t segment = 0; segment < JOURNAL_SEGMENTS; segment++) {
+    StepJournalRecord candidate;
+    uint16_t records;
+    bool clean;
+    if (!scanSegment(segment, candidate, records, clean)) continue;
+    if (!found || (int32_t)(candidate.sequence - newest.sequence) > 0) {
+      newest = candidate;
+      newestSegment = segment;
+      newestSegmentRecords = records;
+      newestSegmentClean = clean;
+      found = true;
+    }
+  }
+
+  recoveredFrom = found ? STEP_SOURCE_JOURNAL : STEP_SOURCE_NONE;
+  if (found) {
+    recovered.dailySteps = newest.dailySteps;
+    recovered.totalSteps = newest.totalSteps;
+    recovered.lastResetDay = newest.lastResetDay;
+    recovered.lastResetMonth = newest.lastResetMonth;
+    recovered.lastResetYear = newest.lastResetYear;
+    lastSequence = newest.sequence;
+    committedCounts = recovered;
+    activeSegment = newestSegment;
+    activeRecords = newestSegmentRecords;
+    // Never append behind a torn record: fixed offsets would stay misaligned
+    if (!newestSegmentClean) rotateSegment();
+  } else {
+    activeSegment = JOURNAL_SEGMENTS - 1;
+    rotateSegment();  // Start clean in segment 0
+    // First boot with the journal: carry the legacy counts over. The file
+    // stays until a factory reset; from now on the journal record wins.
+    if (readLegacy(recovered)) {
+      Serial.println("Migrating legacy step data into the journal");
+      if (commitRecord(recovered)) commits++;
+      else commitFailures++;
+      committedCounts = recovered;
+      recoveredFrom = STEP_SOURCE_LEGACY;
+      found = true;
+    }
+  }
+  if (recoveredTornRecords > 0) {
+    Serial.printf("⚠️ Step journal: skipped %u torn/corrupt records\n", recoveredTornRecords);
+  }
+
+  if (!journalTaskHandle) {
+    xTaskCreatePinnedToCore(
+      journalTask,
+      "StepJournal",
+      JOURNAL_TASK_STACK_SIZE,
+      nullptr,
+      JOURNAL_TASK_PRIORITY,
+      &journalTaskHandle,
+      JOURNAL_TASK_CORE
+    );
+  }
+  return found;
+}
+
+static bool postRequest(JournalOp op, const StepCounts& counts) {
+  if (journalTaskHandle) {
+    portENTER_CRITICAL(&journalMux);
+    if (op == JOURNAL_ERASE) {
+      pendingOps = JOURNAL_ERASE;
+    } else {
+      pendingOps |= op;
+      postedCounts = counts;
+    }
+    portEXIT_CRITICAL(&journalMux);
+    xTaskNotifyGive(journalTaskHandle);
+    return true;
+  }
+  // No task (begin() not run or task creation failed): write through
+  if (op == JOURNAL_ERASE) return eraseSegments();
+  return commitRecord(counts);
+}
+
+bool StepJournal_stage(const StepCounts& counts) {
+  return postRequest(JOURNAL_STAGE, counts);
+}
+
+bool StepJournal_flush(const StepCounts& counts) {
+  return postRequest(JOURNAL_FLUSH, counts);
+}
+
+bool StepJournal_erase() {
+  return postRequest(JOURNAL_ERASE, StepCounts());
+}
+
+// Journal position and counters belong to the commit task: a snapshot
+StepJournalStats StepJournal_getStats() {
+  StepJournalStats stats;
+  stats.recoveredFrom = recoveredFrom;
+  stats.tornRecords = recoveredTornRecords;
+  stats.activeSegment = activeSegment;
+  stats.activeRecords = activeRecords;
+  stats.sequence = lastSequence;
+  stats.commits = commits;
+  stats.commitFailures = commitFailures;
+  return stats;
+}
+
+void StepJournal_printStatus() {
+  Serial.println("\n📒 Step Journal:");
+  Serial.printf("Segments: %u x %u records | Active: %u (%u used) | Sequence: %lu\n",
+                JOURNAL_SEGMENTS, SEGMENT_RECORDS, activeSegment, activeRecords, (unsigned long)lastSequence);
+  Serial.printf("Commits: %lu | Failures: %lu | ", (unsigned long)commits, (unsigned long)commitFailures);
+  if (lastCommitMs) Serial.printf("Last commit: %lus ago\n", (unsigned long)((millis() - lastCommitMs) / 1000));
+  else Serial.println("Last commit: never");
+  static const char* const SOURCES[] = {"none", "journal", "legacy file"};
+  Serial.printf("Boot recovery: %s, %u torn/corrupt records skipped\n",
+                SOURCES[recoveredFrom], recoveredTornRecords);
+  Serial.printf("Batching: every %lus or %lu steps, background task %s\n",
+                (unsigned long)(COMMIT_INTERVAL_MS / 1000), (unsigned long)COMMIT_BATCH_STEPS, journalTaskHandle ? "running" : "not running");
+}
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef STEPJOURNAL_H
+#define STEPJOURNAL_H
+
+#include <Arduino.h>
+
+// Append-only, CRC-checked step count journal on the SD card. Records are
+// appended to a small set of rotating segment files by a background task,
+// batched so the IMU path never waits on the card; the newest valid record
+// is recovered at boot and torn writes are skipped. A card with no journal
+// yet is migrated from the legacy single-block step file.
+struct StepCounts {
+  uint32_t dailySteps = 0;
+  uint32_t totalSteps = 0;
+  uint8_t lastResetDay = 0;
+  uint8_t lastResetMonth = 0;
+  uint16_t lastResetYear = 0;
+};
+
+enum StepJournalSource : uint8_t { STEP_SOURCE_NONE, STEP_SOURCE_JOURNAL, STEP_SOURCE_LEGACY };
+
+struct StepJournalStats {
+  StepJournalSource recoveredFrom;
+  uint16_t tornRecords;         // Torn/corrupt records skipped at boot
+  uint8_t activeSegment;
+  uint16_t activeRecords;       // Record slots used in the active segment
+  uint32_t sequence;            // Last committed
+  uint32_t commits;
+  uint32_t commitFailures;
+};
+
+bool StepJournal_begin(StepCounts& recovered);  // Recovery scan + commit task; false = no valid record
+// false = the request could not be handed over or written through
+bool StepJournal_stage(const StepCounts& counts);  // Committed with the next batch
+bool StepJournal_flush(const StepCounts& counts);  // Committed as soon as possible
+bool StepJournal_erase();                          // Factory reset: drop every segment and the legacy file
+StepJournalStats StepJournal_getStats();
+void StepJournal_printStatus();
+
+#endif // STEPJOURNAL_H
@@ -0,0 +1,156 @@
+#include "TTCEstimator.h"
+#include <math.h>
+
+// ============= Tracker Configuration =============
+// Alpha-beta tracker on filtered range (mm) with variable sample interval
+static const float TRACK_ALPHA = 0.5f;
+static const float TRACK_BETA = 0.1f;
+static const uint32_t MAX_SAMPLE_GAP_MS = 250;   // Longer gaps restart the track
+static const uint32_t STALE_TRACK_MS = 300;      // No sample for this long = estimate unusable
+static const float JUMP_RESET_MM = 300.0f;       // Range jumps are new/removed obstacles, not motion
+static const float CLEAR_RANGE_MM = 3450.0f;     // Near max range = nothing to track
+static const uint8_t MIN_TRACK_SAMPLES = 4;
+
+// ============= Motion Cross-Check =============
+static const float STEP_LENGTH_M = 0.65f;           // Typical step length for a cane user
+static const float STATIONARY_MOTION_ENERGY = 0.15f; // 30% of IMU MOTION_THRESH
+static const float MOVING_OBSTACLE_SPEED = 0.3f;    // m/s closing needed to alert a stationary user
+static const float MAX_OBSTACLE_SPEED = 2.5f;       // m/s on top of walking speed, above = noise
+static const float MIN_CLOSING_SPEED = 0.1f;        // m/s, below = not closing
+
+// ============= Alert Mapping =============
+// Time-to-contact thresholds (s) for levels 1..6, same scale as the buzzer bins
+static const float TTC_LEVEL_SECONDS[6] = {4.0f, 3.0f, 2.2f, 1.5f, 1.0f, 0.6f};
+static const uint32_t LEVEL_DROP_HOLD_MS = 500;     // Level must stay lower this long before dropping
+
+// ============= Tracker State =============
+static float trackDistance = 0;      // mm
+static float trackRate = 0;          // mm/s, negative when approaching
+static uint32_t lastSampleMs = 0;
+static uint8_t trackSamples = 0;
+static float motionEnergy = 0;
+static float stepCadence = 0;
+
+static int8_t alertLevel = 0;
+static uint32_t lowerLevelSince = 0;
+
+static void restartTrack(float distanceMm, uint32_t timestampMs) {
+  trackDistance = distanceMm;
+  trackRate = 0;
+  lastSampleMs = timestampMs;
+  trackSamples = 1;
+}
+
+// Closing speed after the IMU plausibility checks, NAN when implausible
+static float gatedClosingSpeed() {
+  float closing = -trackRate / 1000.0f;
+  float walkSpeed = stepCadence * STEP_LENGTH_M;
+
+  if (closing > walkSpeed + MAX_OBSTACLE_SPEED) return NAN;
+
+  // Standing still: only a clearly moving obstacle counts as closing
+  if (TTC_isUserStationary() && closing < MOVING_OBSTACLE_SPEED) return 0;
+
+  return closing;
+}
+
+void TTC_reset() {
+  trackSamples = 0;
+  trackRate = 0;
+  alertLevel = 0;
+  lowerLevelSince = 0;
+}
+
+void TTC_setMotionContext(float energy, float cadenceHz) {
+  motionEnergy = energy;
+  stepCadence = cadenceHz;
+}
+
+void TTC_addSample(float distanceMm, uint32_t timestampMs) {
+  if (distanceMm >= CLEAR_RANGE_MM) {
+    trackSamples = 0;
+    return;
+  }
+  if (trackSamples == 0) {
+    restartTrack(distanceMm, timestampMs);
+    return;
+  }
+
+  uint32_t gapMs = timestampMs - lastSampleMs;
+  if (gapMs == 0) return;
+  if (gapMs > MAX_SAMPLE_GAP_MS) {
+    restartTrack(distanceMm, timestampMs);
+    return;
+  }
+
+  float dt = gapMs / 1000.0f;
+  float predicted = trackDistance + trackRate * dt;
+  float residual = distanceMm - predicted;
+  if (fabs(residual) > JUMP_RESET_MM) {
+    restartTrack(distanceMm, timestampMs);
+    return;
+  }
+
+  trackDistance = predicted + TRACK_ALPHA * residual;
+  trackRate += (TRACK_BETA / dt) * residual;
+  lastSampleMs = timestampMs;
+  if (trackSamples < 255) trackSamples++;
+}
+
+bool TTC_isValid() {
+  return trackSamples >= MIN_TRACK_SAMPLES && !isnan(gatedClosingSpeed());
+}
+
+bool TTC_isUserStationary() {
+  return stepCadence <= 0 && motionEnergy < STATIONARY_MOTION_ENERGY;
+}
+
+float TTC_getClosingSpeed() {
+  if (trackSamples < MIN_TRACK_SAMPLES) return 0;
+  float closing = gatedClosingSpeed();
+  return isnan(closing) ? 0 : closing;
+}
+
+float TTC_getTimeToContact() {
+  if (!TTC_isValid()) return INFINITY;
+  float closing = gatedClosingSpeed();
+  if (closing < MIN_CLOSING_SPEED) return INFINITY;
+  return (trackDistance / 1000.0f) / closing;
+}
+
+int8_t TTC_getAlertLevel(float distanceMm, uint32_t currentTime) {
+  if (!TTC_isValid() || currentTime - lastSampleMs > STALE_TRACK_MS) {
+    alertLevel = 0;
+    lowerLevelSince = 0;
+    return -1;
+  }
+
+  // Proximity floor: close obstacles always alert, whatever the motion
+  float distance_cm = distanceMm / 10.0f;
+  int8_t level = 0;
+  if (distance_cm < 30.0f) level = 6;
+  else if (distance_cm < 40.0f) level = 5;
+  else if (distance_cm < 70.0f) level = 4;
+  else if (distance_cm < 140.0f) level = 1;  // Gentle presence cue only
+
+  // Escalate by time-to-contact
+  float ttc = TTC_getTimeToContact();
+  for (int8_t i = 5; i >= 0; i--) {
+    if (ttc < TTC_LEVEL_SECONDS[i]) {
+      if (i + 1 > level) level = i + 1;
+      break;
+    }
+  }
+
+  // Escalate immediately, de-escalate only after the lower level has held
+  if (level >= alertLevel) {
+    alertLevel = level;
+    lowerLevelSince = 0;
+  } else if (lowerLevelSince == 0) {
+    lowerLevelSince = currentTime;
+  } else if (currentTime - lowerLevelSince >= LEVEL_DROP_HOLD_MS) {
+    alertLevel = level;
+    lowerLevelSince = 0;
+  }
+  return alertLevel;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#ifndef TTCESTIMATOR_H
+#define TTCESTIMATOR_H
+
+#include <Arduino.h>
+
+// Time-to-contact estimation for the simple-mode obstacle alerts.
+// Closing speed is tracked from timestamped filtered ToF samples and
+// cross-checked against IMU motion energy and step cadence.
+void TTC_reset();
+void TTC_setMotionContext(float motionEnergy, float stepCadenceHz);
+void TTC_addSample(float distanceMm, uint32_t timestampMs);
+
+bool TTC_isValid();
+bool TTC_isUserStationary();
+float TTC_getClosingSpeed();     // m/s, positive when the obstacle is getting closer
+float TTC_getTimeToContact();    // seconds, INFINITY when not closing
+
+// Alert level 0-6 (same scale as the buzzer bins), or -1 when the
+// estimate is not usable and the caller should fall back to distance bins
+int8_t TTC_getAlertLevel(float distanceMm, uint32_t currentTime);
+
+#endif // TTCESTIMATOR_H
@@ -2,6 +2,11 @@
 #include "Pins.h"
 #include "BLEManager.h"
 #include "SensorHealth.h"
+#include "IMU.h"
+#include "TTCEstimator.h"
+#include "SignalFilters.h"
+#include "DropOffDetector.h"
+#include "Log.h"
 #include <Wire.h>
 #include <VL53L1X.h>
 #include <ESP32Servo.h>
@@ -10,9 +15,7 @@
 // ============= Sensor Configuration =============
 static VL53L1X sensor;
 static const uint8_t NUM_SAMPLES = 5;
-static uint16_t samples[NUM_SAMPLES];
-static uint8_t sampleIndex = 0;
-static uint8_t validSamples = 0;
+static MedianN<NUM_SAMPLES> distanceWindow;
 static float filteredDistance = 3500.0; // Initialize to max range
 static uint32_t lastModeSwitch = 0;
 static uint32_t lastAlert = 0;
@@ -47,13 +50,60 @@ static const uint16_t CRITICAL_DISTANCE_MM = 300;  // 30cm critical (reverted)
 static const uint16_t WARNING_DISTANCE_MM = 700;   // 70cm warning (reverted)
 static const uint32_t MODE_SWITCH_DELAY = 2000;
 static const uint16_t LONG_RANGE_TIMING = 33;
-static const uint16_t SHORT_RANGE_TIMING = 15;
+static const uint16_t SHORT_RANGE_TIMING = 20; // VL53L1X minimum budget for Short mode
 static const uint16_t STAIR_TIMING = 20;
-static const float ALPHA_MIN = 0.07f;  // Balanced for speed and safety
-static const float ALPHA_MID = 0.22f;  // Balanced for speed and safety
-static const float ALPHA_MAX = 0.35f;  // Balanced for speed and safety
-static const float CHANGE_THRESHOLD_SMALL = 3.0f;  // Reduced for faster response
-static const float CHANGE_THRESHOLD_LARGE = 20.0f; // Reduced for faster response
+
+// Stable EMA (SignalFilters.h) runs in fixed point; filteredDistance is its float output
+static StableEmaState emaState = stableEmaInit(MIN_DISTANCE_MM, MAX_LONG_DISTANCE_MM);
+
+// ============= Range Profile Controller =============
+// Simple mode picks distance mode + timing budget from range, walking speed and ambient light
+enum RangeProfile : uint8_t { PROFILE_LONG = 0, PROFILE_MEDIUM = 1, PROFILE_SHORT = 2 };
+struct RangeProfileConfig {
+  const char* name;
+  VL53L1X::DistanceMode distanceMode;
+  uint16_t timingBudgetMs;
+  uint16_t maxRangeMm;
+};
+static const RangeProfileConfig RANGE_PROFILES[3] = {
+  {"LONG",   VL53L1X::Long,   LONG_RANGE_TIMING,  MAX_LONG_DISTANCE_MM}, // Open path, full 3.5m reach
+  {"MEDIUM", VL53L1X::Medium, LONG_RANGE_TIMING,  2900},                 // Bright light or obstacle in mid range
+  {"SHORT",  VL53L1X::Short,  SHORT_RANGE_TIMING, 1300},                 // Approaching obstacle, ~50Hz updates
+};
+static RangeProfile activeProfile = PROFILE_LONG;
+static RangeProfile candidateProfile = PROFILE_LONG;
+static uint32_t candidateSince = 0;
+
+static const float SHORT_ENTER_MM = 1000.0f;     // Short mode reaches ~1.3m
+static const float SHORT_EXIT_MM = 1200.0f;
+static const float MEDIUM_ENTER_MM = 2200.0f;
+static const float MEDIUM_EXIT_MM = 2600.0f;
+static const float APPROACH_SPEED = 0.2f;        // m/s closing or walking to count as approaching
+static const float BRIGHT_LUX_ENTER = 10000.0f;  // Long mode loses range in sunlight
+static const float BRIGHT_LUX_EXIT = 5000.0f;
+static const uint32_t PROFILE_CONFIRM_MS = 150;  // Candidate must persist before switching
+
+// Reconfiguration stops ranging and disturbs the filter, so switches are budgeted
+static const uint8_t RECONFIG_TOKENS_MAX = 4;
+static const uint32_t RECONFIG_TOKEN_REFILL_MS = 3000;
+static uint8_t reconfigTokens = RECONFIG_TOKENS_MAX;
+static uint32_t lastTokenRefill = 0;
+static uint32_t profileSwitches = 0;
+static uint32_t profileSwitchesDenied = 0;
+
+struct ProfileDecision {
+  uint32_t timeMs;
+  RangeProfile from;
+  RangeProfile to;
+  uint16_t distanceMm;
+  uint16_t speedCmS;   // max(walking, closing) speed
+  uint32_t lux;
+  const char* reason;
+};
+static const uint8_t PROFILE_LOG_SIZE = 8;
+static ProfileDecision profileLog[PROFILE_LOG_SIZE];
+static uint8_t profileLogHead = 0;
+static uint8_t profileLogCount = 0;
 
 // Buzzer hysteresis to prevent flickering
 static uint8_t lastBuzzerLevel = 0;
@@ -70,6 +120,9 @@ static bool isSensorStuck() {
          (consecutiveMaxReadings > MAX_CONSECUTIVE_MAX_READINGS);
 }
 
+static void logProfileDecision(uint32_t currentTime, RangeProfile to, float speed, float lux, const char* reason);
+static void applyRangeProfile(RangeProfile profile);
+
 static void resetSensor() {
   Serial.println("🔄 ToF Sensor Reset - Reinitializing...");
   
@@ -77,22 +130,23 @@ static void resetSensor() {
   sensor.stopContinuous();
   delay(100);
   
-  // Reconfigure sensor - call the static function directly
-  sensor.setDistanceMode(VL53L1X::Long);
-  sensor.setMeasurementTimingBudget(LONG_RANGE_TIMING * 1000);
-  sensor.startContinuous(20);
+  // Back to the open-path profile, through the controller so tofprofile shows why
+  extern SensorData sensorData;
+  logProfileDecision(millis(), PROFILE_LONG, 0.0f, sensorData.lightLux, "sensor reset");
+  applyRangeProfile(PROFILE_LONG);
+  candidateProfile = PROFILE_LONG;
   
   // Reset all variables
   filteredDistance = MAX_LONG_DISTANCE_MM;
+  emaState.filtered = toQDist(MAX_LONG_DISTANCE_MM);
+  emaState.lastStable = emaState.filtered;
   consecutiveMaxReadings = 0;
   lastValidReading = millis();
   
   // Clear sample buffer
-  for (uint8_t i = 0; i < NUM_SAMPLES; i++) {
-    samples[i] = MAX_LONG_DISTANCE_MM;
-  }
-  sampleIndex = 0;
-  validSamples = 0;
+  distanceWindow.reset();
+  TTC_reset();
+  DropOff_reset();
   
   Serial.println("✅ ToF Sensor Reset Complete");
 }
@@ -101,10 +155,9 @@ static void resetSensor() {
 static void configureSensor(OperationMode mode);
 static void updateBuzzer();
 static void updateBuffer(uint16_t value);
-static uint16_t getMedianDistance();
-static void applyStableEMA(float newDistance);
 static void checkDistanceAlerts(uint16_t distance, uint32_t currentTime);
 static void handleModeSwitching(uint32_t currentTime);
+static bool readSimpleSample(uint16_t& dist, bool& noTarget);
 static void printStatus();
 static void printCurrentConfig();
 
@@ -113,7 +166,6 @@ static void runRadarScan();
 static void radarScanTask(void* parameter);
 static uint16_t getQuickDistanceReading();
 static void moveServoToAngle(int angle);
-static uint16_t getMedianReading(uint16_t readings[], int count);
 static void analyzeRadarData();
 static const char* getSafestDirection();
 static void printRadarResults();
@@ -150,7 +202,6 @@ void ToF_init() {
   SensorHealthManager::updateSensorHealth("vl53l1x", SENSOR_OK, "VL53L1X initialized");
   configureSensor(SIMPLE_MODE);
   sensor.startContinuous(30);
-  for (uint8_t i = 0; i < NUM_SAMPLES; i++) samples[i] = MAX_LONG_DISTANCE_MM;
 #ifdef SC_DEBUG_TOF
   Serial.println(F("\nVL53L1X Smart Cane System Initialized"));
   Serial.println(F("========================================"));
@@ -179,15 +230,22 @@ void ToF_update(SensorData* data) {
     }
   } else {
     // Simple Mode: Original fixed ToF logic
-    if (sensor.dataReady()) {
-      uint16_t rawDist = sensor.read();
-      
-      // Error Detection: Check for stuck sensor
-      if (rawDist >= MAX_LONG_DISTANCE_MM - 50) {
+    uint16_t rawDist;
+    bool noTarget;
+    if (readSimpleSample(rawDist, noTarget)) {
+      // Error Detection: Check for stuck sensor. A short-mode "no target" status is
+      // the sensor answering that the path is clear, not a stuck reading.
+      if (noTarget) {
+        consecutiveMaxReadings = 0;
+        lastValidReading = currentTime;
+        SensorHealthManager::updateSensorHealth("vl53l1x", SENSOR_OK, "no target");
+      } else if (rawDist >= MAX_LONG_DISTANCE_MM - 50) {
         consecutiveMaxReadings++;
         if (consecutiveMaxReadings > MAX_CONSECUTIVE_MAX_READINGS) {
-          Serial.println("⚠️ ToF Sensor appears stuck at max range");
-          SensorHealthManager::updateSensorHealth("vl53l1x", SENSOR_ERROR, nullptr, "Sensor stuck at max range");
+          if (consecutiveMaxReadings == MAX_CONSECUTIVE_MAX_READINGS + 1) {   // Report once, not per sample
+            LOG_WARN(LOG_CAT_TOF, "⚠️ ToF Sensor appears stuck at max range\n");
+            SensorHealthManager::updateSensorHealth("vl53l1x", SENSOR_ERROR, nullptr, "Sensor stuck at max range");
+          }
           if (currentTime - lastValidReading > ERROR_RECOVERY_TIMEOUT) {
             resetSensor();
             return;
@@ -201,18 +259,24 @@ void ToF_update(SensorData* data) {
       }
       
       updateBuffer(rawDist);
-      uint16_t medianDist = getMedianDistance();
+      uint16_t medianDist = distanceWindow.median();
       
       // Debug: Show raw vs filtered values with adaptive speed
       static uint32_t lastDebugTime = 0;
       if (currentTime - lastDebugTime > 500) { // Every 500ms
         const char* speedMode[] = {"Conservative", "Balanced", "Fast"};
-        Serial.printf("ToF Debug: Raw=%d, Median=%d, Filtered=%.1f, Mode=%s [SIMPLE MODE]\n", 
-                      rawDist, medianDist, filteredDistance, speedMode[adaptiveSpeed-1]);
+        LOG_DEBUG(LOG_CAT_TOF, "ToF Debug: Raw=%d, Median=%d, Filtered=%.1f, Mode=%s, Vc=%.2fm/s, TTC=%.1fs [SIMPLE MODE]\n", 
+                      rawDist, medianDist, filteredDistance, speedMode[adaptiveSpeed-1],
+                      TTC_getClosingSpeed(), TTC_getTimeToContact());
         lastDebugTime = currentTime;
       }
       
-      applyStableEMA(medianDist);
+      stableEmaStep(emaState, medianDist, currentTime, adaptiveSpeed);
+      filteredDistance = fromQDist(emaState.filtered);
+      TTC_setMotionContext(IMU_getMotionEnergy(), IMU_getStepCadence());
+      TTC_addSample(filteredDistance, currentTime);
+      // Drop-offs show up as sudden range increases, so use the median rather than the EMA
+      DropOff_update(medianDist, IMU_getPitch(), RANGE_PROFILES[activeProfile].maxRangeMm, currentTime);
       checkDistanceAlerts(static_cast<uint16_t>(filteredDistance), currentTime);
       
       // Extra safety feedback for blind users - alert on rapid changes
@@ -222,7 +286,7 @@ void ToF_update(SensorData* data) {
       
       if (distanceChange > 100.0f && currentTime - lastChangeTime > 1000) {
         // Significant distance change - provide extra feedback
-        Serial.printf("⚠️ Distance change: %.1f cm\n", distanceChange / 10.0f);
+        LOG_WARN(LOG_CAT_TOF, "⚠️ Distance change: %.1f cm\n", distanceChange / 10.0f);
         lastChangeTime = currentTime;
       }
       lastDistance = filteredDistance;
@@ -244,14 +308,9 @@ void ToF_update(SensorData* data) {
     printStatus();
     lastPrint = millis();
   }
-  // TEMPORARILY DISABLED: Automatic mode switching
-  // handleModeSwitching(millis());
-  // if (currentMode == STAIR_DETECTION_MODE &&
-  //     filteredDistance > 1000 &&
-  //     millis() - lastModeSwitch > 5000) {
-  //   Serial.println(F("\u21a9\ufe0f Returning to long range mode"));
-  //   configureSensor(LONG_RANGE_MODE);
-  // }
+  if (currentMode == SIMPLE_MODE) {
+    handleModeSwitching(millis());
+  }
 }
 
 // ============= Sensor Configuration =============
@@ -270,6 +329,8 @@ static void configureSensor(OperationMode mode) {
   }
   sensor.startContinuous(20);
   currentMode = mode;
+  activeProfile = PROFILE_LONG;
+  candidateProfile = PROFILE_LONG;
   lastModeSwitch = millis();
   Serial.print(F("\n🔄 Switched to mode: "));
   switch (mode) {
@@ -301,35 +362,56 @@ static void updateBuzzer() {
     lastDebugTime = currentMillis;
   }
   
-  // Determine new level based on distance
-  if (distance_cm >= 180.0f) newLevel = 0;
-  else if (distance_cm >= 140.0f) newLevel = 1;
-  else if (distance_cm >= 100.0f) newLevel = 2;
-  else if (distance_cm >= 70.0f) newLevel = 3;
-  else if (distance_cm >= 40.0f) newLevel = 4;
-  else if (distance_cm >= 30.0f) newLevel = 5;
-  else newLevel = 6;
-  
-  // Apply hysteresis to prevent flickering
-  if (newLevel != lastBuzzerLevel) {
-    if (newLevel > lastBuzzerLevel) {
-      // Moving closer - use lower threshold
-      if (distance_cm >= (180.0f - BUZZER_HYSTERESIS_CM)) newLevel = 0;
-      else if (distance_cm >= (140.0f - BUZZER_HYSTERESIS_CM)) newLevel = 1;
-      else if (distance_cm >= (100.0f - BUZZER_HYSTERESIS_CM)) newLevel = 2;
-      else if (distance_cm >= (70.0f - BUZZER_HYSTERESIS_CM)) newLevel = 3;
-      else if (distance_cm >= (40.0f - BUZZER_HYSTERESIS_CM)) newLevel = 4;
-      else if (distance_cm >= (30.0f - BUZZER_HYSTERESIS_CM)) newLevel = 5;
-      else newLevel = 6;
-    } else {
-      // Moving away - use higher threshold
-      if (distance_cm >= (180.0f + BUZZER_HYSTERESIS_CM)) newLevel = 0;
-      else if (distance_cm >= (140.0f + BUZZER_HYSTERESIS_CM)) newLevel = 1;
-      else if (distance_cm >= (100.0f + BUZZER_HYSTERESIS_CM)) newLevel = 2;
-      else if (distance_cm >= (70.0f + BUZZER_HYSTERESIS_CM)) newLevel = 3;
-      else if (distance_cm >= (40.0f + BUZZER_HYSTERESIS_CM)) newLevel = 4;
-      else if (distance_cm >= (30.0f + BUZZER_HYSTERESIS_CM)) newLevel = 5;
-      else newLevel = 6;
+  // Drop-off / step alert overrides the distance pattern with fast even pulses
+  if (currentMode == SIMPLE_MODE && DropOff_isAlertActive(currentMillis)) {
+    bool pulseOn = ((currentMillis / 120) % 2) == 0;
+    if (feedbackMode == FEEDBACK_MODE_BOTH || feedbackMode == FEEDBACK_MODE_BUZZER) {
+      digitalWrite(BUZZER_PIN, pulseOn ? LOW : HIGH);
+    }
+    if (feedbackMode == FEEDBACK_MODE_BOTH || feedbackMode == FEEDBACK_MODE_VIBRATION) {
+      digitalWrite(VIB1_PIN, pulseOn ? HIGH : LOW);
+      digitalWrite(VIB2_PIN, pulseOn ? HIGH : LOW);
+    }
+    currentLevel = -1; // Restart the level pattern once the alert ends
+    return;
+  }
+  
+  // Time-to-contact drives the level while the closing-speed estimate is usable
+  int8_t ttcLevel = (currentMode == SIMPLE_MODE) ? TTC_getAlertLevel(filteredDistance, currentMillis) : -1;
+  
+  if (ttcLevel >= 0) {
+    newLevel = ttcLevel;
+  } else {
+    // Fallback: determine new level based on distance bins
+    if (distance_cm >= 180.0f) newLevel = 0;
+    else if (distance_cm >= 140.0f) newLevel = 1;
+    else if (distance_cm >= 100.0f) newLevel = 2;
+    else if (distance_cm >= 70.0f) newLevel = 3;
+    else if (distance_cm >= 40.0f) newLevel = 4;
+    else if (distance_cm >= 30.0f) newLevel = 5;
+    else newLevel = 6;
+    
+    // Apply hysteresis to prevent flickering
+    if (newLevel != lastBuzzerLevel) {
+      if (newLevel > lastBuzzerLevel) {
+        // Moving closer - use lower threshold
+        if (distance_cm >= (180.0f - BUZZER_HYSTERESIS_CM)) newLevel = 0;
+        else if (distance_cm >= (140.0f - BUZZER_HYSTERESIS_CM)) newLevel = 1;
+        else if (distance_cm >= (100.0f - BUZZER_HYSTERESIS_CM)) newLevel = 2;
+        else if (distance_cm >= (70.0f - BUZZER_HYSTERESIS_CM)) newLevel = 3;
+        else if (distance_cm >= (40.0f - BUZZER_HYSTERESIS_CM)) newLevel = 4;
+        else if (distance_cm >= (30.0f - BUZZER_HYSTERESIS_CM)) newLevel = 5;
+        else newLevel = 6;
+      } else {
+        // Moving away - use higher threshold
+        if (distance_cm >= (180.0f + BUZZER_HYSTERESIS_CM)) newLevel = 0;
+        else if (distance_cm >= (140.0f + BUZZER_HYSTERESIS_CM)) newLevel = 1;
+        else if (distance_cm >= (100.0f + BUZZER_HYSTERESIS_CM)) newLevel = 2;
+        else if (distance_cm >= (70.0f + BUZZER_HYSTERESIS_CM)) newLevel = 3;
+        else if (distance_cm >= (40.0f + BUZZER_HYSTERESIS_CM)) newLevel = 4;
+        else if (distance_cm >= (30.0f + BUZZER_HYSTERESIS_CM)) newLevel = 5;
+        else newLevel = 6;
+      }
     }
   }
   
@@ -398,128 +480,8 @@ static void updateBuzzer() {
 
 // ============= Filtering & Processing =============
 static void updateBuffer(uint16_t value) {
-  uint16_t maxDist = (currentMode == SIMPLE_MODE) ? MAX_LONG_DISTANCE_MM : MAX_LONG_DISTANCE_MM;
-  if (value > maxDist) value = maxDist;
-  samples[sampleIndex] = value;
-  sampleIndex = (sampleIndex + 1) % NUM_SAMPLES;
-  if (validSamples < NUM_SAMPLES) validSamples++;
-}
-
-static uint16_t getMedianDistance() {
-  uint16_t temp[NUM_SAMPLES];
-  uint8_t count = validSamples < NUM_SAMPLES ? validSamples : NUM_SAMPLES;
-  memcpy(temp, samples, count * sizeof(uint16_t));
-  for (uint8_t i = 1; i < count; i++) {
-    uint16_t key = temp[i];
-    int8_t j = i - 1;
-    while (j >= 0 && temp[j] > key) {
-      temp[j + 1] = temp[j];
-      j--;
-    }
-    temp[j + 1] = key;
-  }
-  return temp[count >> 1];
-}
-
-static void applyStableEMA(float newDistance) {
-  static uint8_t initCount = 0;
-  static float lastStableDistance = 3500.0;
-  static uint32_t lastLargeChangeTime = 0;
-  static bool recoveringFromObstacle = false;
-  static uint8_t consecutiveStableReadings = 0;
-  
-  if (initCount < 8) {  // Balanced initialization
-    if (newDistance >= MIN_DISTANCE_MM && newDistance <= MAX_LONG_DISTANCE_MM) {
-      filteredDistance = (filteredDistance * initCount + newDistance) / (initCount + 1);
-      lastStableDistance = filteredDistance;
-      initCount++;
-    }
-    return;
-  }
-  
-  // Check for sudden large changes (outliers)
-  float change = fabs(newDistance - lastStableDistance);
-  uint32_t currentTime = millis();
-  
-      // SAFETY FIRST: Immediate response to new obstacles (critical for blind users)
-    if (newDistance < lastStableDistance - 25.0f && newDistance < 1500.0f) {
-      // New obstacle detected - IMMEDIATE response for safety
-      recoveringFromObstacle = false;
-      consecutiveStableReadings = 0;
-      // adaptiveSpeed = 1; // TEMPORARILY DISABLED: Conservative mode for safety
-      filteredDistance = newDistance; // Immediate response
-      lastStableDistance = filteredDistance;
-      return;
-    }
-  
-  // Smart adaptive recovery from obstacle removal
-  if (newDistance > lastStableDistance + 35.0f && lastStableDistance < 800.0f) {
-    // Obstacle was removed - use adaptive recovery
-    recoveringFromObstacle = true;
-    lastLargeChangeTime = currentTime;
-    consecutiveStableReadings = 0;
-    
-    // Adaptive recovery based on environment stability
-    float recoveryRate = 0.95f; // Almost instant jump
-    if (adaptiveSpeed == 3) recoveryRate = 1.0f;   // Full jump in one cycle
-    else if (adaptiveSpeed == 1) recoveryRate = 0.9f; // Still fast
-    
-    filteredDistance = lastStableDistance + (newDistance - lastStableDistance) * recoveryRate;
-  }
-  // Normal filtering with adaptive speed
-  else if (change <= 70.0f) {
-    float alpha = ALPHA_MID;
-    if (change > CHANGE_THRESHOLD_LARGE) alpha = ALPHA_MAX;
-    else if (change < CHANGE_THRESHOLD_SMALL) alpha = ALPHA_MIN;
-    
-    // Adaptive alpha based on environment stability
-    if (recoveringFromObstacle && newDistance > filteredDistance) {
-      if (adaptiveSpeed == 3) alpha = ALPHA_MAX * 1.2f; // Fast recovery
-      else if (adaptiveSpeed == 1) alpha = ALPHA_MAX * 0.7f; // Conservative
-      else alpha = ALPHA_MAX * 0.9f; // Balanced
-    }
-    
-    filteredDistance = alpha * newDistance + (1 - alpha) * filteredDistance;
-    
-    // Track stable readings and adjust adaptive speed
-    if (change < 15.0f) {
-      consecutiveStableReadings++;
-      // TEMPORARILY DISABLED: Mode switching
-      // if (consecutiveStableReadings > 8 && adaptiveSpeed < 3) {
-      //   adaptiveSpeed++; // Increase speed in stable environment
-      // }
-    } else {
-      consecutiveStableReadings = 0;
-      // TEMPORARILY DISABLED: Mode switching
-      // if (change > 50.0f && adaptiveSpeed > 1) {
-      //   adaptiveSpeed--; // Decrease speed in unstable environment
-      // }
-    }
-  }
-  // Large change - adaptive conservative approach
-  else {
-    float conservativeRate = 0.12f; // Balanced default
-    if (adaptiveSpeed == 1) conservativeRate = 0.08f; // More conservative
-    else if (adaptiveSpeed == 3) conservativeRate = 0.18f; // Less conservative
-    
-    filteredDistance = lastStableDistance + (newDistance - lastStableDistance) * conservativeRate;
-    consecutiveStableReadings = 0;
-  }
-  
-  // Smart recovery reset based on environment
-  uint32_t resetTimeout = (adaptiveSpeed == 1) ? 3500 : (adaptiveSpeed == 3) ? 2000 : 2500;
-  uint8_t requiredStableReadings = (adaptiveSpeed == 1) ? 6 : (adaptiveSpeed == 3) ? 3 : 4;
-  
-  if (recoveringFromObstacle && (currentTime - lastLargeChangeTime > resetTimeout || consecutiveStableReadings > requiredStableReadings)) {
-    recoveringFromObstacle = false;
-  }
-  
-  // Ensure bounds
-  if (filteredDistance > MAX_LONG_DISTANCE_MM) filteredDistance = MAX_LONG_DISTANCE_MM;
-  if (filteredDistance < MIN_DISTANCE_MM) filteredDistance = MIN_DISTANCE_MM;
-  
-  // Update stable distance reference
-  lastStableDistance = filteredDistance;
+  if (value > MAX_LONG_DISTANCE_MM) value = MAX_LONG_DISTANCE_MM;
+  distanceWindow.push(value);
 }
 
 // ============= Alert Handling =============
@@ -540,43 +502,131 @@ static void checkDistanceAlerts(uint16_t distance, uint32_t currentTime) {
 }
 
 // ============= Mode Management =============
+// Short mode cannot see past ~1.3m, so its range status decides what a reading means:
+// no target is a clear path, a clipped or failed minimum range is an obstacle closer
+// than the sensor can measure, and any other failure (wrap check, sigma, hardware)
+// is dropped rather than reported either way. Returns false when there is no sample;
+// noTarget is set for the clear-path case.
+static bool readSimpleSample(uint16_t& dist, bool& noTarget) {
+  noTarget = false;
+  if (!sensor.dataReady()) return false;
+  dist = sensor.read();
+  if (activeProfile != PROFILE_SHORT) return true;
+  switch (sensor.ranging_data.range_status) {
+    case VL53L1X::RangeValid:
+      return true;
+    case VL53L1X::SignalFail:
+    case VL53L1X::OutOfBoundsFail:
+    case VL53L1X::None:
+      dist = MAX_LONG_DISTANCE_MM;
+      noTarget = true;
+      return true;
+    case VL53L1X::RangeValidMinRangeClipped:
+    case VL53L1X::MinRangeFail:
+      dist = MIN_DISTANCE_MM;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static void applyRangeProfile(RangeProfile profile) {
+  const RangeProfileConfig& cfg = RANGE_PROFILES[profile];
+  sensor.stopContinuous();
+  sensor.setDistanceMode(cfg.distanceMode);
+  sensor.setMeasurementTimingBudget(cfg.timingBudgetMs * 1000UL);
+  sensor.startContinuous(cfg.timingBudgetMs + 2);
+  activeProfile = profile;
+}
+
+static void logProfileDecision(uint32_t currentTime, RangeProfile to, float speed, float lux, const char* reason) {
+  ProfileDecision& entry = profileLog[profileLogHead];
+  entry.timeMs = currentTime;
+  entry.from = activeProfile;
+  entry.to = to;
+  entry.distanceMm = static_cast<uint16_t>(filteredDistance);
+  entry.speedCmS = static_cast<uint16_t>(speed * 100.0f);
+  entry.lux = static_cast<uint32_t>(lux);
+  entry.reason = reason;
+  profileLogHead = (profileLogHead + 1) % PROFILE_LOG_SIZE;
+  if (profileLogCount < PROFILE_LOG_SIZE) profileLogCount++;
+#ifdef SC_DEBUG_TOF
+  Serial.printf("📐 ToF profile %s -> %s (%s, %.0fcm, %.2fm/s, %.0f lux)\n",
+                RANGE_PROFILES[activeProfile].name, RANGE_PROFILES[to].name, reason,
+                filteredDistance / 10.0f, speed, lux);
+#endif
+}
+
 static void handleModeSwitching(uint32_t currentTime) {
-  // TEMPORARILY DISABLED: Automatic mode switching
-  // if (currentTime - lastModeSwitch < MODE_SWITCH_DELAY) return;
-  // static uint16_t lastDist = MAX_LONG_DISTANCE_MM;
-  // if (currentMode != STAIR_DETECTION_MODE &&
-  //     abs(filteredDistance - lastDist) > 200 &&
-  //     filteredDistance < 800) {
-  //   Serial.println(F("⛰️ Possible stair detected - activating stair mode"));
-  //   configureSensor(STAIR_DETECTION_MODE);
-  // }
-  // lastDist = filteredDistance;
+  extern SensorData sensorData;
+  float lux = sensorData.lightLux;
+  float walkSpeed = TTC_isUserStationary() ? 0.0f : IMU_getStepCadence() * 0.65f;
+  float closing = TTC_getClosingSpeed();
+  float speed = (closing > walkSpeed) ? closing : walkSpeed;
+  bool approaching = speed > APPROACH_SPEED;
+  bool bright = (activeProfile == PROFILE_LONG) ? (lux > BRIGHT_LUX_ENTER) : (lux > BRIGHT_LUX_EXIT);
+  
+  // Refill reconfiguration budget
+  if (currentTime - lastTokenRefill >= RECONFIG_TOKEN_REFILL_MS) {
+    if (reconfigTokens < RECONFIG_TOKENS_MAX) reconfigTokens++;
+    lastTokenRefill = currentTime;
+  }
+  
+  // Desired profile with distance hysteresis around the active one
+  RangeProfile desired = PROFILE_LONG;
+  const char* reason = "open path";
+  float shortLimit = (activeProfile == PROFILE_SHORT) ? SHORT_EXIT_MM : SHORT_ENTER_MM;
+  float mediumLimit = (activeProfile == PROFILE_LONG) ? MEDIUM_ENTER_MM : MEDIUM_EXIT_MM;
+  if (filteredDistance < shortLimit && (approaching || activeProfile == PROFILE_SHORT)) {
+    desired = PROFILE_SHORT;
+    reason = "approach";
+  } else if (bright) {
+    desired = PROFILE_MEDIUM;
+    reason = "bright light";
+  } else if (filteredDistance < mediumLimit && approaching) {
+    desired = PROFILE_MEDIUM;
+    reason = "mid range";
+  }
+  
+  if (desired != candidateProfile) {
+    candidateProfile = desired;
+    candidateSince = currentTime;
+  }
+  if (desired == activeProfile || currentTime - candidateSince < PROFILE_CONFIRM_MS) return;
+  
+  // Moving to a shorter, faster profile is safety relevant; relaxing back waits out the dwell time
+  bool relaxing = desired < activeProfile;
+  if (relaxing && currentTime - lastModeSwitch < MODE_SWITCH_DELAY) return;
+  if (reconfigTokens == 0) {
+    static uint32_t lastDeniedLog = 0;
+    profileSwitchesDenied++;
+    if (currentTime - lastDeniedLog > 1000) {
+      logProfileDecision(currentTime, desired, speed, lux, "denied: budget");
+      lastDeniedLog = currentTime;
+    }
+    return;
+  }
+  
+  reconfigTokens--;
+  logProfileDecision(currentTime, desired, speed, lux, reason);
+  applyRangeProfile(desired);
+  lastModeSwitch = currentTime;
+  profileSwitches++;
 }
 
 // ============= System Status =============
 static void printStatus() {
   float distance_cm = filteredDistance / 10.0f;
-  Serial.print(F("📏 "));
+  const char* mode = (currentMode == RADAR_MODE) ? "RADAR" : "SIMPLE";
+  const char* alert = alertActive ? " | ⚠️ ALERT" : "";
   if (distance_cm >= (MAX_LONG_DISTANCE_MM/10.0f) - 5) {
-    Serial.print(F("CLEAR"));
+    LOG_INFO(LOG_CAT_TOF, "📏 CLEAR | Mode: %s%s\n", mode, alert);
   } else if (distance_cm < (MIN_DISTANCE_MM/10.0f)) {
-    Serial.print(F("DANGER "));
-    Serial.print(distance_cm, 0);
-    Serial.print(F("cm"));
+    LOG_INFO(LOG_CAT_TOF, "📏 DANGER %.0fcm | Mode: %s%s\n", distance_cm, mode, alert);
   } else {
-    Serial.print(distance_cm, 0);
-    Serial.print(F("cm"));
-    if (distance_cm < (WARNING_DISTANCE_MM/10.0f)) {
-      Serial.print(F(" ⚠️"));
-    }
-  }
-  Serial.print(F(" | Mode: "));
-  switch (currentMode) {
-    case SIMPLE_MODE: Serial.print(F("SIMPLE")); break;
-    case RADAR_MODE: Serial.print(F("RADAR")); break;
+    const char* warning = (distance_cm < (WARNING_DISTANCE_MM/10.0f)) ? " ⚠️" : "";
+    LOG_INFO(LOG_CAT_TOF, "📏 %.0fcm%s | Mode: %s%s\n", distance_cm, warning, mode, alert);
   }
-  if (alertActive) Serial.print(F(" | ⚠️ ALERT"));
-  Serial.println();
 }
 
 static void printCurrentConfig() {
@@ -597,6 +647,7 @@ static void printCurrentConfig() {
 void ToF_switchToRadarMode() {
   if (currentMode != RADAR_MODE) {
     Serial.println(F("🔄 Switching to RADAR MODE"));
+    if (activeProfile != PROFILE_LONG) applyRangeProfile(PROFILE_LONG);
     currentMode = RADAR_MODE;
     radarModeActive = true;
     
@@ -724,20 +775,6 @@ static void moveServoToAngle(int angle) {
   // No delay for real-time performance - servo moves while we process next angle
 }
 
-static uint16_t getMedianReading(uint16_t readings[], int count) {
-  // Simple bubble sort for median
-  for (int i = 0; i < count - 1; i++) {
-    for (int j = 0; j < count - i - 1; j++) {
-      if (readings[j] > readings[j + 1]) {
-        uint16_t temp = readings[j];
-        readings[j] = readings[j + 1];
-        readings[j + 1] = temp;
-      }
-    }
-  }
-  return readings[count / 2]; // Return median
-}
-
 static void analyzeRadarData() {
   // Find safest direction
   const char* safestDir = getSafestDirection();
@@ -810,6 +847,107 @@ void ToF_manualReset() {
   resetSensor();
 }
 
+// On-device golden check and cycle benchmark for the simple-mode filter chain
+void ToF_runFilterBenchmark() {
+  static const uint16_t BENCH_SAMPLES = 2000;
+  Serial.println("\n⏱️ ToF Filter Benchmark:");
+  Serial.println("================================");
+  
+  // Deterministic trace: slow walk toward a wall with noise, dropouts and spikes
+  uint32_t seed = 0x1234567;
+  auto nextRandom = [&seed]() { seed = seed * 1664525UL + 1013904223UL; return seed >> 16; };
+  static uint16_t trace[BENCH_SAMPLES];
+  for (uint16_t i = 0; i < BENCH_SAMPLES; i++) {
+    int32_t value = 3000 - (i % 500) * 5 + (int32_t)(nextRandom() % 41) - 20;
+    uint32_t r = nextRandom() % 100;
+    if (r < 3) value = MAX_LONG_DISTANCE_MM;          // dropout
+    else if (r < 5) value = nextRandom() % 400;       // spurious near return
+    else if (r < 8) value = value - (value % 64);     // duplicates
+    trace[i] = (uint16_t)constrain(value, 0, (int32_t)MAX_LONG_DISTANCE_MM);
+  }
+  
+  // Golden: network median must equal a full insertion sort of the same window
+  MedianN<NUM_SAMPLES> window;
+  uint16_t reference[NUM_SAMPLES];
+  uint16_t mismatches = 0;
+  for (uint16_t i = 0; i < BENCH_SAMPLES; i++) {
+    window.push(trace[i]);
+    uint8_t n = (i + 1 < NUM_SAMPLES) ? i + 1 : NUM_SAMPLES;
+    for (uint8_t k = 0; k < n; k++) reference[k] = trace[i + 1 - n + k];
+    MedianN<NUM_SAMPLES>::insertionSort(reference, n);
+    if (window.median() != reference[n >> 1]) mismatches++;
+  }
+  Serial.printf("Median golden check: %s (%u/%u mismatches)\n",
+                mismatches == 0 ? "✅ PASS" : "❌ FAIL", mismatches, BENCH_SAMPLES);
+  
+  // Golden: Q-format blend must track the float formula to within 1/8 mm
+  float maxError = 0;
+  const float gains[] = {EMA_ALPHA_MIN, EMA_ALPHA_MID, EMA_ALPHA_MAX, EMA_ALPHA_MAX * 1.2f, 0.08f, 0.18f, 0.9f, 1.0f};
+  for (uint16_t i = 0; i < BENCH_SAMPLES; i++) {
+    float from = trace[i];
+    float to = trace[(i * 7 + 3) % BENCH_SAMPLES];
+    float gain = gains[i % 8];
+    float expected = from + (to - from) * gain;
+    float actual = fromQDist(qBlend(toQDist(from), toQDist(to), qGain(gain)));
+    float error = fabs(actual - expected);
+    if (error > maxError) maxError = error;
+  }
+  Serial.printf("EMA fixed-point check: %s (max error %.3f mm)\n",
+                maxError <= 0.125f ? "✅ PASS" : "❌ FAIL", maxError);
+  
+  // Cycles per sample: insertion sort baseline vs network median
+  volatile uint16_t sink = 0;
+  uint32_t start = ESP.getCycleCount();
+  for (uint16_t i = 0; i < BENCH_SAMPLES; i++) {
+    for (uint8_t k = 0; k < NUM_SAMPLES; k++) reference[k] = trace[(i + k) % BENCH_SAMPLES];
+    MedianN<NUM_SAMPLES>::insertionSort(reference, NUM_SAMPLES);
+    sink = reference[NUM_SAMPLES >> 1];
+  }
+  uint32_t insertionCycles = ESP.getCycleCount() - start;
+  
+  window.reset();
+  start = ESP.getCycleCount();
+  for (uint16_t i = 0; i < BENCH_SAMPLES; i++) {
+    window.push(trace[i]);
+    sink = window.median();
+  }
+  uint32_t networkCycles = ESP.getCycleCount() - start;
+  
+  // Full stable EMA on a scratch state so the live filter is untouched
+  StableEmaState scratch = stableEmaInit(MIN_DISTANCE_MM, MAX_LONG_DISTANCE_MM);
+  start = ESP.getCycleCount();
+  for (uint16_t i = 0; i < BENCH_SAMPLES; i++) {
+    stableEmaStep(scratch, trace[i], i * 33, adaptiveSpeed);
+  }
+  uint32_t emaCycles = ESP.getCycleCount() - start;
+  (void)sink;
+  
+  Serial.printf("Insertion sort median: %lu cycles/sample\n", insertionCycles / BENCH_SAMPLES);
+  Serial.printf("Network median (ring): %lu cycles/sample\n", networkCycles / BENCH_SAMPLES);
+  Serial.printf("Stable EMA (Q4/Q15):   %lu cycles/sample\n", emaCycles / BENCH_SAMPLES);
+  Serial.println("================================\n");
+}
+
+void ToF_printProfileLog() {
+  Serial.println("\n📐 ToF Range Profile:");
+  Serial.printf("Active: %s (%dms budget)\n", RANGE_PROFILES[activeProfile].name,
+                RANGE_PROFILES[activeProfile].timingBudgetMs);
+  Serial.printf("Switches: %lu | Denied by budget: %lu | Tokens: %d/%d\n",
+                profileSwitches, profileSwitchesDenied, reconfigTokens, RECONFIG_TOKENS_MAX);
+  if (profileLogCount == 0) {
+    Serial.println("No profile decisions logged yet");
+    return;
+  }
+  Serial.println("Recent decisions (oldest first):");
+  uint8_t start = (profileLogHead + PROFILE_LOG_SIZE - profileLogCount) % PROFILE_LOG_SIZE;
+  for (uint8_t i = 0; i < profileLogCount; i++) {
+    const ProfileDecision& entry = profileLog[(start + i) % PROFILE_LOG_SIZE];
+    Serial.printf("  %8lums %-6s -> %-6s %4dcm %4.2fm/s %6lu lux  %s\n",
+                  entry.timeMs, RANGE_PROFILES[entry.from].name, RANGE_PROFILES[entry.to].name,
+                  entry.distanceMm / 10, entry.speedCmS / 100.0f, entry.lux, entry.reason);
+  }
+}
+
 void ToF_diagnostics() {
   Serial.println("\n🔧 ToF Sensor Diagnostics:");
   Serial.println("================================");
@@ -826,6 +964,8 @@ void ToF_diagnostics() {
   // Check sensor initialization status
   Serial.printf("Current Mode: %s\n", currentMode == RADAR_MODE ? "RADAR" : "SIMPLE");
   Serial.printf("Radar Mode Active: %s\n", radarModeActive ? "Yes" : "No");
+  Serial.printf("Drop-off Detector: %s (expected ground %.0fmm, surface %.0fmm)\n",
+                DropOff_getStateName(), DropOff_getExpectedGroundMm(), DropOff_getSurfaceHeightMm());
   
   // Test sensor data ready status
   Serial.print("Sensor Data Ready: ");
@@ -16,6 +16,8 @@ void ToF_manualReset();
 
 // Diagnostic Function
 void ToF_diagnostics();
+void ToF_printProfileLog();
+void ToF_runFilterBenchmark();
 
 // Getter functions for BLE access
 OperationMode ToF_getCurrentMode();
@@ -0,0 +1,624 @@
+#include "TrackLogger.h"
+#include "SDCardManager.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <math.h>
+
+#define TRACK_TASK_STACK_SIZE 4096
+#define TRACK_TASK_PRIORITY 1
+#define TRACK_TASK_CORE 0
+#define TRACK_MAX_RECORD 40
+#define TRACK_MAX_STEP_MS 65535         // Longer gaps start a keyframe
+#define TRACK_ALT_STEP_DM 10            // Deadbands: smaller changes are not logged
+#define TRACK_SPEED_STEP_CMS 20
+#define TRACK_HDOP_STEP 20
+
+// ============= Block Format =============
+// [TrackBlockHeader][payload: `used` bytes of records, zero padded][CRC-32
+// of everything before it]. Blocks decode on their own: each starts with a
+// keyframe, and a file is whole blocks, so every block sits on a sector.
+//   0xFF keyframe: flags (bit 0: time is uptime), time ms (varint), lat,
+//        lon, alt dm (zigzag varints), speed cm/s, HDOP x100 (varints),
+//        satellites (byte)
+//   other: delta record; the header bits say what follows:
+//        0x01 time step changed (zigzag vs the previous step), then always
+//        lat and lon (zigzag residual vs previous + previous step), then
+//        0x02 alt, 0x04 speed, 0x08 HDOP (zigzag deltas), 0x10 satellites
+static const uint32_t TRACK_MAGIC = 0x314B5254;  // "TRK1"
+static const uint8_t RECORD_KEYFRAME = 0xFF;
+static const uint8_t DELTA_STEP = 0x01;
+static const uint8_t DELTA_ALT = 0x02;
+static const uint8_t DELTA_SPEED = 0x04;
+static const uint8_t DELTA_HDOP = 0x08;
+static const uint8_t DELTA_SATS = 0x10;
+static const uint8_t KEY_UPTIME = 0x01;
+
+struct TrackBlockHeader {       // 12 bytes
+  uint32_t magic;
+  uint32_t sequence;            // Within the file
+  uint16_t used;                // Payload bytes
+  uint16_t points;
+};
+
+#define TRACK_PAYLOAD (TRACK_BLOCK_SIZE - sizeof(TrackBlockHeader) - 4)
+
+// What the decoder will know after the last record; deltas are against it
+struct TrackCodecState {
+  uint16_t used;
+  uint16_t points;
+  bool uptimeClock;
+  uint64_t timeMs;
+  uint64_t keyframeMs;
+  uint32_t stepMs;
+  int32_t latE7;
+  int32_t lonE7;
+  int32_t dLat;                 // Last step, for the prediction
+  int32_t dLon;
+  int32_t altDm;
+  uint16_t speedCms;
+  uint16_t hdopCenti;
+  uint8_t satellites;
+};
+
+#define METERS_PER_E7_LAT 0.011119493f
+
+// ============= State =============
+static uint8_t pool[TRACK_BLOCK_POOL][TRACK_BLOCK_SIZE];
+static uint16_t blockFile[TRACK_BLOCK_POOL];     // File index each queued block goes to
+static QueueHandle_t freeBlocks = nullptr;
+static QueueHandle_t fullBlocks = nullptr;
+static TaskHandle_t writerTaskHandle = nullptr;
+
+// GPS task only
+static TrackCodecState encoder;
+static int8_t currentBlock = -1;
+static uint32_t blockSequence = 0;
+static uint32_t blockStartMs = 0;
+static bool haveLast = false;
+static TrackPoint lastLogged;
+static uint64_t lastLoggedMs = 0;
+static uint16_t activeFile = 0;                  // File of the session being encoded
+
+static volatile bool recording = false;
+static volatile bool startRequested = false;
+static volatile bool stopRequested = false;
+static uint16_t nextFileIndex = 0;
+static volatile uint16_t sessionFile = 0;
+
+static TrackPoint history[TRACK_HISTORY];
+static uint8_t historyHead = 0;
+static uint8_t historyCount = 0;
+static portMUX_TYPE historyMux = portMUX_INITIALIZER_UNLOCKED;
+
+static TrackLogStats stats = {};
+static uint32_t encodeCyclesTotal = 0;
+
+// ============= Codec =============
+static inline uint64_t zigzag(int64_t value) {
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t value) {
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static uint8_t putVarint(uint8_t* out, uint64_t value) {
+  uint8_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)value | 0x80;
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+static bool getVarint(const uint8_t* data, uint16_t end, uint16_t* pos, uint64_t* value) {
+  *value = 0;
+  for (uint8_t shift = 0; shift < 64 && *pos < end; shift += 7) {
+    uint8_t byte = data[(*pos)++];
+    *value |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+static void resetCodec(TrackCodecState& state) {
+  memset(&state, 0, sizeof(state));
+}
+
+// Appends one fix to the block payload; false when it does not fit
+static bool encodePoint(TrackCodecState& state, uint8_t* payload, const TrackPoint& point, uint64_t timeMs,
+                        bool uptimeClock) {
+  uint8_t record[TRACK_MAX_RECORD];
+  uint8_t n = 1;
+  bool keyframe = state.points == 0 || uptimeClock != state.uptimeClock || timeMs <= state.timeMs ||
+                  timeMs - state.timeMs > TRACK_MAX_STEP_MS || timeMs - state.keyframeMs >= TRACK_KEYFRAME_MS;
+  TrackCodecState next = state;
+  if (keyframe) {
+    record[0] = RECORD_KEYFRAME;
+    record[n++] = uptimeClock ? KEY_UPTIME : 0;
+    n += putVarint(record + n, timeMs);
+    n += putVarint(record + n, zigzag(point.latE7));
+    n += putVarint(record + n, zigzag(point.lonE7));
+    n += putVarint(record + n, zigzag(point.altDm));
+    n += putVarint(record + n, point.speedCms);
+    n += putVarint(record + n, point.hdopCenti);
+    record[n++] = point.satellites;
+    next.uptimeClock = uptimeClock;
+    next.keyframeMs = timeMs;
+    next.stepMs = 0;
+    next.dLat = next.dLon = 0;
+    next.altDm = point.altDm;
+    next.speedCms = point.speedCms;
+    next.hdopCenti = point.hdopCenti;
+    next.satellites = point.satellites;
+  } else {
+    uint8_t flags = 0;
+    uint32_t step = (uint32_t)(timeMs - state.timeMs);
+    if (step != state.stepMs) {
+      flags |= DELTA_STEP;
+      n += putVarint(record + n, zigzag((int64_t)step - state.stepMs));
+    }
+    n += putVarint(record + n, zigzag((int64_t)point.latE7 - (state.latE7 + state.dLat)));
+    n += putVarint(record + n, zigzag((int64_t)point.lonE7 - (state.lonE7 + state.dLon)));
+    if (abs(point.altDm - state.altDm) >= TRACK_ALT_STEP_DM) {
+      flags |= DELTA_ALT;
+      n += putVarint(record + n, zigzag((int64_t)point.altDm - state.altDm));
+      next.altDm = point.altDm;
+    }
+    if (abs((int32_t)point.speedCms - state.speedCms) >= TRACK_SPEED_STEP_CMS) {
+      flags |= DELTA_SPEED;
+      n += putVarint(record + n, zigzag((int32_t)point.speedCms - state.speedCms));
+      next.speedCms = point.speedCms;
+    }
+    if (abs((int32_t)point.hdopCenti - state.hdopCenti) >= TRACK_HDOP_STEP) {
+      flags |= DELTA_HDOP;
+      n += putVarint(record + n, zigzag((int32_t)point.hdopCenti - state.hdopCenti));
+      next.hdopCenti = point.hdopCenti;
+    }
+    if (point.satellites != state.satellites) {
+      flags |= DELTA_SATS;
+      record[n++] = point.satellites;
+      next.satellites = point.satellites;
+    }
+    record[0] = flags;
+    next.stepMs = step;
+    next.dLat = point.latE7 - state.latE7;
+    next.dLon = point.lonE7 - state.lonE7;
+  }
+  if (state.used + n > TRACK_PAYLOAD) return false;
+  memcpy(payload + state.used, record, n);
+  next.used = state.used + n;
+  next.points = state.points + 1;
+  next.timeMs = timeMs;
+  next.latE7 = point.latE7;
+  next.lonE7 = point.lonE7;
+  state = next;
+  return true;
+}
+
+static void finishBlock(uint8_t* block, const TrackCodecState& state, uint32_t sequence) {
+  TrackBlockHeader header = {TRACK_MAGIC, sequence, state.used, state.points};
+  memcpy(block, &header, sizeof(header));
+  memset(block + sizeof(header) + state.used, 0, TRACK_PAYLOAD - state.used);
+  uint32_t crc = SDCard_crc32(block, TRACK_BLOCK_SIZE - 4);
+  memcpy(block + TRACK_BLOCK_SIZE - 4, &crc, sizeof(crc));
+}
+
+// Self-test only; track_convert.py is the real decoder. Returns fixes, -1 if corrupt.
+static int decodeBlock(const uint8_t* block, TrackPoint* out, uint16_t maxPoints, bool* uptimeClock) {
+  TrackBlockHeader header;
+  memcpy(&header, block, sizeof(header));
+  uint32_t crc;
+  memcpy(&crc, block + TRACK_BLOCK_SIZE - 4, sizeof(crc));
+  if (header.magic != TRACK_MAGIC || header.used > TRACK_PAYLOAD || crc != SDCard_crc32(block, TRACK_BLOCK_SIZE - 4)) {
+    return -1;
+  }
+  const uint8_t* payload = block + sizeof(header);
+  TrackCodecState state;
+  resetCodec(state);
+  uint16_t pos = 0;
+  int count = 0;
+  uint64_t v;
+  while (pos < header.used && count < maxPoints) {
+    uint8_t flags = payload[pos++];
+    TrackPoint& p = out[count];
+    if (flags == RECORD_KEYFRAME) {
+      if (pos >= header.used) return -1;
+      state.uptimeClock = payload[pos++] & KEY_UPTIME;
+      if (!getVarint(payload, header.used, &pos, &v)) return -1;
+      state.timeMs = v;
+      state.stepMs = 0;
+      state.dLat = state.dLon = 0;
+      if (!getVarint(payload, header.used, &pos, &v)) return -1;
+      state.latE7 = unzigzag(v);
+      if (!getVarint(payload, header.used, &pos, &v)) return -1;
+      state.lonE7 = unzigzag(v);
+      if (!getVarint(payload, header.used, &pos, &v)) return -1;
+      state.altDm = unzigzag(v);
+      if (!getVarint(payload, header.used, &pos, &v)) return -1;
+      state.speedCms = v;
+      if (!getVarint(payload, header.used, &pos, &v)) return -1;
+      state.hdopCenti = v;
+      if (pos >= header.used) return -1;
+      state.satellites = payload[pos++];
+    } else {
+      if (flags & DELTA_STEP) {
+        if (!getVarint(payload, header.used, &pos, &v)) return -1;
+        state.stepMs += unzigzag(v);
+      }
+      state.timeMs += state.stepMs;
+      if (!getVarint(payload, header.used, &pos, &v)) return -1;
+      int32_t lat = state.latE7 + state.dLat + unzigzag(v);
+      if (!getVarint(payload, header.used, &pos, &v)) return -1;
+      int32_t lon = state.lonE7 + state.dLon + unzigzag(v);
+      state.dLat = lat - state.latE7;
+      state.dLon = lon - state.lonE7;
+      state.latE7 = lat;
+      state.lonE7 = lon;
+      if (flags & DELTA_ALT) {
+        if (!getVarint(payload, header.used, &pos, &v)) return -1;
+        state.altDm += unzigzag(v);
+      }
+      if (flags & DELTA_SPEED) {
+        if (!getVarint(payload, header.used, &pos, &v)) return -1;
+        state.speedCms += unzigzag(v);
+      }
+      if (flags & DELTA_HDOP) {
+        if (!getVarint(payload, header.used, &pos, &v)) return -1;
+        state.hdopCenti += unzigzag(v);
+      }
+      if (flags & DELTA_SATS) {
+        if (pos >= header.used) return -1;
+        state.satellites = payload[pos++];
+      }
+    }
+    p.utcMs = state.timeMs;
+    p.latE7 = state.latE7;
+    p.lonE7 = state.lonE7;
+    p.altDm = state.altDm;
+    p.speedCms = state.speedCms;
+    p.hdopCenti = state.hdopCenti;
+    p.satellites = state.satellites;
+    count++;
+  }
+  *uptimeClock = state.uptimeClock;
+  return count;
+}
+
+static float stepDistanceM(const TrackPoint& a, const TrackPoint& b) {
+  float north = (b.latE7 - a.latE7) * METERS_PER_E7_LAT;
+  float east = (b.lonE7 - a.lonE7) * METERS_PER_E7_LAT * cosf(a.latE7 * 1e-7f * DEG_TO_RAD);
+  return sqrtf(north * north + east * east);
+}
+
+// Standing still: slow, barely moved, and the heartbeat is not due
+static bool isStill(const TrackPoint& last, uint64_t lastMs, const TrackPoint& point, uint64_t timeMs) {
+  return point.speedCms < TRACK_STILL_SPEED_CMS && timeMs > lastMs && timeMs - lastMs < TRACK_HEARTBEAT_MS &&
+         stepDistanceM(last, point) < TRACK_STILL_MOVE_M;
+}
+
+// ============= Writer Task =============
+static void writerTask(void* parameter) {
+  uint8_t index;
+  char path[32];
+  for (;;) {
+    if (xQueueReceive(fullBlocks, &index, portMAX_DELAY) != pdTRUE) continue;
+    snprintf(path, sizeof(path), "%s/trk_%05u.bin", TRACK_DIR, blockFile[index]);
+    uint32_t start = millis();
+    if (SDCard_appendFile(path, pool[index], TRACK_BLOCK_SIZE)) {
+      stats.blocksWritten++;
+    } else {
+      stats.writeFailures++;
+    }
+    uint32_t elapsed = millis() - start;
+    if (elapsed > stats.maxWriteMs) stats.maxWriteMs = elapsed;
+    xQueueSend(freeBlocks, &index, 0);
+  }
+}
+
+// ============= GPS Task Side =============
+static bool openBlock() {
+  uint8_t index;
+  if (xQueueReceive(freeBlocks, &index, 0) != pdTRUE) return false;
+  currentBlock = index;
+  resetCodec(encoder);
+  blockStartMs = millis();
+  return true;
+}
+
+static void closeBlock() {
+  if (currentBlock < 0) return;
+  uint8_t index = currentBlock;
+  currentBlock = -1;
+  if (encoder.points == 0) {
+    xQueueSend(freeBlocks, &index, 0);
+    return;
+  }
+  finishBlock(pool[index], encoder, blockSequence++);
+  blockFile[index] = activeFile;
+  xQueueSend(fullBlocks, &index, 0);   // Pool-sized queue: never full
+}
+
+void TrackLog_record(const TrackPoint& point) {
+  if (!recording || startRequested || stopRequested) return;
+  uint32_t startCycles = ESP.getCycleCount();
+  bool uptimeClock = point.utcMs == 0;
+  uint64_t timeMs = uptimeClock ? millis() : point.utcMs;
+  if (haveLast && isStill(lastLogged, lastLoggedMs, point, timeMs)) {
+    stats.stillSkipped++;
+    return;
+  }
+  if (currentBlock < 0 && !openBlock()) {
+    stats.dropped++;
+    return;
+  }
+  uint16_t usedBefore = encoder.used;
+  bool keyframe = false;
+  uint8_t* payload = pool[currentBlock] + sizeof(TrackBlockHeader);
+  if (!encodePoint(encoder, payload, point, timeMs, uptimeClock)) {
+    closeBlock();
+    if (!openBlock()) {
+      stats.dropped++;
+      return;
+    }
+    usedBefore = 0;
+    payload = pool[currentBlock] + sizeof(TrackBlockHeader);
+    encodePoint(encoder, payload, point, timeMs, uptimeClock);
+  }
+  keyframe = payload[usedBefore] == RECORD_KEYFRAME;
+  if (keyframe) stats.keyframes++;
+  stats.payloadBytes += encoder.used - usedBefore;
+  if (haveLast) stats.distanceM += stepDistanceM(lastLogged, point);
+  stats.points++;
+  lastLogged = point;
+  lastLoggedMs = timeMs;
+  haveLast = true;
+
+  portENTER_CRITICAL(&historyMux);
+  history[historyHead] = point;
+  if (uptimeClock) history[historyHead].utcMs = 0;
+  historyHead = (historyHead + 1) % TRACK_HISTORY;
+  if (historyCount < TRACK_HISTORY) historyCount++;
+  portEXIT_CRITICAL(&historyMux);
+
+  uint32_t cycles = ESP.getCycleCount() - startCycles;
+  encodeCyclesTotal += cycles;
+  if (cycles > stats.maxEncodeCycles) stats.maxEncodeCycles = cycles;
+}
+
+void TrackLog_service() {
+  if (startRequested) {
+    closeBlock();                       // A restart's old block still goes to the old file
+    activeFile = sessionFile;
+    blockSequence = 0;
+    haveLast = false;
+    memset(&stats, 0, sizeof(stats));
+    stats.fileIndex = activeFile;
+    encodeCyclesTotal = 0;
+    recording = true;
+    startRequested = false;
+  }
+  if (stopRequested) {
+    closeBlock();
+    recording = false;
+    stopRequested = false;
+  }
+  if (currentBlock >= 0 && encoder.points > 0 && millis() - blockStartMs > TRACK_FLUSH_MS) closeBlock();
+  stats.recording = recording;
+}
+
+// ============= Public API =============
+static void findNextFileIndex() {
+  if (!SD.exists(TRACK_DIR)) SD.mkdir(TRACK_DIR);
+  File dir = SD.open(TRACK_DIR);
+  if (!dir) return;
+  File entry = dir.openNextFile();
+  while (entry) {
+    unsigned index;
+    const char* name = entry.name();
+    const char* slash = strrchr(name, '/');
+    if (slash) name = slash + 1;
+    if (sscanf(name, "trk_%5u.bin", &index) == 1 && index >= nextFileIndex) {
+      nextFileIndex = index + 1;
+    }
+    entry.close();
+    entry = dir.openNextFile();
+  }
+  dir.close();
+}
+
+bool TrackLog_begin() {
+  if (writerTaskHandle) return true;
+  freeBlocks = xQueueCreate(TRACK_BLOCK_POOL, sizeof(uint8_t));
+  fullBlocks = xQueueCreate(TRACK_BLOCK_POOL, sizeof(uint8_t));
+  if (!freeBlocks || !fullBlocks) return false;
+  for (uint8_t i = 0; i < TRACK_BLOCK_POOL; i++) xQueueSend(freeBlocks, &i, 0);
+  findNextFileIndex();
+  xTaskCreatePinnedToCore(writerTask, "TrackWriter", TRACK_TASK_STACK_SIZE, nullptr, TRACK_TASK_PRIORITY,
+                          &writerTaskHandle, TRACK_TASK_CORE);
+  return writerTaskHandle != nullptr;
+}
+
+// While recording this starts the next file; a pending stop is cancelled,
+// since the service would otherwise run it right after the start
+void TrackLog_start() {
+  if (!writerTaskHandle) return;
+  sessionFile = nextFileIndex++;
+  stopRequested = false;
+  startRequested = true;
+}
+
+void TrackLog_stop() {
+  if (recording || startRequested) stopRequested = true;
+}
+
+bool TrackLog_isRecording() {
+  return (recording || startRequested) && !stopRequested;
+}
+
+TrackLogStats TrackLog_getStats() {
+  TrackLogStats copy = stats;
+  copy.recording = TrackLog_isRecording();
+  return copy;
+}
+
+uint8_t TrackLog_getHistory(TrackPoint* out, uint8_t maxPoints) {
+  portENTER_CRITICAL(&historyMux);
+  uint8_t count = min(historyCount, maxPoints);
+  for (uint8_t i = 0; i < count; i++) {
+    out[i] = history[(historyHead + TRACK_HISTORY - 1 - i) % TRACK_HISTORY];
+  }
+  portEXIT_CRITICAL(&historyMux);
+  return count;
+}
+
+void TrackLog_printStatus() {
+  TrackLogStats s = TrackLog_getStats();
+  Serial.println("\n🗺️ GPS Track Logger:");
+  if (!writerTaskHandle) {
+    Serial.println("   Not available (SD card)");
+    return;
+  }
+  if (!s.recording && s.points == 0) {
+    Serial.println("   Recording: OFF (gpslog on)");
+    return;
+  }
+  Serial.printf("   Recording: %s, %s/trk_%05u.bin\n", s.recording ? "ON" : "OFF", TRACK_DIR, s.fileIndex);
+  Serial.printf("   Fixes: %lu logged (%lu keyframes), %lu thinned while still, %lu dropped\n",
+                (unsigned long)s.points, (unsigned long)s.keyframes, (unsigned long)s.stillSkipped,
+                (unsigned long)s.dropped);
+  Serial.printf("   Distance: %.2f km\n", s.distanceM / 1000.0f);
+  Serial.printf("   Size: %lu blocks written (%lu KB), %.2f bytes/fix encoded, %lu write failures, max write %lu ms\n",
+                (unsigned long)s.blocksWritten, (unsigned long)(s.blocksWritten * TRACK_BLOCK_SIZE / 1024),
+                s.points ? (float)s.payloadBytes / s.points : 0.0f, (unsigned long)s.writeFailures,
+                (unsigned long)s.maxWriteMs);
+  Serial.printf("   Encode: %lu cycles avg, %lu max\n", (unsigned long)(s.points ? encodeCyclesTotal / s.points : 0),
+                (unsigned long)s.maxEncodeCycles);
+}
+
+void TrackLog_printFiles() {
+  File dir = SD.open(TRACK_DIR);
+  if (!dir) {
+    Serial.println("   No track files");
+    return;
+  }
+  uint16_t files = 0;
+  File entry = dir.openNextFile();
+  while (entry) {
+    Serial.printf("   %s  %lu KB\n", entry.name(), (unsigned long)((entry.size() + 1023) / 1024));
+    files++;
+    entry.close();
+    entry = dir.openNextFile();
+  }
+  dir.close();
+  if (files == 0) Serial.println("   No track files");
+  else Serial.println("   Convert on a PC: hardware/tools/track_convert.py trk_NNNNN.bin --gpx out.gpx");
+}
+
+// ============= Benchmark =============
+// A synthetic 5 Hz walk (turns, a stop, a GPS gap, noisy altitude/speed)
+// is encoded into blocks in RAM and decoded again: positions, time and
+// satellites must match exactly, the rest within its deadband.
+void TrackLog_runBenchmark() {
+  static const uint32_t FIXES = 6000;          // 20 minutes at 5 Hz
+  static const uint16_t MAX_BLOCKS = 96;
+  Serial.println("\n⏱️ Track Logger Benchmark:");
+  Serial.println("================================");
+  uint8_t* blocks = (uint8_t*)malloc(MAX_BLOCKS * TRACK_BLOCK_SIZE);
+  TrackPoint* logged = (TrackPoint*)malloc(FIXES * sizeof(TrackPoint));
+  if (!blocks || !logged) {
+    Serial.println("❌ Not enough memory");
+    free(blocks);
+    free(logged);
+    return;
+  }
+  uint32_t seed = 0x2045;
+  auto noise = [&seed](int32_t range) {
+    seed = seed * 1664525UL + 1013904223UL;
+    return (int32_t)((seed >> 16) % (2 * range + 1)) - range;
+  };
+  TrackCodecState state;
+  resetCodec(state);
+  uint16_t blockCount = 0;
+  uint32_t loggedCount = 0, skipped = 0, maxCycles = 0, totalCycles = 0;
+  TrackPoint point = {1760000000000ULL, 253823440, 683273230, 250, 0, 90, 9};
+  TrackPoint last = point;
+  uint64_t lastMs = 0;
+  float heading = 0;
+  bool overflow = false;
+  for (uint32_t i = 0; i < FIXES && !overflow; i++) {
+    point.utcMs += 200;
+    if (i >= 1500 && i < 1600) continue;                // 20 s without a fix
+    bool stopped = i >= 3000 && i < 3600;              // Two minutes at a crossing
+    heading += (i % 400 == 0) ? 1.57f : noise(10) * 0.002f;
+    float speed = stopped ? 0.0f : 1.3f + noise(20) * 0.01f;
+    point.latE7 += (int32_t)(cosf(heading) * speed * 0.2f / METERS_PER_E7_LAT) + noise(3);
+    point.lonE7 += (int32_t)(sinf(heading) * speed * 0.2f / (METERS_PER_E7_LAT * 0.903f)) + noise(3);
+    point.altDm = 250 + noise(8) + (int32_t)(i / 200);
+    point.speedCms = (uint16_t)(speed * 100 + (stopped ? noise(5) + 5 : 0));
+    point.hdopCenti = 90 + noise(15);
+    point.satellites = 9 + (i / 700) % 3;
+    if (loggedCount > 0 && isStill(last, lastMs, point, point.utcMs)) {
+      skipped++;
+      continue;
+    }
+    uint32_t start = ESP.getCycleCount();
+    if (blockCount == 0 || !encodePoint(state, blocks + (blockCount - 1) * TRACK_BLOCK_SIZE + sizeof(TrackBlockHeader),
+                                        point, point.utcMs, false)) {
+      if (blockCount > 0) finishBlock(blocks + (blockCount - 1) * TRACK_BLOCK_SIZE, state, blockCount - 1);
+      if (blockCount == MAX_BLOCKS) {
+        overflow = true;
+        break;
+      }
+      blockCount++;
+      resetCodec(state);
+      encodePoint(state, blocks + (blockCount - 1) * TRACK_BLOCK_SIZE + sizeof(TrackBlockHeader), point,
+                  point.utcMs, false);
+    }
+    uint32_t cycles = ESP.getCycleCount() - start;
+    totalCycles += cycles;
+    if (cycles > maxCycles) maxCycles = cycles;
+    logged[loggedCount++] = point;
+    last = point;
+    lastMs = point.utcMs;
+  }
+  if (blockCount > 0) finishBlock(blocks + (blockCount - 1) * TRACK_BLOCK_SIZE, state, blockCount - 1);
+
+  uint32_t decoded = 0, mismatches = 0;
+  static TrackPoint out[TRACK_PAYLOAD / 3];
+  for (uint16_t b = 0; b < blockCount; b++) {
+    bool uptimeClock;
+    int count = decodeBlock(blocks + b * TRACK_BLOCK_SIZE, out, TRACK_PAYLOAD / 3, &uptimeClock);
+    if (count < 0) {
+      mismatches++;
+      continue;
+    }
+    for (int i = 0; i < count && decoded < loggedCount; i++, decoded++) {
+      const TrackPoint& a = logged[decoded];
+      const TrackPoint& d = out[i];
+      if (a.utcMs != d.utcMs || a.latE7 != d.latE7 || a.lonE7 != d.lonE7 || a.satellites != d.satellites ||
+          abs(a.altDm - d.altDm) >= TRACK_ALT_STEP_DM || abs((int32_t)a.speedCms - d.speedCms) >= TRACK_SPEED_STEP_CMS ||
+          abs((int32_t)a.hdopCenti - d.hdopCenti) >= TRACK_HDOP_STEP) {
+        mismatches++;
+      }
+    }
+  }
+  bool pass = !overflow && decoded == loggedCount && mismatches == 0;
+  Serial.printf("Round trip: %s (%lu of %lu fixes, %lu mismatches)\n", pass ? "✅ PASS" : "❌ FAIL",
+                (unsigned long)decoded, (unsigned long)loggedCount, (unsigned long)mismatches);
+  uint32_t fileBytes = blockCount * TRACK_BLOCK_SIZE;
+  float bytesPerFix = loggedCount ? (float)fileBytes / loggedCount : 0;
+  Serial.printf("Fixes: %lu in, %lu logged, %lu thinned while still\n", (unsigned long)(FIXES - 100),
+                (unsigned long)loggedCount, (unsigned long)skipped);
+  Serial.printf("Size: %u blocks, %.2f bytes/fix with block overhead\n", blockCount, bytesPerFix);
+  Serial.printf("Projected: 5 Hz moving 24 h = %lu KB; 3 h walking + 21 h still = %lu KB\n",
+                (unsigned long)(bytesPerFix * 5 * 86400 / 1024),
+                (unsigned long)(bytesPerFix * (5 * 3 * 3600 + 21 * 3600000UL / TRACK_HEARTBEAT_MS) / 1024));
+  Serial.printf("Encode: %lu cycles avg, %lu max per fix\n", (unsigned long)(loggedCount ? totalCycles / loggedCount : 0),
+                (unsigned long)maxCycles);
+  Serial.println("================================");
+  free(blocks);
+  free(logged);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#ifndef TRACKLOGGER_H
+#define TRACKLOGGER_H
+
+#include <Arduino.h>
+
+// GPS track recorder. The GPS task encodes each fix into a 512-byte block in
+// RAM: a keyframe with absolute values starts every block (and follows any
+// gap), then each fix is a few bytes of varint deltas, with position
+// predicted from the previous step. Full blocks carry a CRC and are
+// appended to /tracks/trk_NNNNN.bin by a background task, so the GPS path
+// never waits on the SD card. Fixes while standing still are thinned to a
+// heartbeat. Convert with hardware/tools/track_convert.py.
+#define TRACK_DIR "/tracks"
+#define TRACK_BLOCK_SIZE 512
+#define TRACK_BLOCK_POOL 4              // Blocks in RAM: one filling, the rest queued for SD
+#define TRACK_KEYFRAME_MS 60000         // Absolute values at least this often
+#define TRACK_FLUSH_MS 30000            // A partial block is written after this long
+#define TRACK_STILL_SPEED_CMS 30        // Below this and within TRACK_STILL_MOVE_M: standing still
+#define TRACK_STILL_MOVE_M 2
+#define TRACK_HEARTBEAT_MS 30000        // One fix this often while standing still
+#define TRACK_HISTORY 16                // Recent logged fixes kept for gpshistory
+
+struct TrackPoint {
+  uint64_t utcMs;               // Unix ms; 0 = receiver time not known yet (uptime is logged)
+  int32_t latE7;
+  int32_t lonE7;
+  int32_t altDm;                // Above mean sea level, decimeters
+  uint16_t speedCms;
+  uint16_t hdopCenti;           // HDOP x 100
+  uint8_t satellites;
+};
+
+struct TrackLogStats {
+  bool recording;
+  uint16_t fileIndex;           // trk_NNNNN.bin of the session
+  uint32_t points;              // Fixes logged this session
+  uint32_t keyframes;
+  uint32_t stillSkipped;        // Thinned while standing still
+  uint32_t dropped;             // No free block (SD too slow)
+  uint32_t payloadBytes;        // Encoded fixes, without block overhead
+  uint32_t blocksWritten;
+  uint32_t writeFailures;
+  uint32_t maxWriteMs;
+  uint32_t maxEncodeCycles;
+  float distanceM;              // Along the logged fixes
+};
+
+bool TrackLog_begin();                              // Block pool, writer task
+void TrackLog_start();                              // New file from the next fix
+void TrackLog_stop();                               // Writes the partial block and closes the file
+bool TrackLog_isRecording();
+void TrackLog_record(const TrackPoint& point);      // GPS task, per fix; never blocks
+void TrackLog_service();                            // GPS task, per wake-up: start/stop/flush requests
+TrackLogStats TrackLog_getStats();
+uint8_t TrackLog_getHistory(TrackPoint* out, uint8_t maxPoints);   // Newest first
+void TrackLog_printStatus();
+void TrackLog_printFiles();
+void TrackLog_runBenchmark();                       // Encode/decode round trip on a synthetic walk
+
+#endif // TRACKLOGGER_H
@@ -0,0 +1,267 @@
+#include "UbxProtocol.h"
+
+enum UbxParserState : uint8_t {
+  UBX_STATE_SYNC1 = 0,
+  UBX_STATE_SYNC2,
+  UBX_STATE_CLASS,
+  UBX_STATE_ID,
+  UBX_STATE_LENGTH1,
+  UBX_STATE_LENGTH2,
+  UBX_STATE_PAYLOAD,
+  UBX_STATE_CK_A,
+  UBX_STATE_CK_B
+};
+
+// ============= Little-endian Fields =============
+static inline uint16_t readU2(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static inline uint32_t readU4(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+static inline int32_t readI4(const uint8_t* p) { return (int32_t)readU4(p); }
+static inline void writeU2(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static inline void writeU4(uint8_t* p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+
+// ============= Framing =============
+void Ubx_reset(UbxParser& parser) {
+  parser.state = UBX_STATE_SYNC1;
+}
+
+static inline void checksumAdd(UbxParser& parser, uint8_t byte) {
+  parser.ckA += byte;
+  parser.ckB += parser.ckA;
+}
+
+UbxFeedResult Ubx_feed(UbxParser& parser, uint8_t byte) {
+  switch (parser.state) {
+    case UBX_STATE_SYNC1:
+      if (byte != UBX_SYNC_1) return UBX_NOT_MINE;
+      parser.state = UBX_STATE_SYNC2;
+      return UBX_CONSUMED;
+    case UBX_STATE_SYNC2:
+      if (byte != UBX_SYNC_2) {
+        parser.state = UBX_STATE_SYNC1;
+        return UBX_NOT_MINE;
+      }
+      parser.ckA = parser.ckB = 0;
+      parser.state = UBX_STATE_CLASS;
+      return UBX_CONSUMED;
+    case UBX_STATE_CLASS:
+      parser.msgClass = byte;
+      checksumAdd(parser, byte);
+      parser.state = UBX_STATE_ID;
+      return UBX_CONSUMED;
+    case UBX_STATE_ID:
+      parser.msgId = byte;
+      checksumAdd(parser, byte);
+      parser.state = UBX_STATE_LENGTH1;
+      return UBX_CONSUMED;
+    case UBX_STATE_LENGTH1:
+      parser.length = byte;
+      checksumAdd(parser, byte);
+      parser.state = UBX_STATE_LENGTH2;
+      return UBX_CONSUMED;
+    case UBX_STATE_LENGTH2:
+      parser.length |= (uint16_t)byte << 8;
+      checksumAdd(parser, byte);
+      if (parser.length > UBX_MAX_PAYLOAD) {
+        // Not a frame we could hold (or a false sync): resynchronize
+        parser.oversized++;
+        parser.state = UBX_STATE_SYNC1;
+        return UBX_CONSUMED;
+      }
+      parser.index = 0;
+      parser.state = parser.length ? UBX_STATE_PAYLOAD : UBX_STATE_CK_A;
+      return UBX_CONSUMED;
+    case UBX_STATE_PAYLOAD:
+      parser.payload[parser.index++] = byte;
+      checksumAdd(parser, byte);
+      if (parser.index >= parser.length) parser.state = UBX_STATE_CK_A;
+      return UBX_CONSUMED;
+    case UBX_STATE_CK_A:
+      if (byte != parser.ckA) {
+        parser.checksumErrors++;
+        parser.state = UBX_STATE_SYNC1;
+        return UBX_CONSUMED;
+      }
+      parser.state = UBX_STATE_CK_B;
+      return UBX_CONSUMED;
+    case UBX_STATE_CK_B:
+      parser.state = UBX_STATE_SYNC1;
+      if (byte != parser.ckB) {
+        parser.checksumErrors++;
+        return UBX_CONSUMED;
+      }
+      parser.frames++;
+      return UBX_FRAME;
+    default:
+      parser.state = UBX_STATE_SYNC1;
+      return UBX_NOT_MINE;
+  }
+}
+
+size_t Ubx_buildFrame(uint8_t msgClass, uint8_t msgId, const uint8_t* payload, uint16_t length,
+                      uint8_t* out, size_t outSize) {
+  if (outSize < (size_t)length + UBX_FRAME_OVERHEAD) return 0;
+  out[0] = UBX_SYNC_1;
+  out[1] = UBX_SYNC_2;
+  out[2] = msgClass;
+  out[3] = msgId;
+  writeU2(out + 4, length);
+  if (length) memcpy(out + 6, payload, length);
+  uint8_t ckA = 0, ckB = 0;
+  for (size_t i = 2; i < (size_t)length + 6; i++) {
+    ckA += out[i];
+    ckB += ckA;
+  }
+  out[length + 6] = ckA;
+  out[length + 7] = ckB;
+  return length + UBX_FRAME_OVERHEAD;
+}
+
+// ============= NAV Decoders =============
+bool Ubx_decodePosllh(const uint8_t* payload, uint16_t length, UbxNavPosllh* out) {
+  if (length != 28) return false;
+  out->iTOW = readU4(payload);
+  out->lon = readI4(payload + 4);
+  out->lat = readI4(payload + 8);
+  out->heightMm = readI4(payload + 12);
+  out->hMslMm = readI4(payload + 16);
+  out->hAccMm = readU4(payload + 20);
+  out->vAccMm = readU4(payload + 24);
+  return true;
+}
+
+bool Ubx_decodeSol(const uint8_t* payload, uint16_t length, UbxNavSol* out) {
+  if (length != 52) return false;
+  out->iTOW = readU4(payload);
+  out->week = (int16_t)readU2(payload + 8);
+  out->gpsFix = payload[10];
+  out->flags = payload[11];
+  out->pAccCm = readU4(payload + 24);
+  out->pDop = readU2(payload + 44);
+  out->numSV = payload[47];
+  return true;
+}
+
+bool Ubx_decodeVelned(const uint8_t* payload, uint16_t length, UbxNavVelned* out) {
+  if (length != 36) return false;
+  out->iTOW = readU4(payload);
+  out->gSpeedCms = readU4(payload + 20);
+  out->heading = readI4(payload + 24);
+  out->sAccCms = readU4(payload + 28);
+  return true;
+}
+
+bool Ubx_decodeDop(const uint8_t* payload, uint16_t length, UbxNavDop* out) {
+  if (length != 18) return false;
+  out->iTOW = readU4(payload);
+  out->pDop = readU2(payload + 6);
+  out->vDop = readU2(payload + 10);
+  out->hDop = readU2(payload + 12);
+  return true;
+}
+
+// u-blox SV numbering: GPS 1-32, SBAS 120-158, GLONASS 65-96, BeiDou 33-64
+// and 159-163, Galileo 211-246
+static uint8_t systemFromSvid(uint8_t svid) {
+  if ((svid >= 1 && svid <= 32) || (svid >= 120 && svid <= 158)) return GNSS_GPS;
+  if (svid >= 65 && svid <= 96) return GNSS_GLONASS;
+  if ((svid >= 33 && svid <= 64) || (svid >= 159 && svid <= 163)) return GNSS_BEIDOU;
+  if (svid >= 211 && svid <= 246) return GNSS_GALILEO;
+  return GNSS_COUNT;
+}
+
+uint8_t Ubx_decodeSvInfo(const uint8_t* payload, uint16_t length, uint8_t system,
+                         Satellite* out, uint8_t maxCount) {
+  if (length < 8) return 0;
+  uint8_t channels = payload[4];
+  if (length < 8 + 12 * (uint16_t)channels) return 0;
+  uint8_t count = 0;
+  for (uint8_t ch = 0; ch < channels && count < maxCount; ch++) {
+    const uint8_t* block = payload + 8 + 12 * ch;
+    uint8_t svid = block[1];
+    if (svid == 0 || systemFromSvid(svid) != system) continue;
+    Satellite& sat = out[count++];
+    sat.prn = svid;
+    sat.active = block[2] & 0x01;
+    sat.snr = block[4] > 99 ? 99 : block[4];
+    sat.elevation = constrain((int8_t)block[5], -90, 90);
+    int16_t azimuth = (int16_t)readU2(block + 6);
+    sat.azimuth = (azimuth >= 0 && azimuth <= 359) ? azimuth : 0;
+    sat.system = system;
+    sat.quality = sat.snr * (0.5f + sat.elevation / 180.0f);
+  }
+  return count;
+}
+
+// ============= CFG Builders =============
+uint16_t Ubx_cfgPrtUart(uint8_t* payload, uint32_t baud) {
+  memset(payload, 0, 20);
+  payload[0] = 1;                    // UART1
+  writeU4(payload + 4, 0x000008D0);  // 8 data bits, no parity, 1 stop bit
+  writeU4(payload + 8, baud);
+  writeU2(payload + 12, 0x0003);     // In: UBX + NMEA
+  writeU2(payload + 14, 0x0003);     // Out: UBX + NMEA (NMEA messages are switched off one by one)
+  return 20;
+}
+
+uint16_t Ubx_cfgMsg(uint8_t* payload, uint8_t msgClass, uint8_t msgId, uint8_t rate) {
+  payload[0] = msgClass;
+  payload[1] = msgId;
+  payload[2] = rate;                 // Per navigation solution, on the current port
+  return 3;
+}
+
+uint16_t Ubx_cfgRate(uint8_t* payload, uint16_t measRateMs) {
+  writeU2(payload, measRateMs);
+  writeU2(payload + 2, 1);           // One solution per measurement
+  writeU2(payload + 4, 1);           // GPS time
+  return 6;
+}
+
+uint16_t Ubx_cfgNav5(uint8_t* payload, uint8_t dynModel, uint8_t minElevDeg) {
+  memset(payload, 0, 36);
+  writeU2(payload, 0x0003);          // Apply dynModel and minElev only
+  payload[2] = dynModel;
+  payload[12] = minElevDeg;
+  return 36;
+}
+
+uint16_t Ubx_cfgSbas(uint8_t* payload, bool enable) {
+  memset(payload, 0, 8);
+  payload[0] = enable ? 0x01 : 0x00;
+  payload[1] = 0x03;                 // Ranging + differential corrections
+  payload[2] = 3;                    // Up to 3 SBAS channels
+  return 8;
+}
+
+uint16_t Ubx_cfgRxm(uint8_t* payload, bool powerSave) {
+  payload[0] = 8;                    // Reserved, must be 8
+  payload[1] = powerSave ? 1 : 0;
+  return 2;
+}
+
+uint16_t Ubx_cfgRst(uint8_t* payload, uint16_t navBbrMask) {
+  writeU2(payload, navBbrMask);
+  payload[2] = 0x02;                 // Controlled software reset, GPS only
+  payload[3] = 0;
+  return 4;
+}
+
+uint16_t Ubx_aidIni(uint8_t* payload, int32_t latE7, int32_t lonE7, int32_t altCm, uint32_t posAccCm,
+                    int16_t week, uint32_t towMs, uint32_t timeAccMs) {
+  memset(payload, 0, 48);
+  writeU4(payload, (uint32_t)latE7);
+  writeU4(payload + 4, (uint32_t)lonE7);
+  writeU4(payload + 8, (uint32_t)altCm);
+  writeU4(payload + 12, posAccCm);
+  uint32_t flags = 0x01 | 0x20;      // Position valid, given as lat/lon/alt
+  if (week > 0) {
+    writeU2(payload + 18, (uint16_t)week);
+    writeU4(payload + 20, towMs);
+    writeU4(payload + 28, timeAccMs);
+    flags |= 0x02;                   // Time valid
+  }
+  writeU4(payload + 44, flags);
+  return 48;
+}
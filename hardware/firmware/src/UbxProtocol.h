@@ -0,0 +1,134 @@
+#pragma once
+#ifndef UBXPROTOCOL_H
+#define UBXPROTOCOL_H
+
+#include <Arduino.h>
+#include "SatelliteTable.h"
+
+// u-blox binary protocol as spoken by the NEO-6M (u-blox 6, protocol 7.03).
+// Frame: B5 62 | class | id | length (LE) | payload | CK_A CK_B, with an
+// 8-bit Fletcher checksum over class..payload. u-blox 6 predates NAV-PVT and
+// NAV-SAT; the same data comes from NAV-POSLLH/SOL/VELNED/DOP/SVINFO.
+
+#define UBX_SYNC_1 0xB5
+#define UBX_SYNC_2 0x62
+#define UBX_MAX_PAYLOAD 256     // NAV-SVINFO with 16 channels is 200
+#define UBX_FRAME_OVERHEAD 8
+
+#define UBX_CLASS_NAV 0x01
+#define UBX_CLASS_ACK 0x05
+#define UBX_CLASS_CFG 0x06
+#define UBX_CLASS_AID 0x0B
+#define UBX_CLASS_NMEA 0xF0
+
+#define UBX_NAV_POSLLH 0x02
+#define UBX_NAV_DOP 0x04
+#define UBX_NAV_SOL 0x06
+#define UBX_NAV_VELNED 0x12
+#define UBX_NAV_SVINFO 0x30
+#define UBX_ACK_NAK 0x00
+#define UBX_ACK_ACK 0x01
+#define UBX_CFG_PRT 0x00
+#define UBX_CFG_MSG 0x01
+#define UBX_CFG_RST 0x04
+#define UBX_CFG_RATE 0x08
+#define UBX_CFG_RXM 0x11
+#define UBX_CFG_SBAS 0x16
+#define UBX_CFG_NAV5 0x24
+#define UBX_AID_INI 0x01
+#define UBX_AID_ALM 0x30
+#define UBX_AID_EPH 0x31
+
+// AID-ALM/AID-EPH payloads: svid, week/HOW, then the subframe words. The
+// receiver answers a poll with the short form for satellites it has no data for.
+#define UBX_AID_ALM_BYTES 40
+#define UBX_AID_EPH_BYTES 104
+#define UBX_AID_EMPTY_BYTES 8
+
+// NAV5 dynamic platform models
+#define UBX_DYN_PORTABLE 0
+#define UBX_DYN_STATIONARY 2
+#define UBX_DYN_PEDESTRIAN 3
+#define UBX_DYN_AUTOMOTIVE 4
+
+enum UbxFeedResult : uint8_t {
+  UBX_NOT_MINE = 0,             // Byte is not part of a UBX frame (hand it to NMEA)
+  UBX_CONSUMED,
+  UBX_FRAME                     // parser.msgClass/msgId/length/payload hold a checked frame
+};
+
+struct UbxParser {
+  uint8_t state;
+  uint8_t msgClass;
+  uint8_t msgId;
+  uint16_t length;
+  uint16_t index;
+  uint8_t ckA;
+  uint8_t ckB;
+  uint32_t frames;
+  uint32_t checksumErrors;
+  uint32_t oversized;
+  uint8_t payload[UBX_MAX_PAYLOAD];
+};
+
+struct UbxNavPosllh {
+  uint32_t iTOW;                // ms
+  int32_t lon;                  // 1e-7 deg
+  int32_t lat;                  // 1e-7 deg
+  int32_t heightMm;             // Above ellipsoid
+  int32_t hMslMm;               // Above mean sea level
+  uint32_t hAccMm;
+  uint32_t vAccMm;
+};
+
+struct UbxNavSol {
+  uint32_t iTOW;
+  int16_t week;                 // GPS week
+  uint8_t gpsFix;               // 0 none, 1 DR, 2 2D, 3 3D, 4 GPS+DR, 5 time only
+  uint8_t flags;                // Bit 0 gpsFixOk, bits 2-3 week and time of week valid
+  uint32_t pAccCm;              // 3D position accuracy
+  uint16_t pDop;                // 0.01
+  uint8_t numSV;
+};
+
+struct UbxNavVelned {
+  uint32_t iTOW;
+  uint32_t gSpeedCms;           // Ground speed
+  int32_t heading;              // 1e-5 deg
+  uint32_t sAccCms;
+};
+
+struct UbxNavDop {
+  uint32_t iTOW;
+  uint16_t pDop;                // 0.01
+  uint16_t hDop;
+  uint16_t vDop;
+};
+
+void Ubx_reset(UbxParser& parser);
+UbxFeedResult Ubx_feed(UbxParser& parser, uint8_t byte);
+// Whole frame into out; returns its size or 0 if out is too small
+size_t Ubx_buildFrame(uint8_t msgClass, uint8_t msgId, const uint8_t* payload, uint16_t length,
+                      uint8_t* out, size_t outSize);
+
+bool Ubx_decodePosllh(const uint8_t* payload, uint16_t length, UbxNavPosllh* out);
+bool Ubx_decodeSol(const uint8_t* payload, uint16_t length, UbxNavSol* out);
+bool Ubx_decodeVelned(const uint8_t* payload, uint16_t length, UbxNavVelned* out);
+bool Ubx_decodeDop(const uint8_t* payload, uint16_t length, UbxNavDop* out);
+// Channels of one system into out (GPS includes SBAS); returns how many
+uint8_t Ubx_decodeSvInfo(const uint8_t* payload, uint16_t length, uint8_t system,
+                         Satellite* out, uint8_t maxCount);
+
+// CFG payload builders; each returns the payload length
+uint16_t Ubx_cfgPrtUart(uint8_t* payload, uint32_t baud);     // UART1, 8N1, UBX+NMEA in/out
+uint16_t Ubx_cfgMsg(uint8_t* payload, uint8_t msgClass, uint8_t msgId, uint8_t rate);
+uint16_t Ubx_cfgRate(uint8_t* payload, uint16_t measRateMs);
+uint16_t Ubx_cfgNav5(uint8_t* payload, uint8_t dynModel, uint8_t minElevDeg);
+uint16_t Ubx_cfgSbas(uint8_t* payload, bool enable);
+uint16_t Ubx_cfgRxm(uint8_t* payload, bool powerSave);
+uint16_t Ubx_cfgRst(uint8_t* payload, uint16_t navBbrMask);    // 0xFFFF cold, 0x0001 warm, 0 hot
+// AID-INI with a lat/lon/alt position; week <= 0 leaves the time out
+uint16_t Ubx_aidIni(uint8_t* payload, int32_t latE7, int32_t lonE7, int32_t altCm, uint32_t posAccCm,
+                    int16_t week, uint32_t towMs, uint32_t timeAccMs);
+
+#endif // UBXPROTOCOL_H
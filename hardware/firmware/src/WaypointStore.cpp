@@ -0,0 +1,689 @@
+#include "WaypointStore.h"
+#include "SDCardManager.h"
+#include <math.h>
+
+// ============= Grid Index =============
+// Points sit in one array; the index hashes (lat cell, lon cell) to a cell
+// entry holding the cell's projection and a run of slots in `order`, so the
+// points of a cell are contiguous. Rebuilt in O(n) by counting sort after
+// every edit (edits are rare, lookups happen on every fix).
+#define METERS_PER_DEG_LAT 111194.93f
+#define METERS_PER_E7_LAT (METERS_PER_DEG_LAT * 1e-7f)
+
+struct WaypointCell {
+  int32_t latCell;
+  int32_t lonCell;
+  float metersPerE7Lon;         // Equirectangular scale at the cell center
+  uint16_t first;               // Into order[]
+  uint8_t count;
+  uint8_t filled;               // Rebuild only
+  bool used;
+};
+
+struct WaypointGrid {
+  Waypoint* points;
+  uint16_t* order;
+  WaypointCell* cells;
+  uint16_t capacity;
+  uint16_t count;
+  uint16_t cellSlots;           // Power of two, at least twice the capacity
+  uint16_t cellsUsed;
+  uint8_t maxPerCell;
+  uint16_t unindexed;           // Points over WAYPOINT_MAX_PER_CELL (journal from another build)
+};
+
+static inline int32_t cellOf(int32_t e7) {
+  // Floor division, so cells do not straddle the equator or meridian
+  return e7 >= 0 ? e7 / WAYPOINT_CELL_E7 : -((-e7 + WAYPOINT_CELL_E7 - 1) / WAYPOINT_CELL_E7);
+}
+
+static inline uint16_t hashCell(int32_t latCell, int32_t lonCell, uint16_t mask) {
+  return (uint16_t)(((uint32_t)latCell * 73856093UL) ^ ((uint32_t)lonCell * 19349663UL)) & mask;
+}
+
+static float metersPerE7LonAt(int32_t latCell) {
+  float centerDeg = ((float)latCell + 0.5f) * (WAYPOINT_CELL_E7 * 1e-7f);
+  return METERS_PER_E7_LAT * cosf(centerDeg * (float)DEG_TO_RAD);
+}
+
+static const WaypointCell* findCell(const WaypointGrid& grid, int32_t latCell, int32_t lonCell) {
+  uint16_t mask = grid.cellSlots - 1;
+  for (uint16_t slot = hashCell(latCell, lonCell, mask), probes = 0; probes < grid.cellSlots;
+       slot = (slot + 1) & mask, probes++) {
+    const WaypointCell& cell = grid.cells[slot];
+    if (!cell.used) return nullptr;
+    if (cell.latCell == latCell && cell.lonCell == lonCell) return &cell;
+  }
+  return nullptr;
+}
+
+static WaypointCell* insertCell(WaypointGrid& grid, int32_t latCell, int32_t lonCell) {
+  uint16_t mask = grid.cellSlots - 1;
+  uint16_t slot = hashCell(latCell, lonCell, mask);
+  while (grid.cells[slot].used) {
+    WaypointCell& cell = grid.cells[slot];
+    if (cell.latCell == latCell && cell.lonCell == lonCell) return &cell;
+    slot = (slot + 1) & mask;   // Never full: at most capacity cells in 2x capacity slots
+  }
+  WaypointCell& cell = grid.cells[slot];
+  cell.used = true;
+  cell.latCell = latCell;
+  cell.lonCell = lonCell;
+  cell.metersPerE7Lon = metersPerE7LonAt(latCell);
+  cell.first = 0;
+  cell.count = 0;
+  cell.filled = 0;
+  grid.cellsUsed++;
+  return &cell;
+}
+
+static void rebuildIndex(WaypointGrid& grid) {
+  memset(grid.cells, 0, grid.cellSlots * sizeof(WaypointCell));
+  grid.cellsUsed = 0;
+  grid.maxPerCell = 0;
+  grid.unindexed = 0;
+  // Count per cell, then turn the counts into runs and fill them
+  for (uint16_t i = 0; i < grid.count; i++) {
+    WaypointCell* cell = insertCell(grid, cellOf(grid.points[i].latE7), cellOf(grid.points[i].lonE7));
+    if (cell->count < WAYPOINT_MAX_PER_CELL) cell->count++;
+  }
+  uint16_t offset = 0;
+  for (uint16_t slot = 0; slot < grid.cellSlots; slot++) {
+    WaypointCell& cell = grid.cells[slot];
+    if (!cell.used) continue;
+    cell.first = offset;
+    offset += cell.count;
+    if (cell.count > grid.maxPerCell) grid.maxPerCell = cell.count;
+  }
+  for (uint16_t i = 0; i < grid.count; i++) {
+    WaypointCell* cell = insertCell(grid, cellOf(grid.points[i].latE7), cellOf(grid.points[i].lonE7));
+    if (cell->filled >= cell->count) {
+      grid.unindexed++;
+      continue;
+    }
+    grid.order[cell->first + cell->filled++] = i;
+  }
+}
+
+static uint8_t cellOccupancy(const WaypointGrid& grid, int32_t latE7, int32_t lonE7) {
+  const WaypointCell* cell = findCell(grid, cellOf(latE7), cellOf(lonE7));
+  return cell ? cell->count : 0;
+}
+
+static inline float squaredDistance(const Waypoint& point, float metersPerE7Lon, int32_t latE7, int32_t lonE7) {
+  float north = (float)(point.latE7 - latE7) * METERS_PER_E7_LAT;
+  float east = (float)(point.lonE7 - lonE7) * metersPerE7Lon;
+  return north * north + east * east;
+}
+
+// Slots of every indexed point whose geofence (plus margin) contains the
+// position; looks at the 3x3 cells around it only
+static const uint16_t QUERY_MAX = 9 * WAYPOINT_MAX_PER_CELL;
+static uint16_t queryGeofences(const WaypointGrid& grid, int32_t latE7, int32_t lonE7, float marginM,
+                               uint16_t* out, uint16_t* candidates) {
+  int32_t latCell = cellOf(latE7);
+  int32_t lonCell = cellOf(lonE7);
+  uint16_t found = 0;
+  uint16_t checked = 0;
+  for (int8_t dLat = -1; dLat <= 1; dLat++) {
+    for (int8_t dLon = -1; dLon <= 1; dLon++) {
+      const WaypointCell* cell = findCell(grid, latCell + dLat, lonCell + dLon);
+      if (!cell) continue;
+      for (uint8_t k = 0; k < cell->count; k++) {
+        uint16_t slot = grid.order[cell->first + k];
+        const Waypoint& point = grid.points[slot];
+        float reach = point.radiusM + marginM;
+        checked++;
+        if (squaredDistance(point, cell->metersPerE7Lon, latE7, lonE7) <= reach * reach) out[found++] = slot;
+      }
+    }
+  }
+  if (candidates) *candidates = checked;
+  return found;
+}
+
+static bool allocateGrid(WaypointGrid& grid, uint16_t capacity, bool psram) {
+  uint16_t slots = 1;
+  while (slots < 2 * capacity) slots <<= 1;
+  size_t pointBytes = capacity * sizeof(Waypoint);
+  size_t orderBytes = capacity * sizeof(uint16_t);
+  size_t cellBytes = slots * sizeof(WaypointCell);
+  grid.points = (Waypoint*)(psram ? ps_malloc(pointBytes) : malloc(pointBytes));
+  grid.order = (uint16_t*)(psram ? ps_malloc(orderBytes) : malloc(orderBytes));
+  grid.cells = (WaypointCell*)(psram ? ps_malloc(cellBytes) : malloc(cellBytes));
+  if (!grid.points || !grid.order || !grid.cells) {
+    free(grid.points);
+    free(grid.order);
+    free(grid.cells);
+    grid.points = nullptr;
+    grid.order = nullptr;
+    grid.cells = nullptr;
+    return false;
+  }
+  grid.capacity = capacity;
+  grid.count = 0;
+  grid.cellSlots = slots;
+  rebuildIndex(grid);
+  return true;
+}
+
+static void freeGrid(WaypointGrid& grid) {
+  free(grid.points);
+  free(grid.order);
+  free(grid.cells);
+  memset(&grid, 0, sizeof(grid));
+}
+
+// ============= Journal =============
+// Fixed-size upsert/delete records appended on every edit and replayed at
+// boot; a torn or corrupt record is skipped. When most records are stale
+// the journal is rewritten with one upsert per live waypoint.
+static const char* const JOURNAL_PATH = "/data/waypoints.jnl";
+static const char* const JOURNAL_TEMP_PATH = "/data/waypoints.tmp";
+static const uint32_t RECORD_MAGIC = 0x31545057;  // "WPT1"
+
+enum WaypointOp : uint8_t { WAYPOINT_OP_UPSERT = 1, WAYPOINT_OP_DELETE };
+
+struct WaypointRecord {
+  uint32_t magic;
+  uint8_t op;
+  uint8_t kind;
+  uint16_t id;
+  int32_t latE7;
+  int32_t lonE7;
+  uint16_t radiusM;
+  char name[WAYPOINT_NAME_LEN];
+  uint32_t crc;   // CRC-32 of every field above
+};
+
+// ============= Store State (loop task) =============
+#define WAYPOINT_EVENT_QUEUE 8
+
+struct InsideEntry {
+  uint16_t id;
+  uint16_t slot;
+};
+
+static WaypointGrid store = {};
+static uint16_t nextId = 1;
+static uint16_t targetId = 0;
+static bool persistent = false;
+static uint32_t journalRecords = 0;
+static uint16_t tornRecords = 0;
+static bool replayFull = false;       // Replay refused an entry: the journal holds more than the store
+
+static InsideEntry inside[WAYPOINT_MAX_INSIDE];
+static uint8_t insideCount = 0;
+static WaypointEvent events[WAYPOINT_EVENT_QUEUE];
+static uint8_t eventHead = 0;
+static uint8_t eventCount = 0;
+
+static uint32_t fixesEvaluated = 0;
+static uint16_t lastCandidates = 0;
+static uint32_t lastEvalCycles = 0;
+static uint32_t maxEvalCycles = 0;
+static uint32_t enters = 0;
+static uint32_t exits = 0;
+static uint32_t eventsDropped = 0;
+
+static uint32_t recordCrc(const WaypointRecord& record) {
+  return SDCard_crc32((const uint8_t*)&record, offsetof(WaypointRecord, crc));
+}
+
+static void fillRecord(WaypointRecord& record, WaypointOp op, const Waypoint& point) {
+  memset(&record, 0, sizeof(record));
+  record.magic = RECORD_MAGIC;
+  record.op = op;
+  record.kind = point.kind;
+  record.id = point.id;
+  record.latE7 = point.latE7;
+  record.lonE7 = point.lonE7;
+  record.radiusM = point.radiusM;
+  memcpy(record.name, point.name, WAYPOINT_NAME_LEN);
+  record.crc = recordCrc(record);
+}
+
+static bool journal(WaypointOp op, const Waypoint& point) {
+  if (!persistent) return false;
+  WaypointRecord record;
+  fillRecord(record, op, point);
+  if (!SDCard_appendFile(JOURNAL_PATH, (const uint8_t*)&record, sizeof(record))) return false;
+  journalRecords++;
+  return true;
+}
+
+static int32_t findSlot(uint16_t id) {
+  for (uint16_t i = 0; i < store.count; i++) {
+    if (store.points[i].id == id) return i;
+  }
+  return -1;
+}
+
+static void applyRecord(const WaypointRecord& record) {
+  int32_t slot = findSlot(record.id);
+  if (record.op == WAYPOINT_OP_DELETE) {
+    if (slot >= 0) store.points[slot] = store.points[--store.count];
+    return;
+  }
+  if (slot < 0) {
+    if (store.count >= store.capacity) {
+      replayFull = true;
+      return;
+    }
+    slot = store.count++;
+  }
+  Waypoint& point = store.points[slot];
+  point.id = record.id;
+  point.kind = record.kind;
+  point.latE7 = record.latE7;
+  point.lonE7 = record.lonE7;
+  point.radiusM = record.radiusM;
+  memcpy(point.name, record.name, WAYPOINT_NAME_LEN);
+  point.name[WAYPOINT_NAME_LEN - 1] = '\0';
+  if (record.id >= nextId) nextId = record.id + 1;
+}
+
+static void replayJournal() {
+  File file = SD.open(JOURNAL_PATH, FILE_READ);
+  if (!file) return;
+  WaypointRecord record;
+  while (file.read((uint8_t*)&record, sizeof(record)) == sizeof(record)) {
+    journalRecords++;
+    if (record.magic != RECORD_MAGIC || record.crc != recordCrc(record) || record.id == 0) {
+      tornRecords++;
+      continue;
+    }
+    applyRecord(record);
+  }
+  file.close();
+}
+
+static bool compactJournal() {
+  if (SD.exists(JOURNAL_TEMP_PATH)) SD.remove(JOURNAL_TEMP_PATH);
+  File file = SD.open(JOURNAL_TEMP_PATH, FILE_WRITE);
+  if (!file) return false;
+  WaypointRecord record;
+  for (uint16_t i = 0; i < store.count; i++) {
+    fillRecord(record, WAYPOINT_OP_UPSERT, store.points[i]);
+    if (file.write((const uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+      file.close();
+      SD.remove(JOURNAL_TEMP_PATH);
+      return false;
+    }
+  }
+  file.close();
+  SD.remove(JOURNAL_PATH);
+  if (!SD.rename(JOURNAL_TEMP_PATH, JOURNAL_PATH)) return false;
+  journalRecords = store.count;
+  return true;
+}
+
+// Slots move when the array is compacted; re-resolve the entered geofences
+static void remapInside() {
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < insideCount; i++) {
+    int32_t slot = findSlot(inside[i].id);
+    if (slot < 0) continue;
+    inside[kept].id = inside[i].id;
+    inside[kept].slot = slot;
+    kept++;
+  }
+  insideCount = kept;
+}
+
+// ============= Public API =============
+bool Waypoint_begin() {
+  if (store.points) return persistent;
+  bool psram = psramFound();
+  if (!allocateGrid(store, psram ? WAYPOINT_CAPACITY : WAYPOINT_CAPACITY_NO_PSRAM, psram)) {
+    Serial.println("⚠️ Waypoints disabled: allocation failed");
+    return false;
+  }
+  if (!psram) Serial.printf("⚠️ No PSRAM: waypoint store limited to %u entries\n", WAYPOINT_CAPACITY_NO_PSRAM);
+
+  persistent = SDCard_fileExists("/data") || SDCard_fileExists(JOURNAL_PATH);
+  if (persistent) {
+    replayJournal();
+    // Compaction rewrites the journal from the store. If the store could not
+    // hold it all (a card written with PSRAM, read without), that would lose
+    // the entries left out, so the journal is kept as it is.
+    bool partial = replayFull || store.count >= store.capacity || store.capacity == WAYPOINT_CAPACITY_NO_PSRAM;
+    if (replayFull) Serial.printf("⚠️ Waypoint journal holds more than %u entries: kept uncompacted\n", store.capacity);
+    if (!partial && journalRecords > 2u * store.count + 64) compactJournal();
+  }
+  rebuildIndex(store);
+  Serial.printf("📍 Waypoints: %u loaded (%u cells, %lu journal records, %u torn)\n",
+                store.count, store.cellsUsed, (unsigned long)journalRecords, tornRecords);
+  return persistent;
+}
+
+uint16_t Waypoint_add(const char* name, double lat, double lon, uint16_t radiusM, uint8_t kind) {
+  if (!store.points || store.count >= store.capacity || nextId == 0) return 0;
+  Waypoint point = {};
+  point.latE7 = (int32_t)lround(lat * 1e7);
+  point.lonE7 = (int32_t)lround(lon * 1e7);
+  if (cellOccupancy(store, point.latE7, point.lonE7) >= WAYPOINT_MAX_PER_CELL) return 0;
+  point.id = nextId++;
+  point.radiusM = constrain(radiusM, (uint16_t)1, (uint16_t)WAYPOINT_MAX_RADIUS_M);
+  point.kind = kind;
+  strncpy(point.name, name, WAYPOINT_NAME_LEN - 1);
+  store.points[store.count++] = point;
+  rebuildIndex(store);
+  journal(WAYPOINT_OP_UPSERT, point);
+  return point.id;
+}
+
+bool Waypoint_remove(uint16_t id) {
+  int32_t slot = findSlot(id);
+  if (slot < 0) return false;
+  Waypoint removed = store.points[slot];
+  store.points[slot] = store.points[--store.count];
+  rebuildIndex(store);
+  remapInside();
+  if (targetId == id) targetId = 0;
+  journal(WAYPOINT_OP_DELETE, removed);
+  return true;
+}
+
+bool Waypoint_get(uint16_t id, Waypoint* out) {
+  int32_t slot = findSlot(id);
+  if (slot < 0) return false;
+  *out = store.points[slot];
+  return true;
+}
+
+uint16_t Waypoint_count() {
+  return store.count;
+}
+
+uint16_t Waypoint_setHome(double lat, double lon) {
+  for (uint16_t i = 0; i < store.count; i++) {
+    Waypoint& point = store.points[i];
+    if (point.kind != WAYPOINT_HOME) continue;
+    int32_t latE7 = (int32_t)lround(lat * 1e7);
+    int32_t lonE7 = (int32_t)lround(lon * 1e7);
+    bool sameCell = cellOf(latE7) == cellOf(point.latE7) && cellOf(lonE7) == cellOf(point.lonE7);
+    if (!sameCell && cellOccupancy(store, latE7, lonE7) >= WAYPOINT_MAX_PER_CELL) return 0;
+    point.latE7 = latE7;
+    point.lonE7 = lonE7;
+    rebuildIndex(store);
+    remapInside();
+    journal(WAYPOINT_OP_UPSERT, point);
+    return point.id;
+  }
+  return Waypoint_add("Home", lat, lon, WAYPOINT_DEFAULT_RADIUS_M, WAYPOINT_HOME);
+}
+
+bool Waypoint_getHome(Waypoint* out) {
+  for (uint16_t i = 0; i < store.count; i++) {
+    if (store.points[i].kind == WAYPOINT_HOME) {
+      *out = store.points[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+float Waypoint_distance(const Waypoint& waypoint, double lat, double lon, float* bearingDeg) {
+  // Equirectangular at the mean latitude: within 0.5% for the few km a walk covers
+  double waypointLat = waypoint.latE7 * 1e-7;
+  double waypointLon = waypoint.lonE7 * 1e-7;
+  float north = (float)(waypointLat - lat) * METERS_PER_DEG_LAT;
+  float east = (float)(waypointLon - lon) * METERS_PER_DEG_LAT * cosf((float)((waypointLat + lat) * 0.5 * DEG_TO_RAD));
+  if (bearingDeg) {
+    float bearing = atan2f(east, north) * RAD_TO_DEG;
+    if (bearing < 0) bearing += 360.0f;
+    *bearingDeg = bearing >= 360.0f ? 0.0f : bearing;
+  }
+  return sqrtf(north * north + east * east);
+}
+
+static void pushEvent(WaypointEventType type, const Waypoint& point, double lat, double lon) {
+  if (eventCount >= WAYPOINT_EVENT_QUEUE) {
+    eventsDropped++;
+    return;
+  }
+  WaypointEvent& event = events[(eventHead + eventCount++) % WAYPOINT_EVENT_QUEUE];
+  event.type = type;
+  event.id = point.id;
+  event.kind = point.kind;
+  event.isTarget = point.id == targetId;
+  event.distanceM = Waypoint_distance(point, lat, lon, &event.bearingDeg);
+  memcpy(event.name, point.name, WAYPOINT_NAME_LEN);
+}
+
+void Waypoint_update(double lat, double lon) {
+  if (!store.points || store.count == 0) return;
+  uint32_t start = ESP.getCycleCount();
+  int32_t latE7 = (int32_t)lround(lat * 1e7);
+  int32_t lonE7 = (int32_t)lround(lon * 1e7);
+
+  // Exits: only the handful of geofences already entered
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < insideCount; i++) {
+    const Waypoint& point = store.points[inside[i].slot];
+    float reach = point.radiusM + WAYPOINT_EXIT_HYSTERESIS_M;
+    float scale = metersPerE7LonAt(cellOf(point.latE7));
+    if (squaredDistance(point, scale, latE7, lonE7) > reach * reach) {
+      pushEvent(WAYPOINT_EVENT_EXIT, point, lat, lon);
+      exits++;
+      continue;
+    }
+    inside[kept++] = inside[i];
+  }
+  insideCount = kept;
+
+  // Enters: the 3x3 cells around the fix
+  uint16_t hits[QUERY_MAX];
+  uint16_t found = queryGeofences(store, latE7, lonE7, 0, hits, &lastCandidates);
+  for (uint16_t h = 0; h < found; h++) {
+    bool already = false;
+    for (uint8_t i = 0; i < insideCount && !already; i++) already = inside[i].slot == hits[h];
+    if (already || insideCount >= WAYPOINT_MAX_INSIDE) continue;
+    inside[insideCount].slot = hits[h];
+    inside[insideCount].id = store.points[hits[h]].id;
+    insideCount++;
+    pushEvent(WAYPOINT_EVENT_ENTER, store.points[hits[h]], lat, lon);
+    enters++;
+  }
+
+  fixesEvaluated++;
+  lastEvalCycles = ESP.getCycleCount() - start;
+  if (lastEvalCycles > maxEvalCycles) maxEvalCycles = lastEvalCycles;
+}
+
+bool Waypoint_takeEvent(WaypointEvent* event) {
+  if (eventCount == 0) return false;
+  *event = events[eventHead];
+  eventHead = (eventHead + 1) % WAYPOINT_EVENT_QUEUE;
+  eventCount--;
+  return true;
+}
+
+bool Waypoint_setTarget(uint16_t id) {
+  if (id != 0 && findSlot(id) < 0) return false;
+  targetId = id;
+  return true;
+}
+
+uint16_t Waypoint_getTarget() {
+  return targetId;
+}
+
+WaypointStats Waypoint_getStats() {
+  WaypointStats stats;
+  stats.count = store.count;
+  stats.capacity = store.capacity;
+  stats.cells = store.cellsUsed;
+  stats.maxPerCell = store.maxPerCell;
+  stats.inside = insideCount;
+  stats.fixes = fixesEvaluated;
+  stats.lastCandidates = lastCandidates;
+  stats.lastEvalCycles = lastEvalCycles;
+  stats.maxEvalCycles = maxEvalCycles;
+  stats.enters = enters;
+  stats.exits = exits;
+  stats.eventsDropped = eventsDropped;
+  stats.journalRecords = journalRecords;
+  return stats;
+}
+
+static void printRow(const Waypoint& point, double lat, double lon, bool hasPosition) {
+  Serial.printf("   #%-4u %-23s %10.6f, %11.6f  r=%3um%s", point.id, point.name,
+                point.latE7 * 1e-7, point.lonE7 * 1e-7, point.radiusM,
+                point.kind == WAYPOINT_HOME ? " 🏠" : "");
+  if (hasPosition) {
+    float bearing;
+    float distance = Waypoint_distance(point, lat, lon, &bearing);
+    Serial.printf("  %.0f m @ %.0f°", distance, bearing);
+  }
+  Serial.println();
+}
+
+void Waypoint_printList(double lat, double lon, uint16_t maxRows) {
+  bool hasPosition = lat != 0 || lon != 0;
+  Serial.printf("📍 Waypoints: %u of %u\n", store.count, store.capacity);
+  if (!hasPosition) {
+    for (uint16_t i = 0; i < store.count && i < maxRows; i++) printRow(store.points[i], 0, 0, false);
+  } else {
+    // Nearest first: repeated selection, fine for a handful of rows
+    float lastDistance = -1;
+    uint16_t lastId = 0;
+    for (uint16_t row = 0; row < maxRows && row < store.count; row++) {
+      int32_t best = -1;
+      float bestDistance = 0;
+      for (uint16_t i = 0; i < store.count; i++) {
+        float distance = Waypoint_distance(store.points[i], lat, lon, nullptr);
+        bool after = distance > lastDistance || (distance == lastDistance && store.points[i].id > lastId);
+        if (after && (best < 0 || distance < bestDistance)) {
+          best = i;
+          bestDistance = distance;
+        }
+      }
+      if (best < 0) break;
+      printRow(store.points[best], lat, lon, true);
+      lastDistance = bestDistance;
+      lastId = store.points[best].id;
+    }
+  }
+  if (store.count > maxRows) Serial.printf("   ... %u more\n", store.count - maxRows);
+}
+
+void Waypoint_printStatus() {
+  Serial.println("\n📍 Waypoint Store:");
+  Serial.printf("   Waypoints: %u of %u (%s)\n", store.count, store.capacity,
+                persistent ? JOURNAL_PATH : "not persisted");
+  Serial.printf("   Grid: %u cells of %.3f°, max %u per cell (limit %u)%s\n", store.cellsUsed,
+                WAYPOINT_CELL_E7 * 1e-7, store.maxPerCell, WAYPOINT_MAX_PER_CELL,
+                store.unindexed ? ", some points not indexed" : "");
+  Serial.printf("   Journal: %lu records, %u torn skipped\n", (unsigned long)journalRecords, tornRecords);
+  Serial.printf("   Fixes evaluated: %lu, last %u candidates, %lu cycles (max %lu)\n",
+                (unsigned long)fixesEvaluated, lastCandidates, (unsigned long)lastEvalCycles,
+                (unsigned long)maxEvalCycles);
+  Serial.printf("   Inside: %u geofences; enters %lu, exits %lu, events dropped %lu\n", insideCount,
+                (unsigned long)enters, (unsigned long)exits, (unsigned long)eventsDropped);
+}
+
+// ============= Benchmark =============
+static double haversineMeters(double lat1, double lon1, double lat2, double lon2) {
+  const double R = 6371000;
+  double dLat = (lat2 - lat1) * DEG_TO_RAD;
+  double dLon = (lon2 - lon1) * DEG_TO_RAD;
+  double a = sin(dLat / 2) * sin(dLat / 2) +
+             cos(lat1 * DEG_TO_RAD) * cos(lat2 * DEG_TO_RAD) * sin(dLon / 2) * sin(dLon / 2);
+  return R * 2 * atan2(sqrt(a), sqrt(1 - a));
+}
+
+void Waypoint_runBenchmark() {
+  static const uint16_t BENCH_POINTS = 4000;
+  static const uint16_t BENCH_FIXES = 2000;
+  static const int32_t AREA_E7 = 900000;        // 0.09 deg, ~10 km square
+  static const int32_t ORIGIN_LAT_E7 = 253823440;
+  static const int32_t ORIGIN_LON_E7 = 683273230;
+  Serial.println("\n⏱️ Waypoint Grid Benchmark:");
+  Serial.println("================================");
+
+  bool psram = psramFound();
+  uint16_t points = psram ? BENCH_POINTS : WAYPOINT_CAPACITY_NO_PSRAM;
+  WaypointGrid grid = {};
+  if (!allocateGrid(grid, points, psram)) {
+    Serial.println("❌ Scratch store allocation failed");
+    return;
+  }
+  uint32_t seed = 0xC0FFEE;
+  auto nextRandom = [&seed]() { seed = seed * 1664525UL + 1013904223UL; return seed >> 16; };
+  auto randomE7 = [&nextRandom]() { return (int32_t)(((nextRandom() << 16) | nextRandom()) % AREA_E7); };
+  for (uint16_t i = 0; i < points; i++) {
+    Waypoint& point = grid.points[grid.count++];
+    memset(&point, 0, sizeof(point));
+    point.id = i + 1;
+    point.latE7 = ORIGIN_LAT_E7 + randomE7();
+    point.lonE7 = ORIGIN_LON_E7 + randomE7();
+    point.radiusM = 5 + nextRandom() % (WAYPOINT_MAX_RADIUS_M - 4);
+  }
+  uint32_t start = ESP.getCycleCount();
+  rebuildIndex(grid);
+  uint32_t rebuildCycles = ESP.getCycleCount() - start;
+
+  // Golden: the grid must find exactly what a scan of every point finds
+  static int32_t fixLat[BENCH_FIXES], fixLon[BENCH_FIXES];
+  for (uint16_t f = 0; f < BENCH_FIXES; f++) {
+    fixLat[f] = ORIGIN_LAT_E7 + randomE7();
+    fixLon[f] = ORIGIN_LON_E7 + randomE7();
+  }
+  uint16_t hits[QUERY_MAX];
+  uint16_t mismatches = 0;
+  uint32_t totalHits = 0;
+  uint16_t maxCandidates = 0;
+  float maxErrorM = 0;
+  for (uint16_t f = 0; f < BENCH_FIXES; f++) {
+    uint16_t candidates;
+    uint16_t found = queryGeofences(grid, fixLat[f], fixLon[f], 0, hits, &candidates);
+    if (candidates > maxCandidates) maxCandidates = candidates;
+    totalHits += found;
+    uint16_t expected = 0;
+    for (uint16_t i = 0; i < grid.count; i++) {
+      const Waypoint& point = grid.points[i];
+      float scale = metersPerE7LonAt(cellOf(point.latE7));
+      float squared = squaredDistance(point, scale, fixLat[f], fixLon[f]);
+      if (squared > (float)point.radiusM * point.radiusM) continue;
+      expected++;
+      bool listed = false;
+      for (uint16_t h = 0; h < found && !listed; h++) listed = hits[h] == i;
+      if (!listed) mismatches++;
+      float error = fabsf(sqrtf(squared) - (float)haversineMeters(fixLat[f] * 1e-7, fixLon[f] * 1e-7,
+                                                                  point.latE7 * 1e-7, point.lonE7 * 1e-7));
+      if (error > maxErrorM) maxErrorM = error;
+    }
+    if (expected != found) mismatches++;
+  }
+  Serial.printf("Grid vs full scan: %s (%u mismatches, %lu geofence hits over %u fixes)\n",
+                mismatches == 0 && grid.unindexed == 0 ? "✅ PASS" : "❌ FAIL", mismatches,
+                (unsigned long)totalHits, BENCH_FIXES);
+  Serial.printf("Projection vs haversine: %s (max error %.3f m inside geofences)\n",
+                maxErrorM < 0.5f ? "✅ PASS" : "❌ FAIL", maxErrorM);
+
+  // Cycles per fix: grid lookup vs a haversine scan of every saved point
+  volatile uint32_t sink = 0;
+  start = ESP.getCycleCount();
+  for (uint16_t f = 0; f < BENCH_FIXES; f++) sink += queryGeofences(grid, fixLat[f], fixLon[f], 0, hits, nullptr);
+  uint32_t gridCycles = ESP.getCycleCount() - start;
+  static const uint16_t SCAN_FIXES = 20;
+  start = ESP.getCycleCount();
+  for (uint16_t f = 0; f < SCAN_FIXES; f++) {
+    for (uint16_t i = 0; i < grid.count; i++) {
+      const Waypoint& point = grid.points[i];
+      if (haversineMeters(fixLat[f] * 1e-7, fixLon[f] * 1e-7, point.latE7 * 1e-7, point.lonE7 * 1e-7) <= point.radiusM) sink++;
+    }
+  }
+  uint32_t scanCycles = ESP.getCycleCount() - start;
+  (void)sink;
+
+  Serial.printf("Points: %u in %u cells (max %u per cell), index rebuild %lu cycles\n", grid.count,
+                grid.cellsUsed, grid.maxPerCell, (unsigned long)rebuildCycles);
+  Serial.printf("Grid lookup: %lu cycles/fix (max %u candidates)\n",
+                (unsigned long)(gridCycles / BENCH_FIXES), maxCandidates);
+  Serial.printf("Haversine scan: %lu cycles/fix\n", (unsigned long)(scanCycles / SCAN_FIXES));
+  Serial.println("================================");
+  freeGrid(grid);
+}
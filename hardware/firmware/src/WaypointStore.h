@@ -0,0 +1,93 @@
+#pragma once
+#ifndef WAYPOINTSTORE_H
+#define WAYPOINTSTORE_H
+
+#include <Arduino.h>
+
+// Saved places with geofences. Waypoints live in PSRAM, indexed by a uniform
+// grid of WAYPOINT_CELL_E7 cells (hashed, each cell's points contiguous);
+// a fix only looks at the 3x3 cells around it, and each cell holds at most
+// WAYPOINT_MAX_PER_CELL points, so enter/exit checks cost the same with ten
+// saved points or thousands. Distances use an equirectangular projection
+// with the longitude scale precomputed per cell. Edits are appended to a
+// CRC-checked journal on the SD card and replayed at boot.
+#define WAYPOINT_NAME_LEN 24
+#define WAYPOINT_CAPACITY 4096          // With PSRAM
+#define WAYPOINT_CAPACITY_NO_PSRAM 128
+#define WAYPOINT_CELL_E7 20000          // 0.002 deg, ~220 m north-south
+#define WAYPOINT_MAX_PER_CELL 16
+#define WAYPOINT_MAX_RADIUS_M 100       // A geofence must fit in the 3x3 cells (to ~60 deg latitude)
+#define WAYPOINT_DEFAULT_RADIUS_M 15
+#define WAYPOINT_EXIT_HYSTERESIS_M 5    // Leave at radius + this, so fix noise does not chatter
+#define WAYPOINT_MAX_INSIDE 8           // Geofences tracked as entered at once
+
+enum WaypointKind : uint8_t {
+  WAYPOINT_POINT = 0,
+  WAYPOINT_HOME
+};
+
+struct Waypoint {
+  int32_t latE7;                // 1e-7 deg, as UBX reports positions
+  int32_t lonE7;
+  uint16_t id;                  // Stable across reboots; 0 = unused
+  uint16_t radiusM;             // Geofence radius
+  uint8_t kind;
+  char name[WAYPOINT_NAME_LEN];
+};
+
+enum WaypointEventType : uint8_t {
+  WAYPOINT_EVENT_ENTER = 1,
+  WAYPOINT_EVENT_EXIT
+};
+
+struct WaypointEvent {
+  WaypointEventType type;
+  uint16_t id;
+  uint8_t kind;
+  bool isTarget;                // The navigation target
+  float distanceM;
+  float bearingDeg;             // From the fix to the waypoint, 0 = north
+  char name[WAYPOINT_NAME_LEN];
+};
+
+struct WaypointStats {
+  uint16_t count;
+  uint16_t capacity;
+  uint16_t cells;               // Occupied grid cells
+  uint8_t maxPerCell;
+  uint8_t inside;               // Geofences currently entered
+  uint32_t fixes;               // Fixes evaluated
+  uint16_t lastCandidates;      // Points distance-checked on the last fix
+  uint32_t lastEvalCycles;
+  uint32_t maxEvalCycles;
+  uint32_t enters;
+  uint32_t exits;
+  uint32_t eventsDropped;       // Event queue full
+  uint32_t journalRecords;      // Records in the journal file
+};
+
+// Allocate the store and replay the journal; false = running without persistence
+bool Waypoint_begin();
+// New waypoint at a position; returns its id, 0 if full or the cell is full
+uint16_t Waypoint_add(const char* name, double lat, double lon, uint16_t radiusM, uint8_t kind = WAYPOINT_POINT);
+bool Waypoint_remove(uint16_t id);
+bool Waypoint_get(uint16_t id, Waypoint* out);
+uint16_t Waypoint_count();
+uint16_t Waypoint_setHome(double lat, double lon);   // Moves the existing home point
+bool Waypoint_getHome(Waypoint* out);
+
+// Per fix, on the loop task; queues enter/exit events
+void Waypoint_update(double lat, double lon);
+bool Waypoint_takeEvent(WaypointEvent* event);       // Oldest pending event, false when none
+
+// Distance (m) and bearing (deg from north) from a position to a waypoint
+float Waypoint_distance(const Waypoint& waypoint, double lat, double lon, float* bearingDeg);
+bool Waypoint_setTarget(uint16_t id);                // 0 clears
+uint16_t Waypoint_getTarget();
+
+WaypointStats Waypoint_getStats();
+void Waypoint_printList(double lat, double lon, uint16_t maxRows);  // Nearest first when a position is given
+void Waypoint_printStatus();
+void Waypoint_runBenchmark();                        // Grid vs full scan on a scratch store
+
+#endif // WAYPOINTSTORE_H
@@ -137,6 +137,7 @@ $criticalFiles = @(
     @{Path="critical/distance_sensor_failed.wav"; Text="Distance sensor failed"},
     @{Path="critical/low_battery.wav"; Text="Low battery"},
     @{Path="critical/emergency_alert.wav"; Text="Emergency alert"},
+    @{Path="critical/fall_detected.wav"; Text="Fall detected"},
     @{Path="critical/gps_no_signal.wav"; Text="GPS signal lost"}
 )
 
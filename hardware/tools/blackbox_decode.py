@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""Decode Smart Cane fall black box captures (/blackbox/bb_NNNNN.bin).
+
+Prints a summary for tuning FALL_IMPACT_THRESHOLD / FALL_FREE_THRESHOLD and
+optionally writes the samples as CSV, with time relative to the trigger.
+
+    python3 blackbox_decode.py bb_00003.bin
+    python3 blackbox_decode.py bb_00003.bin --csv bb_00003.csv
+"""
+import argparse
+import csv
+import math
+import struct
+import sys
+import zlib
+
+# Must match BlackBoxFileHeader / BlackBoxSample in firmware/src/BlackBox.cpp
+HEADER = struct.Struct("<IHHHHIIIIB3x4f3h3hI")
+RECORD = struct.Struct("<I6h3hHHHBBH")
+MAGIC = 0x58424243  # "CBBX"
+REASONS = {1: "fall", 2: "manual"}
+FALL_STATES = {0: "none", 1: "detected", 2: "confirmed"}
+FLAG_STEP = 0x01
+FLAG_SLOPE = 0x02
+
+
+def load(path):
+    with open(path, "rb") as f:
+        blob = f.read()
+    if len(blob) < HEADER.size:
+        raise ValueError("file too short for a header")
+    (magic, version, header_size, record_size, rate, count, pre, trigger_us,
+     unix_time, reason, accel_lsb, gyro_lsb, impact_g, free_g,
+     aox, aoy, aoz, gox, goy, goz, dropped) = HEADER.unpack_from(blob)
+    if magic != MAGIC:
+        raise ValueError("bad magic 0x%08x" % magic)
+    if version != 1 or record_size != RECORD.size:
+        raise ValueError("unsupported version %d / record size %d" % (version, record_size))
+    body = blob[header_size:header_size + count * record_size]
+    trailer = blob[header_size + count * record_size:][:4]
+    if len(body) != count * record_size or len(trailer) != 4:
+        raise ValueError("truncated capture")
+    crc_ok = struct.unpack("<I", trailer)[0] == zlib.crc32(body)
+    header = {
+        "rate": rate, "count": count, "pre": pre, "trigger_us": trigger_us,
+        "unix_time": unix_time, "reason": REASONS.get(reason, str(reason)),
+        "accel_lsb": accel_lsb, "gyro_lsb": gyro_lsb,
+        "impact_g": impact_g, "free_g": free_g,
+        "accel_offsets": (aox, aoy, aoz), "gyro_offsets": (gox, goy, goz),
+        "dropped": dropped, "crc_ok": crc_ok,
+    }
+    return header, [RECORD.unpack_from(body, i * record_size) for i in range(count)]
+
+
+def wrapped_delta_us(t_us, ref_us):
+    """Signed difference of two micros() stamps across the 32-bit wrap."""
+    delta = (t_us - ref_us) & 0xFFFFFFFF
+    return delta - (1 << 32) if delta & 0x80000000 else delta
+
+
+def to_row(header, record):
+    (t_us, ax, ay, az, gx, gy, gz, roll, pitch, yaw,
+     motion, mag, tof, flags, fall_state, _) = record
+    ao, go = header["accel_offsets"], header["gyro_offsets"]
+    a = [(v - o) / header["accel_lsb"] for v, o in zip((ax, ay, az), ao)]
+    g = [(v - o) / header["gyro_lsb"] for v, o in zip((gx, gy, gz), go)]
+    return {
+        "t_ms": wrapped_delta_us(t_us, header["trigger_us"]) / 1000.0,
+        "ax_g": a[0], "ay_g": a[1], "az_g": a[2],
+        "gx_dps": g[0], "gy_dps": g[1], "gz_dps": g[2],
+        "raw_mag_g": math.sqrt(sum(v * v for v in a)),
+        "smooth_mag_g": mag / 1000.0,
+        "motion": motion / 1000.0,
+        "roll_deg": roll / 100.0, "pitch_deg": pitch / 100.0, "yaw_deg": yaw / 100.0,
+        "tof_mm": tof,
+        "step": int(bool(flags & FLAG_STEP)), "slope": int(bool(flags & FLAG_SLOPE)),
+        "fall_state": FALL_STATES.get(fall_state, str(fall_state)),
+    }
+
+
+def summarize(header, rows):
+    print("Reason: %s | %d samples @ %d Hz (%d before trigger) | CRC %s"
+          % (header["reason"], header["count"], header["rate"], header["pre"],
+             "OK" if header["crc_ok"] else "MISMATCH"))
+    if header["unix_time"]:
+        print("Wall time: %d (unix)" % header["unix_time"])
+    if header["dropped"]:
+        print("Dropped while writing: %d samples" % header["dropped"])
+    if not rows:
+        return
+    period_ms = 1000.0 / header["rate"]
+    for key in ("raw_mag_g", "smooth_mag_g"):
+        peak = max(rows, key=lambda r: r[key])
+        low = min(rows, key=lambda r: r[key])
+        print("%-13s peak %.2f g @ %+.0f ms | min %.2f g @ %+.0f ms"
+              % (key, peak[key], peak["t_ms"], low[key], low["t_ms"]))
+    impact = sum(1 for r in rows if r["smooth_mag_g"] > header["impact_g"])
+    free = sum(1 for r in rows if r["smooth_mag_g"] < header["free_g"])
+    print("Above impact threshold %.2f g: %.0f ms | below free-fall threshold %.2f g: %.0f ms"
+          % (header["impact_g"], impact * period_ms, header["free_g"], free * period_ms))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", nargs="+", help="bb_NNNNN.bin file(s)")
+    parser.add_argument("--csv", help="write samples to this CSV (single capture only)")
+    args = parser.parse_args()
+    if args.csv and len(args.capture) > 1:
+        parser.error("--csv takes a single capture")
+
+    status = 0
+    for path in args.capture:
+        print("== %s" % path)
+        try:
+            header, records = load(path)
+        except (OSError, ValueError) as exc:
+            print("error: %s" % exc, file=sys.stderr)
+            status = 1
+            continue
+        rows = [to_row(header, r) for r in records]
+        summarize(header, rows)
+        if not header["crc_ok"]:
+            status = 1
+        if args.csv and rows:
+            with open(args.csv, "w", newline="") as out:
+                writer = csv.DictWriter(out, fieldnames=list(rows[0].keys()))
+                writer.writeheader()
+                writer.writerows(rows)
+            print("Wrote %d rows to %s" % (len(rows), args.csv))
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
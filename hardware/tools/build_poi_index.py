@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+"""Build the Smart Cane offline point-of-interest index (/poi/poi.idx).
+
+Reads a CSV (lat,lon,category,name) or GeoJSON extract of point features,
+sorts the POIs along a Hilbert curve, packs them into 1 KiB pages and builds
+a packed R-tree over the page bounding boxes. The firmware keeps the tree
+in PSRAM and reads only the pages a query touches.
+
+    python3 build_poi_index.py extract.geojson -o poi.idx
+    python3 build_poi_index.py stops.csv crossings.csv -o poi.idx --bbox 25.37,68.31,25.40,68.35
+    python3 build_poi_index.py --check poi.idx
+"""
+import argparse
+import csv
+import json
+import struct
+import sys
+import zlib
+
+# Must match PoiFileHeader / PoiNode / PoiRecord in firmware/src/PoiDatabase.cpp
+MAGIC = 0x31494F50  # "POI1"
+VERSION = 1
+HEADER = struct.Struct("<IHHHHIIHHIIIiiiiII")
+HEADER_SIZE = 64
+NODE = struct.Struct("<iiiiIHH")
+RECORD = struct.Struct("<iiBB22s")
+PAGE_SIZE = 1024
+RECORDS_PER_PAGE = 31            # 992 bytes, the page CRC sits in the last 4
+FANOUT = 16
+NODE_LEAF = 0x0001
+NAME_BYTES = 22
+
+# Category ids shared with the firmware (PoiCategory) and its audio clips
+CATEGORIES = {
+    "other": 0, "crossing": 1, "bus_stop": 2, "entrance": 3,
+    "traffic_signals": 4, "steps": 5, "station": 6, "bench": 7,
+}
+# OSM-style tags in GeoJSON properties -> category
+TAG_RULES = [
+    ("highway", "crossing", "crossing"),
+    ("railway", "crossing", "crossing"),
+    ("footway", "crossing", "crossing"),
+    ("highway", "bus_stop", "bus_stop"),
+    ("public_transport", "platform", "bus_stop"),
+    ("public_transport", "station", "station"),
+    ("railway", "station", "station"),
+    ("highway", "traffic_signals", "traffic_signals"),
+    ("highway", "steps", "steps"),
+    ("amenity", "bench", "bench"),
+    ("leisure", "bench", "bench"),
+]
+
+
+def category_of(props):
+    explicit = props.get("category")
+    if explicit is not None:
+        return CATEGORIES.get(str(explicit).strip().lower(), 0)
+    if "entrance" in props:
+        return CATEGORIES["entrance"]
+    for key, value, category in TAG_RULES:
+        if props.get(key) == value:
+            return CATEGORIES[category]
+    return 0
+
+
+def read_csv(path):
+    with open(path, newline="", encoding="utf-8") as f:
+        for row in csv.DictReader(f):
+            yield (float(row["lat"]), float(row["lon"]),
+                   category_of({"category": row.get("category", "other")}),
+                   row.get("name", "") or "")
+
+
+def read_geojson(path):
+    with open(path, encoding="utf-8") as f:
+        data = json.load(f)
+    features = data["features"] if data.get("type") == "FeatureCollection" else [data]
+    for feature in features:
+        geometry = feature.get("geometry") or {}
+        if geometry.get("type") != "Point":
+            continue
+        lon, lat = geometry["coordinates"][:2]
+        props = feature.get("properties") or {}
+        name = props.get("name") or props.get("ref") or ""
+        yield float(lat), float(lon), category_of(props), str(name)
+
+
+def hilbert_index(order, x, y):
+    """Distance of (x, y) along a Hilbert curve over a 2^order square."""
+    d = 0
+    s = 1 << (order - 1)
+    while s > 0:
+        rx = 1 if x & s else 0
+        ry = 1 if y & s else 0
+        d += s * s * ((3 * rx) ^ ry)
+        if ry == 0:
+            if rx == 1:
+                x = s - 1 - x
+                y = s - 1 - y
+            x, y = y, x
+        s >>= 1
+    return d
+
+
+def encode_name(name):
+    raw = name.encode("utf-8")[:NAME_BYTES - 1]
+    while raw:
+        try:
+            raw.decode("utf-8")
+            break
+        except UnicodeDecodeError:
+            raw = raw[:-1]  # Do not cut a multi-byte character in half
+    return raw
+
+
+def bbox_of(items):
+    return (min(i[0] for i in items), min(i[1] for i in items),
+            max(i[2] for i in items), max(i[3] for i in items))
+
+
+def build(pois):
+    """Pages (bytes) and tree levels, root level first."""
+    lats = [p[0] for p in pois]
+    lons = [p[1] for p in pois]
+    min_lat, max_lat, min_lon, max_lon = min(lats), max(lats), min(lons), max(lons)
+    span_lat = max(max_lat - min_lat, 1e-9)
+    span_lon = max(max_lon - min_lon, 1e-9)
+
+    def key(p):
+        x = int((p[1] - min_lon) / span_lon * 65535)
+        y = int((p[0] - min_lat) / span_lat * 65535)
+        return hilbert_index(16, x, y)
+
+    ordered = sorted(pois, key=key)
+    pages = []
+    leaves = []
+    for start in range(0, len(ordered), RECORDS_PER_PAGE):
+        chunk = ordered[start:start + RECORDS_PER_PAGE]
+        body = bytearray(PAGE_SIZE)
+        boxes = []
+        for i, (lat, lon, category, name) in enumerate(chunk):
+            lat_e7, lon_e7 = round(lat * 1e7), round(lon * 1e7)
+            RECORD.pack_into(body, i * RECORD.size, lat_e7, lon_e7, category, 0, encode_name(name))
+            boxes.append((lat_e7, lon_e7, lat_e7, lon_e7))
+        struct.pack_into("<I", body, PAGE_SIZE - 4, zlib.crc32(bytes(body[:PAGE_SIZE - 4])))
+        pages.append(bytes(body))
+        leaves.append(bbox_of(boxes) + (len(pages) - 1, len(chunk), NODE_LEAF))
+
+    # Upper levels group FANOUT consecutive entries; child indices are fixed up below
+    levels = [leaves]
+    while len(levels[-1]) > FANOUT:
+        below = levels[-1]
+        level = []
+        for start in range(0, len(below), FANOUT):
+            group = below[start:start + FANOUT]
+            level.append(bbox_of(group) + (start, len(group), 0))
+        levels.append(level)
+    levels.reverse()
+
+    offsets = []
+    total = 0
+    for level in levels:
+        offsets.append(total)
+        total += len(level)
+    nodes = []
+    for depth, level in enumerate(levels):
+        for (a, b, c, d, first, count, flags) in level:
+            if not flags & NODE_LEAF:
+                first += offsets[depth + 1]
+            nodes.append((a, b, c, d, first, count, flags))
+    bbox = (round(min_lat * 1e7), round(min_lon * 1e7), round(max_lat * 1e7), round(max_lon * 1e7))
+    return pages, nodes, len(levels[0]), len(levels), bbox
+
+
+def write_index(path, pois):
+    pages, nodes, top_count, levels, bbox = build(pois)
+    node_blob = b"".join(NODE.pack(*n) for n in nodes)
+    nodes_offset = HEADER_SIZE
+    pages_offset = (nodes_offset + len(node_blob) + PAGE_SIZE - 1) // PAGE_SIZE * PAGE_SIZE
+    fields = [MAGIC, VERSION, HEADER_SIZE, RECORD.size, RECORDS_PER_PAGE, len(pois), len(pages),
+              top_count, levels, len(nodes), nodes_offset, pages_offset, *bbox,
+              zlib.crc32(node_blob)]
+    header = HEADER.pack(*fields, 0)
+    header = header[:-4] + struct.pack("<I", zlib.crc32(header[:-4]))
+    with open(path, "wb") as out:
+        out.write(header.ljust(HEADER_SIZE, b"\0"))
+        out.write(node_blob)
+        out.write(b"\0" * (pages_offset - nodes_offset - len(node_blob)))
+        for page in pages:
+            out.write(page)
+    print("Wrote %s: %d POIs in %d pages, %d tree nodes over %d levels (%d bytes)"
+          % (path, len(pois), len(pages), len(nodes), levels, pages_offset + len(pages) * PAGE_SIZE))
+
+
+def check_index(path):
+    with open(path, "rb") as f:
+        blob = f.read()
+    fields = HEADER.unpack_from(blob)
+    if fields[0] != MAGIC or fields[1] != VERSION:
+        raise ValueError("not a version %d POI index" % VERSION)
+    if zlib.crc32(blob[:HEADER.size - 4]) != fields[-1]:
+        raise ValueError("header CRC mismatch")
+    count, page_count, top_count, levels, node_count, nodes_offset, pages_offset = (
+        fields[5], fields[6], fields[7], fields[8], fields[9], fields[10], fields[11])
+    node_blob = blob[nodes_offset:nodes_offset + node_count * NODE.size]
+    if zlib.crc32(node_blob) != fields[16]:
+        raise ValueError("tree CRC mismatch")
+    bad = 0
+    categories = {}
+    for p in range(page_count):
+        page = blob[pages_offset + p * PAGE_SIZE:pages_offset + (p + 1) * PAGE_SIZE]
+        if len(page) != PAGE_SIZE or struct.unpack_from("<I", page, PAGE_SIZE - 4)[0] != zlib.crc32(page[:-4]):
+            bad += 1
+    for n in range(node_count):
+        a, b, c, d, first, n_children, flags = NODE.unpack_from(node_blob, n * NODE.size)
+        if flags & NODE_LEAF:
+            page = blob[pages_offset + first * PAGE_SIZE:]
+            for i in range(n_children):
+                category = RECORD.unpack_from(page, i * RECORD.size)[2]
+                categories[category] = categories.get(category, 0) + 1
+    names = {v: k for k, v in CATEGORIES.items()}
+    print("%s: %d POIs, %d pages (%d bad), %d nodes, %d levels, %d root entries"
+          % (path, count, page_count, bad, node_count, levels, top_count))
+    print("  " + ", ".join("%s %d" % (names.get(k, str(k)), v) for k, v in sorted(categories.items())))
+    return bad == 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("inputs", nargs="*", help=".csv or .geojson extracts")
+    parser.add_argument("-o", "--output", default="poi.idx", help="index file to write (copy to /poi/poi.idx)")
+    parser.add_argument("--bbox", help="keep only min_lat,min_lon,max_lat,max_lon")
+    parser.add_argument("--check", metavar="INDEX", help="verify an existing index instead")
+    args = parser.parse_args()
+
+    if args.check:
+        try:
+            return 0 if check_index(args.check) else 1
+        except (OSError, ValueError, struct.error) as exc:
+            print("error: %s" % exc, file=sys.stderr)
+            return 1
+    if not args.inputs:
+        parser.error("no input extracts")
+
+    pois = []
+    for path in args.inputs:
+        reader = read_csv if path.lower().endswith(".csv") else read_geojson
+        pois.extend(reader(path))
+    if args.bbox:
+        a, b, c, d = (float(v) for v in args.bbox.split(","))
+        pois = [p for p in pois if a <= p[0] <= c and b <= p[1] <= d]
+    # Same place and name twice (overlapping extracts): keep one
+    pois = list({(round(p[0], 6), round(p[1], 6), p[3]): p for p in pois}.values())
+    if not pois:
+        print("error: no point features", file=sys.stderr)
+        return 1
+    write_index(args.output, pois)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,284 @@
+#!/usr/bin/env python3
+"""Build the Smart Cane offline pedestrian routing graph (/route/graph.bin).
+
+Reads GeoJSON LineStrings with OSM-style tags (an Overpass or osmium export
+of highway=* ways), keeps the walkable ones, joins them where they share a
+vertex and cuts the graph into square tiles. The firmware keeps only the
+tile directory in RAM and loads tiles on demand while planning.
+
+    python3 build_route_graph.py ways.geojson -o graph.bin
+    python3 build_route_graph.py ways.geojson -o graph.bin --tile 0.004 --bbox 25.37,68.31,25.40,68.35
+    python3 build_route_graph.py --check graph.bin
+"""
+import argparse
+import json
+import math
+import struct
+import sys
+import zlib
+
+# Must match RouteFileHeader / RouteTileEntry / RouteNodeRecord / RouteEdgeRecord
+# in firmware/src/RouteEngine.cpp
+MAGIC = 0x31475452  # "RTG1"
+VERSION = 1
+HEADER = struct.Struct("<IHHIiiHHIIIIIiiiiII")
+HEADER_SIZE = 72
+TILE = struct.Struct("<IIHHIII")
+NODE = struct.Struct("<iiHBB")
+EDGE = struct.Struct("<IHH")
+METERS_PER_E7_LAT = 0.011119493
+MAX_TILE_BYTES = 98304           # RouteEngine needs ROUTE_MIN_TILE_SLOTS of the largest tile
+
+EDGE_CROSSING = 0x0001
+EDGE_STEPS = 0x0002
+EDGE_ROAD = 0x0004               # Shared with traffic, no sidewalk mapped
+
+FOOT_WAYS = {"footway", "path", "pedestrian", "steps", "living_street", "track", "corridor", "platform"}
+ROAD_WAYS = {"residential", "service", "unclassified", "tertiary", "tertiary_link", "secondary",
+             "secondary_link", "primary", "primary_link", "road"}
+
+
+def edge_flags(props):
+    """Flags for a walkable way, None if pedestrians cannot use it."""
+    highway = props.get("highway")
+    if props.get("foot") in ("no", "private") or props.get("access") in ("no", "private"):
+        if props.get("foot") not in ("yes", "designated"):
+            return None
+    flags = 0
+    if highway == "steps":
+        flags |= EDGE_STEPS
+    if props.get("footway") == "crossing" or highway == "crossing" or props.get("crossing"):
+        flags |= EDGE_CROSSING
+    if highway in FOOT_WAYS or props.get("foot") in ("yes", "designated"):
+        return flags
+    if highway in ROAD_WAYS:
+        if props.get("sidewalk") in ("both", "left", "right", "separate", "yes"):
+            return flags
+        return flags | EDGE_ROAD
+    return None
+
+
+def read_ways(path):
+    with open(path, encoding="utf-8") as f:
+        data = json.load(f)
+    features = data["features"] if data.get("type") == "FeatureCollection" else [data]
+    for feature in features:
+        geometry = feature.get("geometry") or {}
+        props = feature.get("properties") or {}
+        props = props.get("tags", props)  # Overpass exports nest the tags
+        flags = edge_flags(props)
+        if flags is None:
+            continue
+        if geometry.get("type") == "LineString":
+            lines = [geometry["coordinates"]]
+        elif geometry.get("type") == "MultiLineString":
+            lines = geometry["coordinates"]
+        else:
+            continue
+        for line in lines:
+            yield [(round(c[1] * 1e7), round(c[0] * 1e7)) for c in line], flags
+
+
+def length_dm(a, b):
+    mid = math.cos(math.radians((a[0] + b[0]) * 0.5e-7))
+    north = (b[0] - a[0]) * METERS_PER_E7_LAT
+    east = (b[1] - a[1]) * METERS_PER_E7_LAT * mid
+    return math.hypot(north, east) * 10
+
+
+def inside(c, bbox):
+    return bbox[0] <= c[0] <= bbox[2] and bbox[1] <= c[1] <= bbox[3]
+
+
+def build_graph(ways, bbox, min_component):
+    index = {}
+    coords = []
+    adjacency = []
+
+    def node(c):
+        n = index.get(c)
+        if n is None:
+            n = index[c] = len(coords)
+            coords.append(c)
+            adjacency.append({})
+        return n
+
+    for line, flags in ways:
+        for a, b in zip(line, line[1:]):
+            if a == b or (bbox and not (inside(a, bbox) and inside(b, bbox))):
+                continue
+            # Split long segments so no edge overflows its 16-bit length
+            pieces = max(1, int(length_dm(a, b) // 60000) + 1)
+            prev = a
+            for k in range(1, pieces + 1):
+                cur = b if k == pieces else (a[0] + (b[0] - a[0]) * k // pieces, a[1] + (b[1] - a[1]) * k // pieces)
+                u, v = node(prev), node(cur)
+                dm = max(1, round(length_dm(prev, cur)))
+                if v not in adjacency[u]:
+                    adjacency[u][v] = (dm, flags)
+                    adjacency[v][u] = (dm, flags)
+                prev = cur
+
+    # Drop islands (a snapped start on one would never reach anything)
+    parent = list(range(len(coords)))
+
+    def find(x):
+        while parent[x] != x:
+            parent[x] = parent[parent[x]]
+            x = parent[x]
+        return x
+
+    for u, edges in enumerate(adjacency):
+        for v in edges:
+            ru, rv = find(u), find(v)
+            if ru != rv:
+                parent[ru] = rv
+    sizes = {}
+    for u in range(len(coords)):
+        r = find(u)
+        sizes[r] = sizes.get(r, 0) + 1
+    keep = [u for u in range(len(coords)) if sizes[find(u)] >= min_component]
+    return coords, adjacency, keep, len(coords) - len(keep)
+
+
+def write_graph(path, coords, adjacency, keep, tile_deg):
+    tile_e7 = round(tile_deg * 1e7)
+    lats = [coords[u][0] for u in keep]
+    lons = [coords[u][1] for u in keep]
+    origin_lat = min(lats) // tile_e7 * tile_e7
+    origin_lon = min(lons) // tile_e7 * tile_e7
+    rows = (max(lats) - origin_lat) // tile_e7 + 1
+    cols = (max(lons) - origin_lon) // tile_e7 + 1
+    if rows > 65535 or cols > 65535:
+        raise ValueError("too many tiles; use a larger --tile")
+
+    def tile_of(u):
+        lat, lon = coords[u]
+        return (lat - origin_lat) // tile_e7 * cols + (lon - origin_lon) // tile_e7
+
+    # Node ids run tile by tile, so a tile is a contiguous id range
+    ordered = sorted(keep, key=lambda u: (tile_of(u), coords[u]))
+    new_id = {u: i for i, u in enumerate(ordered)}
+    tiles = []
+    start = 0
+    while start < len(ordered):
+        key = tile_of(ordered[start])
+        end = start
+        while end < len(ordered) and tile_of(ordered[end]) == key:
+            end += 1
+        tiles.append((key, start, end))
+        start = end
+
+    blobs = []
+    directory = []
+    offset = HEADER_SIZE + len(tiles) * TILE.size
+    edge_count = 0
+    for key, first, end in tiles:
+        nodes = bytearray()
+        edges = bytearray()
+        local_edges = 0
+        for u in ordered[first:end]:
+            out = sorted((new_id[v], dm, flags) for v, (dm, flags) in adjacency[u].items() if v in new_id)
+            if len(out) > 255 or local_edges + len(out) > 65535:
+                raise ValueError("tile %d too dense; use a smaller --tile" % key)
+            nodes += NODE.pack(coords[u][0], coords[u][1], local_edges, len(out), 0)
+            for v, dm, flags in out:
+                edges += EDGE.pack(v, dm, flags)
+            local_edges += len(out)
+        blob = bytes(nodes + edges)
+        if len(blob) > MAX_TILE_BYTES:
+            raise ValueError("tile %d is %d bytes (max %d); use a smaller --tile" % (key, len(blob), MAX_TILE_BYTES))
+        directory.append(TILE.pack(key, first, end - first, local_edges, offset, len(blob), zlib.crc32(blob)))
+        blobs.append(blob)
+        offset += len(blob)
+        edge_count += local_edges
+
+    dir_blob = b"".join(directory)
+    max_tile = max(len(b) for b in blobs)
+    fields = [MAGIC, VERSION, HEADER_SIZE, tile_e7, origin_lat, origin_lon, rows, cols, len(tiles),
+              len(ordered), edge_count, max_tile, HEADER_SIZE,
+              min(lats), min(lons), max(lats), max(lons), zlib.crc32(dir_blob)]
+    header = HEADER.pack(*fields, 0)
+    header = header[:-4] + struct.pack("<I", zlib.crc32(header[:-4]))
+    with open(path, "wb") as out:
+        out.write(header.ljust(HEADER_SIZE, b"\0"))
+        out.write(dir_blob)
+        for blob in blobs:
+            out.write(blob)
+    print("Wrote %s: %d nodes, %d edges in %d tiles (largest %d bytes), %d bytes"
+          % (path, len(ordered), edge_count // 2, len(tiles), max_tile, offset))
+
+
+def check_graph(path):
+    with open(path, "rb") as f:
+        blob = f.read()
+    fields = HEADER.unpack_from(blob)
+    if fields[0] != MAGIC or fields[1] != VERSION:
+        raise ValueError("not a version %d route graph" % VERSION)
+    if zlib.crc32(blob[:HEADER.size - 4]) != fields[-1]:
+        raise ValueError("header CRC mismatch")
+    tile_count, node_count, edge_count, max_tile, dir_offset = fields[8], fields[9], fields[10], fields[11], fields[12]
+    dir_blob = blob[dir_offset:dir_offset + tile_count * TILE.size]
+    if zlib.crc32(dir_blob) != fields[17]:
+        raise ValueError("directory CRC mismatch")
+    bad = 0
+    asymmetric = 0
+    edges = {}
+    for t in range(tile_count):
+        key, first, count, n_edges, offset, size, crc = TILE.unpack_from(dir_blob, t * TILE.size)
+        tile = blob[offset:offset + size]
+        if len(tile) != size or zlib.crc32(tile) != crc or size > max_tile:
+            bad += 1
+            continue
+        for i in range(count):
+            lat, lon, first_edge, n_out, _ = NODE.unpack_from(tile, i * NODE.size)
+            for e in range(first_edge, first_edge + n_out):
+                v, dm, flags = EDGE.unpack_from(tile, count * NODE.size + e * EDGE.size)
+                edges[(first + i, v)] = dm
+    for (u, v), dm in edges.items():
+        if v >= node_count or edges.get((v, u)) != dm:
+            asymmetric += 1
+    print("%s: %d nodes, %d edges, %d tiles (%d bad), largest tile %d bytes, %d asymmetric edges"
+          % (path, node_count, edge_count // 2, tile_count, bad, max_tile, asymmetric))
+    return bad == 0 and asymmetric == 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("inputs", nargs="*", help=".geojson extracts of highway ways")
+    parser.add_argument("-o", "--output", default="graph.bin", help="graph file to write (copy to /route/graph.bin)")
+    parser.add_argument("--tile", type=float, default=0.005, help="tile size in degrees (default 0.005, ~550 m)")
+    parser.add_argument("--bbox", help="keep only min_lat,min_lon,max_lat,max_lon")
+    parser.add_argument("--min-component", type=int, default=20, help="drop islands with fewer nodes")
+    parser.add_argument("--check", metavar="GRAPH", help="verify an existing graph instead")
+    args = parser.parse_args()
+
+    if args.check:
+        try:
+            return 0 if check_graph(args.check) else 1
+        except (OSError, ValueError, struct.error) as exc:
+            print("error: %s" % exc, file=sys.stderr)
+            return 1
+    if not args.inputs:
+        parser.error("no input extracts")
+
+    bbox = None
+    if args.bbox:
+        bbox = [round(float(v) * 1e7) for v in args.bbox.split(",")]
+    ways = [w for path in args.inputs for w in read_ways(path)]
+    coords, adjacency, keep, dropped = build_graph(ways, bbox, args.min_component)
+    if not keep:
+        print("error: no walkable ways", file=sys.stderr)
+        return 1
+    if dropped:
+        print("Dropped %d nodes in islands smaller than %d" % (dropped, args.min_component))
+    try:
+        write_graph(args.output, coords, adjacency, keep, args.tile)
+    except ValueError as exc:
+        print("error: %s" % exc, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
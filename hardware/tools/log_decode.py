@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""Decode binary deferred-log frames from a Smart Cane serial capture.
+
+With `logmode binary` the firmware sends each LOG_* record as a frame holding
+the format string's flash address and the raw arguments. The format strings
+are read back from the firmware ELF; plain text between frames (ordinary
+Serial output) is passed through unchanged.
+
+    python3 log_decode.py SmartCaneESP32N16R8.ino.elf capture.bin
+    python3 log_decode.py firmware.elf capture.bin --timestamps
+"""
+import argparse
+import re
+import struct
+import sys
+
+SYNC = b"\xA5\x5A"
+CATEGORIES = ["SYS", "IMU", "TOF", "BLE", "GPS", "TABLE"]
+LEVELS = ["ERROR", "WARN", "INFO", "DEBUG"]
+# Must match LogArgType in firmware/src/Log.h
+ARG_I32, ARG_U32, ARG_F32, ARG_F64, ARG_I64, ARG_U64, ARG_STR = range(1, 8)
+SPEC = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|j|t|L|q)*([diouxXcfFeEgGsp%])")
+
+
+class Elf32:
+    """Just enough ELF32 little-endian parsing to read strings by address."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1:
+            raise ValueError("not a 32-bit ELF file")
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            (_, sh_type, _, addr, offset, size) = struct.unpack_from(
+                "<IIIIII", self.data, shoff + i * shentsize)
+            if addr and sh_type == 1:  # SHT_PROGBITS with a load address
+                self.sections.append((addr, offset, size))
+
+    def string_at(self, address):
+        for addr, offset, size in self.sections:
+            if addr <= address < addr + size:
+                start = offset + (address - addr)
+                end = self.data.index(b"\0", start)
+                return self.data[start:end].decode("utf-8", "replace")
+        return None
+
+
+def render(fmt, args):
+    """printf the way firmware formatRecord() does, using Python % per spec."""
+    values = iter(args)
+
+    def one(match):
+        flags, conv = match.group(1), match.group(2)
+        if conv == "%":
+            return "%"
+        try:
+            kind, value = next(values)
+        except StopIteration:
+            return "?"
+        if conv in "fFeEgG":
+            return ("%" + flags + conv) % float(value if kind != ARG_STR else 0)
+        if conv == "s":
+            return ("%" + flags + "s") % (value if kind == ARG_STR else "?")
+        if kind == ARG_STR:
+            return "?"
+        integer = int(value)
+        if conv == "c":
+            return ("%" + flags + "c") % chr(integer & 0xFF)
+        if conv == "p":
+            return "0x%x" % (integer & 0xFFFFFFFF)
+        wide = kind in (ARG_I64, ARG_U64)
+        bits = 64 if wide else 32
+        if conv in "di":
+            integer &= (1 << bits) - 1
+            if integer >> (bits - 1):
+                integer -= 1 << bits
+            return ("%" + flags + "d") % integer
+        return ("%" + flags + conv.replace("u", "d")) % (integer & ((1 << bits) - 1))
+
+    return SPEC.sub(one, fmt)
+
+
+def parse_payload(payload):
+    cat_level, timestamp, fmt_addr, argc, types = struct.unpack_from("<BIIBI", payload)
+    pos = 14
+    raw = []
+    for i in range(argc):
+        kind = (types >> (i * 4)) & 0xF
+        if kind in (ARG_F64, ARG_I64, ARG_U64):
+            lo, hi = struct.unpack_from("<II", payload, pos)
+            pos += 8
+            bits = lo | (hi << 32)
+            if kind == ARG_F64:
+                value = struct.unpack("<d", struct.pack("<Q", bits))[0]
+            else:
+                value = bits
+        else:
+            word, = struct.unpack_from("<I", payload, pos)
+            pos += 4
+            if kind == ARG_F32:
+                value = struct.unpack("<f", struct.pack("<I", word))[0]
+            elif kind == ARG_I32:
+                value = word - (1 << 32) if word & 0x80000000 else word
+            else:
+                value = word
+        raw.append((kind, value))
+    string_bytes = payload[pos]
+    strings = payload[pos + 1:pos + 1 + string_bytes]
+    args = []
+    for kind, value in raw:
+        if kind == ARG_STR:
+            end = strings.find(b"\0", value)
+            value = strings[value:end if end >= 0 else None].decode("utf-8", "replace")
+        args.append((kind, value))
+    return cat_level & 0x0F, cat_level >> 4, timestamp, fmt_addr, args
+
+
+def decode(elf, blob, out, timestamps):
+    pos = 0
+    bad = 0
+    while pos < len(blob):
+        start = blob.find(SYNC, pos)
+        if start < 0:
+            out.write(blob[pos:].decode("utf-8", "replace"))
+            break
+        out.write(blob[pos:start].decode("utf-8", "replace"))
+        if start + 3 > len(blob):
+            break
+        length = blob[start + 2]
+        payload = blob[start + 3:start + 3 + length]
+        if len(payload) < length or start + 3 + length >= len(blob) or \
+                sum(payload) & 0xFF != blob[start + 3 + length]:
+            bad += 1
+            out.write(blob[start:start + 1].decode("latin-1"))
+            pos = start + 1
+            continue
+        category, level, timestamp, fmt_addr, args = parse_payload(payload)
+        fmt = elf.string_at(fmt_addr)
+        if fmt is None:
+            text = "<unknown format 0x%08x %s>\n" % (fmt_addr, [v for _, v in args])
+        else:
+            text = render(fmt, args)
+        if timestamps:
+            cat = CATEGORIES[category] if category < len(CATEGORIES) else str(category)
+            lvl = LEVELS[level] if level < len(LEVELS) else str(level)
+            text = "[%10.3f %-5s %-5s] %s" % (timestamp / 1000.0, cat, lvl, text)
+        out.write(text)
+        pos = start + 4 + length
+    return bad
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="firmware ELF matching the running build")
+    parser.add_argument("capture", help="raw serial capture (binary)")
+    parser.add_argument("--timestamps", action="store_true", help="prefix time, category and level")
+    args = parser.parse_args()
+    elf = Elf32(args.elf)
+    with open(args.capture, "rb") as f:
+        blob = f.read()
+    bad = decode(elf, blob, sys.stdout, args.timestamps)
+    if bad:
+        print("\n%d corrupt frames skipped" % bad, file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""Convert Smart Cane GPS tracks (/tracks/trk_NNNNN.bin) to GPX or CSV.
+
+Prints a summary per file. Blocks with a bad CRC are skipped; a skipped
+block, a gap of more than --gap seconds or a clock change starts a new
+track segment.
+
+    python3 track_convert.py trk_00004.bin
+    python3 track_convert.py trk_00004.bin --gpx walk.gpx --csv walk.csv
+    python3 track_convert.py trk_*.bin --check
+"""
+import argparse
+import csv
+import datetime
+import math
+import struct
+import sys
+import zlib
+from xml.sax.saxutils import escape
+
+# Must match TrackBlockHeader and the record format in firmware/src/TrackLogger.cpp
+BLOCK_SIZE = 512
+HEADER = struct.Struct("<IIHH")
+MAGIC = 0x314B5254  # "TRK1"
+PAYLOAD = BLOCK_SIZE - HEADER.size - 4
+KEYFRAME = 0xFF
+KEY_UPTIME = 0x01
+DELTA_STEP = 0x01
+DELTA_ALT = 0x02
+DELTA_SPEED = 0x04
+DELTA_HDOP = 0x08
+DELTA_SATS = 0x10
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def byte(self):
+        if self.pos >= len(self.data):
+            raise ValueError("record runs past the block")
+        self.pos += 1
+        return self.data[self.pos - 1]
+
+    def varint(self):
+        value = shift = 0
+        while True:
+            b = self.byte()
+            value |= (b & 0x7F) << shift
+            if not b & 0x80:
+                return value
+            shift += 7
+
+    def zigzag(self):
+        v = self.varint()
+        return (v >> 1) ^ -(v & 1)
+
+
+def decode_block(block):
+    """Fixes of one block as dicts; raises ValueError if it is corrupt."""
+    magic, seq, used, points = HEADER.unpack_from(block)
+    if magic != MAGIC:
+        raise ValueError("bad magic 0x%08x" % magic)
+    if used > PAYLOAD:
+        raise ValueError("payload length %d" % used)
+    if struct.unpack_from("<I", block, BLOCK_SIZE - 4)[0] != zlib.crc32(block[:BLOCK_SIZE - 4]):
+        raise ValueError("CRC mismatch")
+    r = Reader(block[HEADER.size:HEADER.size + used])
+    fixes = []
+    s = {}
+    while r.pos < used:
+        flags = r.byte()
+        if flags == KEYFRAME:
+            s["uptime"] = bool(r.byte() & KEY_UPTIME)
+            s["time"] = r.varint()
+            s["step"] = s["dlat"] = s["dlon"] = 0
+            s["lat"] = r.zigzag()
+            s["lon"] = r.zigzag()
+            s["alt"] = r.zigzag()
+            s["speed"] = r.varint()
+            s["hdop"] = r.varint()
+            s["sats"] = r.byte()
+        else:
+            if not s:
+                raise ValueError("delta record before a keyframe")
+            if flags & DELTA_STEP:
+                s["step"] += r.zigzag()
+            s["time"] += s["step"]
+            lat = s["lat"] + s["dlat"] + r.zigzag()
+            lon = s["lon"] + s["dlon"] + r.zigzag()
+            s["dlat"], s["dlon"] = lat - s["lat"], lon - s["lon"]
+            s["lat"], s["lon"] = lat, lon
+            if flags & DELTA_ALT:
+                s["alt"] += r.zigzag()
+            if flags & DELTA_SPEED:
+                s["speed"] += r.zigzag()
+            if flags & DELTA_HDOP:
+                s["hdop"] += r.zigzag()
+            if flags & DELTA_SATS:
+                s["sats"] = r.byte()
+        fixes.append(dict(s))
+    if len(fixes) != points:
+        raise ValueError("%d fixes decoded, header says %d" % (len(fixes), points))
+    return seq, fixes
+
+
+def load(path, gap_s):
+    """Segments (lists of fixes) and a count of bad blocks."""
+    with open(path, "rb") as f:
+        blob = f.read()
+    segments, bad = [], 0
+    current, last, expected = [], None, 0
+    for offset in range(0, len(blob) - BLOCK_SIZE + 1, BLOCK_SIZE):
+        try:
+            seq, fixes = decode_block(blob[offset:offset + BLOCK_SIZE])
+        except ValueError as exc:
+            print("block %d: %s" % (offset // BLOCK_SIZE, exc), file=sys.stderr)
+            bad += 1
+            last = None
+            continue
+        if seq != expected:
+            last = None
+        expected = seq + 1
+        for fix in fixes:
+            if last is None or fix["uptime"] != last["uptime"] or \
+                    not 0 < fix["time"] - last["time"] <= gap_s * 1000:
+                if current:
+                    segments.append(current)
+                current = []
+            current.append(fix)
+            last = fix
+    if current:
+        segments.append(current)
+    if len(blob) % BLOCK_SIZE:
+        print("%d trailing bytes ignored" % (len(blob) % BLOCK_SIZE), file=sys.stderr)
+        bad += 1
+    return segments, bad
+
+
+def distance_m(a, b):
+    north = (b["lat"] - a["lat"]) * 0.011119493
+    east = (b["lon"] - a["lon"]) * 0.011119493 * math.cos(math.radians(a["lat"] * 1e-7))
+    return math.hypot(north, east)
+
+
+def iso_time(fix):
+    t = datetime.datetime.fromtimestamp(fix["time"] / 1000.0, datetime.timezone.utc)
+    return t.strftime("%Y-%m-%dT%H:%M:%S.") + "%03dZ" % (fix["time"] % 1000)
+
+
+def summarize(segments, bad):
+    fixes = [f for seg in segments for f in seg]
+    print("%d fixes in %d segment(s), %d bad block(s)" % (len(fixes), len(segments), bad))
+    if not fixes:
+        return
+    length = sum(distance_m(a, b) for seg in segments for a, b in zip(seg, seg[1:]))
+    duration = sum(seg[-1]["time"] - seg[0]["time"] for seg in segments) / 1000.0
+    print("Distance %.2f km over %.0f min" % (length / 1000.0, duration / 60.0))
+    timed = [f for f in fixes if not f["uptime"]]
+    if timed:
+        print("UTC %s .. %s" % (iso_time(timed[0]), iso_time(timed[-1])))
+    if len(timed) != len(fixes):
+        print("%d fixes before receiver time was known (uptime clock)" % (len(fixes) - len(timed)))
+
+
+def write_gpx(path, name, segments):
+    with open(path, "w") as out:
+        out.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+        out.write('<gpx version="1.1" creator="Smart Cane track_convert.py" '
+                  'xmlns="http://www.topografix.com/GPX/1/1">\n')
+        out.write("  <trk>\n    <name>%s</name>\n" % escape(name))
+        for seg in segments:
+            out.write("    <trkseg>\n")
+            for f in seg:
+                out.write('      <trkpt lat="%.7f" lon="%.7f"><ele>%.1f</ele>'
+                          % (f["lat"] * 1e-7, f["lon"] * 1e-7, f["alt"] / 10.0))
+                if not f["uptime"]:
+                    out.write("<time>%s</time>" % iso_time(f))
+                out.write("<sat>%d</sat><hdop>%.2f</hdop></trkpt>\n" % (f["sats"], f["hdop"] / 100.0))
+            out.write("    </trkseg>\n")
+        out.write("  </trk>\n</gpx>\n")
+
+
+def write_csv(path, segments):
+    with open(path, "w", newline="") as out:
+        writer = csv.writer(out)
+        writer.writerow(["segment", "clock", "time_ms", "lat", "lon", "alt_m",
+                         "speed_mps", "hdop", "satellites"])
+        for index, seg in enumerate(segments):
+            for f in seg:
+                writer.writerow([index, "uptime" if f["uptime"] else "utc", f["time"],
+                                 "%.7f" % (f["lat"] * 1e-7), "%.7f" % (f["lon"] * 1e-7),
+                                 "%.1f" % (f["alt"] / 10.0), "%.2f" % (f["speed"] / 100.0),
+                                 "%.2f" % (f["hdop"] / 100.0), f["sats"]])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("track", nargs="+", help="trk_NNNNN.bin file(s)")
+    parser.add_argument("--gpx", help="write a GPX track (single file only)")
+    parser.add_argument("--csv", help="write fixes to this CSV (single file only)")
+    parser.add_argument("--gap", type=float, default=10.0,
+                        help="seconds without a fix that start a new segment (default 10)")
+    parser.add_argument("--check", action="store_true", help="only verify blocks; exit 1 on any bad block")
+    args = parser.parse_args()
+    if (args.gpx or args.csv) and len(args.track) > 1:
+        parser.error("--gpx/--csv take a single track")
+
+    status = 0
+    for path in args.track:
+        print("== %s" % path)
+        try:
+            segments, bad = load(path, args.gap)
+        except OSError as exc:
+            print("error: %s" % exc, file=sys.stderr)
+            status = 1
+            continue
+        summarize(segments, bad)
+        if bad:
+            status = 1
+        if args.check:
+            continue
+        if args.gpx:
+            write_gpx(args.gpx, path.rsplit("/", 1)[-1], segments)
+            print("Wrote %s" % args.gpx)
+        if args.csv:
+            write_csv(args.csv, segments)
+            print("Wrote %s" % args.csv)
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,168 @@
+#pragma once
+#ifndef AUDIO_HOST_H
+#define AUDIO_HOST_H
+
+// SD card and I2S for AudioFeedbackManager.cpp on the host. Include from the
+// one test file that links it: the stub functions are defined here.
+//
+// Every clip path gets an id on its first open. Its WAV is audioHostPadMs of
+// silence (100 ms), 200-320 ms of a constant "speech" sample that encodes the
+// id, and the same silence again. The I2S sink turns what is written back
+// into runs of clip ids and silence, and paces itself at AUDIO_SAMPLE_RATE
+// times audioHostSpeed.
+#include "AudioFeedbackManager.h"
+#include "SDCardManager.h"
+#include <unistd.h>
+#include <map>
+#include <string>
+
+static const int16_t HOST_SAMPLE_BASE = 512;        // Above AUDIO_TRIM_LEVEL
+static const int16_t HOST_SAMPLE_STEP = 128;        // Room for 250 clip ids
+
+enum : int {
+  HOST_RUN_SILENCE = 0,
+  HOST_RUN_MIXED = -1,                              // Not one clip's sample: crossfade
+  HOST_RUN_CUT = -2                                 // i2s_zero_dma_buffer()
+};
+
+struct HostRun {
+  int clip;                                         // Clip id or HOST_RUN_*
+  uint32_t samples;
+};
+
+static std::mutex hostAudioLock;
+static std::map<std::string, int> hostClipIds;
+static std::map<int, std::string> hostClipNames;
+static std::map<std::string, uint32_t> hostOpens;
+static uint32_t hostOpenCount = 0;
+static std::vector<HostRun> hostRuns;
+static uint32_t audioHostSpeed = 8;
+static uint32_t audioHostPadMs = 100;               // For clips opened from now on
+
+inline uint32_t hostClipBodyMs(int id) {
+  return 200 + (id % 4) * 40;
+}
+
+inline int hostClipId(const char* path) {
+  auto found = hostClipIds.find(path);
+  if (found != hostClipIds.end()) return found->second;
+  int id = (int)hostClipIds.size() + 1;
+  hostClipIds[path] = id;
+  std::string name = path;
+  name = name.substr(name.rfind('/') + 1);
+  hostClipNames[id] = name.substr(0, name.size() - 4);
+  return id;
+}
+
+File fs::FS::open(const char* path, const char*, bool) {
+  if (strstr(path, "missing")) return File();
+  std::lock_guard<std::mutex> lock(hostAudioLock);
+  hostOpens[path]++;
+  hostOpenCount++;
+  int id = hostClipId(path);
+  uint32_t pad = audioHostPadMs * AUDIO_SAMPLE_RATE / 1000;
+  uint32_t body = hostClipBodyMs(id) * AUDIO_SAMPLE_RATE / 1000;
+  uint32_t dataBytes = (2 * pad + body) * sizeof(int16_t);
+  std::vector<uint8_t> wav(44 + dataBytes, 0);
+  int16_t sample = HOST_SAMPLE_BASE + id * HOST_SAMPLE_STEP;
+  for (uint32_t i = 0; i < body; i++) memcpy(&wav[44 + (pad + i) * sizeof(int16_t)], &sample, sizeof(sample));
+  uint32_t rate = AUDIO_SAMPLE_RATE;
+  memcpy(&wav[0], "RIFF", 4);
+  memcpy(&wav[8], "WAVE", 4);
+  memcpy(&wav[24], &rate, 4);
+  memcpy(&wav[36], "data", 4);
+  memcpy(&wav[40], &dataBytes, 4);
+  FILE* stream = fmemopen(nullptr, wav.size() + 1, "w+b");   // glibc keeps the last byte for a NUL
+  fwrite(wav.data(), 1, wav.size(), stream);
+  fseek(stream, 0, SEEK_SET);
+  return File(stream);
+}
+
+bool SDCard_fileExists(const char* path) {
+  return !strstr(path, "missing");
+}
+
+inline void hostAppendRun(int clip, uint32_t samples) {
+  if (!hostRuns.empty() && hostRuns.back().clip == clip && clip != HOST_RUN_CUT) {
+    hostRuns.back().samples += samples;
+  } else {
+    hostRuns.push_back({clip, samples});
+  }
+}
+
+esp_err_t i2s_write(i2s_port_t, const void* data, size_t size, size_t* written, uint32_t) {
+  const int16_t* samples = (const int16_t*)data;
+  {
+    std::lock_guard<std::mutex> lock(hostAudioLock);
+    for (size_t i = 0; i < size / sizeof(int16_t); i++) {
+      int value = samples[i];
+      int clip = HOST_RUN_SILENCE;
+      if (value != 0) {
+        bool exact = value > HOST_SAMPLE_BASE && (value - HOST_SAMPLE_BASE) % HOST_SAMPLE_STEP == 0;
+        clip = exact ? (value - HOST_SAMPLE_BASE) / HOST_SAMPLE_STEP : HOST_RUN_MIXED;
+      }
+      hostAppendRun(clip, 1);
+    }
+  }
+  *written = size;
+  std::this_thread::sleep_for(std::chrono::microseconds(size * 1000000 / (AUDIO_SAMPLE_RATE * sizeof(int16_t)) / audioHostSpeed));
+  return ESP_OK;
+}
+
+esp_err_t i2s_zero_dma_buffer(i2s_port_t) {
+  std::lock_guard<std::mutex> lock(hostAudioLock);
+  hostAppendRun(HOST_RUN_CUT, 0);
+  return ESP_OK;
+}
+
+esp_err_t i2s_driver_install(i2s_port_t, const i2s_config_t*, int, void*) { return ESP_OK; }
+esp_err_t i2s_driver_uninstall(i2s_port_t) { return ESP_OK; }
+esp_err_t i2s_set_pin(i2s_port_t, const i2s_pin_config_t*) { return ESP_OK; }
+esp_err_t i2s_set_sample_rates(i2s_port_t, uint32_t) { return ESP_OK; }
+
+inline uint32_t hostMs(uint32_t samples) {
+  return samples * 1000 / AUDIO_SAMPLE_RATE;
+}
+
+inline int hostClipIdOf(const char* path) {
+  std::lock_guard<std::mutex> lock(hostAudioLock);
+  auto found = hostClipIds.find(path);
+  return found == hostClipIds.end() ? 0 : found->second;
+}
+
+inline uint32_t hostOpensOf(const char* path) {
+  std::lock_guard<std::mutex> lock(hostAudioLock);
+  auto found = hostOpens.find(path);
+  return found == hostOpens.end() ? 0 : found->second;
+}
+
+// Waits for the player to go idle and returns what reached I2S since the last call
+inline std::vector<HostRun> audioHostTake() {
+  audioManager.waitUntilIdle(30000);
+  std::lock_guard<std::mutex> lock(hostAudioLock);
+  std::vector<HostRun> runs;
+  runs.swap(hostRuns);
+  return runs;
+}
+
+// "(10ms) num50 (14ms) num7": the form the test logs print
+inline std::string audioHostDescribe(const std::vector<HostRun>& runs) {
+  std::lock_guard<std::mutex> lock(hostAudioLock);
+  std::string text;
+  for (const HostRun& run : runs) {
+    if (!text.empty()) text += " ";
+    if (run.clip == HOST_RUN_SILENCE) text += "(" + std::to_string(hostMs(run.samples)) + "ms)";
+    else if (run.clip == HOST_RUN_MIXED) text += "~";
+    else if (run.clip == HOST_RUN_CUT) text += "|CUT|";
+    else text += hostClipNames[run.clip];
+  }
+  return text;
+}
+
+// The audio tasks never return; skip static destructors they may still be using
+inline void audioHostExit(int result) {
+  fflush(stdout);
+  _exit(result);
+}
+
+#endif // AUDIO_HOST_H
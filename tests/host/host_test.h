@@ -0,0 +1,54 @@
+#pragma once
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+// Minimal checks for the host tests: failures are printed and counted, and
+// main() returns HOST_TEST_RESULT() so ctest sees a non-zero exit code.
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+
+static int hostTestChecks = 0;
+static int hostTestFailures = 0;
+
+#define CHECK(cond) \
+  do { \
+    hostTestChecks++; \
+    if (!(cond)) { \
+      hostTestFailures++; \
+      fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+  } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+  do { \
+    hostTestChecks++; \
+    double hostActual = (actual), hostExpected = (expected); \
+    if (!(fabs(hostActual - hostExpected) <= (tolerance))) { \
+      hostTestFailures++; \
+      fprintf(stderr, "%s:%d: CHECK_NEAR failed: %s = %g, expected %g +/- %g\n", \
+              __FILE__, __LINE__, #actual, hostActual, hostExpected, (double)(tolerance)); \
+    } \
+  } while (0)
+
+#define RUN_TEST(test) \
+  do { \
+    int failuresBefore = hostTestFailures; \
+    test(); \
+    printf("%s %s\n", hostTestFailures == failuresBefore ? "PASS" : "FAIL", #test); \
+  } while (0)
+
+#define HOST_TEST_RESULT() \
+  (printf("%d checks, %d failed\n", hostTestChecks, hostTestFailures), hostTestFailures ? 1 : 0)
+
+// Same LCG as the on-device self-tests, so traces match
+struct HostRandom {
+  uint32_t seed;
+  explicit HostRandom(uint32_t s) : seed(s) {}
+  uint32_t next() {
+    seed = seed * 1664525UL + 1013904223UL;
+    return seed >> 16;
+  }
+};
+
+#endif // HOST_TEST_H
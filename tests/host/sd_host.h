@@ -0,0 +1,111 @@
+#pragma once
+#ifndef SD_HOST_H
+#define SD_HOST_H
+
+// SD card on the host: card paths map into a fresh directory under /tmp,
+// so modules that append, truncate, rename and list files run against real
+// file I/O. Include from the one test file that links them: the stub
+// functions are defined here.
+#include "SDCardManager.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <filesystem>
+#include <string>
+
+static std::string sdHostRoot;
+static std::atomic<uint32_t> sdHostAppends{0};     // Successful SDCard_appendFile() calls
+
+inline std::string sdHostPath(const char* path) {
+  return sdHostRoot + path;
+}
+
+// Fresh, empty card
+inline void sdHostMount() {
+  if (!sdHostRoot.empty()) std::filesystem::remove_all(sdHostRoot);
+  char dir[] = "/tmp/sc_sd_XXXXXX";
+  sdHostRoot = mkdtemp(dir);
+}
+
+inline size_t sdHostFileSize(const char* path) {
+  struct stat info;
+  return stat(sdHostPath(path).c_str(), &info) == 0 ? (size_t)info.st_size : 0;
+}
+
+// Cut a file short, as a power cut in the middle of a write would
+inline void sdHostTruncate(const char* path, size_t size) {
+  if (truncate(sdHostPath(path).c_str(), size) != 0) perror(path);
+}
+
+inline void sdHostPatch(const char* path, size_t offset, uint8_t value) {
+  FILE* file = fopen(sdHostPath(path).c_str(), "r+b");
+  if (!file) return;
+  fseek(file, offset, SEEK_SET);
+  fputc(value, file);
+  fclose(file);
+}
+
+File fs::FS::open(const char* path, const char* mode, bool) {
+  std::string host = sdHostPath(path);
+  if (strcmp(mode, FILE_READ) == 0) {
+    if (DIR* dir = opendir(host.c_str())) return File::directory(dir, host);
+  }
+  const char* hostMode = strcmp(mode, FILE_WRITE) == 0 ? "wb" : strcmp(mode, FILE_APPEND) == 0 ? "ab" : "rb";
+  return File(fopen(host.c_str(), hostMode), host);
+}
+
+bool fs::FS::exists(const char* path) {
+  struct stat info;
+  return stat(sdHostPath(path).c_str(), &info) == 0;
+}
+
+bool fs::FS::mkdir(const char* path) {
+  return ::mkdir(sdHostPath(path).c_str(), 0755) == 0;
+}
+
+bool fs::FS::remove(const char* path) {
+  return ::remove(sdHostPath(path).c_str()) == 0;
+}
+
+bool fs::FS::rename(const char* from, const char* to) {
+  return ::rename(sdHostPath(from).c_str(), sdHostPath(to).c_str()) == 0;
+}
+
+// Same behaviour as SDCardManager.cpp, which needs the real SD library
+bool SDCard_appendFile(const char* path, const uint8_t* data, size_t len) {
+  File file = SD.open(path, FILE_APPEND);
+  if (!file) return false;
+  size_t written = file.write(data, len);
+  file.close();
+  if (written != len) return false;
+  sdHostAppends++;
+  return true;
+}
+
+uint32_t SDCard_crc32(const uint8_t* data, size_t len, uint32_t crc) {
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+bool SDCard_fileExists(const char* path) {
+  return SD.exists(path);
+}
+
+bool SDCard_deleteFile(const char* path) {
+  return SD.remove(path);
+}
+
+// Background tasks never return; remove the card and skip static destructors
+inline void sdHostExit(int result) {
+  fflush(stdout);
+  if (!sdHostRoot.empty()) std::filesystem::remove_all(sdHostRoot);
+  _exit(result);
+}
+
+#endif // SD_HOST_H
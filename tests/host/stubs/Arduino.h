@@ -0,0 +1,96 @@
+#pragma once
+#ifndef ARDUINO_HOST_STUB_H
+#define ARDUINO_HOST_STUB_H
+
+// Just enough of the Arduino core for the portable firmware modules to build
+// on the host. Serial goes to stdout; ESP cycle counts come from a steady clock;
+// PSRAM is the host heap and GPIO writes are dropped.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdarg.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+
+using std::max;
+using std::min;
+
+#define HIGH 1
+#define LOW 0
+#define OUTPUT 1
+#define DEC 10
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline uint32_t micros() {
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint32_t millis() {
+  return micros() / 1000;
+}
+
+inline void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+
+inline bool psramFound() { return true; }
+inline void* ps_malloc(size_t size) { return malloc(size); }
+
+class String {
+public:
+  String(const char* text = "") : text(text) {}
+  String(const std::string& text) : text(text) {}
+  String(int value, unsigned char base = DEC) : text(base == DEC ? std::to_string(value) : "") {}
+  const char* c_str() const { return text.c_str(); }
+  unsigned length() const { return text.size(); }
+  void toLowerCase() {
+    for (char& c : text) c = (char)tolower((unsigned char)c);
+  }
+  int indexOf(const String& other) const {
+    size_t at = text.find(other.text);
+    return at == std::string::npos ? -1 : (int)at;
+  }
+  bool operator==(const String& other) const { return text == other.text; }
+  String operator+(const String& other) const { return String(text + other.text); }
+  friend String operator+(const char* left, const String& right) { return String(left + right.text); }
+
+private:
+  std::string text;
+};
+
+class HostSerial {
+public:
+  int printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, format);
+    int written = vprintf(format, args);
+    va_end(args);
+    return written;
+  }
+  void print(const char* text) { fputs(text, stdout); }
+  void println(const char* text = "") { puts(text); }
+  void println(const String& text) { puts(text.c_str()); }
+};
+
+class HostEsp {
+public:
+  uint32_t getCycleCount() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+  }
+  uint32_t getFreeHeap() { return 0; }
+};
+
+inline HostSerial Serial;
+inline HostEsp ESP;
+
+#endif // ARDUINO_HOST_STUB_H
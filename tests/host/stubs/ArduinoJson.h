@@ -0,0 +1,8 @@
+#pragma once
+#ifndef ARDUINOJSON_HOST_STUB_H
+#define ARDUINOJSON_HOST_STUB_H
+
+// Declarations only, for headers that mention JsonDocument in a prototype
+class JsonDocument;
+
+#endif // ARDUINOJSON_HOST_STUB_H
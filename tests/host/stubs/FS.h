@@ -0,0 +1,77 @@
+#pragma once
+#ifndef FS_HOST_STUB_H
+#define FS_HOST_STUB_H
+
+// A File reads a host stdio stream, or lists a host directory; each test
+// defines fs::FS and hands out whatever contents it needs (fmemopen over
+// generated data, or real files as in sd_host.h).
+#include <Arduino.h>
+#include <dirent.h>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File {
+public:
+  File(FILE* stream = nullptr, const std::string& path = "") : stream(stream), dir(nullptr), path(path) {}
+  static File directory(DIR* dir, const std::string& path) {
+    File file(nullptr, path);
+    file.dir = dir;
+    return file;
+  }
+  operator bool() const { return stream != nullptr || dir != nullptr; }
+  bool isDirectory() const { return dir != nullptr; }
+  const char* name() const { return path.c_str() + path.rfind('/') + 1; }
+  size_t read(uint8_t* buffer, size_t size) { return fread(buffer, 1, size, stream); }
+  size_t write(const uint8_t* buffer, size_t size) { return fwrite(buffer, 1, size, stream); }
+  void flush() { fflush(stream); }
+  bool seek(uint32_t position, SeekMode mode = SeekSet) {
+    return fseek(stream, position, mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END)) == 0;
+  }
+  size_t position() const { return ftell(stream); }
+  size_t size() const {
+    long at = ftell(stream);
+    fseek(stream, 0, SEEK_END);
+    long end = ftell(stream);
+    fseek(stream, at, SEEK_SET);
+    return end;
+  }
+  int available() { return (int)(size() - position()); }
+  void close() {
+    if (stream) fclose(stream);
+    if (dir) closedir(dir);
+    stream = nullptr;
+    dir = nullptr;
+  }
+  // Next regular file of a directory, opened for reading
+  File openNextFile() {
+    while (dirent* entry = dir ? readdir(dir) : nullptr) {
+      if (entry->d_type != DT_REG) continue;
+      std::string child = path + "/" + entry->d_name;
+      return File(fopen(child.c_str(), "rb"), child);
+    }
+    return File();
+  }
+
+private:
+  FILE* stream;
+  DIR* dir;
+  std::string path;
+};
+
+namespace fs {
+class FS {
+public:
+  File open(const char* path, const char* mode = FILE_READ, bool create = false);
+  File open(const String& path, const char* mode = FILE_READ, bool create = false) { return open(path.c_str(), mode, create); }
+  bool exists(const char* path);
+  bool mkdir(const char* path);
+  bool remove(const char* path);
+  bool rename(const char* from, const char* to);
+};
+} // namespace fs
+
+#endif // FS_HOST_STUB_H
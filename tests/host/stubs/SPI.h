@@ -0,0 +1,13 @@
+#pragma once
+#ifndef SPI_HOST_STUB_H
+#define SPI_HOST_STUB_H
+
+#include <Arduino.h>
+
+class SPIClass {
+public:
+  SPIClass(uint8_t bus = 0) {}
+  void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+};
+
+#endif // SPI_HOST_STUB_H
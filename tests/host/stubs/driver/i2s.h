@@ -0,0 +1,58 @@
+#pragma once
+#ifndef I2S_HOST_STUB_H
+#define I2S_HOST_STUB_H
+
+// Legacy I2S driver API. Only the types live here: each test that links an
+// I2S user defines the functions and decides where the samples go.
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int esp_err_t;
+typedef int i2s_port_t;
+typedef int i2s_mode_t;
+typedef int i2s_bits_per_sample_t;
+typedef int i2s_channel_fmt_t;
+typedef int i2s_comm_format_t;
+
+#define ESP_OK 0
+#define I2S_NUM_0 0
+#define I2S_MODE_MASTER 1
+#define I2S_MODE_TX 4
+#define I2S_BITS_PER_SAMPLE_16BIT 16
+#define I2S_CHANNEL_FMT_ONLY_LEFT 4
+#define I2S_COMM_FORMAT_STAND_I2S 1
+#define ESP_INTR_FLAG_LEVEL1 2
+#define I2S_PIN_NO_CHANGE -1
+
+typedef struct {
+  int mode;
+  int sample_rate;
+  int bits_per_sample;
+  int channel_format;
+  int communication_format;
+  int intr_alloc_flags;
+  int dma_buf_count;
+  int dma_buf_len;
+  bool use_apll;
+  bool tx_desc_auto_clear;
+  int fixed_mclk;
+} i2s_config_t;
+
+typedef struct {
+  int mck_io_num;
+  int bck_io_num;
+  int ws_io_num;
+  int data_out_num;
+  int data_in_num;
+} i2s_pin_config_t;
+
+esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t* config, int queueSize, void* queue);
+esp_err_t i2s_driver_uninstall(i2s_port_t port);
+esp_err_t i2s_set_pin(i2s_port_t port, const i2s_pin_config_t* pins);
+esp_err_t i2s_set_sample_rates(i2s_port_t port, uint32_t rate);
+esp_err_t i2s_zero_dma_buffer(i2s_port_t port);
+esp_err_t i2s_write(i2s_port_t port, const void* data, size_t size, size_t* written, uint32_t ticks);
+
+inline const char* esp_err_to_name(esp_err_t err) { return err == ESP_OK ? "ESP_OK" : "ESP_FAIL"; }
+
+#endif // I2S_HOST_STUB_H
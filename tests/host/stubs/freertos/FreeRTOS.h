@@ -0,0 +1,53 @@
+#pragma once
+#ifndef FREERTOS_HOST_STUB_H
+#define FREERTOS_HOST_STUB_H
+
+// Tasks, queues, task notifications and critical sections on std::thread, so
+// the task-based firmware modules run unchanged on the host. One tick is 1 ms.
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+// Every portMUX shares one recursive lock: enough for correctness on the host
+typedef struct { uint32_t owner; uint32_t count; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0, 0}
+
+namespace HostRtos {
+
+inline std::recursive_mutex& criticalLock() {
+  static std::recursive_mutex lock;
+  return lock;
+}
+
+// Runs until ready() holds or the tick timeout passes; portMAX_DELAY waits forever
+template <typename Ready>
+inline bool waitFor(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, TickType_t ticks, Ready ready) {
+  if (ticks == portMAX_DELAY) {
+    cv.wait(lock, ready);
+    return true;
+  }
+  return cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+} // namespace HostRtos
+
+inline void portENTER_CRITICAL(portMUX_TYPE*) { HostRtos::criticalLock().lock(); }
+inline void portEXIT_CRITICAL(portMUX_TYPE*) { HostRtos::criticalLock().unlock(); }
+
+#endif // FREERTOS_HOST_STUB_H
@@ -0,0 +1,48 @@
+#pragma once
+#ifndef FREERTOS_QUEUE_HOST_STUB_H
+#define FREERTOS_QUEUE_HOST_STUB_H
+
+#include "freertos/FreeRTOS.h"
+
+struct HostQueue {
+  size_t itemSize;
+  size_t capacity;
+  std::deque<std::vector<uint8_t>> items;
+  std::mutex lock;
+  std::condition_variable changed;
+};
+typedef HostQueue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  QueueHandle_t queue = new HostQueue;
+  queue->itemSize = itemSize;
+  queue->capacity = length;
+  return queue;
+}
+
+inline void vQueueDelete(QueueHandle_t queue) { delete queue; }
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(queue->lock);
+  if (!HostRtos::waitFor(queue->changed, lock, ticks, [queue] { return queue->items.size() < queue->capacity; })) return pdFALSE;
+  const uint8_t* bytes = (const uint8_t*)item;
+  queue->items.emplace_back(bytes, bytes + queue->itemSize);
+  queue->changed.notify_all();
+  return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(queue->lock);
+  if (!HostRtos::waitFor(queue->changed, lock, ticks, [queue] { return !queue->items.empty(); })) return pdFALSE;
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  queue->changed.notify_all();
+  return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> lock(queue->lock);
+  return queue->items.size();
+}
+
+#endif // FREERTOS_QUEUE_HOST_STUB_H
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef FREERTOS_TASK_HOST_STUB_H
+#define FREERTOS_TASK_HOST_STUB_H
+
+#include "freertos/FreeRTOS.h"
+
+// A task is a detached thread plus its notification count
+struct HostTask {
+  uint32_t notifications = 0;
+  std::mutex lock;
+  std::condition_variable notified;
+};
+typedef HostTask* TaskHandle_t;
+
+namespace HostRtos {
+inline thread_local TaskHandle_t currentTask = nullptr;
+} // namespace HostRtos
+
+inline BaseType_t xTaskCreatePinnedToCore(void (*function)(void*), const char*, uint32_t, void* parameter,
+                                          UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+  TaskHandle_t task = new HostTask;
+  if (handle) *handle = task;
+  std::thread([function, parameter, task] {
+    HostRtos::currentTask = task;
+    function(parameter);
+  }).detach();
+  return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(void (*function)(void*), const char* name, uint32_t stack, void* parameter,
+                              UBaseType_t priority, TaskHandle_t* handle) {
+  return xTaskCreatePinnedToCore(function, name, stack, parameter, priority, handle, 0);
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return HostRtos::currentTask; }
+
+inline void vTaskDelay(TickType_t ticks) { std::this_thread::sleep_for(std::chrono::milliseconds(ticks)); }
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  std::lock_guard<std::mutex> lock(task->lock);
+  task->notifications++;
+  task->notified.notify_all();
+  return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+  TaskHandle_t task = HostRtos::currentTask;
+  std::unique_lock<std::mutex> lock(task->lock);
+  HostRtos::waitFor(task->notified, lock, ticks, [task] { return task->notifications > 0; });
+  uint32_t count = task->notifications;
+  if (count) task->notifications = clearOnExit ? 0 : count - 1;
+  return count;
+}
+
+#endif // FREERTOS_TASK_HOST_STUB_H
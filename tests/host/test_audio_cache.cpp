@@ -0,0 +1,179 @@
+// AudioFeedbackManager.cpp on the host: the PSRAM clip cache. Pinned alerts
+// are loaded at boot and play with no SD open, digit and unit clips are
+// cached on first use and evicted least recently used, and other clips
+// stream. Under ASan, a writer reading an evicted clip fails the run.
+#include "audio_host.h"
+#include "host_test.h"
+
+static std::mutex doneLock;
+static uint32_t donePlayed = 0;
+static uint32_t doneDropped = 0;
+
+static void onDone(uint32_t, bool played) {
+  std::lock_guard<std::mutex> lock(doneLock);
+  (played ? donePlayed : doneDropped)++;
+}
+
+static const char* const OBSTACLE = "/audio/critical/obstacle_ahead.wav";
+static const char* const FALL = "/audio/critical/fall_detected.wav";
+
+static String unitName(int n) {
+  return String("unit") + String(n);
+}
+
+static String unitPath(int n) {
+  return String(DIGITS_AUDIO_PATH "/") + unitName(n) + ".wav";
+}
+
+// Samples of the clip's sound in runs, i.e. how much of it was heard
+static uint32_t heard(const std::vector<HostRun>& runs, const char* path) {
+  int id = hostClipIdOf(path);
+  uint32_t samples = 0;
+  for (const HostRun& run : runs) {
+    if (run.clip == id) samples += run.samples;
+  }
+  return samples;
+}
+
+static uint32_t bodySamples(const char* path) {
+  return hostClipBodyMs(hostClipIdOf(path)) * AUDIO_SAMPLE_RATE / 1000;
+}
+
+static void testPinnedAlertsPreloaded() {
+  AudioStats stats = audioManager.getStats();
+  CHECK(stats.cachePinned == 4);
+  CHECK(stats.cacheEntries == 4 && stats.cacheLoads == 0);
+  CHECK(hostOpenCount == 4);
+  CHECK(hostOpensOf(OBSTACLE) == 1 && hostOpensOf(FALL) == 1);
+}
+
+static void testAlertPlaysWithoutSd() {
+  uint32_t opens = hostOpenCount;
+  uint32_t hits = audioManager.getStats().cacheHits;
+  audioManager.playObstacleAlert();
+  std::vector<HostRun> runs = audioHostTake();
+  AudioStats stats = audioManager.getStats();
+  printf("  obstacle: %s, start %lu ms\n", audioHostDescribe(runs).c_str(), (unsigned long)stats.lastStartMs);
+  CHECK(hostOpenCount == opens);
+  CHECK(stats.cacheHits == hits + 1);
+  CHECK(heard(runs, OBSTACLE) == bodySamples(OBSTACLE));
+  CHECK(stats.lastStartMs <= 50);     // Nothing but queue hand-offs before the first sample
+
+  audioManager.playFallDetected();
+  runs = audioHostTake();
+  CHECK(hostOpenCount == opens);
+  CHECK(heard(runs, FALL) == bodySamples(FALL));
+}
+
+static void testDigitsCachedOnFirstUse() {
+  const char* fifty = DIGITS_AUDIO_PATH "/num50.wav";
+  const char* seven = DIGITS_AUDIO_PATH "/num7.wav";
+  uint32_t loads = audioManager.getStats().cacheLoads;
+  audioManager.announceNumber(57);
+  std::vector<HostRun> runs = audioHostTake();
+  CHECK(hostOpensOf(fifty) == 1 && hostOpensOf(seven) == 1);
+  CHECK(audioManager.getStats().cacheLoads == loads + 2);
+
+  uint32_t hits = audioManager.getStats().cacheHits;
+  audioManager.announceNumber(57);
+  runs = audioHostTake();
+  CHECK(hostOpensOf(fifty) == 1 && hostOpensOf(seven) == 1);
+  CHECK(audioManager.getStats().cacheHits == hits + 2);
+  CHECK(heard(runs, fifty) == bodySamples(fifty) && heard(runs, seven) == bodySamples(seven));
+}
+
+static void testOtherClipsStream() {
+  const char* turn = "/audio/navigation/turn_left.wav";
+  uint32_t loads = audioManager.getStats().cacheLoads;
+  for (uint8_t i = 0; i < 2; i++) {
+    audioManager.playTurnLeft();
+    std::vector<HostRun> runs = audioHostTake();
+    CHECK(heard(runs, turn) == bodySamples(turn));
+  }
+  CHECK(hostOpensOf(turn) == 2);
+  CHECK(audioManager.getStats().cacheLoads == loads);
+}
+
+static void testMissingClip() {
+  AudioStats before = audioManager.getStats();
+  uint32_t dropped = doneDropped;
+  audioManager.playAudioFile("/audio/digits/missing.wav");
+  audioHostTake();
+  CHECK(audioManager.getStats().failed == before.failed + 1);
+  CHECK(audioManager.getStats().cacheEntries == before.cacheEntries);
+  CHECK(doneDropped == dropped + 1);
+}
+
+// More unit clips than cache entries: the oldest go, the alerts stay
+static void testLeastRecentlyUsedEvicted() {
+  static const int UNITS = 70;
+  static const int PER_PHRASE = 10;
+  for (int first = 0; first < UNITS; first += PER_PHRASE) {
+    audioManager.beginPhrase(AUDIO_PRIORITY_INFO);
+    for (int n = first; n < first + PER_PHRASE; n++) audioManager.announceUnit(unitName(n));
+    audioManager.endPhrase();
+  }
+  std::vector<HostRun> runs = audioHostTake();
+  AudioStats stats = audioManager.getStats();
+  printf("  %u clips, %lu KB, %lu evictions\n", stats.cacheEntries, (unsigned long)(stats.cacheBytes / 1024),
+         (unsigned long)stats.cacheEvictions);
+  uint32_t missed = 0;
+  for (int n = 0; n < UNITS; n++) {
+    if (heard(runs, unitPath(n).c_str()) != bodySamples(unitPath(n).c_str())) missed++;
+  }
+  CHECK(missed == 0);
+  CHECK(stats.cacheEvictions > 0);
+  CHECK(stats.cacheEntries <= AUDIO_CACHE_ENTRIES && stats.cacheBytes <= AUDIO_CACHE_BYTES);
+  CHECK(stats.cachePinned == 4);
+
+  uint32_t opens = hostOpenCount;
+  audioManager.playObstacleAlert();
+  audioManager.announceUnit(unitName(UNITS - 1));
+  audioHostTake();
+  CHECK(hostOpenCount == opens);
+  audioManager.announceUnit(unitName(0));
+  audioHostTake();
+  CHECK(hostOpensOf(unitPath(0).c_str()) == 2);
+}
+
+// Phrases of new units queued faster than they play, with alerts cutting in:
+// loads evict while other phrases are queued, playing or being replayed
+static void testEvictionWhileQueued() {
+  static const int ROUNDS = 3;
+  HostRandom random(0xA0D10);
+  audioHostSpeed = 32;
+  uint32_t queued = audioManager.getStats().queued;
+  uint32_t done = donePlayed + doneDropped;
+  for (int round = 0; round < ROUNDS; round++) {
+    for (int p = 0; p < 6; p++) {
+      audioManager.beginPhrase(AUDIO_PRIORITY_INFO);
+      audioManager.announceNumber(random.next() % 1000);
+      for (int u = 0; u < 4; u++) audioManager.announceUnit(unitName(random.next() % 120));
+      audioManager.endPhrase();
+      if (random.next() % 3 == 0) audioManager.playObstacleAlert();
+      delay(random.next() % 40);
+    }
+    audioHostTake();
+  }
+  audioHostSpeed = 8;
+  AudioStats stats = audioManager.getStats();
+  printf("  %lu phrases, %lu evictions, %lu cut off\n", (unsigned long)(stats.queued - queued),
+         (unsigned long)stats.cacheEvictions, (unsigned long)stats.preempted);
+  CHECK(donePlayed + doneDropped - done == stats.queued - queued);
+  CHECK(stats.cacheEntries <= AUDIO_CACHE_ENTRIES && stats.cacheBytes <= AUDIO_CACHE_BYTES);
+  CHECK(stats.cachePinned == 4);
+}
+
+int main() {
+  setvbuf(stdout, nullptr, _IONBF, 0);
+  if (!audioManager.initialize()) audioHostExit(1);
+  audioManager.setDoneCallback(onDone);
+  RUN_TEST(testPinnedAlertsPreloaded);
+  RUN_TEST(testAlertPlaysWithoutSd);
+  RUN_TEST(testDigitsCachedOnFirstUse);
+  RUN_TEST(testOtherClipsStream);
+  RUN_TEST(testMissingClip);
+  RUN_TEST(testLeastRecentlyUsedEvicted);
+  RUN_TEST(testEvictionWhileQueued);
+  audioHostExit(HOST_TEST_RESULT());
+}
@@ -0,0 +1,100 @@
+// AudioFeedbackManager.cpp on the host: trimmed and crossfaded number
+// phrases. Clips have 100 ms of silence at each end, as TTS exports do; a
+// cached word keeps AUDIO_TRIM_MARGIN_MS of it, words of a number overlap by
+// AUDIO_CROSSFADE_MS and the unit follows after AUDIO_UNIT_GAP_MS.
+#include "audio_host.h"
+#include "host_test.h"
+#include <initializer_list>
+
+static const uint32_t SAMPLES_PER_MS = AUDIO_SAMPLE_RATE / 1000;
+
+static uint32_t bodyMs(const char* word) {
+  std::string path = std::string(DIGITS_AUDIO_PATH "/") + word + ".wav";
+  return hostClipBodyMs(hostClipIdOf(path.c_str()));
+}
+
+static uint32_t totalSamples(const std::vector<HostRun>& runs) {
+  uint32_t samples = 0;
+  for (const HostRun& run : runs) samples += run.samples;
+  return samples;
+}
+
+// Expected runs: silence and words alternating, in ms
+static bool runsAre(const std::vector<HostRun>& runs, std::initializer_list<std::pair<const char*, uint32_t>> expected) {
+  if (runs.size() != expected.size()) return false;
+  size_t i = 0;
+  for (const auto& item : expected) {
+    int clip = item.first ? hostClipIdOf((std::string(DIGITS_AUDIO_PATH "/") + item.first + ".wav").c_str())
+                          : HOST_RUN_SILENCE;
+    if (runs[i].clip != clip || runs[i].samples != item.second * SAMPLES_PER_MS) return false;
+    i++;
+  }
+  return true;
+}
+
+static void testNumberAndUnitOneUtterance() {
+  audioManager.announceTemperature(23.5f);
+  audioHostTake();
+  audioManager.announceDistanceReading(123);
+  std::vector<HostRun> runs = audioHostTake();
+  printf("  distance: %s\n", audioHostDescribe(runs).c_str());
+
+  const uint32_t margin = AUDIO_TRIM_MARGIN_MS;
+  const uint32_t wordGap = 2 * margin - AUDIO_CROSSFADE_MS;
+  CHECK(runsAre(runs, {{nullptr, margin}, {"num1", bodyMs("num1")}, {nullptr, wordGap},
+                       {"hundred", bodyMs("hundred")}, {nullptr, wordGap}, {"num20", bodyMs("num20")},
+                       {nullptr, wordGap}, {"num3", bodyMs("num3")}, {nullptr, 2 * margin + AUDIO_UNIT_GAP_MS},
+                       {"centimeters", bodyMs("centimeters")}, {nullptr, margin}}));
+
+  // The same clips untrimmed, with the old delay(200) between words and delay(300) before the unit
+  uint32_t old = 0;
+  for (const char* word : {"num1", "hundred", "num20", "num3", "centimeters"}) old += bodyMs(word) + 200;
+  old += 3 * 200 + 300;
+  uint32_t phraseMs = audioManager.getStats().lastPhraseMs;
+  printf("  one hundred twenty three centimeters: %lu ms (old sequence %lu ms)\n", (unsigned long)phraseMs,
+         (unsigned long)old);
+  CHECK(phraseMs == totalSamples(runs) / SAMPLES_PER_MS);
+  CHECK(phraseMs * 2 < old);
+}
+
+// Streamed clips keep their silence: plain concatenation
+static void testStreamedClipUntrimmed() {
+  const char* turn = "/audio/navigation/turn_left.wav";
+  audioManager.playTurnLeft();
+  std::vector<HostRun> runs = audioHostTake();
+  uint32_t body = hostClipBodyMs(hostClipIdOf(turn)) * SAMPLES_PER_MS;
+  CHECK(runs.size() == 3);
+  if (runs.size() != 3) return;
+  CHECK(runs[0].clip == HOST_RUN_SILENCE && runs[0].samples == audioHostPadMs * SAMPLES_PER_MS);
+  CHECK(runs[1].clip == hostClipIdOf(turn) && runs[1].samples == body);
+  CHECK(audioManager.getStats().lastPhraseMs == (body + 2 * audioHostPadMs * SAMPLES_PER_MS) / SAMPLES_PER_MS);
+}
+
+// Words with no silence of their own: the last AUDIO_CROSSFADE_MS of one is
+// mixed into the first of the next, so the phrase is that much shorter
+static void testWordsCrossfaded() {
+  audioHostPadMs = 0;
+  audioManager.announceNumber(67);
+  std::vector<HostRun> runs = audioHostTake();
+  audioHostPadMs = 100;
+  printf("  sixty seven: %s\n", audioHostDescribe(runs).c_str());
+  uint32_t silence = 0, mixed = 0;
+  for (const HostRun& run : runs) {
+    if (run.clip == HOST_RUN_SILENCE) silence += run.samples;
+    if (run.clip == HOST_RUN_MIXED) mixed += run.samples;
+  }
+  CHECK(silence == 0);
+  CHECK(mixed > 0 && mixed < AUDIO_CROSSFADE_MS * SAMPLES_PER_MS);
+  CHECK(totalSamples(runs) == (bodyMs("num60") + bodyMs("num7") - AUDIO_CROSSFADE_MS) * SAMPLES_PER_MS);
+  CHECK(runs.front().clip == hostClipIdOf(DIGITS_AUDIO_PATH "/num60.wav"));
+  CHECK(runs.back().clip == hostClipIdOf(DIGITS_AUDIO_PATH "/num7.wav"));
+}
+
+int main() {
+  setvbuf(stdout, nullptr, _IONBF, 0);
+  if (!audioManager.initialize()) audioHostExit(1);
+  RUN_TEST(testNumberAndUnitOneUtterance);
+  RUN_TEST(testStreamedClipUntrimmed);
+  RUN_TEST(testWordsCrossfaded);
+  audioHostExit(HOST_TEST_RESULT());
+}
@@ -0,0 +1,214 @@
+// PdrFilter.cpp on the host: the gpsfilterbench rectangle walk (yaw drift,
+// ~4 m fix noise, a 60-step GPS outage) over several seeds, plus gating,
+// re-initialization, heading lock and a walk along the 0/360 yaw wrap.
+#include "PdrFilter.h"
+#include "SignalFilters.h"
+#include "host_test.h"
+
+static const double ORIGIN_LAT = 25.382344;
+static const double ORIGIN_LON = 68.327323;
+static const float METERS_PER_DEG_LAT = 6371000.0f * (float)M_PI / 180.0f;
+static const float METERS_PER_DEG_LON = METERS_PER_DEG_LAT * cosf(ORIGIN_LAT * (float)M_PI / 180.0f);
+static const float YAW_SIGN = -1.0f;        // PDR_YAW_SIGN: Madgwick yaw turns the other way
+
+struct WalkResult {
+  float fusedRms;
+  float rawRms;
+  float outageMaxM;
+  float stepLengthM;
+  bool covarianceSane;                       // Symmetric, finite, positive diagonal after every call
+};
+
+static float errorM(const PdrFilter& filter, float trueNorth, float trueEast) {
+  double lat, lon;
+  Pdr_getPosition(filter, &lat, &lon);
+  float dN = (float)(lat - ORIGIN_LAT) * METERS_PER_DEG_LAT - trueNorth;
+  float dE = (float)(lon - ORIGIN_LON) * METERS_PER_DEG_LON - trueEast;
+  return sqrtf(dN * dN + dE * dE);
+}
+
+static bool covarianceSane(const PdrFilter& filter) {
+  if (!filter.initialized) return true;     // P is all zero until the first fix
+  for (uint8_t i = 0; i < PDR_STATE_COUNT; i++) {
+    if (!isfinite(filter.x[i]) || !(filter.P[i][i] > 0)) return false;
+    for (uint8_t j = 0; j < PDR_STATE_COUNT; j++) {
+      if (!isfinite(filter.P[i][j]) || fabsf(filter.P[i][j] - filter.P[j][i]) > 1e-3f * (1 + fabsf(filter.P[i][j]))) return false;
+    }
+  }
+  return true;
+}
+
+// Rectangle walk, N/E/S/W legs, fixes every second step except in the outage
+static WalkResult walk(PdrFilter& filter, uint32_t seed) {
+  static const uint16_t LEG_STEPS = 100;
+  static const uint16_t WALK_STEPS = 4 * LEG_STEPS;
+  static const uint16_t OUTAGE_START = 250;
+  static const uint16_t OUTAGE_STEPS = 60;
+  static const float TRUE_STEP_M = 0.72f;
+  static const float FIX_NOISE_M = 7.0f;    // Uniform +/-7 m, sigma ~4 m
+  HostRandom random(seed);
+  auto noise = [&random](float amplitude) { return ((random.next() & 0xFFFF) / 32767.5f - 1.0f) * amplitude; };
+
+  WalkResult result = {0, 0, 0, 0, true};
+  Pdr_reset(filter);
+  float trueNorth = 0, trueEast = 0, yawDrift = 0;
+  double fusedSquared = 0, rawSquared = 0;
+  uint16_t scored = 0;
+  for (uint16_t step = 0; step < WALK_STEPS; step++) {
+    float heading = (step / LEG_STEPS) * (float)M_PI / 2.0f;
+    trueNorth += TRUE_STEP_M * cosf(heading);
+    trueEast += TRUE_STEP_M * sinf(heading);
+    yawDrift += 0.0003f;
+    float imuYaw = (heading - 0.65f) / YAW_SIGN + yawDrift + noise(0.03f);
+    Pdr_predictStep(filter, imuYaw);
+    result.covarianceSane = result.covarianceSane && covarianceSane(filter);
+
+    if (step >= OUTAGE_START && step < OUTAGE_START + OUTAGE_STEPS) {
+      result.outageMaxM = fmaxf(result.outageMaxM, errorM(filter, trueNorth, trueEast));
+      continue;
+    }
+    if (step % 2) continue;
+
+    float rawNorth = trueNorth + noise(FIX_NOISE_M);
+    float rawEast = trueEast + noise(FIX_NOISE_M);
+    double rawLat = ORIGIN_LAT + rawNorth / METERS_PER_DEG_LAT;
+    double rawLon = ORIGIN_LON + rawEast / METERS_PER_DEG_LON;
+    if (!filter.initialized) {
+      Pdr_init(filter, rawLat, rawLon, 4.0f, 0.65f);
+    } else {
+      Pdr_updateFix(filter, rawLat, rawLon, 4.0f);
+      Pdr_updateCourse(filter, heading + noise(0.1f), imuYaw, 0.1f);
+    }
+    result.covarianceSane = result.covarianceSane && covarianceSane(filter);
+
+    if (step < LEG_STEPS / 2) continue;
+    float fused = errorM(filter, trueNorth, trueEast);
+    fusedSquared += fused * fused;
+    rawSquared += (rawNorth - trueNorth) * (rawNorth - trueNorth) + (rawEast - trueEast) * (rawEast - trueEast);
+    scored++;
+  }
+  result.fusedRms = sqrtf(fusedSquared / scored);
+  result.rawRms = sqrtf(rawSquared / scored);
+  result.stepLengthM = filter.x[PDR_STATE_STEP_LENGTH];
+  return result;
+}
+
+static void testSyntheticWalk() {
+  static const uint32_t SEEDS[] = {0x5EED41, 1, 2, 3, 0xC0FFEE, 0xBADA55};
+  for (uint32_t seed : SEEDS) {
+    PdrFilter filter;
+    WalkResult result = walk(filter, seed);
+    printf("  seed %08x: fused %.2f m, raw %.2f m, outage max %.2f m, step %.3f m\n",
+           (unsigned)seed, result.fusedRms, result.rawRms, result.outageMaxM, result.stepLengthM);
+    CHECK(result.fusedRms < result.rawRms);
+    CHECK(result.outageMaxM < 10.0f);
+    CHECK_NEAR(result.stepLengthM, 0.72, 0.08);
+    CHECK(result.covarianceSane);
+    CHECK(filter.resets == 0);
+  }
+}
+
+static void testPredictWaitsForHeading() {
+  PdrFilter filter;
+  Pdr_reset(filter);
+  Pdr_predictStep(filter, 0.3f);             // Not initialized
+  CHECK(filter.steps == 0);
+  Pdr_init(filter, ORIGIN_LAT, ORIGIN_LON, 3.0f, 0.7f);
+  Pdr_predictStep(filter, 0.3f);             // No heading yet: position must not move
+  CHECK(filter.steps == 0);
+  CHECK(filter.x[PDR_STATE_X_NORTH] == 0 && filter.x[PDR_STATE_X_EAST] == 0);
+
+  // First course sets the offset directly; the fused heading then matches it
+  Pdr_updateCourse(filter, (float)M_PI / 2, 1.0f, 0.1f);
+  CHECK(filter.headingLocked);
+  CHECK_NEAR(Pdr_headingDeg(filter, 1.0f), 90.0, 0.01);
+  Pdr_predictStep(filter, 1.0f);
+  CHECK(filter.steps == 1);
+  CHECK_NEAR(filter.x[PDR_STATE_X_EAST], 0.7, 1e-4);
+  CHECK_NEAR(filter.x[PDR_STATE_X_NORTH], 0.0, 1e-4);
+
+  float degrees = Pdr_headingDeg(filter, 1.0f + (float)M_PI);
+  CHECK(degrees >= 0 && degrees < 360);
+  CHECK(Pdr_updateFix(filter, ORIGIN_LAT, ORIGIN_LON, 3.0f));
+}
+
+static void testOutlierGateAndReinit() {
+  PdrFilter filter;
+  walk(filter, 0x5EED41);
+  double lat, lon;
+  Pdr_getPosition(filter, &lat, &lon);
+  float stepLength = filter.x[PDR_STATE_STEP_LENGTH];
+  uint32_t fixes = filter.fixes;
+
+  // 300 m north: far outside the gate
+  double farLat = lat + 300.0 / METERS_PER_DEG_LAT;
+  for (uint8_t i = 0; i < 4; i++) CHECK(!Pdr_updateFix(filter, farLat, lon, 4.0f));
+  double heldLat, heldLon;
+  Pdr_getPosition(filter, &heldLat, &heldLon);
+  CHECK(heldLat == lat && heldLon == lon);
+  CHECK(filter.rejected >= 4 && filter.resets == 0);
+
+  // The fifth consecutive reject restarts at the fix, keeping step length and counters
+  CHECK(!Pdr_updateFix(filter, farLat, lon, 4.0f));
+  CHECK(filter.resets == 1);
+  CHECK(filter.fixes == fixes);
+  CHECK(!filter.headingLocked);
+  CHECK_NEAR(filter.x[PDR_STATE_STEP_LENGTH], stepLength, 1e-6);
+  Pdr_getPosition(filter, &heldLat, &heldLon);
+  CHECK_NEAR((heldLat - farLat) * METERS_PER_DEG_LAT, 0.0, 0.01);
+  CHECK_NEAR(Pdr_positionSigma(filter), 4.0, 0.01);
+
+  // A fix near the new origin is accepted again
+  CHECK(Pdr_updateFix(filter, farLat, lon, 4.0f));
+  CHECK(filter.consecutiveRejects == 0);
+}
+
+// Walking north with the IMU yaw swaying across 359 -> 0 at the sample rate,
+// smoothed the way IMU.cpp does it. The heading has to stay near north and
+// the steps on the track; a plain EMA of the degrees points them south.
+static void testYawAcrossWrap() {
+  static const uint16_t STEPS = 120;
+  static const uint8_t SAMPLES_PER_STEP = 125;    // 250 Hz, two steps a second
+  static const float STEP_M = 0.72f;
+  HostRandom random(0x0360);
+  auto noise = [&random](float amplitude) { return ((random.next() & 0xFFFF) / 32767.5f - 1.0f) * amplitude; };
+
+  PdrFilter filter;
+  Pdr_reset(filter);
+  Pdr_init(filter, ORIGIN_LAT, ORIGIN_LON, 3.0f, STEP_M);
+  AngleEma yaw;
+  float worstDeg = 0;
+  float trueNorth = 0;
+  for (uint16_t step = 0; step < STEPS; step++) {
+    float smoothed = 0;
+    for (uint8_t i = 0; i < SAMPLES_PER_STEP; i++) {
+      float sway = 6.0f * sinf(i * 2.0f * (float)M_PI / SAMPLES_PER_STEP) + noise(2.0f);
+      float raw = (sway < 0) ? sway + 360.0f : sway;   // Madgwick yaw is 0-360
+      smoothed = yaw.update(raw, 0.15f);
+      worstDeg = fmaxf(worstDeg, fminf(smoothed, 360.0f - smoothed));
+    }
+    float yawRad = smoothed * (float)M_PI / 180.0f;
+    Pdr_predictStep(filter, yawRad);
+    trueNorth += STEP_M;
+    if (step % 2 == 0) {
+      double lat = ORIGIN_LAT + trueNorth / METERS_PER_DEG_LAT;
+      Pdr_updateFix(filter, lat, ORIGIN_LON, 3.0f);
+      Pdr_updateCourse(filter, noise(0.05f), yawRad, 0.1f);
+    }
+  }
+  float heading = Pdr_headingDeg(filter, yaw.value() * (float)M_PI / 180.0f);
+  printf("  worst smoothed yaw %.1f deg from north, heading %.1f deg, error %.2f m\n",
+         worstDeg, heading, errorM(filter, trueNorth, 0));
+  CHECK(worstDeg < 10.0f);
+  CHECK(fminf(heading, 360.0f - heading) < 5.0f);
+  CHECK(errorM(filter, trueNorth, 0) < 2.0f);
+  CHECK(filter.rejected == 0);
+}
+
+int main() {
+  RUN_TEST(testSyntheticWalk);
+  RUN_TEST(testPredictWaitsForHeading);
+  RUN_TEST(testOutlierGateAndReinit);
+  RUN_TEST(testYawAcrossWrap);
+  return HOST_TEST_RESULT();
+}
@@ -0,0 +1,229 @@
+// SatelliteTable.cpp on the host: in-place GSV/GSA parsing, group handling
+// and a corruption fuzz. Every sentence is copied into an exact-size heap
+// buffer, so ASan flags any read or write past len + 1.
+#include "SatelliteTable.h"
+#include "host_test.h"
+#include <vector>
+
+static const char* const GOLDEN_SENTENCES[] = {
+  "$GPGSA,A,3,04,05,09,12,,,,,,,,,2.5,1.3,2.1*3F",
+  "$GPGSV,3,1,11,04,45,120,42,05,30,200,38,09,60,045,45,12,15,300,30*7C",
+  "$GPGSV,3,2,11,17,05,090,,19,70,010,47,20,25,260,33,23,40,330,40*7F",
+  "$GPGSV,3,3,11,25,10,180,,28,50,100,36,31,08,020,22*45",
+  "$GLGSV,1,1,03,65,35,050,35,66,60,150,41,72,12,270,*54",
+  "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A",
+};
+static const uint8_t GOLDEN_COUNT = sizeof(GOLDEN_SENTENCES) / sizeof(GOLDEN_SENTENCES[0]);
+
+static SatelliteTable table;
+
+// Parses a copy of text[0..len) with exactly len + 1 bytes of room
+static bool feed(const char* text, size_t len, uint32_t nowMs, bool* changed = nullptr) {
+  std::vector<char> buffer(text, text + len);
+  buffer.push_back('\0');
+  bool viewChanged = false;
+  bool handled = SatTable_parse(table, buffer.data(), len, nowMs, &viewChanged);
+  if (changed) *changed = viewChanged;
+  return handled;
+}
+
+static bool feed(const char* text, uint32_t nowMs, bool* changed = nullptr) {
+  return feed(text, strlen(text), nowMs, changed);
+}
+
+static bool viewIsSane(const SatelliteView& view) {
+  for (uint8_t system = 0; system < GNSS_COUNT; system++) {
+    const GnssSnrStats& stats = view.stats[system];
+    if (view.count[system] > SATS_PER_SYSTEM) return false;
+    if (stats.tracked > view.count[system] || stats.used > view.count[system]) return false;
+    if (stats.minSnr > stats.maxSnr || stats.maxSnr > 99) return false;
+    for (uint8_t i = 0; i < view.count[system]; i++) {
+      const Satellite& sat = view.sats[system][i];
+      if (sat.prn == 0 || sat.system != system || sat.azimuth > 359) return false;
+      if (sat.elevation < -90 || sat.elevation > 90 || sat.snr > 99) return false;
+    }
+  }
+  return view.fixType >= 1 && view.fixType <= 3;
+}
+
+static void testTokenizer() {
+  char sentence[] = "$GPGSA,A,3,,*3F";
+  char* fields[NMEA_MAX_FIELDS];
+  uint8_t count = Nmea_tokenize(sentence, strlen(sentence), fields, NMEA_MAX_FIELDS);
+  CHECK(count == 5);
+  CHECK(strcmp(fields[0], "$GPGSA") == 0);
+  CHECK(strcmp(fields[2], "3") == 0);
+  CHECK(fields[3][0] == '\0' && fields[4][0] == '\0');
+
+  char crlf[] = "$GPGSV,1,1,00\r\n";
+  CHECK(Nmea_tokenize(crlf, strlen(crlf), fields, NMEA_MAX_FIELDS) == 4);
+  CHECK(strcmp(fields[3], "00") == 0);
+
+  char many[] = "$X,1,2,3,4,5,6,7,8,9";
+  CHECK(Nmea_tokenize(many, strlen(many), fields, 4) == 4);
+  CHECK(Nmea_tokenize(many, 0, fields, 4) == 0);
+
+  CHECK(Nmea_parseInt("42", -1) == 42);
+  CHECK(Nmea_parseInt("-7", 0) == -7);
+  CHECK(Nmea_parseInt("12a", 0) == 12);
+  CHECK(Nmea_parseInt("", -1) == -1);
+  CHECK(Nmea_parseInt("-", -1) == -1);
+  CHECK(Nmea_parseInt(nullptr, -1) == -1);
+  CHECK(Nmea_parseInt("12345678901", 0) == 123456789);   // Capped at 9 digits, no overflow
+}
+
+static void testGoldenGroups() {
+  SatTable_reset(table);
+  uint8_t handled = 0;
+  for (uint8_t i = 0; i < GOLDEN_COUNT; i++) handled += feed(GOLDEN_SENTENCES[i], 1000) ? 1 : 0;
+  const SatelliteView& view = table.view;
+  const GnssSnrStats& gps = view.stats[GNSS_GPS];
+  const GnssSnrStats& glo = view.stats[GNSS_GLONASS];
+  CHECK(handled == GOLDEN_COUNT - 1);   // RMC is not ours
+  CHECK(view.count[GNSS_GPS] == 11 && gps.inView == 11);
+  CHECK(gps.tracked == 9 && gps.used == 4);
+  CHECK(gps.minSnr == 22 && gps.maxSnr == 47);
+  CHECK_NEAR(gps.meanSnr, 37.0, 0.01);
+  CHECK(view.count[GNSS_GLONASS] == 3 && glo.tracked == 2);
+  CHECK_NEAR(glo.meanSnr, 38.0, 0.01);
+  CHECK(view.fixType == 3);
+  CHECK_NEAR(view.pdop, 2.5, 0.01);
+  CHECK_NEAR(view.hdop, 1.3, 0.01);
+  CHECK_NEAR(view.vdop, 2.1, 0.01);
+  CHECK(view.sats[GNSS_GPS][4].snr == 0);
+  CHECK(view.sats[GNSS_GPS][5].elevation == 70);
+  CHECK(view.sats[GNSS_GPS][0].active && !view.sats[GNSS_GPS][4].active);
+  CHECK(view.gsvSentences == 4 && view.gsaSentences == 1 && view.malformed == 0);
+
+  Satellite top[3];
+  CHECK(SatTable_top(view, top, 3) == 3);
+  CHECK(top[0].prn == 19 && top[1].prn == 9 && top[2].prn == 66);
+}
+
+static void testLostMessageDropsGroup() {
+  SatTable_reset(table);
+  for (uint8_t i = 0; i < GOLDEN_COUNT; i++) feed(GOLDEN_SENTENCES[i], 1000);
+  bool changed = true;
+  feed(GOLDEN_SENTENCES[1], 2000, &changed);
+  CHECK(!changed);                      // Only a complete group reaches the view
+  feed(GOLDEN_SENTENCES[3], 2000, &changed);
+  CHECK(!changed);
+  CHECK(table.view.malformed == 1);
+  CHECK(table.view.updatedMs[GNSS_GPS] == 1000);
+  CHECK(table.view.count[GNSS_GPS] == 11);
+
+  // The next complete group is taken again
+  for (uint8_t i = 1; i <= 3; i++) feed(GOLDEN_SENTENCES[i], 3000, &changed);
+  CHECK(changed && table.view.updatedMs[GNSS_GPS] == 3000);
+}
+
+static void testMixedTalkerAndSystemId() {
+  SatTable_reset(table);
+  CHECK(feed("$GNGSV,1,1,02,70,40,100,30,71,20,200,25*00", 500));
+  CHECK(table.view.count[GNSS_GLONASS] == 2);
+  CHECK(table.view.count[GNSS_GPS] == 0);
+
+  // NMEA 4.10 system ID overrides the GN talker
+  CHECK(feed("$GNGSA,A,3,70,,,,,,,,,,,,1.8,1.0,1.5,2*00", 500));
+  CHECK(table.view.stats[GNSS_GLONASS].used == 1);
+  CHECK(table.view.sats[GNSS_GLONASS][0].active);
+  CHECK(!table.view.sats[GNSS_GLONASS][1].active);
+
+  // Too few GSA fields: counted, view untouched
+  CHECK(feed("$GPGSA,A,3,01*00", 600));
+  CHECK(table.view.malformed == 1);
+  CHECK_NEAR(table.view.pdop, 1.8, 0.01);
+}
+
+static void testGroupTruncatedAtTableSize() {
+  SatTable_reset(table);
+  char sentence[96];
+  uint8_t prn = 1;
+  for (uint8_t number = 1; number <= 6; number++) {
+    int len = snprintf(sentence, sizeof(sentence), "$GPGSV,6,%u,24", number);
+    for (uint8_t k = 0; k < 4; k++, prn++) {
+      len += snprintf(sentence + len, sizeof(sentence) - len, ",%02u,30,100,40", prn);
+    }
+    feed(sentence, 100);
+  }
+  CHECK(table.view.count[GNSS_GPS] == SATS_PER_SYSTEM);
+  CHECK(table.view.stats[GNSS_GPS].inView == 24);
+  CHECK(table.view.sats[GNSS_GPS][SATS_PER_SYSTEM - 1].prn == SATS_PER_SYSTEM);
+  CHECK(viewIsSane(table.view));
+}
+
+static void testOtherSentencesUntouched() {
+  char sentence[] = "$GPRMC,123519,A,4807.038,N*6A";
+  char copy[sizeof(sentence)];
+  memcpy(copy, sentence, sizeof(sentence));
+  SatTable_reset(table);
+  bool changed = true;
+  CHECK(!SatTable_parse(table, sentence, strlen(sentence), 0, &changed));
+  CHECK(memcmp(sentence, copy, sizeof(sentence)) == 0);
+  CHECK(!feed("$GP", 0));
+  CHECK(!feed("", 0));
+}
+
+static void testSetSystem() {
+  SatTable_reset(table);
+  Satellite sats[3] = {};
+  for (uint8_t i = 0; i < 3; i++) {
+    sats[i].prn = 10 + i;
+    sats[i].snr = 30 + i;
+    sats[i].system = GNSS_GALILEO;
+    sats[i].active = (i != 1);
+  }
+  SatTable_setSystem(table, GNSS_GALILEO, sats, 3, 700);
+  CHECK(table.view.count[GNSS_GALILEO] == 3);
+  CHECK(table.view.stats[GNSS_GALILEO].used == 2);
+  CHECK(table.view.stats[GNSS_GALILEO].minSnr == 30 && table.view.stats[GNSS_GALILEO].maxSnr == 32);
+  SatTable_setSystem(table, GNSS_COUNT, sats, 3, 700);   // Ignored
+  CHECK(viewIsSane(table.view));
+}
+
+// Corrupted, truncated and spliced copies of the golden sentences
+static void testFuzz() {
+  static const uint32_t FUZZ_SENTENCES = 200000;
+  static const char ALPHABET[] = ",,,**$0123456789-.GSVAPLNB";
+  HostRandom random(0x5A7E11);
+  uint32_t violations = 0;
+  char buffer[128];
+  SatTable_reset(table);
+  for (uint32_t n = 0; n < FUZZ_SENTENCES; n++) {
+    const char* source = GOLDEN_SENTENCES[random.next() % GOLDEN_COUNT];
+    size_t len = strlen(source);
+    memcpy(buffer, source, len);
+    if (random.next() % 8 == 0) {
+      // Splice the tail of another sentence on
+      const char* other = GOLDEN_SENTENCES[random.next() % GOLDEN_COUNT];
+      size_t cut = 1 + random.next() % (len - 1);
+      size_t from = random.next() % strlen(other);
+      size_t extra = strlen(other) - from;
+      if (cut + extra > sizeof(buffer) - 1) extra = sizeof(buffer) - 1 - cut;
+      memcpy(buffer + cut, other + from, extra);
+      len = cut + extra;
+    }
+    uint8_t edits = random.next() % 6;
+    for (uint8_t e = 0; e < edits; e++) {
+      size_t at = 1 + random.next() % (len - 1);
+      buffer[at] = (random.next() % 4 == 0) ? (char)(random.next() & 0xFF) : ALPHABET[random.next() % (sizeof(ALPHABET) - 1)];
+    }
+    if (random.next() % 4 == 0) len = 1 + random.next() % len;
+    feed(buffer, len, n);
+    if (!viewIsSane(table.view)) violations++;
+  }
+  CHECK(violations == 0);
+  CHECK(table.view.malformed > 0);
+}
+
+int main() {
+  RUN_TEST(testTokenizer);
+  RUN_TEST(testGoldenGroups);
+  RUN_TEST(testLostMessageDropsGroup);
+  RUN_TEST(testMixedTalkerAndSystemId);
+  RUN_TEST(testGroupTruncatedAtTableSize);
+  RUN_TEST(testOtherSentencesUntouched);
+  RUN_TEST(testSetSystem);
+  RUN_TEST(testFuzz);
+  return HOST_TEST_RESULT();
+}
@@ -0,0 +1,412 @@
+// SignalFilters.h on the host: running median, Q-format helpers and the
+// stable EMA used by the ToF filter chain, and the six-axis median used by
+// the IMU. The on-device tofbench and imubench commands run the same golden
+// checks and add cycle counts; only imubench can exercise the PIE (SIMD)
+// path. Set SC_TOF_TRACE to a file of raw ToF readings (mm, one per line)
+// to also check the EMA against a recording.
+#include "SignalFilters.h"
+#include "host_test.h"
+#include <chrono>
+#include <vector>
+
+static const uint16_t TRACE_SAMPLES = 2000;
+static const uint16_t MAX_RANGE_MM = 3500;
+static const uint16_t TOF_MIN_MM = 30;
+// Q4 rounding is under 1/32 mm a step and the EMA damps it. Now and then it
+// flips a threshold compare (a 70 mm change in one filter, 70.06 in the
+// other) and the two differ by a few mm until they reconverge.
+static const float EMA_MAX_ERROR_MM = 4.0f;
+static const float EMA_RMS_ERROR_MM = 0.25f;
+
+// Slow walk toward a wall with noise, dropouts, spurious near returns and
+// duplicates (the tofbench trace)
+static void makeRangeTrace(uint16_t* trace) {
+  HostRandom random(0x1234567);
+  for (uint16_t i = 0; i < TRACE_SAMPLES; i++) {
+    int32_t value = 3000 - (i % 500) * 5 + (int32_t)(random.next() % 41) - 20;
+    uint32_t r = random.next() % 100;
+    if (r < 3) value = MAX_RANGE_MM;
+    else if (r < 5) value = random.next() % 400;
+    else if (r < 8) value = value - (value % 64);
+    trace[i] = (uint16_t)constrain(value, 0, (int32_t)MAX_RANGE_MM);
+  }
+}
+
+template <uint8_t N>
+static void checkRunningMedian(const uint16_t* trace) {
+  MedianN<N> window;
+  uint16_t reference[N];
+  uint16_t mismatches = 0;
+  for (uint16_t i = 0; i < TRACE_SAMPLES; i++) {
+    window.push(trace[i]);
+    uint8_t n = (i + 1 < N) ? i + 1 : N;
+    for (uint8_t k = 0; k < n; k++) reference[k] = trace[i + 1 - n + k];
+    MedianN<N>::insertionSort(reference, n);
+    if (window.median() != reference[n >> 1]) mismatches++;
+  }
+  CHECK(mismatches == 0);
+  CHECK(window.full());
+}
+
+static void testRunningMedianMatchesSort() {
+  static uint16_t trace[TRACE_SAMPLES];
+  makeRangeTrace(trace);
+  checkRunningMedian<5>(trace);   // 7-comparator network (ToF window)
+  checkRunningMedian<3>(trace);   // Odd-even transposition
+  checkRunningMedian<7>(trace);
+}
+
+// Every input over a 5-value alphabet, so ties and all orders are covered
+static void testFiveComparatorNetworkExhaustive() {
+  uint16_t failures = 0;
+  for (uint16_t code = 0; code < 5 * 5 * 5 * 5 * 5; code++) {
+    uint16_t v[5], sorted[5];
+    uint16_t rest = code;
+    for (uint8_t k = 0; k < 5; k++) {
+      v[k] = sorted[k] = rest % 5;
+      rest /= 5;
+    }
+    MedianN<5>::insertionSort(sorted, 5);
+    if (MedianN<5>::medianOfFull(v) != sorted[2]) failures++;
+  }
+  CHECK(failures == 0);
+}
+
+static void testWarmupAndReset() {
+  MedianN<5> window;
+  CHECK(window.median() == 0);
+  window.push(900);
+  CHECK(window.median() == 900);
+  window.push(100);
+  CHECK(window.median() == 900);   // Upper median of an even prefix
+  window.push(500);
+  CHECK(window.median() == 500);
+  CHECK(window.count() == 3 && !window.full());
+  window.reset();
+  CHECK(window.count() == 0);
+  CHECK(window.median() == 0);
+}
+
+static void testFixedPointBlend() {
+  static uint16_t trace[TRACE_SAMPLES];
+  makeRangeTrace(trace);
+  const float gains[] = {0.07f, 0.22f, 0.35f, 0.42f, 0.08f, 0.18f, 0.9f, 1.0f};
+  float maxError = 0;
+  for (uint16_t i = 0; i < TRACE_SAMPLES; i++) {
+    float from = trace[i];
+    float to = trace[(i * 7 + 3) % TRACE_SAMPLES];
+    float gain = gains[i % 8];
+    float expected = from + (to - from) * gain;
+    float actual = fromQDist(qBlend(toQDist(from), toQDist(to), qGain(gain)));
+    maxError = fmaxf(maxError, fabsf(actual - expected));
+  }
+  CHECK(maxError <= 0.125f);
+
+  // Full-range jump at unity gain must not overflow the Q4 x Q15 product
+  CHECK(qBlend(toQDist((uint16_t)0), toQDist(MAX_RANGE_MM), qGain(1.0f)) == toQDist(MAX_RANGE_MM));
+  CHECK(qBlend(toQDist(MAX_RANGE_MM), toQDist((uint16_t)0), qGain(1.0f)) == 0);
+  CHECK(toQDist((uint16_t)1234) == 1234 * 16);
+  CHECK_NEAR(fromQDist(toQDist(12.5f)), 12.5, 1e-6);
+}
+
+// The float stable EMA the Q4/Q15 version replaced, kept as the reference
+struct FloatStableEma {
+  uint8_t initCount = 0;
+  float filtered = MAX_RANGE_MM;
+  float lastStable = MAX_RANGE_MM;
+  uint32_t lastLargeChangeTime = 0;
+  bool recoveringFromObstacle = false;
+  uint8_t consecutiveStableReadings = 0;
+
+  void step(float newDistance, uint32_t currentTime, uint8_t speed) {
+    if (initCount < 8) {
+      if (newDistance >= TOF_MIN_MM && newDistance <= MAX_RANGE_MM) {
+        filtered = (filtered * initCount + newDistance) / (initCount + 1);
+        lastStable = filtered;
+        initCount++;
+      }
+      return;
+    }
+    float change = fabsf(newDistance - lastStable);
+    if (newDistance < lastStable - EMA_NEW_OBSTACLE_DROP_MM && newDistance < EMA_NEW_OBSTACLE_RANGE_MM) {
+      recoveringFromObstacle = false;
+      consecutiveStableReadings = 0;
+      filtered = newDistance;
+      lastStable = filtered;
+      return;
+    }
+    if (newDistance > lastStable + EMA_OBSTACLE_REMOVED_RISE_MM && lastStable < EMA_OBSTACLE_REMOVED_RANGE_MM) {
+      recoveringFromObstacle = true;
+      lastLargeChangeTime = currentTime;
+      consecutiveStableReadings = 0;
+      filtered = lastStable + (newDistance - lastStable) * EMA_RECOVERY_RATE[speed];
+    } else if (change <= EMA_NORMAL_CHANGE_LIMIT_MM) {
+      float alpha = EMA_ALPHA_MID;
+      if (change > EMA_CHANGE_LARGE_MM) alpha = EMA_ALPHA_MAX;
+      else if (change < EMA_CHANGE_SMALL_MM) alpha = EMA_ALPHA_MIN;
+      if (recoveringFromObstacle && newDistance > filtered) alpha = EMA_RECOVERY_ALPHA[speed];
+      filtered = alpha * newDistance + (1 - alpha) * filtered;
+      consecutiveStableReadings = (change < EMA_STABLE_CHANGE_MM) ? consecutiveStableReadings + 1 : 0;
+    } else {
+      filtered = lastStable + (newDistance - lastStable) * EMA_CONSERVATIVE_RATE[speed];
+      consecutiveStableReadings = 0;
+    }
+    uint32_t resetTimeout = (speed == 1) ? 3500 : (speed == 3) ? 2000 : 2500;
+    uint8_t requiredStableReadings = (speed == 1) ? 6 : (speed == 3) ? 3 : 4;
+    if (recoveringFromObstacle && (currentTime - lastLargeChangeTime > resetTimeout ||
+                                   consecutiveStableReadings > requiredStableReadings)) {
+      recoveringFromObstacle = false;
+    }
+    filtered = constrain(filtered, (float)TOF_MIN_MM, (float)MAX_RANGE_MM);
+    lastStable = filtered;
+  }
+};
+
+// Walking toward a wall and back at ~30 Hz: +/-8 mm noise, a person crossing
+// at 0.9 m, a post passed at 0.5 m, and dropouts to max range
+static std::vector<uint16_t> makeWalkTrace() {
+  std::vector<uint16_t> trace;
+  HostRandom random(0x2028);
+  for (uint16_t i = 0; i < 1800; i++) {
+    float wall = (i < 900) ? 3400.0f - i * 3.4f : 340.0f + (i - 900) * 3.4f;
+    float value = wall + (int32_t)(random.next() % 17) - 8;
+    if (i >= 200 && i < 240) value = 900 + (int32_t)(random.next() % 11) - 5;
+    if (i >= 1300 && i < 1330) value = 500 + (int32_t)(random.next() % 11) - 5;
+    if (random.next() % 100 < 2) value = MAX_RANGE_MM;
+    trace.push_back((uint16_t)constrain(value, 0.0f, (float)MAX_RANGE_MM));
+  }
+  return trace;
+}
+
+// Raw readings from SC_TOF_TRACE, if set
+static std::vector<uint16_t> loadRecordedTrace() {
+  std::vector<uint16_t> trace;
+  const char* path = getenv("SC_TOF_TRACE");
+  FILE* file = path ? fopen(path, "r") : nullptr;
+  if (!file) return trace;
+  unsigned value;
+  while (fscanf(file, "%u", &value) == 1) trace.push_back((uint16_t)min(value, (unsigned)MAX_RANGE_MM));
+  fclose(file);
+  return trace;
+}
+
+struct EmaError {
+  float maxMm;
+  float rmsMm;
+};
+
+// Raw readings through the 5-sample median and both EMAs, 33 ms apart
+static EmaError compareEma(const std::vector<uint16_t>& trace, uint8_t speed) {
+  MedianN<5> window;
+  StableEmaState fixed = stableEmaInit(TOF_MIN_MM, MAX_RANGE_MM);
+  FloatStableEma reference;
+  double squared = 0;
+  EmaError error = {0, 0};
+  for (size_t i = 0; i < trace.size(); i++) {
+    window.push(trace[i]);
+    uint16_t median = window.median();
+    stableEmaStep(fixed, median, i * 33, speed);
+    reference.step(median, i * 33, speed);
+    float diff = fabsf(fromQDist(fixed.filtered) - reference.filtered);
+    error.maxMm = fmaxf(error.maxMm, diff);
+    squared += diff * diff;
+  }
+  error.rmsMm = sqrtf(squared / trace.size());
+  return error;
+}
+
+// The Q4/Q15 EMA must follow the float one it replaced on every adaptive speed
+static void testStableEmaMatchesFloat() {
+  static uint16_t bench[TRACE_SAMPLES];
+  makeRangeTrace(bench);
+  std::vector<std::pair<const char*, std::vector<uint16_t>>> traces = {
+    {"tofbench", std::vector<uint16_t>(bench, bench + TRACE_SAMPLES)},
+    {"walk", makeWalkTrace()},
+    {"recorded", loadRecordedTrace()},
+  };
+  for (const auto& trace : traces) {
+    if (trace.second.empty()) continue;
+    for (uint8_t speed = 1; speed <= 3; speed++) {
+      EmaError error = compareEma(trace.second, speed);
+      printf("  %s, speed %u: max %.3f mm, rms %.4f mm\n", trace.first, speed, error.maxMm, error.rmsMm);
+      CHECK(error.maxMm <= EMA_MAX_ERROR_MM);
+      CHECK(error.rmsMm <= EMA_RMS_ERROR_MM);
+    }
+  }
+}
+
+static void testStableEmaBehaviour() {
+  StableEmaState st = stableEmaInit(TOF_MIN_MM, MAX_RANGE_MM);
+  stableEmaStep(st, 10, 0, 3);                      // Below range: not part of the warm-up
+  CHECK(st.initCount == 0);
+  for (uint8_t i = 0; i < 8; i++) stableEmaStep(st, 2000, i * 33, 3);
+  CHECK(st.initCount == 8);
+  CHECK(st.filtered == toQDist((uint16_t)2000));
+  stableEmaStep(st, 1000, 300, 3);                  // New obstacle: taken at once
+  CHECK(st.filtered == toQDist((uint16_t)1000));
+  stableEmaStep(st, 1010, 333, 3);                  // Small change: EMA
+  CHECK(st.filtered > toQDist((uint16_t)1000) && st.filtered < toQDist((uint16_t)1010));
+  stableEmaStep(st, 3500, 366, 3);                  // Far jump: partway
+  CHECK(st.filtered < toQDist((uint16_t)1500));
+  bool clamped = true;
+  for (uint8_t i = 0; i < 200; i++) {
+    stableEmaStep(st, 3500, 400 + i * 33, 3);
+    clamped = clamped && st.filtered <= st.maxQ;
+  }
+  CHECK(clamped);
+  CHECK(st.filtered > toQDist((uint16_t)3499));
+}
+
+// ns per sample on this machine; build with -DSC_HOST_SANITIZE=OFF for useful
+// numbers. Cycle counts on the ESP32-S3 come from tofbench.
+template <typename Fn>
+static double nsPerSample(uint32_t samples, Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / samples;
+}
+
+static void benchmarkToFChain() {
+  static const uint16_t PASSES = 100;
+  static uint16_t trace[TRACE_SAMPLES];
+  makeRangeTrace(trace);
+  volatile uint32_t sink = 0;
+  double insertion = nsPerSample(PASSES * TRACE_SAMPLES, [&] {
+    uint16_t v[5];
+    for (uint16_t pass = 0; pass < PASSES; pass++) {
+      for (uint16_t i = 0; i < TRACE_SAMPLES; i++) {
+        for (uint8_t k = 0; k < 5; k++) v[k] = trace[(i + k) % TRACE_SAMPLES];
+        MedianN<5>::insertionSort(v, 5);
+        sink = sink + v[2];
+      }
+    }
+  });
+  double network = nsPerSample(PASSES * TRACE_SAMPLES, [&] {
+    MedianN<5> window;
+    for (uint16_t pass = 0; pass < PASSES; pass++) {
+      for (uint16_t i = 0; i < TRACE_SAMPLES; i++) {
+        window.push(trace[i]);
+        sink = sink + window.median();
+      }
+    }
+  });
+  double floatEma = nsPerSample(PASSES * TRACE_SAMPLES, [&] {
+    FloatStableEma ema;
+    for (uint16_t pass = 0; pass < PASSES; pass++) {
+      for (uint16_t i = 0; i < TRACE_SAMPLES; i++) {
+        ema.step(trace[i], i * 33, 3);
+        sink = sink + (uint32_t)ema.filtered;
+      }
+    }
+  });
+  double fixedEma = nsPerSample(PASSES * TRACE_SAMPLES, [&] {
+    StableEmaState ema = stableEmaInit(TOF_MIN_MM, MAX_RANGE_MM);
+    for (uint16_t pass = 0; pass < PASSES; pass++) {
+      for (uint16_t i = 0; i < TRACE_SAMPLES; i++) {
+        stableEmaStep(ema, trace[i], i * 33, 3);
+        sink = sink + ema.filtered;
+      }
+    }
+  });
+  printf("  median: insertion sort %.1f ns/sample, network %.1f ns/sample\n", insertion, network);
+  printf("  stable EMA: float %.1f ns/sample, Q4/Q15 %.1f ns/sample\n", floatEma, fixedEma);
+  CHECK(sink != 0);
+}
+
+// Walking-like six-axis trace with noise, saturation and sign flips (the imubench trace)
+static const uint8_t AXIS_AZ = 2;
+static void makeAxisTrace(int16_t (*trace)[AXIS_CHANNELS]) {
+  HostRandom random(0x2468ACE);
+  for (uint16_t i = 0; i < TRACE_SAMPLES; i++) {
+    for (uint8_t lane = 0; lane < AXIS_CHANNELS; lane++) {
+      int32_t base = (lane == AXIS_AZ) ? 4096 : 0;
+      int32_t value = base + (int32_t)((i * (lane + 3)) % 800) - 400 + (int32_t)(random.next() % 201) - 100;
+      uint32_t r = random.next() % 100;
+      if (r < 2) value = 32767;
+      else if (r < 4) value = -32768;
+      else if (r < 6) value = -value;
+      trace[i][lane] = (int16_t)constrain(value, -32768, 32767);
+    }
+  }
+}
+
+static void testAxisMedianMatchesSort() {
+  static int16_t trace[TRACE_SAMPLES][AXIS_CHANNELS];
+  makeAxisTrace(trace);
+  AxisMedian5 window;
+  AxisBlock dispatched, scalar;
+  int16_t reference[AXIS_HISTORY];
+  uint16_t mismatches = 0, paddingErrors = 0;
+  window.fill(trace[0]);
+  for (uint16_t i = 0; i < TRACE_SAMPLES; i++) {
+    window.push(trace[i]);
+    window.median(dispatched);
+    window.medianScalar(scalar);
+    if (memcmp(&dispatched, &scalar, sizeof(AxisBlock)) != 0) mismatches++;
+    if (scalar.lane[6] != 0 || scalar.lane[7] != 0) paddingErrors++;
+    if (i + 1 < AXIS_HISTORY) continue;
+    for (uint8_t lane = 0; lane < AXIS_CHANNELS; lane++) {
+      for (uint8_t k = 0; k < AXIS_HISTORY; k++) reference[k] = trace[i + 1 - AXIS_HISTORY + k][lane];
+      MedianN<AXIS_HISTORY, int16_t>::insertionSort(reference, AXIS_HISTORY);
+      if (scalar.lane[lane] != reference[AXIS_HISTORY >> 1]) mismatches++;
+    }
+  }
+  CHECK(mismatches == 0);
+  CHECK(paddingErrors == 0);
+}
+
+// Every input over a 5-value alphabet including both saturation limits; lane l
+// sees the values rotated by l, so each lane gets a different order
+static void testAxisMedianExhaustive() {
+  static const int16_t VALUES[5] = {-32768, -1, 0, 1, 32767};
+  uint16_t failures = 0;
+  for (uint16_t code = 0; code < 5 * 5 * 5 * 5 * 5; code++) {
+    AxisMedian5 window;
+    int16_t samples[AXIS_HISTORY][AXIS_CHANNELS];
+    uint16_t rest = code;
+    for (uint8_t k = 0; k < AXIS_HISTORY; k++, rest /= 5) {
+      for (uint8_t lane = 0; lane < AXIS_CHANNELS; lane++) samples[k][lane] = VALUES[(rest + lane) % 5];
+      window.push(samples[k]);
+    }
+    AxisBlock out;
+    window.medianScalar(out);
+    for (uint8_t lane = 0; lane < AXIS_CHANNELS; lane++) {
+      int16_t sorted[AXIS_HISTORY];
+      for (uint8_t k = 0; k < AXIS_HISTORY; k++) sorted[k] = samples[k][lane];
+      MedianN<AXIS_HISTORY, int16_t>::insertionSort(sorted, AXIS_HISTORY);
+      if (out.lane[lane] != sorted[2]) failures++;
+    }
+  }
+  CHECK(failures == 0);
+}
+
+static void testAxisMedianFill() {
+  const int16_t seed[AXIS_CHANNELS] = {10, -20, 4096, 300, -32768, 32767};
+  const int16_t spike[AXIS_CHANNELS] = {32767, 32767, -32768, -32768, 0, 0};
+  AxisMedian5 window;
+  window.fill(seed);
+  window.push(spike);
+  window.push(spike);
+  AxisBlock out;
+  window.median(out);
+  // Two spikes against three seeded slots: the seed still wins
+  CHECK(memcmp(out.lane, seed, sizeof(seed)) == 0);
+  window.push(spike);
+  window.median(out);
+  CHECK(memcmp(out.lane, spike, sizeof(spike)) == 0);
+}
+
+int main() {
+  RUN_TEST(testRunningMedianMatchesSort);
+  RUN_TEST(testFiveComparatorNetworkExhaustive);
+  RUN_TEST(testWarmupAndReset);
+  RUN_TEST(testFixedPointBlend);
+  RUN_TEST(testStableEmaMatchesFloat);
+  RUN_TEST(testStableEmaBehaviour);
+  RUN_TEST(benchmarkToFChain);
+  RUN_TEST(testAxisMedianMatchesSort);
+  RUN_TEST(testAxisMedianExhaustive);
+  RUN_TEST(testAxisMedianFill);
+  return HOST_TEST_RESULT();
+}
@@ -0,0 +1,210 @@
+// StepJournal.cpp on the host, appending to real segment files through the
+// SD stub: recovery from torn and corrupt records, segment rotation and
+// wrap-around, legacy step_data.dat migration, and factory reset.
+#include "sd_host.h"
+#include "StepJournal.h"
+#include "host_test.h"
+#include <cstddef>
+
+// The record and legacy block as StepJournal.cpp writes and reads them
+struct JournalRecord {
+  uint32_t magic;
+  uint32_t sequence;
+  uint32_t dailySteps;
+  uint32_t totalSteps;
+  uint8_t lastResetDay;
+  uint8_t lastResetMonth;
+  uint16_t lastResetYear;
+  uint32_t crc;
+};
+
+struct LegacyBlock {
+  uint32_t magic;
+  uint32_t dailySteps;
+  uint32_t totalSteps;
+  uint8_t lastResetDay;
+  uint8_t lastResetMonth;
+  uint16_t lastResetYear;
+  uint32_t checksum;
+};
+
+static const size_t RECORD = sizeof(JournalRecord);
+static const uint16_t SEGMENT_RECORDS = 256;
+static const uint8_t SEGMENTS = 4;
+static const char* const LEGACY_PATH = "/data/step_data.dat";
+
+static std::string segment(uint8_t index) {
+  char path[32];
+  snprintf(path, sizeof(path), "/data/steps_%u.jnl", index);
+  return path;
+}
+
+static size_t recordsIn(uint8_t index) {
+  return sdHostFileSize(segment(index).c_str()) / RECORD;
+}
+
+static StepCounts countsFor(uint32_t n) {
+  StepCounts counts;
+  counts.dailySteps = n % 1000;
+  counts.totalSteps = n * 100;
+  counts.lastResetDay = 18;
+  counts.lastResetMonth = 10;
+  counts.lastResetYear = 2026;
+  return counts;
+}
+
+// Fresh card with a /data directory and the journal recovered from it
+static bool remount(StepCounts& recovered) {
+  sdHostMount();
+  SD.mkdir("/data");
+  return StepJournal_begin(recovered);
+}
+
+// Flushes n = first..last, waiting for each record to reach the card
+static bool commit(uint32_t first, uint32_t last) {
+  for (uint32_t n = first; n <= last; n++) {
+    uint32_t appends = sdHostAppends;
+    StepJournal_flush(countsFor(n));
+    for (uint16_t i = 0; i < 2000 && sdHostAppends == appends; i++) delay(1);
+    if (sdHostAppends == appends) return false;
+  }
+  return true;
+}
+
+static void writeLegacy(const StepCounts& counts, bool damaged) {
+  LegacyBlock block = {0x53544550, counts.dailySteps, counts.totalSteps, counts.lastResetDay,
+                       counts.lastResetMonth, counts.lastResetYear, 0};
+  const uint8_t* bytes = (const uint8_t*)&block;
+  for (size_t i = 0; i < offsetof(LegacyBlock, checksum); i++) block.checksum += bytes[i];
+  if (damaged) block.totalSteps++;
+  File file = SD.open(LEGACY_PATH, FILE_WRITE);
+  file.write(bytes, sizeof(block));
+  file.close();
+}
+
+static bool sameCounts(const StepCounts& a, const StepCounts& b) {
+  return a.dailySteps == b.dailySteps && a.totalSteps == b.totalSteps && a.lastResetDay == b.lastResetDay &&
+         a.lastResetMonth == b.lastResetMonth && a.lastResetYear == b.lastResetYear;
+}
+
+static void testEmptyCard() {
+  StepCounts recovered;
+  CHECK(!remount(recovered));
+  StepJournalStats stats = StepJournal_getStats();
+  CHECK(stats.recoveredFrom == STEP_SOURCE_NONE);
+  CHECK(stats.activeSegment == 0 && stats.activeRecords == 0);
+  CHECK(SD.exists(segment(0).c_str()) && recordsIn(0) == 0);
+}
+
+// A damaged legacy file is ignored; a good one becomes the first record
+static void testLegacyMigration() {
+  StepCounts legacy = countsFor(4321);
+  StepCounts recovered;
+  sdHostMount();
+  SD.mkdir("/data");
+  writeLegacy(legacy, true);
+  CHECK(!StepJournal_begin(recovered));
+  CHECK(StepJournal_getStats().recoveredFrom == STEP_SOURCE_NONE);
+
+  sdHostMount();
+  SD.mkdir("/data");
+  writeLegacy(legacy, false);
+  CHECK(StepJournal_begin(recovered));
+  CHECK(sameCounts(recovered, legacy));
+  CHECK(StepJournal_getStats().recoveredFrom == STEP_SOURCE_LEGACY);
+  CHECK(recordsIn(0) == 1);
+
+  // Next boot: the journal record wins over the legacy file left beside it
+  writeLegacy(countsFor(1), false);
+  StepCounts again;
+  CHECK(StepJournal_begin(again));
+  CHECK(sameCounts(again, legacy));
+  CHECK(StepJournal_getStats().recoveredFrom == STEP_SOURCE_JOURNAL);
+  CHECK(commit(4322, 4322));
+  CHECK(recordsIn(0) == 2);
+}
+
+// Power cut mid-append plus corrupt records inside the segment: the newest
+// valid record is recovered, and appending resumes in a clean segment
+static void testTornAndCorruptRecords() {
+  StepCounts recovered;
+  remount(recovered);
+  uint32_t base = StepJournal_getStats().sequence;      // Sequences run on across remounts
+  CHECK(commit(1, 50));
+  std::string name = segment(0);
+  const char* path = name.c_str();
+  sdHostPatch(path, 29 * RECORD + offsetof(JournalRecord, totalSteps), 0xFF);   // Record 30
+  sdHostPatch(path, 47 * RECORD + offsetof(JournalRecord, crc), 0x00);          // Record 48
+  sdHostPatch(path, 47 * RECORD + offsetof(JournalRecord, crc) + 1, 0x00);
+  sdHostTruncate(path, 48 * RECORD + RECORD / 2);                               // Records 49-50 torn off
+
+  StepCounts after;
+  CHECK(StepJournal_begin(after));
+  StepJournalStats stats = StepJournal_getStats();
+  printf("  recovered %lu steps, %u torn/corrupt records\n", (unsigned long)after.totalSteps, stats.tornRecords);
+  CHECK(sameCounts(after, countsFor(47)));
+  CHECK(stats.tornRecords == 2);
+  CHECK(stats.sequence == base + 47);
+  CHECK(stats.activeSegment == 1 && stats.activeRecords == 0);
+
+  // The damaged segment is left alone; the next record starts segment 1
+  size_t damagedSize = sdHostFileSize(path);
+  CHECK(commit(48, 48));
+  CHECK(sdHostFileSize(path) == damagedSize);
+  CHECK(recordsIn(1) == 1);
+  CHECK(StepJournal_begin(after));
+  CHECK(sameCounts(after, countsFor(48)));
+  CHECK(StepJournal_getStats().sequence == base + 48);
+}
+
+// Four full segments and a wrap into segment 0, which is truncated first
+static void testSegmentRotation() {
+  static const uint32_t TOTAL = SEGMENTS * SEGMENT_RECORDS + 5;
+  StepCounts recovered;
+  remount(recovered);
+  CHECK(commit(1, TOTAL));
+  CHECK(recordsIn(0) == 5);
+  for (uint8_t i = 1; i < SEGMENTS; i++) CHECK(recordsIn(i) == SEGMENT_RECORDS);
+  for (uint8_t i = 0; i < SEGMENTS; i++) CHECK(sdHostFileSize(segment(i).c_str()) % RECORD == 0);
+
+  StepCounts after;
+  CHECK(StepJournal_begin(after));
+  CHECK(sameCounts(after, countsFor(TOTAL)));
+  StepJournalStats stats = StepJournal_getStats();
+  CHECK(stats.activeSegment == 0 && stats.activeRecords == 5 && stats.tornRecords == 0);
+
+  // Every record of the newest segment corrupt: fall back to the end of segment 3
+  std::string newest = segment(0);
+  for (uint8_t i = 0; i < 5; i++) sdHostPatch(newest.c_str(), i * RECORD, 0x00);
+  CHECK(StepJournal_begin(after));
+  CHECK(sameCounts(after, countsFor(TOTAL - 5)));
+  stats = StepJournal_getStats();
+  CHECK(stats.tornRecords == 5);
+  CHECK(stats.activeSegment == 3 && stats.activeRecords == SEGMENT_RECORDS);   // Full: the commit rotates
+  CHECK(commit(TOTAL + 1, TOTAL + 1));
+  CHECK(recordsIn(0) == 1);
+  CHECK(StepJournal_begin(after));
+  CHECK(sameCounts(after, countsFor(TOTAL + 1)));
+}
+
+static void testEraseDropsEverything() {
+  StepCounts recovered;
+  remount(recovered);
+  CHECK(commit(1, 3));
+  writeLegacy(countsFor(9), false);
+  CHECK(StepJournal_erase());
+  for (uint16_t i = 0; i < 2000 && SD.exists(LEGACY_PATH); i++) delay(1);
+  for (uint8_t i = 0; i < SEGMENTS; i++) CHECK(!SD.exists(segment(i).c_str()));
+  CHECK(!SD.exists(LEGACY_PATH));
+  CHECK(!StepJournal_begin(recovered));
+}
+
+int main() {
+  setvbuf(stdout, nullptr, _IONBF, 0);
+  RUN_TEST(testEmptyCard);
+  RUN_TEST(testLegacyMigration);
+  RUN_TEST(testTornAndCorruptRecords);
+  RUN_TEST(testSegmentRotation);
+  RUN_TEST(testEraseDropsEverything);
+  sdHostExit(HOST_TEST_RESULT());
+}
@@ -0,0 +1,199 @@
+// TrackLogger.cpp on the host, writing real block files through the SD
+// stub: the encoder round trip checked by hardware/tools/track_convert.py
+// (the PC decoder), file numbering, and session restarts.
+#include "sd_host.h"
+#include "TrackLogger.h"
+#include "host_test.h"
+#include <sys/wait.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#ifndef SC_PYTHON
+#define SC_PYTHON ""
+#endif
+
+static const uint64_t WALK_START_MS = 1760000000000ULL;
+
+static std::string trackFile(uint16_t index) {
+  char path[32];
+  snprintf(path, sizeof(path), "%s/trk_%05u.bin", TRACK_DIR, index);
+  return path;
+}
+
+static bool haveConverter() {
+  return SC_PYTHON[0] != '\0';
+}
+
+// track_convert.py with arguments; returns its exit status
+static int runConverter(const std::string& args) {
+  std::string command = std::string(SC_PYTHON) + " " SC_TRACK_CONVERT " " + args + " > /dev/null 2>&1";
+  int status = system(command.c_str());
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static std::string readText(const std::string& path) {
+  std::ifstream in(path);
+  std::stringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+// Wait for the writer task to append `blocks` blocks in total
+static bool waitForBlocks(uint32_t blocks) {
+  for (uint16_t i = 0; i < 2000 && sdHostAppends < blocks; i++) delay(1);
+  return sdHostAppends == blocks;
+}
+
+// Wait until the writer task has had nothing to append for 50 ms
+static void waitForWriter() {
+  uint32_t seen = sdHostAppends;
+  for (uint16_t quiet = 0; quiet < 50; quiet++) {
+    delay(1);
+    if (sdHostAppends != seen) {
+      seen = sdHostAppends;
+      quiet = 0;
+    }
+  }
+}
+
+// Logs one fix and runs the service, as the GPS task does per wake-up. Pauses
+// now and then so the writer keeps up (a block holds ~100 of these fixes).
+static void feed(const TrackPoint& point, uint32_t n) {
+  TrackLog_record(point);
+  TrackLog_service();
+  if (n % 32 == 31) delay(2);
+}
+
+// A 1 Hz walk with turns, a 70 s gap and a clock the decoder must follow.
+// Altitude, speed and HDOP move in steps past their deadbands and the
+// speed never drops to standing still, so every fix is logged exactly.
+static std::vector<TrackPoint> makeWalk() {
+  std::vector<TrackPoint> walk;
+  HostRandom random(0x7045);
+  TrackPoint point = {WALK_START_MS, 253823440, 683273230, 250, 130, 90, 9};
+  int32_t dLat = 120, dLon = 0;
+  for (uint16_t i = 0; i < 480; i++) {
+    point.utcMs += (i == 240) ? 70000 : 1000;
+    if (i % 90 == 89) {
+      int32_t turn = dLat;      // 90 degree turn
+      dLat = -dLon;
+      dLon = turn;
+    }
+    point.latE7 += dLat + (int32_t)(random.next() % 7) - 3;
+    point.lonE7 += dLon + (int32_t)(random.next() % 7) - 3;
+    if (i % 30 == 29) point.altDm += (i % 60 == 59) ? -12 : 15;
+    if (i % 50 == 49) point.speedCms = (point.speedCms == 130) ? 160 : 130;
+    if (i % 70 == 69) point.hdopCenti = (point.hdopCenti == 90) ? 140 : 90;
+    if (i % 110 == 109) point.satellites = 9 + (point.satellites - 8) % 4;
+    walk.push_back(point);
+  }
+  return walk;
+}
+
+// The CSV track_convert.py --csv writes for the walk: two segments, split at the gap
+static std::string expectedCsv(const std::vector<TrackPoint>& walk) {
+  std::string csv = "segment,clock,time_ms,lat,lon,alt_m,speed_mps,hdop,satellites\r\n";
+  char row[160];
+  for (size_t i = 0; i < walk.size(); i++) {
+    const TrackPoint& p = walk[i];
+    snprintf(row, sizeof(row), "%d,utc,%llu,%.7f,%.7f,%.1f,%.2f,%.2f,%u\r\n", i < 240 ? 0 : 1,
+             (unsigned long long)p.utcMs, p.latE7 * 1e-7, p.lonE7 * 1e-7, p.altDm / 10.0, p.speedCms / 100.0,
+             p.hdopCenti / 100.0, p.satellites);
+    csv += row;
+  }
+  return csv;
+}
+
+// An old track on the card: the first session takes the next number
+static void testBeginFindsNextFile() {
+  SD.mkdir(TRACK_DIR);
+  File old = SD.open(trackFile(6).c_str(), FILE_WRITE);
+  old.close();
+  CHECK(TrackLog_begin());
+  CHECK(!TrackLog_isRecording());
+  TrackLog_start();
+  CHECK(TrackLog_isRecording());
+  TrackLog_service();
+  CHECK(TrackLog_getStats().fileIndex == 7);
+}
+
+static void testRoundTripThroughConverter() {
+  std::vector<TrackPoint> walk = makeWalk();
+  for (uint32_t n = 0; n < walk.size(); n++) feed(walk[n], n);
+  TrackLog_stop();
+  TrackLog_service();
+  waitForWriter();
+  TrackLogStats stats = TrackLog_getStats();
+  size_t blocks = sdHostFileSize(trackFile(7).c_str()) / TRACK_BLOCK_SIZE;
+  printf("  %lu fixes, %lu keyframes, %zu blocks, %.2f bytes/fix encoded\n", (unsigned long)stats.points,
+         (unsigned long)stats.keyframes, blocks, (float)stats.payloadBytes / stats.points);
+  CHECK(!TrackLog_isRecording());
+  CHECK(stats.points == walk.size() && stats.dropped == 0 && stats.stillSkipped == 0);
+  CHECK(sdHostFileSize(trackFile(7).c_str()) % TRACK_BLOCK_SIZE == 0);
+  CHECK(blocks >= 3 && blocks == stats.blocksWritten && stats.writeFailures == 0);
+
+  if (!haveConverter()) {
+    printf("  python3 not found: track_convert.py checks skipped\n");
+    return;
+  }
+  std::string file = sdHostPath(trackFile(7).c_str());
+  std::string csv = sdHostRoot + "/decoded.csv";
+  CHECK(runConverter(file + " --check") == 0);
+  CHECK(runConverter(file + " --csv " + csv) == 0);
+  CHECK(readText(csv) == expectedCsv(walk));
+
+  // One flipped byte in the second block: --check must fail on it
+  sdHostPatch(trackFile(7).c_str(), TRACK_BLOCK_SIZE + 40, 0x5A);
+  CHECK(runConverter(file + " --check") == 1);
+}
+
+// gpslog on while recording, then a quick off/on: each session keeps its
+// own fixes in its own file
+static void testRestartKeepsSessionsApart() {
+  static const uint16_t COUNTS[3] = {30, 20, 10};
+  uint32_t written = sdHostAppends;
+  TrackPoint point = {WALK_START_MS + 3600000, 253823440, 683273230, 250, 130, 90, 9};
+  TrackLog_start();
+  TrackLog_service();
+  uint16_t first = TrackLog_getStats().fileIndex;
+  for (uint8_t session = 0; session < 3; session++) {
+    for (uint16_t n = 0; n < COUNTS[session]; n++) {
+      point.utcMs += 1000;
+      point.latE7 += 120;
+      feed(point, n);
+    }
+    CHECK(TrackLog_getStats().points == COUNTS[session]);
+    if (session == 0) {
+      TrackLog_start();                    // Already recording
+    } else if (session == 1) {
+      TrackLog_stop();
+      TrackLog_start();                    // Before the service saw the stop
+    }
+    CHECK(TrackLog_isRecording());
+    TrackLog_service();
+    CHECK(TrackLog_isRecording());
+  }
+  TrackLog_stop();
+  TrackLog_service();
+  CHECK(!TrackLog_isRecording());
+  CHECK(waitForBlocks(written + 3));
+  for (uint8_t session = 0; session < 3; session++) {
+    std::string path = trackFile(first + session);
+    CHECK(sdHostFileSize(path.c_str()) == TRACK_BLOCK_SIZE);
+    if (!haveConverter()) continue;
+    std::string csv = sdHostRoot + "/session.csv";
+    CHECK(runConverter(sdHostPath(path.c_str()) + " --csv " + csv) == 0);
+    std::string text = readText(csv);
+    CHECK((size_t)std::count(text.begin(), text.end(), '\n') == COUNTS[session] + 1u);
+  }
+}
+
+int main() {
+  setvbuf(stdout, nullptr, _IONBF, 0);
+  sdHostMount();
+  RUN_TEST(testBeginFindsNextFile);
+  RUN_TEST(testRoundTripThroughConverter);
+  RUN_TEST(testRestartKeepsSessionsApart);
+  sdHostExit(HOST_TEST_RESULT());
+}